@@ -40,6 +40,7 @@
 #include "../driver.h"
 #include "../configuration.h"
 #include "../retroarch.h"
+#include "../performance_counters.h"
 #include "../verbosity.h"
 #include "../list_special.h"
 
@@ -564,6 +565,7 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
    bool is_paused                                       = false;
    bool is_idle                                         = false;
    bool is_slowmotion                                   = false;
+   retro_time_t flush_start                             = 0;
    const void *output_data                              = NULL;
    unsigned output_frames                               = 0;
    float audio_volume_gain                              = !audio_driver_mute_enable ?
@@ -587,6 +589,8 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
 		   !audio_driver_output_samples_buf)
       return;
 
+   performance_probe_start(is_perfcnt_enable, flush_start);
+
    convert_s16_to_float(audio_driver_input_data, data, samples,
          audio_volume_gain);
 
@@ -636,6 +640,9 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
       audio_source_ratio_current   =
          audio_source_ratio_original * adjust;
 
+      performance_trace_counter("audio_buffer_full",
+            (unsigned)(100 - (avail * 100) / audio_driver_buffer_size));
+
 #if 0
       if (verbosity_is_enabled())
       {
@@ -682,9 +689,14 @@ static void audio_driver_flush(const int16_t *data, size_t samples)
       output_frames  *= sizeof(int16_t);
    }
 
+   performance_trace_begin("audio_write");
    if (current_audio->write(audio_driver_context_audio_data,
             output_data, output_frames * 2) < 0)
       audio_driver_active = false;
+   performance_trace_end("audio_write");
+
+   performance_probe_stop(is_perfcnt_enable,
+         PERF_PROBE_AUDIO_FLUSH, flush_start);
 }
 
 /**
@@ -21,6 +21,7 @@
 #include <rthreads/rthreads.h>
 
 #include "audio_thread_wrapper.h"
+#include "../performance_counters.h"
 #include "../verbosity.h"
 
 typedef struct audio_thread
@@ -77,6 +78,8 @@ static void audio_thread_loop(void *data)
 
    RARCH_LOG("[Audio Thread]: Starting audio.\n");
 
+   performance_trace_thread_begin("audio");
+
    for (;;)
    {
       slock_lock(thr->lock);
@@ -105,9 +108,14 @@ static void audio_thread_loop(void *data)
       }
 
       slock_unlock(thr->lock);
+
+      performance_trace_begin("audio_callback");
       audio_driver_callback();
+      performance_trace_end("audio_callback");
    }
 
+   performance_trace_thread_end();
+
    RARCH_LOG("[Audio Thread]: Tearing down driver.\n");
    thr->driver->free(thr->driver_data);
 }
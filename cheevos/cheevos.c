@@ -46,6 +46,7 @@
 #include "cheevos.h"
 #include "var.h"
 #include "cond.h"
+#include "program.h"
 
 #include "../file_path_special.h"
 #include "../command.h"
@@ -107,18 +108,6 @@
 #define CHEEVOS_JSON_KEY_MEM          0x0b8807e4U
 #define CHEEVOS_JSON_KEY_FORMAT       0xb341208eU
 
-typedef struct
-{
-   cheevos_cond_t *conds;
-   unsigned        count;
-} cheevos_condset_t;
-
-typedef struct
-{
-   cheevos_condset_t *condsets;
-   unsigned count;
-} cheevos_condition_t;
-
 typedef struct
 {
    unsigned    id;
@@ -139,6 +128,9 @@ typedef struct
 {
    cheevo_t *cheevos;
    unsigned  count;
+
+   /* The conditions of all cheevos, compiled once addresses are patched */
+   cheevos_program_t *program;
 } cheevoset_t;
 
 typedef struct
@@ -267,8 +259,8 @@ static cheevos_locals_t cheevos_locals =
    /* add_buffer          */ 0,
    /* add_hits            */ 0,
 
-   /* core                */ {NULL, 0},
-   /* unofficial          */ {NULL, 0},
+   /* core                */ {NULL, 0, NULL},
+   /* unofficial          */ {NULL, 0, NULL},
    /* leaderboards        */ NULL,
    /* lboard_count        */ 0,
 
@@ -1778,6 +1770,26 @@ static int cheevos_reset_cond_set(cheevos_condset_t *condset, int deltas)
    return dirty;
 }
 
+static void cheevos_update_cheevo(cheevo_t *cheevo,
+      int dirty_conds, int reset_conds)
+{
+   if (dirty_conds)
+      cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
+
+   if (reset_conds)
+   {
+      int dirty                    = 0;
+      cheevos_condset_t *condset   = cheevo->condition.condsets;
+      const cheevos_condset_t *end = condset + cheevo->condition.count;
+
+      for (; condset < end; condset++)
+         dirty |= cheevos_reset_cond_set(condset, 0);
+
+      if (dirty)
+         cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
+   }
+}
+
 static int cheevos_test_cheevo(cheevo_t *cheevo)
 {
    int dirty_conds              = 0;
@@ -1811,20 +1823,7 @@ static int cheevos_test_cheevo(cheevo_t *cheevo)
       condset++;
    }
 
-   if (dirty_conds)
-      cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
-
-   if (reset_conds)
-   {
-      int dirty = 0;
-
-      for (condset = cheevo->condition.condsets; condset < end; condset++)
-         dirty |= cheevos_reset_cond_set(condset, 0);
-
-      if (dirty)
-         cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
-   }
-
+   cheevos_update_cheevo(cheevo, dirty_conds, reset_conds);
    return (ret_val && ret_val_sub_cond);
 }
 
@@ -1924,11 +1923,27 @@ static void cheevos_test_cheevo_set(const cheevoset_t *set)
    if (settings && settings->bools.cheevos_hardcore_mode_enable)
       mode = CHEEVOS_ACTIVE_HARDCORE;
 
+   if (set->program)
+      cheevos_program_load(set->program);
+
    for (cheevo = set->cheevos; cheevo < end; cheevo++)
    {
       if (cheevo->active & mode)
       {
-         int valid = cheevos_test_cheevo(cheevo);
+         int valid;
+
+         if (set->program)
+         {
+            int dirty_conds = 0;
+            int reset_conds = 0;
+
+            valid = cheevos_program_test(set->program,
+                  (unsigned)(cheevo - set->cheevos),
+                  &dirty_conds, &reset_conds);
+            cheevos_update_cheevo(cheevo, dirty_conds, reset_conds);
+         }
+         else
+            valid = cheevos_test_cheevo(cheevo);
 
          if (cheevo->last)
          {
@@ -2242,6 +2257,8 @@ static void cheevos_free_cheevo_set(const cheevoset_t *set)
 
    if (set->cheevos)
       free((void*)set->cheevos);
+
+   cheevos_program_free(set->program);
 }
 
 #ifndef CHEEVOS_DONT_DEACTIVATE
@@ -2524,6 +2541,8 @@ bool cheevos_unload(void)
    cheevos_locals.unofficial.cheevos = NULL;
    cheevos_locals.core.count         = 0;
    cheevos_locals.unofficial.count   = 0;
+   cheevos_locals.core.program       = NULL;
+   cheevos_locals.unofficial.program = NULL;
 
    cheevos_loaded     = false;
 
@@ -2718,6 +2737,31 @@ static void cheevos_patch_lbs(cheevos_leaderboard_t *leaderboard)
    }
 }
 
+/* Falls back to interpreting the conditions if it can't compile them */
+static void cheevos_compile_cheevo_set(cheevoset_t* set)
+{
+   unsigned i;
+   cheevos_condition_t** conditions = NULL;
+
+   cheevos_program_free(set->program);
+   set->program = NULL;
+
+   if (!set->count)
+      return;
+
+   conditions = (cheevos_condition_t**)
+      malloc(set->count * sizeof(*conditions));
+
+   if (!conditions)
+      return;
+
+   for (i = 0; i < set->count; i++)
+      conditions[i] = &set->cheevos[i].condition;
+
+   set->program = cheevos_program_new(conditions, set->count);
+   free(conditions);
+}
+
 void cheevos_test(void)
 {
    settings_t *settings = config_get_ptr();
@@ -2728,6 +2772,9 @@ void cheevos_test(void)
       cheevos_patch_addresses(&cheevos_locals.unofficial);
       cheevos_patch_lbs(cheevos_locals.leaderboards);
 
+      cheevos_compile_cheevo_set(&cheevos_locals.core);
+      cheevos_compile_cheevo_set(&cheevos_locals.unofficial);
+
       cheevos_locals.addrs_patched = true;
    }
 
@@ -3115,6 +3162,8 @@ found:
          cheevos_locals.unofficial.cheevos = NULL;
          cheevos_locals.core.count         = 0;
          cheevos_locals.unofficial.count   = 0;
+         cheevos_locals.core.program       = NULL;
+         cheevos_locals.unofficial.program = NULL;
 
          cheevos_loaded     = false;
          CORO_STOP();
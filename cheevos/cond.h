@@ -53,6 +53,18 @@ typedef struct
    cheevos_var_t       target;
 } cheevos_cond_t;
 
+typedef struct
+{
+   cheevos_cond_t *conds;
+   unsigned        count;
+} cheevos_condset_t;
+
+typedef struct
+{
+   cheevos_condset_t *condsets;
+   unsigned count;
+} cheevos_condition_t;
+
 void     cheevos_cond_parse(cheevos_cond_t* cond, const char** memaddr);
 unsigned cheevos_cond_count_in_set(const char* memaddr, unsigned which);
 void     cheevos_cond_parse_in_set(cheevos_cond_t* cond, const char* memaddr, unsigned which);
@@ -0,0 +1,659 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2015-2017 - Andre Leiradella
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+
+#include "program.h"
+
+#include "../retroarch.h"
+#include "../verbosity.h"
+
+/* Each condition set compiles to its PauseIf conditions, then the others
+ * in order, then its ResetIf conditions, and a SET_END closing it, which
+ * is the order cheevos_test_cond_set goes through them in. */
+enum
+{
+   CHEEVOS_INSN_PAUSE_IF = 0,
+   CHEEVOS_INSN_ADD_SOURCE,
+   CHEEVOS_INSN_SUB_SOURCE,
+   CHEEVOS_INSN_ADD_HITS,
+   CHEEVOS_INSN_STANDARD,
+   CHEEVOS_INSN_RESET_IF,
+   CHEEVOS_INSN_SET_END
+};
+
+enum
+{
+   CHEEVOS_OPERAND_CONST = 0,
+   /* The value read this frame */
+   CHEEVOS_OPERAND_READ,
+   /* The value read the last time the operand was evaluated */
+   CHEEVOS_OPERAND_DELTA
+};
+
+typedef struct
+{
+   uint8_t  kind;
+   uint8_t  is_bcd;
+   /* The constant, or the index of the read */
+   unsigned value;
+} cheevos_operand_t;
+
+typedef struct
+{
+   uint8_t           op;
+   uint8_t           cmp;
+   /* How far ahead the SET_END is, for PauseIf and ResetIf */
+   unsigned          skip;
+   cheevos_cond_t*   cond;
+   cheevos_operand_t source;
+   cheevos_operand_t target;
+} cheevos_insn_t;
+
+typedef struct
+{
+   unsigned first;
+   unsigned end;
+   int      single_set;
+} cheevos_trigger_t;
+
+typedef struct
+{
+   const uint8_t*     ptr;
+   int                bank_id;
+   unsigned           offset;
+   cheevos_var_size_t size;
+} cheevos_read_t;
+
+struct cheevos_program
+{
+   cheevos_insn_t*    insns;
+   cheevos_trigger_t* triggers;
+   unsigned           trigger_count;
+
+   /* Sorted by size, then address, so each size gets its own loop */
+   cheevos_read_t*    reads;
+   unsigned*          values;
+   unsigned           read_count;
+   unsigned           size_end[CHEEVOS_VAR_SIZE_THIRTYTWO_BITS + 1];
+
+   const uint8_t**    bases;
+   unsigned           bank_count;
+   /* Memory maps don't move, what the core returns for its memory may */
+   bool               fixed_bases;
+};
+
+/* Where reads from memory the core doesn't have go */
+static const uint8_t cheevos_program_zero[4] = {0};
+
+/*****************************************************************************
+Compiling
+*****************************************************************************/
+
+static bool cheevos_program_var_reads(const cheevos_var_t* var)
+{
+   return var->type == CHEEVOS_VAR_TYPE_ADDRESS
+      || var->type == CHEEVOS_VAR_TYPE_DELTA_MEM;
+}
+
+static int cheevos_program_read_cmp(const void* a_, const void* b_)
+{
+   const cheevos_read_t* a = (const cheevos_read_t*)a_;
+   const cheevos_read_t* b = (const cheevos_read_t*)b_;
+
+   if (a->size != b->size)
+      return a->size < b->size ? -1 : 1;
+   if (a->bank_id != b->bank_id)
+      return a->bank_id < b->bank_id ? -1 : 1;
+   if (a->offset != b->offset)
+      return a->offset < b->offset ? -1 : 1;
+   return 0;
+}
+
+static void cheevos_program_add_read(cheevos_program_t* program,
+      const cheevos_var_t* var)
+{
+   cheevos_read_t* read;
+
+   if (!cheevos_program_var_reads(var))
+      return;
+
+   read          = &program->reads[program->read_count++];
+   read->ptr     = NULL;
+   read->bank_id = var->bank_id;
+   read->offset  = var->value;
+   read->size    = var->size;
+}
+
+/* Sorts the reads and drops the duplicates */
+static void cheevos_program_dedup_reads(cheevos_program_t* program)
+{
+   unsigned i, count = 0;
+
+   if (!program->read_count)
+      return;
+
+   qsort(program->reads, program->read_count, sizeof(*program->reads),
+         cheevos_program_read_cmp);
+
+   for (i = 1; i < program->read_count; i++)
+      if (cheevos_program_read_cmp(&program->reads[count],
+               &program->reads[i]) != 0)
+         program->reads[++count] = program->reads[i];
+
+   program->read_count = count + 1;
+
+   for (i = 0; i < program->read_count; i++)
+      program->size_end[program->reads[i].size] = i + 1;
+
+   /* Sizes nothing reads end where the previous one did */
+   for (i = 1; i <= CHEEVOS_VAR_SIZE_THIRTYTWO_BITS; i++)
+      if (program->size_end[i] < program->size_end[i - 1])
+         program->size_end[i] = program->size_end[i - 1];
+}
+
+static void cheevos_program_operand(const cheevos_program_t* program,
+      cheevos_operand_t* operand, const cheevos_var_t* var)
+{
+   operand->is_bcd = var->is_bcd;
+
+   if (cheevos_program_var_reads(var))
+   {
+      cheevos_read_t key;
+      const cheevos_read_t* read;
+
+      key.bank_id   = var->bank_id;
+      key.offset    = var->value;
+      key.size      = var->size;
+      read          = (const cheevos_read_t*)bsearch(&key, program->reads,
+            program->read_count, sizeof(*program->reads),
+            cheevos_program_read_cmp);
+
+      operand->kind  = var->type == CHEEVOS_VAR_TYPE_DELTA_MEM
+         ? CHEEVOS_OPERAND_DELTA : CHEEVOS_OPERAND_READ;
+      operand->value = (unsigned)(read - program->reads);
+   }
+   else
+   {
+      operand->kind  = CHEEVOS_OPERAND_CONST;
+      /* Dynamic variables aren't supported and read as zero */
+      operand->value = var->type == CHEEVOS_VAR_TYPE_VALUE_COMP
+         ? var->value : 0;
+   }
+}
+
+static cheevos_insn_t* cheevos_program_emit(cheevos_program_t* program,
+      cheevos_insn_t* insn, cheevos_cond_t* cond, unsigned op)
+{
+   insn->op   = op;
+   insn->cmp  = cond->op;
+   insn->skip = 0;
+   insn->cond = cond;
+   cheevos_program_operand(program, &insn->source, &cond->source);
+   cheevos_program_operand(program, &insn->target, &cond->target);
+   return insn + 1;
+}
+
+static cheevos_insn_t* cheevos_program_compile_set(
+      cheevos_program_t* program, cheevos_insn_t* insn,
+      const cheevos_condset_t* condset)
+{
+   cheevos_cond_t* cond;
+   cheevos_insn_t* first = insn;
+   cheevos_cond_t* end   = condset->conds + condset->count;
+
+   for (cond = condset->conds; cond < end; cond++)
+      if (cond->type == CHEEVOS_COND_TYPE_PAUSE_IF)
+         insn = cheevos_program_emit(program, insn, cond,
+               CHEEVOS_INSN_PAUSE_IF);
+
+   for (cond = condset->conds; cond < end; cond++)
+   {
+      switch (cond->type)
+      {
+         case CHEEVOS_COND_TYPE_ADD_SOURCE:
+            insn = cheevos_program_emit(program, insn, cond,
+                  CHEEVOS_INSN_ADD_SOURCE);
+            break;
+         case CHEEVOS_COND_TYPE_SUB_SOURCE:
+            insn = cheevos_program_emit(program, insn, cond,
+                  CHEEVOS_INSN_SUB_SOURCE);
+            break;
+         case CHEEVOS_COND_TYPE_ADD_HITS:
+            insn = cheevos_program_emit(program, insn, cond,
+                  CHEEVOS_INSN_ADD_HITS);
+            break;
+         case CHEEVOS_COND_TYPE_STANDARD:
+            insn = cheevos_program_emit(program, insn, cond,
+                  CHEEVOS_INSN_STANDARD);
+            break;
+         default:
+            break;
+      }
+   }
+
+   for (cond = condset->conds; cond < end; cond++)
+      if (cond->type == CHEEVOS_COND_TYPE_RESET_IF)
+         insn = cheevos_program_emit(program, insn, cond,
+               CHEEVOS_INSN_RESET_IF);
+
+   memset(insn, 0, sizeof(*insn));
+   insn->op = CHEEVOS_INSN_SET_END;
+
+   for (; first < insn; first++)
+      first->skip = (unsigned)(insn - first);
+
+   return insn + 1;
+}
+
+/* Points the reads at memory, and returns whether anything moved */
+static bool cheevos_program_resolve(cheevos_program_t* program)
+{
+   unsigned i;
+   bool moved = false;
+
+   for (i = 0; i < program->bank_count; i++)
+   {
+      const uint8_t* base;
+      cheevos_var_t var;
+
+      memset(&var, 0, sizeof(var));
+      var.bank_id = (int)i;
+      base        = cheevos_var_get_memory(&var);
+
+      if (base != program->bases[i])
+      {
+         program->bases[i] = base;
+         moved             = true;
+      }
+   }
+
+   if (!moved)
+      return false;
+
+   for (i = 0; i < program->read_count; i++)
+   {
+      cheevos_read_t* read = &program->reads[i];
+      const uint8_t* base  = read->bank_id >= 0
+         ? program->bases[read->bank_id] : NULL;
+
+      read->ptr = base ? base + read->offset : cheevos_program_zero;
+   }
+
+   return true;
+}
+
+/**
+ * cheevos_program_new:
+ * @conditions         : conditions to compile, with patched addresses
+ * @count              : how many
+ *
+ * Compile conditions, which are then tested by their index.
+ *
+ * Returns: the program, or NULL if out of memory.
+ **/
+cheevos_program_t* cheevos_program_new(cheevos_condition_t** conditions,
+      unsigned count)
+{
+   unsigned i, j, k;
+   unsigned insn_count        = 0;
+   unsigned var_reads         = 0;
+   cheevos_insn_t* insn       = NULL;
+   rarch_system_info_t* system = runloop_get_system_info();
+   cheevos_program_t* program = (cheevos_program_t*)
+      calloc(1, sizeof(*program));
+
+   if (!program)
+      return NULL;
+
+   for (i = 0; i < count; i++)
+   {
+      const cheevos_condition_t* condition = conditions[i];
+
+      for (j = 0; j < condition->count; j++)
+         insn_count += condition->condsets[j].count + 1;
+   }
+
+   program->insns    = (cheevos_insn_t*)
+      calloc(insn_count + 1, sizeof(*program->insns));
+   program->triggers = (cheevos_trigger_t*)
+      calloc(count + 1, sizeof(*program->triggers));
+   program->reads    = (cheevos_read_t*)
+      calloc(insn_count * 2 + 1, sizeof(*program->reads));
+
+   if (!program->insns || !program->triggers || !program->reads)
+      goto error;
+
+   for (i = 0; i < count; i++)
+   {
+      const cheevos_condition_t* condition = conditions[i];
+
+      for (j = 0; j < condition->count; j++)
+      {
+         const cheevos_condset_t* condset = &condition->condsets[j];
+
+         for (k = 0; k < condset->count; k++)
+         {
+            cheevos_program_add_read(program, &condset->conds[k].source);
+            cheevos_program_add_read(program, &condset->conds[k].target);
+         }
+      }
+   }
+
+   var_reads = program->read_count;
+   cheevos_program_dedup_reads(program);
+
+   program->values = (unsigned*)
+      calloc(program->read_count + 1, sizeof(*program->values));
+   if (!program->values)
+      goto error;
+
+   for (i = 0; i < program->read_count; i++)
+      if (program->reads[i].bank_id >= (int)program->bank_count)
+         program->bank_count = program->reads[i].bank_id + 1;
+
+   program->bases = (const uint8_t**)
+      calloc(program->bank_count + 1, sizeof(*program->bases));
+   if (!program->bases)
+      goto error;
+
+   for (i = 0; i < program->read_count; i++)
+      program->reads[i].ptr = cheevos_program_zero;
+   cheevos_program_resolve(program);
+   program->fixed_bases = system->mmaps.num_descriptors != 0;
+
+   insn = program->insns;
+
+   for (i = 0; i < count; i++)
+   {
+      const cheevos_condition_t* condition = conditions[i];
+      cheevos_trigger_t* trigger           = &program->triggers[i];
+
+      trigger->first      = (unsigned)(insn - program->insns);
+      trigger->single_set = condition->count == 1;
+
+      for (j = 0; j < condition->count; j++)
+         insn = cheevos_program_compile_set(program, insn,
+               &condition->condsets[j]);
+
+      trigger->end        = (unsigned)(insn - program->insns);
+   }
+
+   program->trigger_count = count;
+
+   RARCH_LOG("[CHEEVOS]: compiled %u conditions into %u instructions, "
+         "%u memory reads of which %u distinct.\n",
+         count, insn_count, var_reads, program->read_count);
+
+   return program;
+
+error:
+   cheevos_program_free(program);
+   return NULL;
+}
+
+void cheevos_program_free(cheevos_program_t* program)
+{
+   if (!program)
+      return;
+
+   free(program->insns);
+   free(program->triggers);
+   free(program->reads);
+   free(program->values);
+   free((void*)program->bases);
+   free(program);
+}
+
+/*****************************************************************************
+Testing
+*****************************************************************************/
+
+/**
+ * cheevos_program_load:
+ * @program            : the program
+ *
+ * Read the memory the program looks at. Call once per frame, before
+ * testing any of its conditions.
+ **/
+void cheevos_program_load(cheevos_program_t* program)
+{
+   unsigned size, i;
+   unsigned begin              = 0;
+   const cheevos_read_t* reads = program->reads;
+   unsigned* values            = program->values;
+
+   if (!program->fixed_bases)
+      cheevos_program_resolve(program);
+
+   for (size = 0; size <= CHEEVOS_VAR_SIZE_THIRTYTWO_BITS; size++)
+   {
+      unsigned end = program->size_end[size];
+
+      switch (size)
+      {
+         case CHEEVOS_VAR_SIZE_NIBBLE_LOWER:
+            for (i = begin; i < end; i++)
+               values[i] = reads[i].ptr[0] & 0x0f;
+            break;
+         case CHEEVOS_VAR_SIZE_NIBBLE_UPPER:
+            for (i = begin; i < end; i++)
+               values[i] = (reads[i].ptr[0] >> 4) & 0x0f;
+            break;
+         case CHEEVOS_VAR_SIZE_EIGHT_BITS:
+            for (i = begin; i < end; i++)
+               values[i] = reads[i].ptr[0];
+            break;
+         case CHEEVOS_VAR_SIZE_SIXTEEN_BITS:
+            for (i = begin; i < end; i++)
+               values[i] = reads[i].ptr[0] | reads[i].ptr[1] << 8;
+            break;
+         case CHEEVOS_VAR_SIZE_THIRTYTWO_BITS:
+            for (i = begin; i < end; i++)
+               values[i] = reads[i].ptr[0]
+                  | reads[i].ptr[1] << 8
+                  | reads[i].ptr[2] << 16
+                  | (unsigned)reads[i].ptr[3] << 24;
+            break;
+         default:
+            /* CHEEVOS_VAR_SIZE_BIT_0 to CHEEVOS_VAR_SIZE_BIT_7 */
+            for (i = begin; i < end; i++)
+               values[i] = (reads[i].ptr[0] >> size) & 1;
+            break;
+      }
+
+      begin = end;
+   }
+}
+
+static INLINE unsigned cheevos_program_value(
+      const cheevos_program_t* program,
+      const cheevos_operand_t* operand, cheevos_var_t* var)
+{
+   unsigned value;
+
+   switch (operand->kind)
+   {
+      case CHEEVOS_OPERAND_READ:
+         value         = program->values[operand->value];
+         break;
+      case CHEEVOS_OPERAND_DELTA:
+         value         = var->previous;
+         var->previous = program->values[operand->value];
+         break;
+      default:
+         value         = operand->value;
+         break;
+   }
+
+   if (operand->is_bcd)
+      return (((value >> 4) & 0xf) * 10) + (value & 0xf);
+   return value;
+}
+
+static INLINE int cheevos_program_compare(const cheevos_program_t* program,
+      const cheevos_insn_t* insn, int add_buffer)
+{
+   unsigned sval = cheevos_program_value(program, &insn->source,
+         &insn->cond->source) + add_buffer;
+   unsigned tval = cheevos_program_value(program, &insn->target,
+         &insn->cond->target);
+
+   switch (insn->cmp)
+   {
+      case CHEEVOS_COND_OP_EQUALS:
+         return (sval == tval);
+      case CHEEVOS_COND_OP_LESS_THAN:
+         return (sval < tval);
+      case CHEEVOS_COND_OP_LESS_THAN_OR_EQUAL:
+         return (sval <= tval);
+      case CHEEVOS_COND_OP_GREATER_THAN:
+         return (sval > tval);
+      case CHEEVOS_COND_OP_GREATER_THAN_OR_EQUAL:
+         return (sval >= tval);
+      case CHEEVOS_COND_OP_NOT_EQUAL_TO:
+         return (sval != tval);
+      default:
+         break;
+   }
+
+   return 1;
+}
+
+/**
+ * cheevos_program_test:
+ * @program            : the program, loaded this frame
+ * @index              : which of the conditions it was made from
+ * @dirty_conds        : set to 1 if any hits changed
+ * @reset_conds        : set to 1 if a ResetIf was true
+ *
+ * Test one condition, just like cheevos_test_cheevo would.
+ *
+ * Returns: 1 if the condition is true, otherwise 0.
+ **/
+int cheevos_program_test(cheevos_program_t* program, unsigned index,
+      int* dirty_conds, int* reset_conds)
+{
+   const cheevos_trigger_t* trigger = &program->triggers[index];
+   const cheevos_insn_t* insn       = program->insns + trigger->first;
+   const cheevos_insn_t* end        = program->insns + trigger->end;
+   int ret_val                      = 0;
+   int ret_val_sub_cond             = trigger->single_set;
+   int first_set                    = 1;
+   int set_valid                    = 1;
+   int add_buffer                   = 0;
+   int add_hits                     = 0;
+
+   while (insn < end)
+   {
+      cheevos_cond_t* cond = insn->cond;
+
+      switch (insn->op)
+      {
+         case CHEEVOS_INSN_PAUSE_IF:
+            /* Reset by default, set to 1 if hit! */
+            cond->curr_hits = 0;
+
+            if (cheevos_program_compare(program, insn, add_buffer))
+            {
+               cond->curr_hits = 1;
+               *dirty_conds    = 1;
+               set_valid       = 0;
+               insn           += insn->skip;
+               continue;
+            }
+            break;
+
+         case CHEEVOS_INSN_ADD_SOURCE:
+            add_buffer += cheevos_program_value(program, &insn->source,
+                  &cond->source);
+            break;
+
+         case CHEEVOS_INSN_SUB_SOURCE:
+            add_buffer -= cheevos_program_value(program, &insn->source,
+                  &cond->source);
+            break;
+
+         case CHEEVOS_INSN_ADD_HITS:
+            if (cheevos_program_compare(program, insn, add_buffer))
+            {
+               cond->curr_hits++;
+               *dirty_conds = 1;
+            }
+
+            add_hits += cond->curr_hits;
+            break;
+
+         case CHEEVOS_INSN_STANDARD:
+         {
+            int cond_valid;
+
+            if (  (cond->req_hits != 0) &&
+                  (cond->curr_hits + add_hits) >= cond->req_hits)
+            {
+               add_buffer = 0;
+               add_hits   = 0;
+               break;
+            }
+
+            cond_valid = cheevos_program_compare(program, insn, add_buffer);
+
+            if (cond_valid)
+            {
+               cond->curr_hits++;
+               *dirty_conds = 1;
+
+               if (  (cond->req_hits != 0) &&
+                     (cond->curr_hits + add_hits) < cond->req_hits)
+                  cond_valid = 0;
+            }
+
+            add_buffer = 0;
+            add_hits   = 0;
+            set_valid &= cond_valid;
+            break;
+         }
+
+         case CHEEVOS_INSN_RESET_IF:
+            if (cheevos_program_compare(program, insn, add_buffer))
+            {
+               *reset_conds = 1;
+               set_valid    = 0;
+               insn        += insn->skip;
+               continue;
+            }
+            break;
+
+         case CHEEVOS_INSN_SET_END:
+            if (first_set)
+               ret_val = set_valid;
+            else
+               ret_val_sub_cond |= set_valid;
+
+            first_set  = 0;
+            set_valid  = 1;
+            add_buffer = 0;
+            add_hits   = 0;
+            break;
+      }
+
+      insn++;
+   }
+
+   return (ret_val && ret_val_sub_cond);
+}
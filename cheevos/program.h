@@ -0,0 +1,41 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2015-2017 - Andre Leiradella
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_CHEEVOS_PROGRAM_H
+#define __RARCH_CHEEVOS_PROGRAM_H
+
+#include "cond.h"
+
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* A set of conditions compiled into one flat array of instructions, with
+ * the memory they read resolved to pointers and each distinct read done
+ * once per frame. Hits and delta values stay in the conditions, so the
+ * rest of cheevos sees the same state as when interpreting them. */
+typedef struct cheevos_program cheevos_program_t;
+
+cheevos_program_t* cheevos_program_new(cheevos_condition_t** conditions,
+      unsigned count);
+void cheevos_program_free(cheevos_program_t* program);
+
+void cheevos_program_load(cheevos_program_t* program);
+int  cheevos_program_test(cheevos_program_t* program, unsigned index,
+      int* dirty_conds, int* reset_conds);
+
+RETRO_END_DECLS
+
+#endif /* __RARCH_CHEEVOS_PROGRAM_H */
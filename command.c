@@ -129,12 +129,25 @@ static bool command_read_ram(const char *arg);
 static bool command_write_ram(const char *arg);
 #endif
 
+#if defined(HAVE_COMMAND) && (defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING))
+static bool command_get_frame_stats(const char *arg);
+static bool command_dump_frame_trace(const char *arg);
+static bool command_trace_start(const char *arg);
+static bool command_trace_stop(const char *arg);
+#endif
+
 static const struct cmd_action_map action_map[] = {
    { "SET_SHADER",      command_set_shader,  "<shader path>" },
 #if defined(HAVE_COMMAND) && defined(HAVE_CHEEVOS)
    { "READ_CORE_RAM",   command_read_ram,    "<address> <number of bytes>" },
    { "WRITE_CORE_RAM",  command_write_ram,   "<address> <byte1> <byte2> ..." },
 #endif
+#if defined(HAVE_COMMAND) && (defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING))
+   { "GET_FRAME_STATS", command_get_frame_stats, "" },
+   { "DUMP_FRAME_TRACE", command_dump_frame_trace, "<trace path>" },
+   { "TRACE_START",     command_trace_start, "<trace path>" },
+   { "TRACE_STOP",      command_trace_stop,  "" },
+#endif
 };
 
 static const struct cmd_map map[] = {
@@ -186,7 +199,6 @@ static struct sockaddr_storage lastcmd_net_source;
 static socklen_t lastcmd_net_source_len;
 #endif
 
-#ifdef HAVE_CHEEVOS
 #if defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING)
 static bool command_reply(const char * data, size_t len)
 {
@@ -214,7 +226,6 @@ static bool command_reply(const char * data, size_t len)
    return false;
 }
 #endif
-#endif
 
 bool command_set_shader(const char *arg)
 {
@@ -314,6 +325,47 @@ static bool command_write_ram(const char *arg)
 }
 #endif
 
+#if defined(HAVE_COMMAND) && (defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING))
+static bool command_get_frame_stats(const char *arg)
+{
+   char reply[1024];
+   size_t len = strlcpy(reply, "GET_FRAME_STATS\n", sizeof(reply));
+
+   len += performance_probes_get_summary(reply + len, sizeof(reply) - len);
+   command_reply(reply, len);
+   return true;
+}
+
+static bool command_dump_frame_trace(const char *arg)
+{
+   char reply[PATH_MAX_LENGTH + 32];
+   bool ret = !string_is_empty(arg) && performance_probes_write_trace(arg);
+
+   snprintf(reply, sizeof(reply), "DUMP_FRAME_TRACE %s %s\n",
+         arg, ret ? "OK" : "-1");
+   command_reply(reply, strlen(reply));
+   return ret;
+}
+
+static bool command_trace_start(const char *arg)
+{
+   char reply[PATH_MAX_LENGTH + 32];
+   bool ret = !string_is_empty(arg) && performance_trace_start(arg);
+
+   snprintf(reply, sizeof(reply), "TRACE_START %s %s\n",
+         arg, ret ? "OK" : "-1");
+   command_reply(reply, strlen(reply));
+   return ret;
+}
+
+static bool command_trace_stop(const char *arg)
+{
+   performance_trace_stop();
+   command_reply("TRACE_STOP OK\n", 14);
+   return true;
+}
+#endif
+
 static bool command_get_arg(const char *tok,
       const char **arg, unsigned *index)
 {
@@ -339,11 +391,11 @@ static bool command_get_arg(const char *tok,
       if (str == tok)
       {
          const char *argument = str + strlen(action_map[i].str);
-         if (*argument != ' ')
+         if (*argument != ' ' && *argument != '\0')
             return false;
 
          if (arg)
-            *arg = argument + 1;
+            *arg = (*argument == ' ') ? argument + 1 : argument;
 
          if (index)
             *index = i;
@@ -159,6 +159,11 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Picks the frame delay by itself, from how long the core and the video
+ * driver have been taking, instead of using frame_delay.
+ */
+static bool frame_delay_auto = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated
  * ghosting. video_refresh_rate should still be configured as if it
@@ -556,6 +561,15 @@ static const bool netplay_use_mitm_server = false;
 
 static const char *netplay_mitm_server = "nyc";
 
+/* Send input over UDP next to the TCP connection, so a lost
+ * packet doesn't hold back the input behind it. Both sides
+ * need it enabled. */
+static const bool netplay_udp_input = false;
+
+/* Minimum amount of frames of input repeated in every UDP
+ * input datagram. */
+static const unsigned netplay_udp_redundancy = 8;
+
 #ifdef HAVE_NETWORKING
 static const unsigned netplay_share_digital = RARCH_NETPLAY_SHARE_DIGITAL_NO_PREFERENCE;
 
@@ -648,6 +662,14 @@ static const unsigned input_bind_timeout = 5;
 
 static const unsigned menu_thumbnails_default = 3;
 
+/* Memory budget of the decoded thumbnail cache, in MB.
+ * 0 disables the cache. */
+static const unsigned menu_thumbnail_cache_size = 32;
+
+/* Amount of entries above and below the selection whose
+ * thumbnails are decoded ahead of time. */
+static const unsigned menu_thumbnail_prefetch = 2;
+
 #ifdef IOS
 static const bool ui_companion_start_on_boot = false;
 #else
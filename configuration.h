@@ -74,6 +74,7 @@ typedef struct settings
       bool video_vsync;
       bool video_hard_sync;
       bool video_black_frame_insertion;
+      bool video_frame_delay_auto;
       bool video_vfilter;
       bool video_smooth;
       bool video_force_aspect;
@@ -177,6 +178,7 @@ typedef struct settings
       bool netplay_stateless_mode;
       bool netplay_nat_traversal;
       bool netplay_use_mitm_server;
+      bool netplay_udp_input;
       bool netplay_request_devices[MAX_USERS];
 
       /* Network */
@@ -319,6 +321,7 @@ typedef struct settings
       unsigned netplay_input_latency_frames_range;
       unsigned netplay_share_digital;
       unsigned netplay_share_analog;
+      unsigned netplay_udp_redundancy;
       unsigned bundle_assets_extract_version_current;
       unsigned bundle_assets_extract_last_version;
       unsigned content_history_size;
@@ -346,6 +349,8 @@ typedef struct settings
       unsigned video_msg_bgcolor_blue;
 
       unsigned menu_thumbnails;
+      unsigned menu_thumbnail_cache_size;
+      unsigned menu_thumbnail_prefetch;
       unsigned menu_dpi_override_value;
       unsigned menu_entry_normal_color;
       unsigned menu_entry_hover_color;
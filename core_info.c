@@ -15,12 +15,18 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <file/file_path.h>
 #include <lists/dir_list.h>
 #include <file/archive_file.h>
 #include <streams/file_stream.h>
+#include <features/features_cpu.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -35,8 +41,6 @@
 #include "file_path_special.h"
 #include "list_special.h"
 
-static const char *core_info_tmp_path               = NULL;
-static const struct string_list *core_info_tmp_list = NULL;
 static core_info_t *core_info_current               = NULL;
 static core_info_list_t *core_info_curr_list        = NULL;
 
@@ -81,103 +85,803 @@ static void core_info_list_resolve_all_extensions(
 #endif
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+#define CORE_INFO_CACHE_MAGIC   0x43494352 /* "RCIC" */
+#define CORE_INFO_CACHE_VERSION 1
+
+/* Binary cache of the parsed .info files, so that startup does not
+ * have to go through config_file_new() for every installed core.
+ *
+ * Layout, integers are in native byte order:
+ *
+ *   uint32 magic, uint32 version, uint32 number of entries
+ *   for each entry:
+ *     uint32 size of the rest of the entry
+ *     string path of the .info file
+ *     int32  size of the .info file
+ *     int64  modification time of the .info file
+ *     uint8  flags (CORE_INFO_CACHE_FLAG_*)
+ *     string display_name ... notes, see core_info_get_strings()
+ *     uint32 firmware count
+ *     for each firmware: string path, string desc, uint8 optional
+ *
+ * Strings are stored as a uint32 length followed by the characters
+ * and a NUL terminator. A zero length stands for NULL.
+ *
+ * Any entry whose .info file changed size or modification time is
+ * ignored and that file gets parsed again. An unreadable or
+ * mismatching cache just behaves as if it was empty. */
+
+#define CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME            (1 << 0)
+#define CORE_INFO_CACHE_FLAG_DATABASE_MATCH_ARCHIVE      (1 << 1)
+
+#define CORE_INFO_STRINGS 11
+
+typedef struct
 {
-   size_t i;
-   unsigned c;
+   const char *info_path;
+   const uint8_t *data;
+   const uint8_t *end;
+   int64_t mtime;
+   int32_t size;
+} core_info_cache_entry_t;
+
+typedef struct
+{
+   void *buf;
+   core_info_cache_entry_t *entries;
+   size_t count;
+} core_info_cache_t;
 
-   for (i = 0; i < core_info_list->count; i++)
+typedef struct
+{
+   const uint8_t *data;
+   const uint8_t *end;
+} core_info_cache_reader_t;
+
+typedef struct
+{
+   uint8_t *data;
+   size_t len;
+   size_t cap;
+   bool error;
+} core_info_cache_writer_t;
+
+/* Reverse lookup index, built once per core info list.
+ *
+ * Maps each supported extension and each database name to the set
+ * of cores listing it, stored as a bitmap over core_info_t.id, so
+ * content matching does not need to walk every core's string lists.
+ * Keys compare case-insensitively, like string_list_find_elem(). */
+
+typedef struct
+{
+   const char *key;
+   uint32_t *cores;
+   uint32_t hash;
+} core_info_index_slot_t;
+
+typedef struct
+{
+   core_info_index_slot_t *slots;
+   size_t size;
+} core_info_index_table_t;
+
+struct core_info_index
+{
+   core_info_index_table_t extensions;
+   core_info_index_table_t databases;
+   /* Cores with database_match_archive_member set */
+   uint32_t *archive_member;
+   /* Scratch bitmap for queries */
+   uint32_t *scratch;
+   /* Core ids ordered by display name */
+   unsigned *order;
+   /* Scratch copy of the list, indexed by core id */
+   core_info_t *sorted;
+   size_t words;
+};
+
+static uint32_t core_info_index_hash(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (uint8_t)tolower((uint8_t)*key++);
+
+   return hash;
+}
+
+static core_info_index_slot_t *core_info_index_find(
+      const core_info_index_table_t *table,
+      const char *key, uint32_t hash)
+{
+   size_t slot = hash & (table->size - 1);
+
+   while (table->slots[slot].key)
    {
-      unsigned count                  = 0;
-      core_info_firmware_t *firmware  = NULL;
-      core_info_t *info               = (core_info_t*)&core_info_list->list[i];
-      config_file_t *config           = (config_file_t*)info->config_data;
+      core_info_index_slot_t *entry = &table->slots[slot];
 
-      if (!config || !config_get_uint(config, "firmware_count", &count))
-         continue;
+      if (entry->hash == hash && string_is_equal_noncase(entry->key, key))
+         break;
+
+      slot = (slot + 1) & (table->size - 1);
+   }
+
+   return &table->slots[slot];
+}
+
+static const uint32_t *core_info_index_lookup(
+      const core_info_index_table_t *table, const char *key)
+{
+   if (!table->size || string_is_empty(key))
+      return NULL;
+
+   return core_info_index_find(table, key,
+         core_info_index_hash(key))->cores;
+}
+
+static bool core_info_index_table_init(core_info_index_table_t *table,
+      size_t keys)
+{
+   /* Keep the load factor at or below 1/2. */
+   size_t size = 16;
+
+   while (size < keys * 2)
+      size *= 2;
+
+   table->slots = (core_info_index_slot_t*)calloc(size, sizeof(*table->slots));
+   table->size  = table->slots ? size : 0;
+
+   return table->slots != NULL;
+}
+
+static bool core_info_index_table_add(core_info_index_table_t *table,
+      const struct string_list *list, size_t id, size_t words)
+{
+   size_t i;
 
-      firmware = (core_info_firmware_t*)calloc(count, sizeof(*firmware));
+   if (!list)
+      return true;
 
-      if (!firmware)
+   for (i = 0; i < list->size; i++)
+   {
+      const char *key               = list->elems[i].data;
+      uint32_t hash                 = 0;
+      core_info_index_slot_t *entry = NULL;
+
+      if (string_is_empty(key))
          continue;
 
-      info->firmware = firmware;
+      hash  = core_info_index_hash(key);
+      entry = core_info_index_find(table, key, hash);
 
-      for (c = 0; c < count; c++)
+      if (!entry->key)
       {
-         char path_key[64];
-         char desc_key[64];
-         char opt_key[64];
-         bool tmp_bool     = false;
-         char *tmp         = NULL;
-         path_key[0]       = desc_key[0] = opt_key[0] = '\0';
-
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
-
-         if (config_get_string(config, path_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].path = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(config, desc_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].desc = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (tmp)
-            free(tmp);
-         tmp = NULL;
-         if (config_get_bool(config, opt_key , &tmp_bool))
-            info->firmware[c].optional = tmp_bool;
+         entry->cores = (uint32_t*)calloc(words, sizeof(uint32_t));
+         if (!entry->cores)
+            return false;
+         entry->key  = key;
+         entry->hash = hash;
       }
+
+      entry->cores[id / 32] |= 1u << (id % 32);
    }
+
+   return true;
 }
 
-static void core_info_list_free(core_info_list_t *core_info_list)
+static void core_info_index_table_free(core_info_index_table_t *table)
 {
-   size_t i, j;
+   size_t i;
 
-   if (!core_info_list)
+   for (i = 0; i < table->size; i++)
+      free(table->slots[i].cores);
+   free(table->slots);
+}
+
+static void core_info_index_free(struct core_info_index *index)
+{
+   if (!index)
       return;
 
+   core_info_index_table_free(&index->extensions);
+   core_info_index_table_free(&index->databases);
+   free(index->archive_member);
+   free(index->scratch);
+   free(index->order);
+   free(index->sorted);
+   free(index);
+}
+
+static int core_info_display_name_cmp(const void *a_, const void *b_)
+{
+   const core_info_t *a = (const core_info_t*)a_;
+   const core_info_t *b = (const core_info_t*)b_;
+
+   return strcasecmp(a->display_name, b->display_name);
+}
+
+/* The keys point into the string lists of @core_info_list,
+ * which has to outlive the index. */
+static struct core_info_index *core_info_index_new(
+      const core_info_list_t *core_info_list)
+{
+   size_t i;
+   size_t num_extensions         = 0;
+   size_t num_databases          = 0;
+   struct core_info_index *index = (struct core_info_index*)
+      calloc(1, sizeof(*index));
+
+   if (!index)
+      return NULL;
+
+   index->words          = (core_info_list->count + 31) / 32;
+   index->archive_member = (uint32_t*)calloc(index->words + 1, sizeof(uint32_t));
+   index->scratch        = (uint32_t*)calloc(index->words + 1, sizeof(uint32_t));
+   index->order          = (unsigned*)calloc(core_info_list->count + 1, sizeof(unsigned));
+   index->sorted         = (core_info_t*)calloc(core_info_list->count + 1, sizeof(core_info_t));
+
+   if (!index->archive_member || !index->scratch
+         || !index->order || !index->sorted)
+      goto error;
+
+   memcpy(index->sorted, core_info_list->list,
+         core_info_list->count * sizeof(core_info_t));
+   qsort(index->sorted, core_info_list->count,
+         sizeof(core_info_t), core_info_display_name_cmp);
+
    for (i = 0; i < core_info_list->count; i++)
+      index->order[i] = index->sorted[i].id;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const core_info_t *info = &core_info_list->list[i];
+
+      if (info->supported_extensions_list)
+         num_extensions += info->supported_extensions_list->size;
+      if (info->databases_list)
+         num_databases  += info->databases_list->size;
+   }
+
+   if (     !core_info_index_table_init(&index->extensions, num_extensions)
+         || !core_info_index_table_init(&index->databases,  num_databases))
+      goto error;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const core_info_t *info = &core_info_list->list[i];
+
+      if (!core_info_index_table_add(&index->extensions,
+               info->supported_extensions_list, info->id, index->words))
+         goto error;
+      if (!core_info_index_table_add(&index->databases,
+               info->databases_list, info->id, index->words))
+         goto error;
+
+      if (info->database_match_archive_member)
+         index->archive_member[info->id / 32] |= 1u << (info->id % 32);
+   }
+
+   return index;
+
+error:
+   core_info_index_free(index);
+   return NULL;
+}
+
+/* ORs the cores supporting the extension of @path into @cores,
+ * matching @ext as well as ".@ext" in the extension lists. */
+static void core_info_index_add_supporting(
+      const struct core_info_index *index, uint32_t *cores,
+      const char *path)
+{
+   size_t i;
+   char prefixed[255];
+   const uint32_t *bits = NULL;
+   const char *ext      = path_get_extension(path);
+
+   if (string_is_empty(ext))
+      return;
+
+   prefixed[0] = '.';
+   strlcpy(prefixed + 1, ext, sizeof(prefixed) - 1);
+
+   if ((bits = core_info_index_lookup(&index->extensions, ext)))
+      for (i = 0; i < index->words; i++)
+         cores[i] |= bits[i];
+
+   if ((bits = core_info_index_lookup(&index->extensions, prefixed)))
+      for (i = 0; i < index->words; i++)
+         cores[i] |= bits[i];
+}
+
+static bool core_info_index_intersects(const uint32_t *a,
+      const uint32_t *b, size_t words)
+{
+   size_t i;
+
+   if (!a || !b)
+      return false;
+
+   for (i = 0; i < words; i++)
+      if (a[i] & b[i])
+         return true;
+
+   return false;
+}
+
+static bool core_info_index_has_core(const uint32_t *cores, size_t id)
+{
+   return (cores[id / 32] & (1u << (id % 32))) != 0;
+}
+
+static void core_info_get_strings(core_info_t *info, char **strings[])
+{
+   strings[0]  = &info->display_name;
+   strings[1]  = &info->core_name;
+   strings[2]  = &info->systemname;
+   strings[3]  = &info->system_manufacturer;
+   strings[4]  = &info->supported_extensions;
+   strings[5]  = &info->authors;
+   strings[6]  = &info->permissions;
+   strings[7]  = &info->licenses;
+   strings[8]  = &info->categories;
+   strings[9]  = &info->databases;
+   strings[10] = &info->notes;
+}
+
+static void core_info_free(core_info_t *info)
+{
+   size_t i;
+
+   free(info->path);
+   free(info->core_name);
+   free(info->systemname);
+   free(info->system_manufacturer);
+   free(info->display_name);
+   free(info->supported_extensions);
+   free(info->authors);
+   free(info->permissions);
+   free(info->licenses);
+   free(info->categories);
+   free(info->databases);
+   free(info->notes);
+   string_list_free(info->supported_extensions_list);
+   string_list_free(info->authors_list);
+   string_list_free(info->note_list);
+   string_list_free(info->permissions_list);
+   string_list_free(info->licenses_list);
+   string_list_free(info->categories_list);
+   string_list_free(info->databases_list);
+
+   for (i = 0; i < info->firmware_count; i++)
+   {
+      free(info->firmware[i].path);
+      free(info->firmware[i].desc);
+   }
+   free(info->firmware);
+
+   memset(info, 0, sizeof(*info));
+}
+
+static void core_info_resolve_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list     = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list    = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list  = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list   = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list        = string_split(info->notes, "|");
+}
+
+/* Returns the value of @key, or NULL if missing or empty.
+ * The returned string must be freed. */
+static char *core_info_config_get_string(config_file_t *conf,
+      const char *key)
+{
+   char *tmp = NULL;
+
+   if (config_get_string(conf, key, &tmp) && !string_is_empty(tmp))
+      return tmp;
+
+   free(tmp);
+   return NULL;
+}
+
+static void core_info_parse_firmware(core_info_t *info,
+      config_file_t *conf)
+{
+   unsigned c;
+   unsigned count = 0;
+
+   if (!config_get_uint(conf, "firmware_count", &count) || !count)
+      return;
+
+   info->firmware = (core_info_firmware_t*)
+      calloc(count, sizeof(*info->firmware));
+
+   if (!info->firmware)
+      return;
+
+   info->firmware_count = count;
+
+   for (c = 0; c < count; c++)
    {
-      core_info_t *info = (core_info_t*)&core_info_list->list[i];
-
-      free(info->path);
-      free(info->core_name);
-      free(info->systemname);
-      free(info->system_manufacturer);
-      free(info->display_name);
-      free(info->supported_extensions);
-      free(info->authors);
-      free(info->permissions);
-      free(info->licenses);
-      free(info->categories);
-      free(info->databases);
-      free(info->notes);
-      string_list_free(info->supported_extensions_list);
-      string_list_free(info->authors_list);
-      string_list_free(info->note_list);
-      string_list_free(info->permissions_list);
-      string_list_free(info->licenses_list);
-      string_list_free(info->categories_list);
-      string_list_free(info->databases_list);
-      config_file_free((config_file_t*)info->config_data);
-
-      for (j = 0; j < info->firmware_count; j++)
+      char path_key[64];
+      char desc_key[64];
+      char opt_key[64];
+      bool tmp_bool     = false;
+      path_key[0]       = desc_key[0] = opt_key[0] = '\0';
+
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
+
+      info->firmware[c].path = core_info_config_get_string(conf, path_key);
+      info->firmware[c].desc = core_info_config_get_string(conf, desc_key);
+
+      if (config_get_bool(conf, opt_key , &tmp_bool))
+         info->firmware[c].optional = tmp_bool;
+   }
+}
+
+static void core_info_parse_config(core_info_t *info, config_file_t *conf)
+{
+   bool tmp_bool = false;
+
+   info->display_name         = core_info_config_get_string(conf, "display_name");
+   info->core_name            = core_info_config_get_string(conf, "corename");
+   info->systemname           = core_info_config_get_string(conf, "systemname");
+   info->system_manufacturer  = core_info_config_get_string(conf, "manufacturer");
+   info->supported_extensions = core_info_config_get_string(conf, "supported_extensions");
+   info->authors              = core_info_config_get_string(conf, "authors");
+   info->permissions          = core_info_config_get_string(conf, "permissions");
+   info->licenses             = core_info_config_get_string(conf, "license");
+   info->categories           = core_info_config_get_string(conf, "categories");
+   info->databases            = core_info_config_get_string(conf, "database");
+   info->notes                = core_info_config_get_string(conf, "notes");
+
+   if (config_get_bool(conf, "supports_no_game",
+            &tmp_bool))
+      info->supports_no_game = tmp_bool;
+
+   if (config_get_bool(conf, "database_match_archive_member",
+            &tmp_bool))
+      info->database_match_archive_member = tmp_bool;
+
+   core_info_parse_firmware(info, conf);
+
+   info->has_info = true;
+}
+
+static bool core_info_cache_read(core_info_cache_reader_t *r,
+      void *out, size_t len)
+{
+   if ((size_t)(r->end - r->data) < len)
+      return false;
+
+   memcpy(out, r->data, len);
+   r->data += len;
+   return true;
+}
+
+static bool core_info_cache_read_string(core_info_cache_reader_t *r,
+      const char **out)
+{
+   uint32_t len = 0;
+
+   *out = NULL;
+
+   if (!core_info_cache_read(r, &len, sizeof(len)))
+      return false;
+
+   if (len == 0)
+      return true;
+
+   if ((size_t)(r->end - r->data) <= len || r->data[len] != '\0')
+      return false;
+
+   *out     = (const char*)r->data;
+   r->data += len + 1;
+   return true;
+}
+
+static char *core_info_cache_strdup(const char *s)
+{
+   return s ? strdup(s) : NULL;
+}
+
+/* Fills @info from a cache entry. On failure @info may be
+ * partially filled and has to be released with core_info_free(). */
+static bool core_info_cache_read_info(
+      const core_info_cache_entry_t *entry, core_info_t *info)
+{
+   unsigned i;
+   char **strings[CORE_INFO_STRINGS];
+   const char *values[CORE_INFO_STRINGS];
+   uint8_t flags                = 0;
+   uint32_t firmware_count      = 0;
+   core_info_cache_reader_t r;
+
+   r.data = entry->data;
+   r.end  = entry->end;
+
+   if (!core_info_cache_read(&r, &flags, sizeof(flags)))
+      return false;
+
+   for (i = 0; i < CORE_INFO_STRINGS; i++)
+      if (!core_info_cache_read_string(&r, &values[i]))
+         return false;
+
+   if (!core_info_cache_read(&r, &firmware_count, sizeof(firmware_count)))
+      return false;
+
+   /* Every firmware takes at least two string lengths
+    * and the optional flag. */
+   if (firmware_count > (size_t)(r.end - r.data) / 9)
+      return false;
+
+   core_info_get_strings(info, strings);
+   for (i = 0; i < CORE_INFO_STRINGS; i++)
+      *strings[i] = core_info_cache_strdup(values[i]);
+
+   info->supports_no_game              =
+      !!(flags & CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME);
+   info->database_match_archive_member =
+      !!(flags & CORE_INFO_CACHE_FLAG_DATABASE_MATCH_ARCHIVE);
+
+   if (firmware_count)
+   {
+      info->firmware = (core_info_firmware_t*)
+         calloc(firmware_count, sizeof(*info->firmware));
+
+      if (!info->firmware)
+         return false;
+
+      for (i = 0; i < firmware_count; i++)
+      {
+         const char *path = NULL;
+         const char *desc = NULL;
+         uint8_t optional = 0;
+
+         if (     !core_info_cache_read_string(&r, &path)
+               || !core_info_cache_read_string(&r, &desc)
+               || !core_info_cache_read(&r, &optional, sizeof(optional)))
+            return false;
+
+         info->firmware[i].path     = core_info_cache_strdup(path);
+         info->firmware[i].desc     = core_info_cache_strdup(desc);
+         info->firmware[i].optional = optional != 0;
+         info->firmware_count       = i + 1;
+      }
+   }
+
+   info->has_info = true;
+   return true;
+}
+
+static int core_info_cache_entry_cmp(const void *a_, const void *b_)
+{
+   const core_info_cache_entry_t *a = (const core_info_cache_entry_t*)a_;
+   const core_info_cache_entry_t *b = (const core_info_cache_entry_t*)b_;
+
+   return strcmp(a->info_path, b->info_path);
+}
+
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   free(cache->entries);
+   free(cache->buf);
+   memset(cache, 0, sizeof(*cache));
+}
+
+static bool core_info_cache_load(core_info_cache_t *cache,
+      const char *path)
+{
+   size_t i;
+   uint32_t magic              = 0;
+   uint32_t version            = 0;
+   uint32_t count              = 0;
+   ssize_t len                 = 0;
+   core_info_cache_reader_t r;
+
+   memset(cache, 0, sizeof(*cache));
+
+   if (!path_is_valid(path)
+         || !filestream_read_file(path, &cache->buf, &len)
+         || len <= 0)
+      goto error;
+
+   r.data = (const uint8_t*)cache->buf;
+   r.end  = r.data + len;
+
+   if (     !core_info_cache_read(&r, &magic,   sizeof(magic))
+         || !core_info_cache_read(&r, &version, sizeof(version))
+         || !core_info_cache_read(&r, &count,   sizeof(count))
+         || magic   != CORE_INFO_CACHE_MAGIC
+         || version != CORE_INFO_CACHE_VERSION
+         || count   >  (size_t)(r.end - r.data) / sizeof(uint32_t))
+      goto error;
+
+   if (!count)
+      return true;
+
+   cache->entries = (core_info_cache_entry_t*)
+      calloc(count, sizeof(*cache->entries));
+
+   if (!cache->entries)
+      goto error;
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t entry_len               = 0;
+      core_info_cache_entry_t *entry   = &cache->entries[i];
+      core_info_cache_reader_t sub;
+
+      if (     !core_info_cache_read(&r, &entry_len, sizeof(entry_len))
+            || (size_t)(r.end - r.data) < entry_len)
+         goto error;
+
+      sub.data = r.data;
+      sub.end  = r.data + entry_len;
+      r.data   = sub.end;
+
+      if (     !core_info_cache_read_string(&sub, &entry->info_path)
+            || !entry->info_path
+            || !core_info_cache_read(&sub, &entry->size,  sizeof(entry->size))
+            || !core_info_cache_read(&sub, &entry->mtime, sizeof(entry->mtime)))
+         goto error;
+
+      entry->data = sub.data;
+      entry->end  = sub.end;
+   }
+
+   cache->count = count;
+
+   qsort(cache->entries, cache->count,
+         sizeof(*cache->entries), core_info_cache_entry_cmp);
+
+   return true;
+
+error:
+   core_info_cache_free(cache);
+   return false;
+}
+
+static const core_info_cache_entry_t *core_info_cache_find(
+      const core_info_cache_t *cache, const char *info_path)
+{
+   core_info_cache_entry_t key;
+
+   if (!cache->count)
+      return NULL;
+
+   key.info_path = info_path;
+
+   return (const core_info_cache_entry_t*)bsearch(&key,
+         cache->entries, cache->count,
+         sizeof(*cache->entries), core_info_cache_entry_cmp);
+}
+
+static void core_info_cache_write(core_info_cache_writer_t *w,
+      const void *data, size_t len)
+{
+   if (w->error)
+      return;
+
+   if (w->len + len > w->cap)
+   {
+      uint8_t *tmp = NULL;
+      size_t   cap = w->cap ? w->cap : 16 * 1024;
+
+      while (cap < w->len + len)
+         cap *= 2;
+
+      tmp = (uint8_t*)realloc(w->data, cap);
+
+      if (!tmp)
       {
-         free(info->firmware[j].path);
-         free(info->firmware[j].desc);
+         w->error = true;
+         return;
       }
-      free(info->firmware);
+
+      w->data = tmp;
+      w->cap  = cap;
    }
 
+   memcpy(w->data + w->len, data, len);
+   w->len += len;
+}
+
+static void core_info_cache_write_string(core_info_cache_writer_t *w,
+      const char *s)
+{
+   uint32_t len = s ? (uint32_t)strlen(s) : 0;
+
+   core_info_cache_write(w, &len, sizeof(len));
+   if (len)
+      core_info_cache_write(w, s, len + 1);
+}
+
+static void core_info_cache_write_info(core_info_cache_writer_t *w,
+      const char *info_path, int32_t size, int64_t mtime,
+      core_info_t *info)
+{
+   unsigned i;
+   char **strings[CORE_INFO_STRINGS];
+   uint32_t entry_len      = 0;
+   uint32_t firmware_count = (uint32_t)info->firmware_count;
+   uint8_t flags           = 0;
+   size_t start            = w->len;
+
+   if (info->supports_no_game)
+      flags |= CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME;
+   if (info->database_match_archive_member)
+      flags |= CORE_INFO_CACHE_FLAG_DATABASE_MATCH_ARCHIVE;
+
+   /* Patched below once the entry is complete. */
+   core_info_cache_write(w, &entry_len, sizeof(entry_len));
+   core_info_cache_write_string(w, info_path);
+   core_info_cache_write(w, &size,  sizeof(size));
+   core_info_cache_write(w, &mtime, sizeof(mtime));
+   core_info_cache_write(w, &flags, sizeof(flags));
+
+   core_info_get_strings(info, strings);
+   for (i = 0; i < CORE_INFO_STRINGS; i++)
+      core_info_cache_write_string(w, *strings[i]);
+
+   core_info_cache_write(w, &firmware_count, sizeof(firmware_count));
+   for (i = 0; i < firmware_count; i++)
+   {
+      uint8_t optional = info->firmware[i].optional ? 1 : 0;
+
+      core_info_cache_write_string(w, info->firmware[i].path);
+      core_info_cache_write_string(w, info->firmware[i].desc);
+      core_info_cache_write(w, &optional, sizeof(optional));
+   }
+
+   if (w->error)
+      return;
+
+   entry_len = (uint32_t)(w->len - start - sizeof(entry_len));
+   memcpy(w->data + start, &entry_len, sizeof(entry_len));
+}
+
+/* The cache only goes in the cache directory, the info
+ * directory is often read-only in system installs. */
+static bool core_info_cache_get_path(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (!settings || string_is_empty(settings->paths.directory_cache))
+      return false;
+
+   fill_pathname_join(s, settings->paths.directory_cache,
+         file_path_str(FILE_PATH_CORE_INFO_CACHE), len);
+   return true;
+}
+
+static void core_info_list_free(core_info_list_t *core_info_list)
+{
+   size_t i;
+
+   if (!core_info_list)
+      return;
+
+   core_info_index_free(core_info_list->index);
+
+   for (i = 0; i < core_info_list->count; i++)
+      core_info_free(&core_info_list->list[i]);
+
    free(core_info_list->all_ext);
    free(core_info_list->list);
    free(core_info_list);
@@ -227,6 +931,11 @@ static bool core_info_list_iterate(
 static core_info_list_t *core_info_list_new(const char *path)
 {
    size_t i;
+   uint32_t count                   = 0;
+   unsigned num_info                = 0;
+   unsigned num_cached              = 0;
+   retro_time_t start_time          = cpu_features_get_time_usec();
+   char *cache_path                 = NULL;
    core_info_t *core_info           = NULL;
    core_info_list_t *core_info_list = NULL;
    struct string_list *contents     = dir_list_new_special(
@@ -234,6 +943,11 @@ static core_info_list_t *core_info_list_new(const char *path)
    settings_t             *settings = config_get_ptr();
    const char       *path_basedir   = !string_is_empty(settings->paths.path_libretro_info) ?
       settings->paths.path_libretro_info : settings->paths.directory_libretro;
+   core_info_cache_t cache;
+   core_info_cache_writer_t writer;
+
+   memset(&cache,  0, sizeof(cache));
+   memset(&writer, 0, sizeof(writer));
 
    if (!contents)
       return NULL;
@@ -250,8 +964,30 @@ static core_info_list_t *core_info_list_new(const char *path)
    core_info_list->list  = core_info;
    core_info_list->count = contents->size;
 
+   cache_path            = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+   if (!cache_path)
+      goto error;
+
+   if (core_info_cache_get_path(cache_path,
+            PATH_MAX_LENGTH * sizeof(char)))
+      core_info_cache_load(&cache, cache_path);
+   else
+      cache_path[0] = '\0';
+
+   /* Header, the entry count is patched in once known. */
+   {
+      uint32_t magic   = CORE_INFO_CACHE_MAGIC;
+      uint32_t version = CORE_INFO_CACHE_VERSION;
+
+      core_info_cache_write(&writer, &magic,   sizeof(magic));
+      core_info_cache_write(&writer, &version, sizeof(version));
+      core_info_cache_write(&writer, &count,   sizeof(count));
+   }
+
    for (i = 0; i < contents->size; i++)
    {
+      int32_t size          = 0;
+      int64_t mtime         = 0;
       size_t info_path_size = PATH_MAX_LENGTH * sizeof(char);
       char *info_path       = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
 
@@ -260,145 +996,43 @@ static core_info_list_t *core_info_list_new(const char *path)
       if (
             core_info_list_iterate(info_path, info_path_size,
                path_basedir, contents, i)
-            && path_is_valid(info_path))
+            && path_get_size_mtime(info_path, &size, &mtime))
       {
-         char *tmp           = NULL;
-         bool tmp_bool       = false;
-         unsigned count      = 0;
-         config_file_t *conf = config_file_new(info_path);
-
-         free(info_path);
-
-         if (!conf)
-            continue;
-
-         if (config_get_string(conf, "display_name", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].display_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(conf, "corename", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].core_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "systemname", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].systemname = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "manufacturer", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].system_manufacturer = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         config_get_uint(conf, "firmware_count", &count);
-
-         core_info[i].firmware_count = count;
-
-         if (config_get_string(conf, "supported_extensions", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].supported_extensions      = strdup(tmp);
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "authors", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].authors      = strdup(tmp);
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "permissions", &tmp)
-               && !string_is_empty(tmp))
+         const core_info_cache_entry_t *entry =
+            core_info_cache_find(&cache, info_path);
+
+         if (     entry
+               && entry->size  == size
+               && entry->mtime == mtime
+               && core_info_cache_read_info(entry, &core_info[i]))
+            num_cached++;
+         else
          {
-            core_info[i].permissions      = strdup(tmp);
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
+            config_file_t *conf = NULL;
 
-            free(tmp);
-            tmp = NULL;
-         }
+            core_info_free(&core_info[i]);
 
-         if (config_get_string(conf, "license", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].licenses      = strdup(tmp);
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
+            conf = config_file_new(info_path);
 
-            free(tmp);
-            tmp = NULL;
+            if (conf)
+            {
+               core_info_parse_config(&core_info[i], conf);
+               config_file_free(conf);
+            }
          }
 
-         if (config_get_string(conf, "categories", &tmp)
-               && !string_is_empty(tmp))
+         if (core_info[i].has_info)
          {
-            core_info[i].categories      = strdup(tmp);
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "database", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].databases      = strdup(tmp);
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "notes", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].notes     = strdup(tmp);
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
-
-            free(tmp);
-            tmp = NULL;
+            core_info_resolve_lists(&core_info[i]);
+            core_info_cache_write_info(&writer,
+                  info_path, size, mtime, &core_info[i]);
+            num_info++;
          }
+      }
 
-         if (tmp)
-            free(tmp);
-         tmp    = NULL;
-
-         if (config_get_bool(conf, "supports_no_game",
-               &tmp_bool))
-            core_info[i].supports_no_game = tmp_bool;
-
-         if (config_get_bool(conf, "database_match_archive_member",
-               &tmp_bool))
-            core_info[i].database_match_archive_member = tmp_bool;
+      free(info_path);
 
-         core_info[i].config_data = conf;
-      }
-      else
-         free(info_path);
+      core_info[i].id = (unsigned)i;
 
       if (!string_is_empty(contents->elems[i].data))
          core_info[i].path = strdup(contents->elems[i].data);
@@ -408,16 +1042,39 @@ static core_info_list_t *core_info_list_new(const char *path)
             strdup(path_basename(core_info[i].path));
    }
 
-   if (core_info_list)
+   /* Only rewrite the cache when something was parsed
+    * or some of its entries went stale. */
+   if (     !string_is_empty(cache_path)
+         && !writer.error
+         && (num_cached != num_info || cache.count != num_info))
    {
-      core_info_list_resolve_all_extensions(core_info_list);
-      core_info_list_resolve_all_firmware(core_info_list);
+      count = num_info;
+      memcpy(writer.data + 2 * sizeof(uint32_t), &count, sizeof(count));
+
+      if (!filestream_write_file(cache_path, writer.data, writer.len))
+         RARCH_WARN("Failed to write core info cache to %s\n", cache_path);
    }
 
+   RARCH_LOG("Loaded %u core info files (%u from cache) in %u ms.\n",
+         num_info, num_cached,
+         (unsigned)((cpu_features_get_time_usec() - start_time) / 1000));
+
+   core_info_list_resolve_all_extensions(core_info_list);
+
+   core_info_list->index = core_info_index_new(core_info_list);
+   if (!core_info_list->index)
+      goto error;
+
+   core_info_cache_free(&cache);
+   free(writer.data);
+   free(cache_path);
    dir_list_free(contents);
    return core_info_list;
 
 error:
+   core_info_cache_free(&cache);
+   free(writer.data);
+   free(cache_path);
    if (contents)
       dir_list_free(contents);
    core_info_list_free(core_info_list);
@@ -452,50 +1109,6 @@ static bool core_info_list_get_info(core_info_list_t *core_info_list,
    return false;
 }
 
-static bool core_info_does_support_any_file(const core_info_t *core,
-      const struct string_list *list)
-{
-   size_t i;
-   if (!list || !core || !core->supported_extensions_list)
-      return false;
-
-   for (i = 0; i < list->size; i++)
-      if (string_list_find_elem_prefix(core->supported_extensions_list,
-               ".", path_get_extension(list->elems[i].data)))
-         return true;
-   return false;
-}
-
-static bool core_info_does_support_file(
-      const core_info_t *core, const char *path)
-{
-   if (!core || !core->supported_extensions_list)
-      return false;
-   if (string_is_empty(path))
-      return false;
-
-   return string_list_find_elem_prefix(
-         core->supported_extensions_list, ".", path_get_extension(path));
-}
-
-/* qsort_r() is not in standard C, sadly. */
-
-static int core_info_qsort_cmp(const void *a_, const void *b_)
-{
-   const core_info_t *a = (const core_info_t*)a_;
-   const core_info_t *b = (const core_info_t*)b_;
-   int support_a        =
-         core_info_does_support_any_file(a, core_info_tmp_list)
-      || core_info_does_support_file(a, core_info_tmp_path);
-   int support_b        =
-         core_info_does_support_any_file(b, core_info_tmp_list)
-      || core_info_does_support_file(b, core_info_tmp_path);
-
-   if (support_a != support_b)
-      return support_b - support_a;
-   return strcasecmp(a->display_name, b->display_name);
-}
-
 static core_info_t *core_info_find_internal(
       core_info_list_t *list,
       const char *core)
@@ -709,40 +1322,44 @@ core_info_t *core_info_get(core_info_list_t *list, size_t i)
 void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
       const char *path, const core_info_t **infos, size_t *num_infos)
 {
-   size_t i;
-   struct string_list *list = NULL;
-   size_t supported         = 0;
+   size_t i, n;
+   struct core_info_index *index = NULL;
+   struct string_list *list      = NULL;
+   size_t supported              = 0;
 
-   if (!core_info_list)
+   if (!core_info_list || !core_info_list->index)
       return;
 
-   core_info_tmp_path = path;
+   index = core_info_list->index;
+
+   memset(index->scratch, 0, index->words * sizeof(uint32_t));
+
+   if (!string_is_empty(path))
+      core_info_index_add_supporting(index, index->scratch, path);
 
 #ifdef HAVE_COMPRESSION
    if (path_is_compressed_file(path))
       list = file_archive_get_file_list(path, NULL);
-   core_info_tmp_list = list;
+
+   if (list)
+      for (i = 0; i < list->size; i++)
+         core_info_index_add_supporting(index, index->scratch,
+               list->elems[i].data);
 #endif
 
    /* Let supported core come first in list so we can return
-    * a pointer to them. */
-   qsort(core_info_list->list, core_info_list->count,
-         sizeof(core_info_t), core_info_qsort_cmp);
-
-   for (i = 0; i < core_info_list->count; i++, supported++)
-   {
-      const core_info_t *core = &core_info_list->list[i];
-
-      if (core_info_does_support_file(core, path))
-         continue;
+    * a pointer to them, both halves sorted by display name. */
+   for (i = 0; i < core_info_list->count; i++)
+      index->sorted[core_info_list->list[i].id] = core_info_list->list[i];
 
-#ifdef HAVE_COMPRESSION
-      if (core_info_does_support_any_file(core, list))
-         continue;
-#endif
+   for (i = 0; i < core_info_list->count; i++)
+      if (core_info_index_has_core(index->scratch, index->order[i]))
+         core_info_list->list[supported++] = index->sorted[index->order[i]];
 
-      break;
-   }
+   n = supported;
+   for (i = 0; i < core_info_list->count; i++)
+      if (!core_info_index_has_core(index->scratch, index->order[i]))
+         core_info_list->list[n++] = index->sorted[index->order[i]];
 
    if (list)
       string_list_free(list);
@@ -819,11 +1436,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
       return 0;
 
    for (i = 0; i < core_info_list->count; i++)
-   {
-      config_file_t *conf = (config_file_t*)
-         core_info_list->list[i].config_data;
-      num += !!conf;
-   }
+      num += core_info_list->list[i].has_info;
 
    return num;
 }
@@ -843,20 +1456,14 @@ bool core_info_database_match_archive_member(const char *database_path)
 
    path_remove_extension(database);
 
-   if (core_info_curr_list)
+   if (core_info_curr_list && core_info_curr_list->index)
    {
-      size_t i;
+      const struct core_info_index *index = core_info_curr_list->index;
 
-      for (i = 0; i < core_info_curr_list->count; i++)
+      if (core_info_index_intersects(
+               core_info_index_lookup(&index->databases, database),
+               index->archive_member, index->words))
       {
-         const core_info_t *info = &core_info_curr_list->list[i];
-
-         if (!info->database_match_archive_member)
-             continue;
-
-         if (!string_list_find_elem(info->databases_list, database))
-             continue;
-
          free(database);
          return true;
       }
@@ -883,21 +1490,16 @@ bool core_info_database_supports_content_path(const char *database_path, const c
 
    path_remove_extension(database);
 
-   if (core_info_curr_list)
+   if (core_info_curr_list && core_info_curr_list->index)
    {
-      size_t i;
+      const struct core_info_index *index = core_info_curr_list->index;
 
-      for (i = 0; i < core_info_curr_list->count; i++)
+      if (core_info_index_intersects(
+               core_info_index_lookup(&index->databases, database),
+               core_info_index_lookup(&index->extensions,
+                  path_get_extension(path)),
+               index->words))
       {
-         const core_info_t *info = &core_info_curr_list->list[i];
-
-         if (!string_list_find_elem(info->supported_extensions_list,
-                  path_get_extension(path)))
-            continue;
-
-         if (!string_list_find_elem(info->databases_list, database))
-            continue;
-
          free(database);
          return true;
       }
@@ -39,9 +39,13 @@ typedef struct
 {
    bool supports_no_game;
    bool database_match_archive_member;
+   /* Set when an .info file was found for the core. */
+   bool has_info;
+   /* Position of the core in the list when it was created,
+    * stays the same when the list gets sorted. */
+   unsigned id;
    size_t firmware_count;
    char *path;
-   void *config_data;
    char *display_name;
    char *core_name;
    char *system_manufacturer;
@@ -64,11 +68,14 @@ typedef struct
    void *userdata;
 } core_info_t;
 
+struct core_info_index;
+
 typedef struct
 {
    core_info_t *list;
    size_t count;
    char *all_ext;
+   struct core_info_index *index;
 } core_info_list_t;
 
 typedef struct core_info_ctx_firmware
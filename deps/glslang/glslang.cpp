@@ -17,16 +17,25 @@
 
 #include "glslang/glslang/Public/ShaderLang.h"
 #include "glslang/SPIRV/GlslangToSpv.h"
+#include "glslang/glslang/Include/revision.h"
 #include <vector>
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 
 #include "../../verbosity.h"
 
 using namespace glslang;
 using namespace std;
 
+/* Everything besides the source and the stage that goes
+ * into the SPIR-V put out by compile_spirv(). */
+static const int compile_default_version  = 100;
+static const EProfile compile_profile     = ENoProfile;
+static const EShMessages compile_messages = static_cast<EShMessages>(
+      EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
+
 struct SlangProcess
 {
    public:
@@ -355,18 +364,18 @@ bool glslang::compile_spirv(const string &source, Stage stage, std::vector<uint3
    const char *src = source.c_str();
    shader.setStrings(&src, 1);
 
-   EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
+   EShMessages messages = compile_messages;
 
    string msg;
    auto forbid_include = TShader::ForbidInclude();
-   if (!shader.preprocess(&process.GetResources(), 100, ENoProfile, false, false,
+   if (!shader.preprocess(&process.GetResources(), compile_default_version, compile_profile, false, false,
             messages, &msg, forbid_include))
    {
       fprintf(stderr, "%s\n", msg.c_str());
       return false;
    }
 
-   if (!shader.parse(&process.GetResources(), 100, false, messages))
+   if (!shader.parse(&process.GetResources(), compile_default_version, false, messages))
    {
       RARCH_ERR("%s\n", shader.getInfoLog());
       RARCH_ERR("%s\n", shader.getInfoDebugLog());
@@ -386,3 +395,16 @@ bool glslang::compile_spirv(const string &source, Stage stage, std::vector<uint3
    return true;
 }
 
+string glslang::get_compiler_id()
+{
+   char buf[256];
+   string spirv_version;
+
+   GetSpirvVersion(spirv_version);
+   snprintf(buf, sizeof(buf), "glslang %s (%s), SPIR-V %s, tool %d, "
+         "version %d, profile %d, messages 0x%x",
+         GLSLANG_REVISION, GLSLANG_DATE, spirv_version.c_str(),
+         GetKhronosToolId(), compile_default_version,
+         (int)compile_profile, (unsigned)compile_messages);
+   return buf;
+}
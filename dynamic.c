@@ -1692,6 +1692,21 @@ bool rarch_environment_cb(unsigned cmd, void *data)
             ledintf->set_led_state = led_driver_set_led;
       }
       break;
+
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+      {
+         int result = 1 | 2; /* video | audio */
+
+#ifdef HAVE_NETWORKING
+         /* Netplay replays throw away everything the core outputs */
+         if (netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_REPLAYING, NULL))
+            result = 0;
+#endif
+
+         if (data)
+            *(int*)data = result;
+      }
+      break;
       
       default:
          RARCH_LOG("Environ UNSUPPORTED (#%u).\n", cmd);
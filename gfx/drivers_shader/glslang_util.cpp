@@ -20,8 +20,12 @@
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
+#include <lists/dir_list.h>
 #include <lists/string_list.h>
 #include <string/stdstring.h>
 
@@ -33,6 +37,8 @@
 #if defined(HAVE_GLSLANG) && !defined(HAVE_GRIFFIN)
 #include "glslang.hpp"
 #endif
+#include "../../configuration.h"
+#include "../../paths.h"
 #include "../../verbosity.h"
 
 using namespace std;
@@ -370,11 +376,252 @@ bool glslang_parse_meta(const vector<string> &lines, glslang_meta *meta)
 
 
 #if defined(HAVE_GLSLANG) && !defined(HAVE_GRIFFIN)
+#define GLSLANG_CACHE_MAGIC    0x43535352 /* "RSSC" */
+#define GLSLANG_CACHE_VERSION  1
+#define GLSLANG_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+/* On-disk cache of compiled SPIR-V, so that presets don't go
+ * through glslang again on every launch or core switch.
+ *
+ * Entries are named after a hash of the source of both stages,
+ * with all includes already resolved, so any change to any file
+ * a shader pulls in makes for a new entry. The glslang revision
+ * and compile options go into the hash too, so a glslang update
+ * doesn't load SPIR-V built by the old one. Layout, integers are
+ * in native byte order:
+ *
+ *   uint32 magic, uint32 version, uint64 source hash,
+ *   uint32 vertex words, uint32 fragment words,
+ *   uint32 crc32 of the words, then the vertex and fragment words
+ *
+ * Entries that don't check out are deleted and recompiled. Once
+ * the cache grows past GLSLANG_CACHE_MAX_SIZE, the oldest entries
+ * go first. */
+
+struct glslang_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint64_t hash;
+   uint32_t vertex_size;
+   uint32_t fragment_size;
+   uint32_t crc;
+};
+
+static uint64_t glslang_cache_hash_string(uint64_t hash, const string &s)
+{
+   size_t i;
+
+   /* FNV-1a */
+   for (i = 0; i < s.size(); i++)
+      hash = (hash ^ (uint8_t)s[i]) * 0x100000001b3ULL;
+   /* Keep the boundary to the next string significant. */
+   return (hash ^ 0xff) * 0x100000001b3ULL;
+}
+
+static uint64_t glslang_cache_hash(const string &vertex,
+      const string &fragment)
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   hash = glslang_cache_hash_string(hash, glslang::get_compiler_id());
+   hash = (hash ^ glslang::StageVertex) * 0x100000001b3ULL;
+   hash = glslang_cache_hash_string(hash, vertex);
+   hash = (hash ^ glslang::StageFragment) * 0x100000001b3ULL;
+   hash = glslang_cache_hash_string(hash, fragment);
+
+   return hash;
+}
+
+static bool glslang_cache_get_dir(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+   char *dir            = NULL;
+
+   if (settings && !string_is_empty(settings->paths.directory_cache))
+      fill_pathname_join(s, settings->paths.directory_cache, "slang", len);
+   else if (!path_is_empty(RARCH_PATH_CONFIG))
+   {
+      dir = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+      if (!dir)
+         return false;
+      fill_pathname_basedir(dir, path_get(RARCH_PATH_CONFIG),
+            PATH_MAX_LENGTH * sizeof(char));
+      fill_pathname_join(s, dir, "slang-cache", len);
+      free(dir);
+   }
+   else
+      return false;
+
+   return path_is_directory(s) || path_mkdir(s);
+}
+
+static void glslang_cache_get_path(char *s, size_t len,
+      const char *dir, uint64_t hash)
+{
+   char name[32];
+
+   snprintf(name, sizeof(name), "%08x%08x.spv",
+         (unsigned)(hash >> 32), (unsigned)(hash & 0xffffffff));
+   fill_pathname_join(s, dir, name, len);
+}
+
+static bool glslang_cache_load(const char *path, uint64_t hash,
+      glslang_output *output)
+{
+   struct glslang_cache_header header;
+   ssize_t len       = 0;
+   void *buf         = NULL;
+   const uint32_t *words;
+   size_t size;
+
+   if (!filestream_exists(path))
+      return false;
+
+   if (!filestream_read_file(path, &buf, &len))
+      return false;
+
+   if ((size_t)len < sizeof(header))
+      goto error;
+
+   memcpy(&header, buf, sizeof(header));
+   size = ((size_t)header.vertex_size + header.fragment_size)
+      * sizeof(uint32_t);
+
+   if (     header.magic   != GLSLANG_CACHE_MAGIC
+         || header.version != GLSLANG_CACHE_VERSION
+         || header.hash    != hash
+         || header.vertex_size == 0
+         || header.fragment_size == 0
+         || (size_t)len != sizeof(header) + size)
+      goto error;
+
+   words = (const uint32_t*)((const uint8_t*)buf + sizeof(header));
+
+   if (encoding_crc32(0, (const uint8_t*)words, size) != header.crc)
+      goto error;
+
+   output->vertex.assign(words, words + header.vertex_size);
+   output->fragment.assign(words + header.vertex_size,
+         words + header.vertex_size + header.fragment_size);
+
+   free(buf);
+   return true;
+
+error:
+   RARCH_WARN("[slang]: Discarding bad cache entry \"%s\".\n", path);
+   free(buf);
+   filestream_delete(path);
+   return false;
+}
+
+struct glslang_cache_entry
+{
+   string path;
+   int64_t mtime;
+   int32_t size;
+};
+
+static bool glslang_cache_entry_older(const glslang_cache_entry &a,
+      const glslang_cache_entry &b)
+{
+   return a.mtime < b.mtime;
+}
+
+static void glslang_cache_evict(const char *dir)
+{
+   size_t i;
+   size_t total                     = 0;
+   vector<glslang_cache_entry> entries;
+   struct string_list *list         = dir_list_new(dir, "spv",
+         false, false, false, false);
+
+   if (!list)
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      glslang_cache_entry entry;
+
+      entry.path  = list->elems[i].data;
+      entry.mtime = 0;
+      entry.size  = 0;
+
+      if (!path_get_size_mtime(list->elems[i].data,
+               &entry.size, &entry.mtime))
+         continue;
+
+      total += entry.size;
+      entries.push_back(entry);
+   }
+
+   string_list_free(list);
+
+   if (total <= GLSLANG_CACHE_MAX_SIZE)
+      return;
+
+   sort(entries.begin(), entries.end(), glslang_cache_entry_older);
+
+   /* Leave some room, so that this doesn't run on every store. */
+   for (i = 0; i < entries.size() && total > GLSLANG_CACHE_MAX_SIZE / 4 * 3; i++)
+   {
+      if (filestream_delete(entries[i].path.c_str()) == 0)
+         total -= entries[i].size;
+   }
+}
+
+static void glslang_cache_store(const char *dir, const char *path,
+      uint64_t hash, const glslang_output *output)
+{
+   struct glslang_cache_header header;
+   char *tmp_path      = NULL;
+   size_t vertex_len   = output->vertex.size()   * sizeof(uint32_t);
+   size_t fragment_len = output->fragment.size() * sizeof(uint32_t);
+   vector<uint8_t> buf(sizeof(header) + vertex_len + fragment_len);
+
+   memset(&header, 0, sizeof(header));
+   header.magic         = GLSLANG_CACHE_MAGIC;
+   header.version       = GLSLANG_CACHE_VERSION;
+   header.hash          = hash;
+   header.vertex_size   = (uint32_t)output->vertex.size();
+   header.fragment_size = (uint32_t)output->fragment.size();
+
+   memcpy(&buf[sizeof(header)], output->vertex.data(), vertex_len);
+   memcpy(&buf[sizeof(header) + vertex_len],
+         output->fragment.data(), fragment_len);
+
+   header.crc           = encoding_crc32(0,
+         &buf[sizeof(header)], vertex_len + fragment_len);
+   memcpy(&buf[0], &header, sizeof(header));
+
+   /* Write then rename, so that a concurrent load
+    * never sees a partial entry. */
+   tmp_path = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+   if (!tmp_path)
+      return;
+
+   strlcpy(tmp_path, path, PATH_MAX_LENGTH * sizeof(char));
+   strlcat(tmp_path, ".tmp", PATH_MAX_LENGTH * sizeof(char));
+
+   if (filestream_write_file(tmp_path, buf.data(), buf.size()))
+   {
+      filestream_delete(path);
+      if (filestream_rename(tmp_path, path) != 0)
+         filestream_delete(tmp_path);
+   }
+
+   free(tmp_path);
+
+   glslang_cache_evict(dir);
+}
+
 bool glslang_compile_shader(const char *shader_path, glslang_output *output)
 {
    vector<string> lines;
-
-   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+   char *cache_dir  = NULL;
+   char *cache_path = NULL;
+   uint64_t hash    = 0;
+   retro_time_t start;
 
    if (!glslang_read_shader_file(shader_path, &lines, true))
       return false;
@@ -382,21 +629,69 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(lines, &output->meta))
       return false;
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "vertex"),
+   start                = cpu_features_get_time_usec();
+
+   string vertex_source   = build_stage_source(lines, "vertex");
+   string fragment_source = build_stage_source(lines, "fragment");
+
+   cache_dir  = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+   cache_path = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+
+   if (cache_dir && cache_path &&
+         glslang_cache_get_dir(cache_dir, PATH_MAX_LENGTH * sizeof(char)))
+   {
+      hash = glslang_cache_hash(vertex_source, fragment_source);
+      glslang_cache_get_path(cache_path, PATH_MAX_LENGTH * sizeof(char),
+            cache_dir, hash);
+
+      if (glslang_cache_load(cache_path, hash, output))
+      {
+         RARCH_LOG("[slang]: Loaded shader \"%s\" from cache (%.2f ms).\n",
+               shader_path,
+               (cpu_features_get_time_usec() - start) / 1000.0);
+         free(cache_dir);
+         free(cache_path);
+         return true;
+      }
+   }
+   else
+   {
+      free(cache_dir);
+      free(cache_path);
+      cache_dir = cache_path = NULL;
+   }
+
+   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+
+   if (    !glslang::compile_spirv(vertex_source,
             glslang::StageVertex, &output->vertex))
    {
       RARCH_ERR("Failed to compile vertex shader stage.\n");
-      return false;
+      goto error;
    }
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "fragment"),
+   if (    !glslang::compile_spirv(fragment_source,
             glslang::StageFragment, &output->fragment))
    {
       RARCH_ERR("Failed to compile fragment shader stage.\n");
-      return false;
+      goto error;
    }
 
+   RARCH_LOG("[slang]: Compiled shader \"%s\" in %.2f ms (%s).\n",
+         shader_path, (cpu_features_get_time_usec() - start) / 1000.0,
+         cache_path ? "cache miss" : "no cache directory");
+
+   if (cache_path)
+      glslang_cache_store(cache_dir, cache_path, hash, output);
+
+   free(cache_dir);
+   free(cache_path);
    return true;
+
+error:
+   free(cache_dir);
+   free(cache_path);
+   return false;
 }
 #else
 bool glslang_compile_shader(const char *shader_path, glslang_output *output)
@@ -63,6 +63,7 @@
 #include "../core.h"
 #include "../command.h"
 #include "../msg_hash.h"
+#include "../performance_counters.h"
 #include "../verbosity.h"
 
 #define MEASURE_FRAME_TIME_SAMPLES_COUNT (2 * 1024)
@@ -71,6 +72,18 @@
 
 #define FPS_UPDATE_INTERVAL 256
 
+/* Automatic frame delay: how many frames the core's run time is tracked over,
+ * how many frames it must run without overruns before the delay is raised,
+ * and before the limit set by the last overrun is lifted by 1ms, by how much
+ * a higher delay must fit before it's taken, and the slack left for
+ * scheduling */
+#define FRAME_DELAY_AUTO_WINDOW      64
+#define FRAME_DELAY_AUTO_SETTLE      120
+#define FRAME_DELAY_AUTO_RECOVER     600
+#define FRAME_DELAY_AUTO_HYSTERESIS  2
+#define FRAME_DELAY_AUTO_MARGIN_USEC 1000
+#define FRAME_DELAY_AUTO_MAX         15
+
 #ifdef HAVE_THREADS
 #define video_driver_is_threaded() ((!video_driver_is_hw_context() && video_driver_threaded) ? true : false)
 #else
@@ -163,6 +176,24 @@ static bool video_driver_window_title_update             = true;
 
 static retro_time_t video_driver_frame_time_samples[MEASURE_FRAME_TIME_SAMPLES_COUNT];
 static uint64_t video_driver_frame_time_count            = 0;
+
+/* State of the automatic frame delay. For each of the last frames it keeps
+ * how long the core ran without counting the time spent presenting, and how
+ * long presenting took, the shortest of which is about what the driver needs
+ * when it doesn't have to wait. An overrun is a frame time sample well above
+ * the refresh period, i.e. a missed vsync. */
+static struct
+{
+   retro_time_t work[FRAME_DELAY_AUTO_WINDOW];
+   retro_time_t present[FRAME_DELAY_AUTO_WINDOW];
+   retro_time_t present_time;
+   uint64_t sample_count;
+   unsigned index, samples;
+   unsigned delay, ceiling;
+   unsigned stable, calm;
+   unsigned frames, overruns;
+   bool active;
+} video_driver_frame_delay_auto;
 static uint64_t video_driver_frame_count                 = 0;
 
 static void *video_driver_data                           = NULL;
@@ -1347,6 +1378,167 @@ bool video_monitor_fps_statistics(double *refresh_rate,
 
 
 
+static void video_driver_frame_delay_reset(void)
+{
+   memset(&video_driver_frame_delay_auto, 0,
+         sizeof(video_driver_frame_delay_auto));
+   video_driver_frame_delay_auto.ceiling = FRAME_DELAY_AUTO_MAX;
+   video_driver_frame_delay_auto.active  = true;
+}
+
+/**
+ * video_driver_frame_delay:
+ *
+ * Returns: how many milliseconds to sleep before running the core, either
+ * video_frame_delay or, with video_frame_delay_auto, the delay picked from
+ * how long frames have been taking.
+ **/
+unsigned video_driver_frame_delay(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->bools.video_frame_delay_auto)
+      return settings->uints.video_frame_delay;
+
+   return video_driver_frame_delay_auto.delay;
+}
+
+/**
+ * video_driver_frame_delay_update:
+ * @run_time           : How long core_run() took, in microseconds.
+ *
+ * Feeds the automatic frame delay with the frame that just ran. The delay is
+ * lowered right away when the core no longer fits or a vsync was missed, and
+ * raised by 1ms at a time, once it's been stable for a while and there's
+ * room for more than that.
+ **/
+void video_driver_frame_delay_update(retro_time_t run_time)
+{
+   settings_t *settings = config_get_ptr();
+   float refresh_rate   = settings->floats.video_refresh_rate;
+   retro_time_t period, interval, work, work_peak, present_floor, budget;
+   unsigned i, target;
+   bool overrun         = false;
+
+   if (!settings->bools.video_frame_delay_auto)
+      return;
+
+   /* Only frames that were presented say anything */
+   if (video_driver_frame_time_count == video_driver_frame_delay_auto.sample_count)
+      return;
+
+   if (!video_driver_frame_delay_auto.active)
+      video_driver_frame_delay_reset();
+
+   if (refresh_rate <= 0.0f)
+      refresh_rate = 60.0f;
+   period   = (retro_time_t)(1000000.0f / refresh_rate);
+   interval = video_driver_frame_time_samples[
+      (video_driver_frame_time_count - 1) &
+      (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1)];
+   video_driver_frame_delay_auto.sample_count = video_driver_frame_time_count;
+
+   work = run_time - video_driver_frame_delay_auto.present_time;
+   if (work < 0)
+      work = 0;
+
+   i = video_driver_frame_delay_auto.index;
+   video_driver_frame_delay_auto.work[i]    = work;
+   video_driver_frame_delay_auto.present[i] =
+      video_driver_frame_delay_auto.present_time;
+   video_driver_frame_delay_auto.index      = (i + 1) % FRAME_DELAY_AUTO_WINDOW;
+   if (video_driver_frame_delay_auto.samples < FRAME_DELAY_AUTO_WINDOW)
+      video_driver_frame_delay_auto.samples++;
+   video_driver_frame_delay_auto.present_time = 0;
+
+   /* Much longer gaps are pauses, menus and loading, not overruns */
+   if (interval > period + period / 2 && interval < 4 * period)
+      overrun = true;
+
+   /* Decaying counts, for the overrun rate */
+   video_driver_frame_delay_auto.frames++;
+   if (overrun)
+      video_driver_frame_delay_auto.overruns++;
+   if (video_driver_frame_delay_auto.frames >= 1024)
+   {
+      video_driver_frame_delay_auto.frames   /= 2;
+      video_driver_frame_delay_auto.overruns /= 2;
+   }
+
+   if (overrun)
+   {
+      /* Back off, and don't come back here for a while */
+      if (video_driver_frame_delay_auto.delay)
+         video_driver_frame_delay_auto.delay--;
+      video_driver_frame_delay_auto.ceiling =
+         video_driver_frame_delay_auto.delay;
+      video_driver_frame_delay_auto.stable = 0;
+      video_driver_frame_delay_auto.calm   = 0;
+      return;
+   }
+
+   if (++video_driver_frame_delay_auto.calm >= FRAME_DELAY_AUTO_RECOVER)
+   {
+      video_driver_frame_delay_auto.calm = 0;
+      if (video_driver_frame_delay_auto.ceiling < FRAME_DELAY_AUTO_MAX)
+         video_driver_frame_delay_auto.ceiling++;
+   }
+
+   if (video_driver_frame_delay_auto.samples < FRAME_DELAY_AUTO_WINDOW)
+      return;
+
+   /* The largest delay the slowest recent frame would have fit with */
+   work_peak     = 0;
+   present_floor = period;
+   for (i = 0; i < FRAME_DELAY_AUTO_WINDOW; i++)
+   {
+      if (video_driver_frame_delay_auto.work[i] > work_peak)
+         work_peak = video_driver_frame_delay_auto.work[i];
+      if (video_driver_frame_delay_auto.present[i] < present_floor)
+         present_floor = video_driver_frame_delay_auto.present[i];
+   }
+
+   budget = period - work_peak - present_floor - FRAME_DELAY_AUTO_MARGIN_USEC;
+   target = (budget > 0) ? (unsigned)(budget / 1000) : 0;
+   target = MIN(target, video_driver_frame_delay_auto.ceiling);
+
+   video_driver_frame_delay_auto.stable++;
+
+   if (target < video_driver_frame_delay_auto.delay)
+   {
+      video_driver_frame_delay_auto.delay  = target;
+      video_driver_frame_delay_auto.stable = 0;
+   }
+   else if (target >= video_driver_frame_delay_auto.delay +
+            FRAME_DELAY_AUTO_HYSTERESIS &&
+         video_driver_frame_delay_auto.stable >= FRAME_DELAY_AUTO_SETTLE)
+   {
+      video_driver_frame_delay_auto.delay++;
+      video_driver_frame_delay_auto.stable = 0;
+   }
+}
+
+/**
+ * video_driver_frame_delay_stats:
+ * @delay              : Current frame delay, in milliseconds.
+ * @overrun_rate       : Recent share of frames that missed vsync.
+ *
+ * Returns: true (1) if the frame delay is picked automatically.
+ **/
+bool video_driver_frame_delay_stats(unsigned *delay, float *overrun_rate)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->bools.video_frame_delay_auto)
+      return false;
+
+   *delay        = video_driver_frame_delay_auto.delay;
+   *overrun_rate = video_driver_frame_delay_auto.frames ?
+      (float)video_driver_frame_delay_auto.overruns /
+      video_driver_frame_delay_auto.frames : 0.0f;
+   return true;
+}
+
 float video_driver_get_aspect_ratio(void)
 {
    return video_driver_aspect_ratio;
@@ -1365,15 +1557,22 @@ static bool video_driver_frame_filter(
       unsigned *output_width, unsigned *output_height,
       unsigned *output_pitch)
 {
+   retro_time_t filter_start = 0;
+
    rarch_softfilter_get_output_size(video_driver_state_filter,
          output_width, output_height, width, height);
 
    *output_pitch = (*output_width) * video_driver_state_out_bpp;
 
+   performance_probe_start(video_info->is_perfcnt_enable, filter_start);
+
    rarch_softfilter_process(video_driver_state_filter,
          video_driver_state_buffer, *output_pitch,
          data, width, height, pitch);
 
+   performance_probe_stop(video_info->is_perfcnt_enable,
+         PERF_PROBE_SOFTFILTER, filter_start);
+
    if (video_info->post_filter_record && recording_data)
       recording_dump_frame(video_driver_state_buffer,
             *output_width, *output_height, *output_pitch,
@@ -1777,6 +1976,7 @@ void video_driver_free(void)
 void video_driver_monitor_reset(void)
 {
    video_driver_frame_time_count = 0;
+   video_driver_frame_delay_reset();
 }
 
 void video_driver_set_aspect_ratio(void)
@@ -2365,6 +2565,9 @@ void video_driver_frame(const void *data, unsigned width,
    unsigned output_height                            = 0;
    unsigned output_pitch                             = 0;
    const char *msg                                   = NULL;
+   unsigned frame_delay                              = 0;
+   float overrun_rate                                = 0.0f;
+   retro_time_t present_start                        = 0;
    retro_time_t        new_time                      =
       cpu_features_get_time_usec();
 
@@ -2456,6 +2659,17 @@ void video_driver_frame(const void *data, unsigned width,
                   "FPS: %6.1f",
                   last_fps);
          }
+
+         if (video_driver_frame_delay_stats(&frame_delay, &overrun_rate))
+         {
+            size_t len = strlen(video_info.fps_text);
+            snprintf(video_info.fps_text + len,
+                  sizeof(video_info.fps_text) - len,
+                  " || %s: %u ms, %.1f%% %s",
+                  msg_hash_to_str(MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY),
+                  frame_delay, overrun_rate * 100.0f,
+                  msg_hash_to_str(MSG_LATE_FRAMES));
+         }
       }
    }
    else
@@ -2515,16 +2729,27 @@ void video_driver_frame(const void *data, unsigned width,
 #endif
    }
 
+   performance_trace_begin("video_present");
+   present_start       = cpu_features_get_time_usec();
    video_driver_active = current_video->frame(
          video_driver_data, data, width, height,
          video_driver_frame_count,
          (unsigned)pitch, video_driver_msg, &video_info);
+   video_driver_frame_delay_auto.present_time +=
+      cpu_features_get_time_usec() - present_start;
+   performance_trace_end("video_present");
+
+   if (video_info.is_perfcnt_enable)
+      performance_probe_present();
 
    video_driver_frame_count++;
 
    /* Display the FPS, with a higher priority. */
    if (video_info.fps_show)
       runloop_msg_queue_push(video_info.fps_text, 2, 1, true);
+
+   performance_probe_stop(video_info.is_perfcnt_enable,
+         PERF_PROBE_VIDEO_FRAME, new_time);
 }
 
 void video_driver_display_type_set(enum rarch_display_type type)
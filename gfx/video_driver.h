@@ -1125,6 +1125,30 @@ void video_monitor_set_refresh_rate(float hz);
 bool video_monitor_fps_statistics(double *refresh_rate,
       double *deviation, unsigned *sample_points);
 
+/**
+ * video_driver_frame_delay:
+ *
+ * Returns: how many milliseconds to sleep before running the core.
+ **/
+unsigned video_driver_frame_delay(void);
+
+/**
+ * video_driver_frame_delay_update:
+ * @run_time           : How long core_run() took, in microseconds.
+ *
+ * Feeds the automatic frame delay with the frame that just ran.
+ **/
+void video_driver_frame_delay_update(retro_time_t run_time);
+
+/**
+ * video_driver_frame_delay_stats:
+ * @delay              : Current frame delay, in milliseconds.
+ * @overrun_rate       : Recent share of frames that missed vsync.
+ *
+ * Returns: true (1) if the frame delay is picked automatically.
+ **/
+bool video_driver_frame_delay_stats(unsigned *delay, float *overrun_rate);
+
 unsigned video_pixel_get_alignment(unsigned pitch);
 
 const video_poke_interface_t *video_driver_get_poke(void);
@@ -61,6 +61,8 @@ static void filter_thread_loop(void *data)
 {
    struct filter_thread_data *thr = (struct filter_thread_data*)data;
 
+   performance_trace_thread_begin("softfilter");
+
    for (;;)
    {
       bool die;
@@ -74,13 +76,19 @@ static void filter_thread_loop(void *data)
          break;
 
       if (thr->packet && thr->packet->work)
+      {
+         performance_trace_begin("softfilter_work");
          thr->packet->work(thr->userdata, thr->packet->thread_data);
+         performance_trace_end("softfilter_work");
+      }
 
       slock_lock(thr->lock);
       thr->done = true;
       scond_signal(thr->cond);
       slock_unlock(thr->lock);
    }
+
+   performance_trace_thread_end();
 }
 #endif
 
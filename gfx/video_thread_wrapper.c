@@ -26,6 +26,7 @@
 #include "video_thread_wrapper.h"
 #include "font_driver.h"
 
+#include "../performance_counters.h"
 #include "../retroarch.h"
 #include "../verbosity.h"
 
@@ -577,6 +578,8 @@ static void video_thread_loop(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
 
+   performance_trace_thread_begin("video");
+
    for (;;)
    {
       thread_packet_t pkt;
@@ -595,7 +598,7 @@ static void video_thread_loop(void *data)
       slock_unlock(thr->lock);
 
       if (video_thread_handle_packet(thr, &pkt))
-         return;
+         break;
 
       if (updated)
       {
@@ -612,6 +615,8 @@ static void video_thread_loop(void *data)
          vp.full_width            = 0;
          vp.full_height           = 0;
 
+         performance_trace_begin("video_thread_frame");
+
          slock_lock(thr->frame.lock);
 
          thread_update_driver_state(thr);
@@ -650,8 +655,12 @@ static void video_thread_loop(void *data)
          thr->vp            = vp;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
+
+         performance_trace_end("video_thread_frame");
       }
    }
+
+   performance_trace_thread_end();
 }
 
 static bool video_thread_alive(void *data)
@@ -156,6 +156,7 @@ ACHIEVEMENTS
 #include "../cheevos/badges.c"
 #include "../cheevos/var.c"
 #include "../cheevos/cond.c"
+#include "../cheevos/program.c"
 #endif
 
 /*============================================================
@@ -1067,12 +1068,15 @@ NETPLAY
 #ifdef HAVE_NETWORKING
 #define JSON_STATIC 1 /* must come before netplay_room_parse and jsonsax_full */
 #include "../network/netplay/netplay_delta.c"
+#include "../network/netplay/netplay_event.c"
 #include "../network/netplay/netplay_frontend.c"
 #include "../network/netplay/netplay_handshake.c"
 #include "../network/netplay/netplay_init.c"
 #include "../network/netplay/netplay_io.c"
 #include "../network/netplay/netplay_keyboard.c"
+#include "../network/netplay/netplay_stream.c"
 #include "../network/netplay/netplay_sync.c"
+#include "../network/netplay/netplay_udp.c"
 #include "../network/netplay/netplay_discovery.c"
 #include "../network/netplay/netplay_buf.c"
 #include "../network/netplay/netplay_room_parse.c"
@@ -1128,6 +1132,7 @@ MENU
 #include "../menu/menu_setting.c"
 #include "../menu/menu_cbs.c"
 #include "../menu/menu_content.c"
+#include "../menu/menu_thumbnail_cache.c"
 
 #include "../menu/menu_networking.c"
 
@@ -55,6 +55,7 @@
 #include "../file_path_special.h"
 #include "../driver.h"
 #include "../retroarch.h"
+#include "../performance_counters.h"
 #include "../movie.h"
 #include "../list_special.h"
 #include "../verbosity.h"
@@ -567,9 +568,16 @@ void input_poll(void)
    size_t i;
    settings_t *settings           = config_get_ptr();
    uint8_t max_users              = (uint8_t)input_driver_max_users;
+   bool is_perfcnt_enable         = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
+   retro_time_t poll_start        = 0;
+
+   performance_probe_start(is_perfcnt_enable, poll_start);
 
    current_input->poll(current_input_data);
 
+   performance_probe_stop(is_perfcnt_enable,
+         PERF_PROBE_INPUT_POLL, poll_start);
+
    input_driver_turbo_btns.count++;
 
    for (i = 0; i < max_users; i++)
@@ -659,6 +659,10 @@ MSG_HASH(MENU_ENUM_LABEL_NETPLAY_MODE,
       "netplay_mode")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL,
       "netplay_nat_traversal")
+MSG_HASH(MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,
+      "netplay_udp_input")
+MSG_HASH(MENU_ENUM_LABEL_NETPLAY_UDP_REDUNDANCY,
+      "netplay_udp_redundancy")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_NICKNAME,
       "netplay_nickname")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_PASSWORD,
@@ -1023,6 +1027,10 @@ MSG_HASH(MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE,
       "threaded_data_runloop_enable")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS,
       "thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE,
+      "menu_thumbnail_cache_size")
+MSG_HASH(MENU_ENUM_LABEL_THUMBNAIL_PREFETCH,
+      "menu_thumbnail_prefetch")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS_DIRECTORY,
       "thumbnails_directory")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS_UPDATER_LIST,
@@ -1111,6 +1119,8 @@ MSG_HASH(MENU_ENUM_LABEL_VIDEO_FORCE_SRGB_DISABLE,
       "video_force_srgb_disable")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_FRAME_DELAY,
       "video_frame_delay")
+MSG_HASH(MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+      "video_frame_delay_auto")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_FULLSCREEN,
       "video_fullscreen")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_GAMMA,
@@ -1135,6 +1135,10 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_TCP_UDP_PORT,
       "Netplay TCP Port")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_NAT_TRAVERSAL,
       "Netplay NAT Traversal")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_INPUT,
+      "Netplay UDP Input")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_REDUNDANCY,
+      "Netplay UDP Input Redundancy")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETWORK_CMD_ENABLE,
       "Network Commands")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETWORK_CMD_PORT,
@@ -1529,6 +1533,10 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_LAKKA_VERSION,
       "Lakka Version")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_LIBRETRODB_SUPPORT,
       "LibretroDB support")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_USAGE,
+      "Thumbnail cache usage")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_HITS,
+      "Thumbnail cache hits")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_LIBUSB_SUPPORT,
       "Libusb support")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_LIBXML2_SUPPORT,
@@ -1615,6 +1623,10 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_ENABLE,
       "Threaded tasks")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS,
       "Thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAIL_CACHE_SIZE,
+      "Thumbnail Cache Size (MB)")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAIL_PREFETCH,
+      "Thumbnail Prefetch")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS_DIRECTORY,
       "Thumbnails")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS_UPDATER_LIST,
@@ -1717,6 +1729,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FORCE_SRGB_DISABLE,
       "Force-disable sRGB FBO")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY,
       "Frame Delay")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO,
+      "Automatic Frame Delay")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FULLSCREEN,
       "Start in Fullscreen Mode")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_GAMMA,
@@ -1981,6 +1995,8 @@ MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_BLACK_FRAME_INSERTION,
       "Inserts a black frame inbetween frames. Useful for users with 120Hz screens who want to play 60Hz content to eliminate ghosting.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY,
       "Reduces latency at the cost of a higher risk of video stuttering. Adds a delay after V-Sync (in ms).")
+MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY_AUTO,
+      "Picks the frame delay from how long the core and the video driver take, lowering it when frames come late. Overrides 'Frame Delay'.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_HARD_SYNC_FRAMES,
       "Sets how many frames the CPU can run ahead of the GPU when using 'Hard GPU Sync'.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_MAX_SWAPCHAIN_IMAGES,
@@ -2191,6 +2207,8 @@ MSG_HASH(MSG_FOUND_SHADER,
       "Found shader")
 MSG_HASH(MSG_FRAMES,
       "Frames")
+MSG_HASH(MSG_LATE_FRAMES,
+      "late")
 MSG_HASH(MSG_GAME_SPECIFIC_CORE_OPTIONS_FOUND_AT,
       "Per-Game Options: game-specific core options found at")
 MSG_HASH(MSG_GOT_INVALID_DISK_INDEX,
@@ -2874,6 +2892,14 @@ MSG_HASH(
       MENU_ENUM_SUBLABEL_NETPLAY_NAT_TRAVERSAL,
       "When hosting, attempt to listen for connections from the public Internet, using UPnP or similar technologies to escape LANs."
       )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_NETPLAY_UDP_INPUT,
+      "Send input over UDP next to the TCP connection, so a lost packet doesn't hold back the input behind it. Both sides need it enabled."
+      )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_NETPLAY_UDP_REDUNDANCY,
+      "Minimum amount of frames of input repeated in every UDP input packet. Higher values ride out longer bursts of packet loss."
+      )
 MSG_HASH(
       MENU_ENUM_SUBLABEL_STDIN_CMD_ENABLE,
       "Enable stdin command interface."
@@ -2890,6 +2916,14 @@ MSG_HASH(
       MENU_ENUM_SUBLABEL_THUMBNAILS,
       "Type of thumbnail to display."
       )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_THUMBNAIL_CACHE_SIZE,
+      "Memory kept for decoded thumbnails, so scrolling back to an entry does not decode its image again. 0 disables the cache."
+      )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_THUMBNAIL_PREFETCH,
+      "Amount of entries above and below the selection whose thumbnails are decoded ahead of time."
+      )
 MSG_HASH(
       MENU_ENUM_SUBLABEL_TIMEDATE_ENABLE,
       "Shows current date and/or time inside the menu."
@@ -42,18 +42,26 @@
 #include <compat/msvc.h>
 #include <file/config_file.h>
 #include <file/file_path.h>
-#include <lists/string_list.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
 
 #define MAX_INCLUDE_DEPTH 16
 
+/* Initial size of the key index, must be a power of two. */
+#define CONFIG_INDEX_MIN_SIZE 64
+
 struct config_entry_list
 {
    /* If we got this from an #include,
     * do not allow overwrite. */
    bool readonly;
+   /* Entry and key were carved out of an arena block by the
+    * parser, and are released with it. */
+   bool in_arena;
+   /* Same for the value, which can be replaced later on. */
+   bool value_in_arena;
 
+   uint32_t hash;
    char *key;
    char *value;
    struct config_entry_list *next;
@@ -65,9 +73,123 @@ struct config_include_list
    struct config_include_list *next;
 };
 
+/* Header of a block owned by a config_file_t. The block data
+ * follows the header. Blocks hold the file contents, tokenized
+ * in place, and the entries parsed out of them, so that loading
+ * a config only takes a couple of allocations. */
+struct config_arena
+{
+   struct config_arena *next;
+};
+
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth);
 
+static uint32_t config_hash_key(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (uint8_t)*key++;
+
+   return hash;
+}
+
+/* The index is an open addressing hash table mapping each key
+ * to the first entry in conf->entries with that key, which is
+ * the one lookups have always returned. The list itself stays
+ * the source of truth for ordering and for config_file_dump(). */
+static bool config_index_grow(config_file_t *conf)
+{
+   size_t i;
+   size_t size                             = conf->index_size
+      ? conf->index_size * 2 : CONFIG_INDEX_MIN_SIZE;
+   struct config_entry_list **index        = (struct config_entry_list**)
+      calloc(size, sizeof(*index));
+
+   if (!index)
+      return false;
+
+   for (i = 0; i < conf->index_size; i++)
+   {
+      size_t slot;
+      struct config_entry_list *entry = conf->index[i];
+
+      if (!entry)
+         continue;
+
+      slot = entry->hash & (size - 1);
+      while (index[slot])
+         slot = (slot + 1) & (size - 1);
+      index[slot] = entry;
+   }
+
+   free(conf->index);
+   conf->index      = index;
+   conf->index_size = size;
+   return true;
+}
+
+static struct config_entry_list **config_index_find(
+      const config_file_t *conf, const char *key, uint32_t hash)
+{
+   size_t slot;
+
+   if (!conf->index)
+      return NULL;
+
+   slot = hash & (conf->index_size - 1);
+
+   while (conf->index[slot])
+   {
+      const struct config_entry_list *entry = conf->index[slot];
+
+      if (entry->hash == hash && string_is_equal(entry->key, key))
+         break;
+
+      slot = (slot + 1) & (conf->index_size - 1);
+   }
+
+   return &conf->index[slot];
+}
+
+/* Indexes @entry unless an earlier entry with the same key is
+ * already indexed. @entry must come after all indexed entries
+ * in the list. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   struct config_entry_list **slot = NULL;
+
+   if (!entry->key)
+      return;
+
+   /* Keep the load factor under 3/4. */
+   if ((conf->index_count + 1) * 4 > conf->index_size * 3)
+      if (!config_index_grow(conf))
+         return;
+
+   slot = config_index_find(conf, entry->key, entry->hash);
+
+   if (*slot)
+      return;
+
+   *slot = entry;
+   conf->index_count++;
+}
+
+static void config_index_rebuild(config_file_t *conf)
+{
+   struct config_entry_list *entry = NULL;
+
+   if (conf->index)
+      memset(conf->index, 0, conf->index_size * sizeof(*conf->index));
+   conf->index_count = 0;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      config_index_add(conf, entry);
+}
+
 static char *strip_comment(char *str)
 {
    /* Remove everything after comment.
@@ -94,6 +216,10 @@ static char *strip_comment(char *str)
       else if (!cut_comment && literal)
       {
          cut_comment = true;
+         /* Unterminated literal, don't run past the end
+          * of the line into the rest of the buffer. */
+         if (literal == string_end)
+            break;
          str         = literal + 1;
       }
       else
@@ -140,10 +266,52 @@ static char *extract_value(char *line, bool is_value)
       tok = strtok_r(line, " \n\t\f\r\v", &save);
 
    if (tok && *tok)
-      return strdup(tok);
+      return tok;
    return NULL;
 }
 
+static void *config_arena_alloc(config_file_t *conf, size_t size)
+{
+   struct config_arena *block = (struct config_arena*)
+      malloc(sizeof(*block) + size);
+
+   if (!block)
+      return NULL;
+
+   block->next  = conf->arena;
+   conf->arena  = block;
+
+   return block + 1;
+}
+
+/* Hands all of @src's arena blocks over to @dst, for when
+ * @dst takes over @src's entries. */
+static void config_arena_move(config_file_t *dst, config_file_t *src)
+{
+   struct config_arena *tail = src->arena;
+
+   if (!tail)
+      return;
+
+   while (tail->next)
+      tail = tail->next;
+
+   tail->next  = dst->arena;
+   dst->arena  = src->arena;
+   src->arena  = NULL;
+}
+
+static void config_entry_free(struct config_entry_list *entry)
+{
+   if (!entry->value_in_arena)
+      free(entry->value);
+   if (!entry->in_arena)
+   {
+      free(entry->key);
+      free(entry);
+   }
+}
+
 /* Move semantics? */
 static void add_child_list(config_file_t *parent, config_file_t *child)
 {
@@ -173,7 +341,13 @@ static void add_child_list(config_file_t *parent, config_file_t *child)
       parent->entries   = child->entries;
    }
 
+   /* Included entries end up after everything in the parent,
+    * so they only get indexed for keys the parent lacks. */
+   for (list = child->entries; list; list = list->next)
+      config_index_add(parent, list);
+
    child->entries = NULL;
+   config_arena_move(parent, child);
 
    /* Rebase tail. */
    if (parent->entries)
@@ -245,19 +419,14 @@ static void add_sub_conf(config_file_t *conf, char *path)
    config_file_free(sub_conf);
 }
 
+/* Parses @line in place, @list->key and @list->value
+ * end up pointing into it. */
 static bool parse_line(config_file_t *conf,
       struct config_entry_list *list, char *line)
 {
-   char *comment   = NULL;
-   char *key_tmp   = NULL;
-   size_t cur_size = 8;
-   size_t idx      = 0;
-   char *key       = (char*)malloc(9);
-
-   if (!key)
-      return false;
-
-   comment = strip_comment(line);
+   char *key     = NULL;
+   char *key_end = NULL;
+   char *comment = strip_comment(line);
 
    /* Starting line with #include includes config files. */
    if (comment == line)
@@ -274,9 +443,8 @@ static bool parse_line(config_file_t *conf,
                fprintf(stderr, "!!! #include depth exceeded for config. Might be a cycle.\n");
             else
                add_sub_conf(conf, path);
-            free(path);
          }
-         goto error;
+         return false;
       }
    }
 
@@ -284,52 +452,120 @@ static bool parse_line(config_file_t *conf,
    while (isspace((int)*line))
       line++;
 
+   key = line;
    while (isgraph((int)*line))
+      line++;
+   key_end = line;
+
+   list->value = extract_value(line, true);
+
+   if (!list->value)
+      return false;
+
+   /* Only terminate the key now, it may be
+    * immediately followed by the '='. */
+   *key_end   = '\0';
+   list->key  = key;
+   list->hash = config_hash_key(key);
+
+   return true;
+}
+
+/* Tokenizes @buf in place. @entries must have room for one
+ * entry per line of @buf. */
+static void config_file_parse(config_file_t *conf, char *buf,
+      struct config_entry_list *entries)
+{
+   struct config_entry_list *list = entries;
+
+   while (buf)
    {
-      if (idx == cur_size)
-      {
-         cur_size *= 2;
-         key_tmp = (char*)realloc(key, cur_size + 1);
+      char *line = buf;
 
-         if (!key_tmp)
-            goto error;
+      buf = strchr(buf, '\n');
+      if (buf)
+         *buf++ = '\0';
 
-         key = key_tmp;
-      }
+      if (!*line)
+         continue;
+
+      list->readonly       = false;
+      list->in_arena       = true;
+      list->value_in_arena = true;
+      list->key            = NULL;
+      list->value          = NULL;
+      list->next           = NULL;
+
+      if (!parse_line(conf, list, line))
+         continue;
+
+      if (conf->entries)
+         conf->tail->next = list;
+      else
+         conf->entries    = list;
 
-      key[idx++] = *line++;
+      conf->tail = list;
+      config_index_add(conf, list);
+      list++;
    }
-   key[idx]      = '\0';
-   list->key     = key;
+}
 
-   list->value   = extract_value(line, true);
+static bool config_file_parse_string(config_file_t *conf,
+      const char *str, size_t len)
+{
+   size_t lines                      = 1;
+   const char *nl                    = str;
+   struct config_entry_list *entries = NULL;
+   char *buf                         = NULL;
 
-   if (!list->value)
+   while ((nl = (const char*)memchr(nl, '\n', len - (nl - str))))
    {
-      list->key = NULL;
-      goto error;
+      nl++;
+      lines++;
    }
 
+   buf     = (char*)config_arena_alloc(conf, len + 1);
+   entries = (struct config_entry_list*)
+      config_arena_alloc(conf, lines * sizeof(*entries));
+
+   if (!buf || !entries)
+      return false;
+
+   memcpy(buf, str, len);
+   buf[len] = '\0';
+
+   config_file_parse(conf, buf, entries);
    return true;
+}
 
-error:
-   free(key);
-   return false;
+static void config_file_init(config_file_t *conf)
+{
+   conf->path          = NULL;
+   conf->entries       = NULL;
+   conf->tail          = NULL;
+   conf->includes      = NULL;
+   conf->include_depth = 0;
+   conf->index         = NULL;
+   conf->index_size    = 0;
+   conf->index_count   = 0;
+   conf->arena         = NULL;
 }
 
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth)
 {
-   RFILE              *file = NULL;
-   struct config_file *conf = (struct config_file*)malloc(sizeof(*conf));
+   int64_t size;
+   int64_t len;
+   size_t lines                      = 1;
+   char *buf                         = NULL;
+   char *nl                          = NULL;
+   struct config_entry_list *entries = NULL;
+   RFILE              *file          = NULL;
+   struct config_file *conf          = (struct config_file*)malloc(sizeof(*conf));
    if (!conf)
       return NULL;
 
-   conf->path          = NULL;
-   conf->entries       = NULL;
-   conf->tail          = NULL;
-   conf->includes      = NULL;
-   conf->include_depth = 0;
+   config_file_init(conf);
 
    if (!path || !*path)
       return conf;
@@ -352,48 +588,35 @@ static config_file_t *config_file_new_internal(
       goto error;
    }
 
-   while (!filestream_eof(file))
-   {
-      char *line                     = NULL;
-      struct config_entry_list *list = (struct config_entry_list*)malloc(sizeof(*list));
+   /* Read the whole file at once, it is parsed in place. */
+   size = filestream_get_size(file);
+   buf  = (size >= 0 && (int64_t)(size_t)size == size)
+      ? (char*)config_arena_alloc(conf, (size_t)size + 1) : NULL;
+   len  = buf ? filestream_read(file, buf, size) : -1;
 
-      if (!list)
-      {
-         config_file_free(conf);
-         filestream_close(file);
-         return NULL;
-      }
-
-      list->readonly  = false;
-      list->key       = NULL;
-      list->value     = NULL;
-      list->next      = NULL;
-
-      line            = filestream_getline(file);
+   filestream_close(file);
 
-      if (!line)
-      {
-         free(list);
-         continue;
-      }
+   if (len < 0)
+   {
+      config_file_free(conf);
+      return NULL;
+   }
 
-      if (*line && parse_line(conf, list, line))
-      {
-         if (conf->entries)
-            conf->tail->next = list;
-         else
-            conf->entries = list;
+   buf[len] = '\0';
 
-         conf->tail = list;
-      }
+   for (nl = buf; (nl = strchr(nl, '\n')); nl++)
+      lines++;
 
-      free(line);
+   entries = (struct config_entry_list*)
+      config_arena_alloc(conf, lines * sizeof(*entries));
 
-      if (list != conf->tail)
-         free(list);
+   if (!entries)
+   {
+      config_file_free(conf);
+      return NULL;
    }
 
-   filestream_close(file);
+   config_file_parse(conf, buf, entries);
 
    return conf;
 
@@ -413,20 +636,9 @@ void config_file_free(config_file_t *conf)
    tmp = conf->entries;
    while (tmp)
    {
-      struct config_entry_list *hold = NULL;
-      if (tmp->key)
-         free(tmp->key);
-      if (tmp->value)
-         free(tmp->value);
-
-      tmp->value = NULL;
-      tmp->key   = NULL;
-
-      hold       = tmp;
-      tmp        = tmp->next;
-
-      if (hold)
-         free(hold);
+      struct config_entry_list *hold = tmp;
+      tmp                            = tmp->next;
+      config_entry_free(hold);
    }
 
    inc_tmp = (struct config_include_list*)conf->includes;
@@ -439,8 +651,16 @@ void config_file_free(config_file_t *conf)
       free(hold);
    }
 
+   while (conf->arena)
+   {
+      struct config_arena *hold = conf->arena;
+      conf->arena               = hold->next;
+      free(hold);
+   }
+
    if (conf->path)
       free(conf->path);
+   free(conf->index);
    free(conf);
 }
 
@@ -453,8 +673,14 @@ bool config_append_file(config_file_t *conf, const char *path)
    if (new_conf->tail)
    {
       new_conf->tail->next = conf->entries;
+      if (!conf->entries)
+         conf->tail        = new_conf->tail;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+      config_arena_move(conf, new_conf);
+
+      /* The new entries come first now and take priority. */
+      config_index_rebuild(conf);
    }
 
    config_file_free(new_conf);
@@ -464,61 +690,21 @@ bool config_append_file(config_file_t *conf, const char *path)
 
 config_file_t *config_file_new_from_string(const char *from_string)
 {
-   size_t i;
-   struct string_list *lines = NULL;
    struct config_file *conf = (struct config_file*)malloc(sizeof(*conf));
    if (!conf)
       return NULL;
 
-   if (!from_string)
-      return conf;
-
-   conf->path          = NULL;
-   conf->entries       = NULL;
-   conf->tail          = NULL;
-   conf->includes      = NULL;
-   conf->include_depth = 0;
+   config_file_init(conf);
 
-   lines = string_split(from_string, "\n");
-   if (!lines)
+   if (!from_string)
       return conf;
 
-   for (i = 0; i < lines->size; i++)
+   if (!config_file_parse_string(conf, from_string, strlen(from_string)))
    {
-      struct config_entry_list *list = (struct config_entry_list*)malloc(sizeof(*list));
-      char                    *line  = lines->elems[i].data;
-
-      if (!list)
-      {
-         string_list_free(lines);
-         config_file_free(conf);
-         return NULL;
-      }
-
-      list->readonly  = false;
-      list->key       = NULL;
-      list->value     = NULL;
-      list->next      = NULL;
-
-      if (line && conf)
-      {
-         if (*line && parse_line(conf, list, line))
-         {
-            if (conf->entries)
-               conf->tail->next = list;
-            else
-               conf->entries = list;
-
-            conf->tail = list;
-         }
-      }
-
-      if (list != conf->tail)
-         free(list);
+      config_file_free(conf);
+      return NULL;
    }
 
-   string_list_free(lines);
-
    return conf;
 }
 
@@ -528,28 +714,21 @@ config_file_t *config_file_new(const char *path)
 }
 
 static struct config_entry_list *config_get_entry(const config_file_t *conf,
-      const char *key, struct config_entry_list **prev)
+      const char *key)
 {
-   struct config_entry_list *entry    = NULL;
-   struct config_entry_list *previous = prev ? *prev : NULL;
+   struct config_entry_list **slot = NULL;
 
-   for (entry = conf->entries; entry; entry = entry->next)
-   {
-      if (string_is_equal(key, entry->key))
-         return entry;
-
-      previous = entry;
-   }
+   if (!key)
+      return NULL;
 
-   if (prev)
-      *prev = previous;
+   slot = config_index_find(conf, key, config_hash_key(key));
 
-   return NULL;
+   return slot ? *slot : NULL;
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -562,7 +741,7 @@ bool config_get_double(config_file_t *conf, const char *key, double *in)
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -575,7 +754,7 @@ bool config_get_float(config_file_t *conf, const char *key, float *in)
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -595,7 +774,7 @@ bool config_get_int(config_file_t *conf, const char *key, int *in)
 #if defined(__STDC_VERSION__) && __STDC_VERSION__>=199901L
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -614,7 +793,7 @@ bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -633,7 +812,7 @@ bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -652,7 +831,7 @@ bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -668,7 +847,7 @@ bool config_get_char(config_file_t *conf, const char *key, char *in)
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -689,7 +868,7 @@ bool config_get_config_path(config_file_t *conf, char *s, size_t len)
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       return strlcpy(buf, entry->value, size) < size;
@@ -703,7 +882,7 @@ bool config_get_path(config_file_t *conf, const char *key,
    if (config_get_array(conf, key, buf, size))
       return true;
 #else
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -716,7 +895,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -737,13 +916,14 @@ bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry && !entry->readonly)
    {
-      free(entry->value);
-      entry->value = strdup(val);
+      if (!entry->value_in_arena)
+         free(entry->value);
+      entry->value          = strdup(val);
+      entry->value_in_arena = false;
       return;
    }
 
@@ -754,29 +934,39 @@ void config_set_string(config_file_t *conf, const char *key, const char *val)
    if (!entry)
       return;
 
-   entry->readonly  = false;
+   entry->readonly       = false;
+   entry->in_arena       = false;
+   entry->value_in_arena = false;
+   entry->hash      = config_hash_key(key);
    entry->key       = strdup(key);
    entry->value     = strdup(val);
    entry->next      = NULL;
 
-   if (last)
-      last->next    = entry;
+   if (conf->tail)
+      conf->tail->next = entry;
    else
-      conf->entries = entry;
+      conf->entries    = entry;
+
+   conf->tail       = entry;
+   config_index_add(conf, entry);
 }
 
 void config_unset(config_file_t *conf, const char *key)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return;
 
+   if (!entry->in_arena)
+      free(entry->key);
+   if (!entry->value_in_arena)
+      free(entry->value);
    entry->key   = NULL;
    entry->value = NULL;
-   free(entry->key);
-   free(entry->value);
+
+   /* A later entry with the same key may be visible now. */
+   config_index_rebuild(conf);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -905,16 +1095,7 @@ void config_file_dump(config_file_t *conf, FILE *file)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (string_is_equal(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
@@ -955,6 +1136,8 @@ bool config_file_exists(const char *path)
 }
 
 #if 0
+#include <time.h>
+
 static void test_config_file_parse_contains(
       const char * cfgtext,
       const char *key, const char *val)
@@ -1001,15 +1184,56 @@ static void test_config_file(void)
    test_config_file_parse_contains("foo = \"\"",     "bar", NULL);
 }
 
+/* Loads @path and looks every key in it up, plus as many misses,
+ * which is roughly what config_load_file() does on startup. */
+static void bench_config_file(const char *path)
+{
+   unsigned i;
+   size_t lookups = 0;
+   clock_t start  = clock();
+
+   for (i = 0; i < 100; i++)
+   {
+      char buf[PATH_MAX_LENGTH];
+      char miss[256];
+      struct config_file_entry entry;
+      config_file_t *conf = config_file_new(path);
+
+      if (!conf)
+         abort();
+
+      if (config_get_entry_list_head(conf, &entry))
+      {
+         do
+         {
+            snprintf(miss, sizeof(miss), "%s_x", entry.key);
+            config_get_array(conf, entry.key, buf, sizeof(buf));
+            config_get_array(conf, miss, buf, sizeof(buf));
+            lookups += 2;
+         } while (config_get_entry_list_next(&entry));
+      }
+
+      config_file_free(conf);
+   }
+
+   printf("%u loads, %u lookups: %.1f ms\n", i, (unsigned)lookups,
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+}
+
 /* compile with:
  gcc config_file.c -g -I ../include/ \
  ../streams/file_stream.c ../vfs/vfs_implementation.c ../lists/string_list.c \
  ../compat/compat_strl.c file_path.c ../compat/compat_strcasestr.c \
- && ./a.out
+ && ./a.out [retroarch.cfg]
 */
 
-int main(void)
+int main(int argc, char *argv[])
 {
-	test_config_file();
+   test_config_file();
+
+   if (argc > 1)
+      bench_config_file(argv[1]);
+
+   return 0;
 }
 #endif
@@ -20,6 +20,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -58,6 +59,10 @@
 #  include <sys/stat.h>
 #  include <dirent.h>
 #  include <unistd.h>
+#  if defined(__linux__)
+#    include <fcntl.h>
+#    include <sys/syscall.h>
+#  endif
 #endif
 
 #ifdef __CELLOS_LV2__
@@ -74,6 +79,23 @@
 #endif
 #endif
 
+#if defined(__linux__) && defined(SYS_getdents64)
+/* Read directories straight through getdents64 with a large buffer.
+ * On network shares every getdents call is a round trip, and glibc's
+ * readdir only asks for one block's worth of entries at a time. */
+#define RETRO_DIRENT_GETDENTS64
+#define RETRO_DIRENT_BUFFER_SIZE (64 * 1024)
+
+struct retro_linux_dirent64
+{
+   uint64_t d_ino;
+   int64_t d_off;
+   unsigned short d_reclen;
+   unsigned char d_type;
+   char d_name[1];
+};
+#endif
+
 struct RDIR
 {
 #if defined(_WIN32)
@@ -92,6 +114,12 @@ struct RDIR
    CellFsErrno error;
    int directory;
    CellFsDirent entry;
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   int directory;
+   int size;
+   int pos;
+   char *buf;
+   const struct retro_linux_dirent64 *entry;
 #else
    DIR *directory;
    const struct dirent *entry;
@@ -145,6 +173,18 @@ struct RDIR *retro_opendir(const char *name)
    rdir->entry     = NULL;
 #elif defined(__CELLOS_LV2__)
    rdir->error     = cellFsOpendir(name, &rdir->directory);
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   rdir->directory = open(name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   rdir->buf       = (char*)malloc(RETRO_DIRENT_BUFFER_SIZE);
+
+   if (rdir->directory >= 0 && rdir->buf)
+      return rdir;
+
+   if (rdir->directory >= 0)
+      close(rdir->directory);
+   free(rdir->buf);
+   free(rdir);
+   return NULL;
 #else
    rdir->directory = opendir(name);
    rdir->entry     = NULL;
@@ -165,6 +205,8 @@ bool retro_dirent_error(struct RDIR *rdir)
    return (rdir->directory < 0);
 #elif defined(__CELLOS_LV2__)
    return (rdir->error != CELL_FS_SUCCEEDED);
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   return (rdir->directory < 0);
 #else
    return !(rdir->directory);
 #endif
@@ -188,6 +230,23 @@ int retro_readdir(struct RDIR *rdir)
    uint64_t nread;
    rdir->error = cellFsReaddir(rdir->directory, &rdir->entry, &nread);
    return (nread != 0);
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   if (rdir->pos >= rdir->size)
+   {
+      long ret   = syscall(SYS_getdents64, rdir->directory,
+            rdir->buf, RETRO_DIRENT_BUFFER_SIZE);
+
+      rdir->pos  = 0;
+      rdir->size = ret > 0 ? (int)ret : 0;
+
+      if (ret <= 0)
+         return 0;
+   }
+
+   rdir->entry = (const struct retro_linux_dirent64*)
+      (rdir->buf + rdir->pos);
+   rdir->pos  += rdir->entry->d_reclen;
+   return 1;
 #else
    return ((rdir->entry = readdir(rdir->directory)) != NULL);
 #endif
@@ -214,6 +273,8 @@ const char *retro_dirent_get_name(struct RDIR *rdir)
    return (char*)rdir->entry.cFileName;
 #elif defined(VITA) || defined(PSP) || defined(__CELLOS_LV2__)
    return rdir->entry.d_name;
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   return rdir->entry->d_name;
 #else
 
    return rdir->entry->d_name;
@@ -246,6 +307,27 @@ bool retro_dirent_is_dir(struct RDIR *rdir, const char *path)
 #elif defined(__CELLOS_LV2__)
    CellFsDirent *entry = (CellFsDirent*)&rdir->entry;
    return (entry->d_type == CELL_FS_TYPE_DIRECTORY);
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   struct stat buf;
+   const struct retro_linux_dirent64 *entry = rdir->entry;
+   if (entry->d_type == DT_DIR)
+      return true;
+   if (!(entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK))
+      return false;
+#if defined(STATX_TYPE) && !defined(ANDROID)
+   {
+      /* Only the file type is needed, and the attributes the
+       * kernel already has cached from READDIRPLUS are good
+       * enough for that, so don't make NFS revalidate them. */
+      struct statx stx;
+      if (statx(rdir->directory, entry->d_name,
+               AT_STATX_DONT_SYNC, STATX_TYPE, &stx) == 0)
+         return S_ISDIR(stx.stx_mode);
+   }
+#endif
+   if (fstatat(rdir->directory, entry->d_name, &buf, 0) < 0)
+      return false;
+   return S_ISDIR(buf.st_mode);
 #else
    struct stat buf;
 #if defined(DT_DIR)
@@ -285,6 +367,10 @@ void retro_closedir(struct RDIR *rdir)
    sceIoDclose(rdir->directory);
 #elif defined(__CELLOS_LV2__)
    rdir->error = cellFsClosedir(rdir->directory);
+#elif defined(RETRO_DIRENT_GETDENTS64)
+   if (rdir->directory >= 0)
+      close(rdir->directory);
+   free(rdir->buf);
 #else
    if (rdir->directory)
       closedir(rdir->directory);
@@ -29,6 +29,12 @@
 #include <malloc.h>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) && !defined(MSB_FIRST)
+#include <arm_neon.h>
+#endif
+
 #include <boolean.h>
 #include <formats/image.h>
 #include <formats/rpng.h>
@@ -252,11 +258,38 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   /* 8-bit RGBA only needs R and B swapped to become ARGB. */
+   if (bpp == 1)
+   {
+#if defined(__SSE2__)
+      const __m128i mask_ag = _mm_set1_epi32((int)0xff00ff00);
+
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i px = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i ag = _mm_and_si128(px, mask_ag);
+         __m128i rb = _mm_andnot_si128(mask_ag, px);
+         rb         = _mm_or_si128(_mm_slli_epi32(rb, 16),
+               _mm_srli_epi32(rb, 16));
+         _mm_storeu_si128((__m128i*)(data + i), _mm_or_si128(ag, rb));
+      }
+#elif defined(__ARM_NEON__) && !defined(MSB_FIRST)
+      for (; i + 16 <= width; i += 16, decoded += 64)
+      {
+         uint8x16x4_t px  = vld4q_u8(decoded);
+         uint8x16_t r     = px.val[0];
+         px.val[0]        = px.val[2];
+         px.val[2]        = r;
+         vst4q_u8((uint8_t*)(data + i), px);
+      }
+#endif
+   }
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -578,44 +611,301 @@ error:
    return -1;
 }
 
-static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
-      struct rpng_process *pngp, unsigned filter)
+/* Reverse filters for a single scanline.
+ *
+ * Sub, Average and Paeth depend on the previous pixel of the
+ * line being decoded, so the SIMD versions process one pixel
+ * per step with all of its channels in parallel. They are only
+ * used for 8-bit RGB and RGBA (bpp 3 and 4), which covers
+ * practically every thumbnail and asset we load. */
+#if defined(__SSE2__)
+static INLINE __m128i png_unfilter_load_px(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v = 0;
+   memcpy(&v, p, bpp);
+   return _mm_cvtsi32_si128((int)v);
+}
+
+static INLINE void png_unfilter_store_px(uint8_t *p, __m128i v, unsigned bpp)
+{
+   uint32_t x = (uint32_t)_mm_cvtsi128_si32(v);
+   memcpy(p, &x, bpp);
+}
+
+static INLINE void png_unfilter_sub_simd(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = _mm_add_epi8(a, png_unfilter_load_px(in + i, bpp));
+      png_unfilter_store_px(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_unfilter_avg_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i one = _mm_set1_epi8(1);
+   __m128i a         = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b   = png_unfilter_load_px(prev + i, bpp);
+      /* PAVGB rounds up, PNG rounds down. */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+      a           = _mm_add_epi8(png_unfilter_load_px(in + i, bpp), avg);
+      png_unfilter_store_px(out + i, a, bpp);
+   }
+}
+
+static INLINE __m128i png_unfilter_abs16(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static INLINE __m128i png_unfilter_select(__m128i cond,
+      __m128i t, __m128i e)
+{
+   return _mm_or_si128(_mm_and_si128(cond, t), _mm_andnot_si128(cond, e));
+}
+
+static INLINE void png_unfilter_paeth_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i mask = _mm_set1_epi16(0xff);
+   __m128i a          = zero;
+   __m128i c          = zero;
+
+   /* Work in 16-bit lanes so the predictor distances can't overflow. */
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b       = _mm_unpacklo_epi8(
+            png_unfilter_load_px(prev + i, bpp), zero);
+      __m128i x       = _mm_unpacklo_epi8(
+            png_unfilter_load_px(in + i, bpp), zero);
+      __m128i pa      = _mm_sub_epi16(b, c);
+      __m128i pb      = _mm_sub_epi16(a, c);
+      __m128i pc      = _mm_add_epi16(pa, pb);
+      __m128i smallest;
+      __m128i nearest;
+
+      pa              = png_unfilter_abs16(pa);
+      pb              = png_unfilter_abs16(pb);
+      pc              = png_unfilter_abs16(pc);
+      smallest        = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+      nearest         = png_unfilter_select(_mm_cmpeq_epi16(smallest, pa),
+            a, png_unfilter_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+      a               = _mm_and_si128(_mm_add_epi16(x, nearest), mask);
+      png_unfilter_store_px(out + i, _mm_packus_epi16(a, a), bpp);
+      c               = b;
+   }
+}
+#define PNG_UNFILTER_SIMD
+#elif defined(__ARM_NEON__) && !defined(MSB_FIRST)
+static INLINE uint8x8_t png_unfilter_load_px(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v = 0;
+   memcpy(&v, p, bpp);
+   return vreinterpret_u8_u32(vdup_n_u32(v));
+}
+
+static INLINE void png_unfilter_store_px(uint8_t *p, uint8x8_t v, unsigned bpp)
+{
+   uint32_t x = vget_lane_u32(vreinterpret_u32_u8(v), 0);
+   memcpy(p, &x, bpp);
+}
+
+static INLINE void png_unfilter_sub_simd(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(a, png_unfilter_load_px(in + i, bpp));
+      png_unfilter_store_px(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_unfilter_avg_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      /* VHADD truncates, same as PNG. */
+      uint8x8_t avg = vhadd_u8(a, png_unfilter_load_px(prev + i, bpp));
+      a             = vadd_u8(png_unfilter_load_px(in + i, bpp), avg);
+      png_unfilter_store_px(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_unfilter_paeth_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      uint8x8_t b      = png_unfilter_load_px(prev + i, bpp);
+      uint16x8_t p1    = vaddl_u8(a, b);
+      uint16x8_t pc    = vabdq_u16(p1, vaddl_u8(c, c));
+      uint16x8_t pa    = vabdl_u8(b, c);
+      uint16x8_t pb    = vabdl_u8(a, c);
+      uint16x8_t pick_a;
+      uint8x8_t pick_b;
+      uint8x8_t nearest;
+
+      pick_a           = vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc));
+      pick_b           = vmovn_u16(vcleq_u16(pb, pc));
+      nearest          = vbsl_u8(pick_b, b, c);
+      nearest          = vbsl_u8(vmovn_u16(pick_a), a, nearest);
+
+      a                = vadd_u8(png_unfilter_load_px(in + i, bpp), nearest);
+      png_unfilter_store_px(out + i, a, bpp);
+      c                = b;
+   }
+}
+#define PNG_UNFILTER_SIMD
+#endif
+
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(in + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#elif defined(__ARM_NEON__) && !defined(MSB_FIRST)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
+
+static void png_unfilter_sub(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#ifdef PNG_UNFILTER_SIMD
+   if (bpp == 4)
+   {
+      png_unfilter_sub_simd(out, in, pitch, 4);
+      return;
+   }
+   if (bpp == 3)
+   {
+      png_unfilter_sub_simd(out, in, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = out[i - bpp] + in[i];
+}
+
+static void png_unfilter_avg(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#ifdef PNG_UNFILTER_SIMD
+   if (bpp == 4)
+   {
+      png_unfilter_avg_simd(out, in, prev, pitch, 4);
+      return;
+   }
+   if (bpp == 3)
+   {
+      png_unfilter_avg_simd(out, in, prev, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+   {
+      uint8_t avg = prev[i] >> 1;
+      out[i]      = avg + in[i];
+   }
+   for (i = bpp; i < pitch; i++)
+   {
+      uint8_t avg = (out[i - bpp] + prev[i]) >> 1;
+      out[i]      = avg + in[i];
+   }
+}
+
+static void png_unfilter_paeth(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
 {
    unsigned i;
 
+#ifdef PNG_UNFILTER_SIMD
+   if (bpp == 4)
+   {
+      png_unfilter_paeth_simd(out, in, prev, pitch, 4);
+      return;
+   }
+   if (bpp == 3)
+   {
+      png_unfilter_paeth_simd(out, in, prev, pitch, 3);
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = paeth(0, prev[i], 0) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + in[i];
+}
+
+static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
+      struct rpng_process *pngp, unsigned filter)
+{
    switch (filter)
    {
       case PNG_FILTER_NONE:
          memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_unfilter_sub(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_unfilter_up(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_unfilter_avg(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_unfilter_paeth(pngp->decoded_scanline, pngp->inflate_buf,
+               pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
 
       default:
@@ -24,9 +24,17 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <encodings/crc32.h>
 #include <streams/file_stream.h>
 #include <streams/trans_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
 
 #include "rpng_internal.h"
 
@@ -145,6 +153,31 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
    }
 }
 
+#if defined(__SSE2__)
+static unsigned count_sad(const uint8_t *data, size_t size)
+{
+   size_t i;
+   unsigned cnt      = 0;
+   /* |x| of a signed byte is |(x ^ 0x80) - 0x80| as unsigned,
+    * which is exactly what PSADBW computes. */
+   const __m128i bias = _mm_set1_epi8((char)0x80);
+   __m128i acc        = _mm_setzero_si128();
+
+   for (i = 0; i + 16 <= size; i += 16)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+      acc       = _mm_add_epi64(acc,
+            _mm_sad_epu8(_mm_xor_si128(v, bias), bias));
+   }
+
+   cnt = (unsigned)_mm_cvtsi128_si32(acc)
+      + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+
+   for (; i < size; i++)
+      cnt += abs((int8_t)data[i]);
+   return cnt;
+}
+#else
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
    size_t i;
@@ -153,6 +186,7 @@ static unsigned count_sad(const uint8_t *data, size_t size)
       cnt += abs((int8_t)data[i]);
    return cnt;
 }
+#endif
 
 static unsigned filter_up(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
@@ -205,71 +239,160 @@ static unsigned filter_paeth(uint8_t *target,
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+static void png_copy_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
 {
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   const struct trans_stream_backend *stream_backend = NULL;
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-   uint32_t total_in       = 0;
-   uint32_t total_out      = 0;
-   RFILE *file             = filestream_open(path,
-         RETRO_VFS_FILE_ACCESS_WRITE,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
-   if (!file)
-      GOTO_END_ERROR();
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
 
-   stream_backend = trans_stream_get_zlib_deflate_backend();
+/* Minimum amount of rows handed to a single deflate worker.
+ * Smaller bands lose too much compression to the sync flush
+ * and the reset dictionary to be worth a thread. */
+#define RPNG_ENCODE_MIN_BAND_ROWS 64
+#define RPNG_ENCODE_MAX_BANDS     16
 
-   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
+/* Largest deflate window, the bands are raw streams of that size */
+#define RPNG_ENCODE_WINDOW_BITS   15
 
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
+#define ADLER32_BASE 65521U
+/* Most bytes summed before the sums can overflow 32 bits */
+#define ADLER32_NMAX 5552
 
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+static uint32_t rpng_adler32(uint32_t adler, const uint8_t *data, size_t len)
+{
+   uint32_t sum1 = adler & 0xffff;
+   uint32_t sum2 = adler >> 16;
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
-      GOTO_END_ERROR();
+   while (len)
+   {
+      size_t n = len < ADLER32_NMAX ? len : ADLER32_NMAX;
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+      len -= n;
+      while (n--)
+      {
+         sum1 += *data++;
+         sum2 += sum1;
+      }
+
+      sum1 %= ADLER32_BASE;
+      sum2 %= ADLER32_BASE;
+   }
+
+   return sum1 | (sum2 << 16);
+}
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+/* Checksum of two buffers one after the other, from the checksum
+ * of each and the length of the second, as zlib's adler32_combine. */
+static uint32_t rpng_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t len2)
+{
+   uint32_t rem  = (uint32_t)(len2 % ADLER32_BASE);
+   uint32_t sum1 = adler1 & 0xffff;
+   uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER32_BASE);
+
+   sum1 += (adler2 & 0xffff) + ADLER32_BASE - 1;
+   sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER32_BASE - rem;
+
+   if (sum1 >= ADLER32_BASE)
+      sum1 -= ADLER32_BASE;
+   if (sum1 >= ADLER32_BASE)
+      sum1 -= ADLER32_BASE;
+   if (sum2 >= (ADLER32_BASE << 1))
+      sum2 -= (ADLER32_BASE << 1);
+   if (sum2 >= ADLER32_BASE)
+      sum2 -= ADLER32_BASE;
+
+   return sum1 | (sum2 << 16);
+}
+
+/* A horizontal slice of the image which is filtered and deflated
+ * independently of the others. Every band ends on a byte boundary
+ * (sync flush), so the raw deflate streams can simply be
+ * concatenated, pigz-style. */
+struct rpng_encode_band
+{
+   const uint8_t *data;      /* First source row of the band */
+   const uint8_t *prev_data; /* Source row above the band, or NULL */
+   unsigned rows;
+   unsigned width;
+   unsigned pitch;
+   unsigned bpp;
+   int level;
+   bool first;
+   bool last;
+   bool ok;
+   uint32_t adler;
+   size_t in_len;            /* Filtered bytes fed to deflate */
+   size_t out_len;           /* Bytes written after the chunk header */
+   size_t out_size;
+   uint8_t *out;             /* 8 bytes chunk header + deflate data */
+};
+
+static void rpng_encode_band(void *data)
+{
+   unsigned h;
+   uint32_t total_in, total_out;
+   struct rpng_encode_band *band = (struct rpng_encode_band*)data;
+   unsigned line_size            = band->width * band->bpp;
+   const uint8_t *src            = band->data;
+   uint8_t *out                  = band->out + 8;
+   enum trans_stream_error err   = TRANS_STREAM_ERROR_NONE;
+   const struct trans_stream_backend *stream_backend =
+      trans_stream_get_zlib_deflate_backend();
+   void *stream                  = stream_backend
+      ? stream_backend->stream_new() : NULL;
+   uint8_t *rgba_line            = (uint8_t*)malloc(line_size);
+   uint8_t *prev_line            = (uint8_t*)calloc(1, line_size);
+   uint8_t *filtered             = (uint8_t*)malloc(5 * (line_size + 1));
+
+   band->ok                      = false;
+   band->adler                   = 1;
+   band->in_len                  = 0;
+   band->out_len                 = 0;
+
+   if (!stream || !rgba_line || !prev_line || !filtered)
+      goto end;
+
+   if (band->prev_data)
+      png_copy_line(prev_line, band->prev_data, band->width, band->bpp);
+
+   /* Raw deflate, the zlib wrapper is written by the caller
+    * around the concatenated bands. */
+   stream_backend->define(stream, "level", (uint32_t)band->level);
+   stream_backend->define(stream, "window_bits",
+         (uint32_t)-RPNG_ENCODE_WINDOW_BITS);
+   if (!band->last)
+      stream_backend->define(stream, "sync_flush", 1);
+
+   if (band->first)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
+      /* zlib header: deflate, 32K window, FLEVEL matching the level. */
+      uint8_t flevel = band->level < 0 ? 2
+         : band->level < 2 ? 0 : band->level < 6 ? 1
+         : band->level == 6 ? 2 : 3;
+      unsigned cmf_flg = (0x78 << 8) | (flevel << 6);
+      cmf_flg         += 31 - (cmf_flg % 31);
+
+      *out++           = (uint8_t)(cmf_flg >> 8);
+      *out++           = (uint8_t)(cmf_flg >> 0);
+   }
+
+   stream_backend->set_out(stream, out,
+         (uint32_t)(band->out_size - (out - band->out)));
+
+   for (h = 0; h < band->rows; h++, src += band->pitch)
+   {
+      uint8_t *none_filtered  = filtered;
+      uint8_t *sub_filtered   = none_filtered  + line_size + 1;
+      uint8_t *up_filtered    = sub_filtered   + line_size + 1;
+      uint8_t *avg_filtered   = up_filtered    + line_size + 1;
+      uint8_t *paeth_filtered = avg_filtered   + line_size + 1;
+
+      png_copy_line(none_filtered + 1, src, band->width, band->bpp);
+      memcpy(rgba_line, none_filtered + 1, line_size);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
@@ -278,15 +401,15 @@ static bool rpng_save_image(const char *path,
        * simple to implement.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
-         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned none_score  = count_sad(rgba_line, line_size);
+         unsigned up_score    = filter_up(up_filtered + 1, rgba_line, prev_line, band->width, band->bpp);
+         unsigned sub_score   = filter_sub(sub_filtered + 1, rgba_line, band->width, band->bpp);
+         unsigned avg_score   = filter_avg(avg_filtered + 1, rgba_line, prev_line, band->width, band->bpp);
+         unsigned paeth_score = filter_paeth(paeth_filtered + 1, rgba_line, prev_line, band->width, band->bpp);
 
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
-         const uint8_t *chosen_filtered = rgba_line;
+         uint8_t *chosen_filtered = none_filtered;
 
          if (sub_score < min_sad)
          {
@@ -315,40 +438,164 @@ static bool rpng_save_image(const char *path,
             chosen_filtered = paeth_filtered;
          }
 
-         *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         chosen_filtered[0] = filter;
+
+         band->adler    = rpng_adler32(band->adler,
+               chosen_filtered, line_size + 1);
+         band->in_len  += line_size + 1;
+
+         stream_backend->set_in(stream, chosen_filtered, line_size + 1);
+         if (!stream_backend->trans(stream, false,
+                  &total_in, &total_out, NULL)
+               || total_in != line_size + 1)
+            goto end;
+         out           += total_out;
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         memcpy(prev_line, rgba_line, line_size);
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
+   /* Finishes the last band, and only flushes the others */
+   stream_backend->set_in(stream, NULL, 0);
+   if (!stream_backend->trans(stream, true, &total_in, &total_out, &err)
+         || err != TRANS_STREAM_ERROR_NONE)
+      goto end;
+   out          += total_out;
+
+   band->out_len = out - (band->out + 8);
+   band->ok      = true;
+
+end:
+   if (stream)
+      stream_backend->stream_free(stream);
+   free(rgba_line);
+   free(prev_line);
+   free(filtered);
+}
+
+static unsigned rpng_encode_band_count(unsigned height)
+{
+   unsigned bands = 1;
+#ifdef HAVE_THREADS
+   bands = cpu_features_get_core_amount();
+   if (bands > RPNG_ENCODE_MAX_BANDS)
+      bands = RPNG_ENCODE_MAX_BANDS;
+   if (bands > height / RPNG_ENCODE_MIN_BAND_ROWS)
+      bands = height / RPNG_ENCODE_MIN_BAND_ROWS;
+   if (bands < 1)
+      bands = 1;
+#endif
+   return bands;
+}
+
+static bool rpng_save_image(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int level)
+{
+   unsigned i;
+   bool ret                        = true;
+   struct png_ihdr ihdr            = {0};
+   unsigned num_bands              = rpng_encode_band_count(height);
+   unsigned rows_left              = height;
+   uint32_t adler                  = 0;
+   struct rpng_encode_band *bands  = NULL;
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_ENCODE_MAX_BANDS] = {NULL};
+#endif
+   RFILE *file                     = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!file)
       GOTO_END_ERROR();
 
-   stream = stream_backend->stream_new();
+   /* 0-9, or -1 for the zlib default */
+   if (level < -1 || level > 9)
+      level = RPNG_DEFAULT_COMPRESSION_LEVEL;
 
-   if (!stream)
+   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
       GOTO_END_ERROR();
 
-   stream_backend->set_in(
-         stream,
-         encode_buf,
-         (unsigned)encode_buf_size);
-   stream_backend->set_out(
-         stream,
-         deflate_buf + 8,
-         (unsigned)(encode_buf_size * 2));
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
 
-   if (!stream_backend->trans(stream, true, &total_in, &total_out, NULL))
-   {
+   bands = (struct rpng_encode_band*)calloc(num_bands, sizeof(*bands));
+   if (!bands)
       GOTO_END_ERROR();
+
+   for (i = 0; i < num_bands; i++)
+   {
+      struct rpng_encode_band *band = &bands[i];
+      size_t in_len;
+
+      band->rows      = rows_left / (num_bands - i);
+      band->data      = data;
+      band->prev_data = i > 0 ? data - pitch : NULL;
+      band->width     = width;
+      band->pitch     = pitch;
+      band->bpp       = bpp;
+      band->level     = level;
+      band->first     = (i == 0);
+      band->last      = (i == num_bands - 1);
+
+      in_len          = (size_t)(width * bpp + 1) * band->rows;
+      /* Raw deflate bound, plus chunk header, zlib header/trailer
+       * and the empty stored block emitted by the sync flush. */
+      band->out_size  = in_len + (in_len >> 12) + (in_len >> 14)
+         + (in_len >> 25) + 13 + 8 + 2 + 4 + 16;
+      band->out       = (uint8_t*)malloc(band->out_size);
+      if (!band->out)
+         GOTO_END_ERROR();
+
+      data           += (size_t)pitch * band->rows;
+      rows_left      -= band->rows;
    }
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0,        ((uint32_t)total_out));
-   if (!png_write_idat(file, deflate_buf, ((size_t)total_out + 8)))
-      GOTO_END_ERROR();
+#ifdef HAVE_THREADS
+   /* The first band is encoded on the calling thread. */
+   for (i = 1; i < num_bands; i++)
+      threads[i] = sthread_create(rpng_encode_band, &bands[i]);
+#endif
+
+   for (i = 0; i < num_bands; i++)
+   {
+#ifdef HAVE_THREADS
+      if (threads[i])
+      {
+         sthread_join(threads[i]);
+         threads[i] = NULL;
+         continue;
+      }
+#endif
+      rpng_encode_band(&bands[i]);
+   }
+
+   for (i = 0; i < num_bands; i++)
+   {
+      struct rpng_encode_band *band = &bands[i];
+
+      if (!band->ok)
+         GOTO_END_ERROR();
+
+      adler = (i == 0) ? band->adler
+         : rpng_adler32_combine(adler, band->adler, band->in_len);
+
+      if (band->last)
+      {
+         dword_write_be(band->out + 8 + band->out_len, (uint32_t)adler);
+         band->out_len += 4;
+      }
+
+      /* One IDAT chunk per band, decoders concatenate them. */
+      memcpy(band->out + 4, "IDAT", 4);
+      dword_write_be(band->out + 0, (uint32_t)band->out_len);
+      if (!png_write_idat(file, band->out, band->out_len + 8))
+         GOTO_END_ERROR();
+   }
 
    if (!png_write_iend(file))
       GOTO_END_ERROR();
@@ -356,36 +603,41 @@ static bool rpng_save_image(const char *path,
 end:
    if (file)
       filestream_close(file);
-   free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   if (stream_backend)
+   if (bands)
    {
-      if (stream)
-      {
-         if (stream_backend->stream_free)
-            stream_backend->stream_free(stream);
-      }
+      for (i = 0; i < num_bands; i++)
+         free(bands[i].out);
+      free(bands);
    }
    return ret;
 }
 
+bool rpng_save_image_argb_level(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, sizeof(uint32_t), level);
+}
+
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, 3, level);
+}
+
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, sizeof(uint32_t));
+         width, height, pitch, sizeof(uint32_t),
+         RPNG_DEFAULT_COMPRESSION_LEVEL);
 }
 
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, 3);
+         width, height, pitch, 3,
+         RPNG_DEFAULT_COMPRESSION_LEVEL);
 }
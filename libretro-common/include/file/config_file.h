@@ -60,6 +60,14 @@ struct config_file
    unsigned include_depth;
 
    struct config_include_list *includes;
+
+   /* Hash index over entries, see config_file.c. */
+   struct config_entry_list **index;
+   size_t index_size;
+   size_t index_count;
+
+   /* Blocks holding parsed file contents and entries. */
+   struct config_arena *arena;
 };
 
 
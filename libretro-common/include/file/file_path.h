@@ -484,6 +484,20 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+/**
+ * path_get_size_mtime:
+ * @path               : path
+ * @size               : size of the file, may be NULL
+ * @mtime              : last modification time of the file, may be NULL.
+ *                       Only meaningful when compared to another value
+ *                       returned by this function.
+ *
+ * Stats a file once for both its size and modification time.
+ *
+ * Returns: true (1) if path exists, otherwise false (0).
+ */
+bool path_get_size_mtime(const char *path, int32_t *size, int64_t *mtime);
+
 RETRO_END_DECLS
 
 #endif
@@ -32,6 +32,8 @@
 
 RETRO_BEGIN_DECLS
 
+#define RPNG_DEFAULT_COMPRESSION_LEVEL 9
+
 typedef struct rpng rpng_t;
 
 rpng_t *rpng_init(const char *path);
@@ -56,6 +58,14 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
 
+/* Same as above, with an explicit deflate level (0-9, or -1 for the
+ * zlib default). Images tall enough are split in row bands that are
+ * filtered and deflated on multiple threads when HAVE_THREADS is set. */
+bool rpng_save_image_argb_level(const char *path, const uint32_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level);
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level);
+
 RETRO_END_DECLS
 
 #endif
@@ -56,6 +56,23 @@ struct string_list *dir_list_new(const char *dir, const char *ext,
  **/
 void dir_list_sort(struct string_list *list, bool dir_first);
 
+/**
+ * dir_list_cache_init:
+ *
+ * Lets dir_list_new() reuse the listing of a directory it read
+ * a few seconds earlier, as long as the modification time of the
+ * directory did not change since. Off until this is called.
+ **/
+void dir_list_cache_init(void);
+
+/**
+ * dir_list_cache_deinit:
+ *
+ * Drops all cached directory listings and turns the cache off.
+ * Must not be called while other threads may call dir_list_new().
+ **/
+void dir_list_cache_deinit(void);
+
 /**
  * dir_list_free:
  * @list : pointer to the directory listing
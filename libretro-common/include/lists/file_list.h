@@ -42,6 +42,8 @@ struct item_file
    size_t entry_idx;
    void *userdata;
    void *actiondata;
+   /* Added by file_list_append_pending() and not filled in yet. */
+   bool pending;
 };
 
 typedef struct file_list
@@ -50,6 +52,12 @@ typedef struct file_list
 
    size_t capacity;
    size_t size;
+
+   /* Fills in a pending entry the first time it is looked up,
+    * see file_list_set_fill(). */
+   void (*fill)(struct file_list *list, size_t idx, void *data);
+   void (*fill_free)(void *data);
+   void *fill_data;
 } file_list_t;
 
 
@@ -92,10 +100,56 @@ bool file_list_prepend(file_list_t *list,
       unsigned type, size_t directory_ptr,
       size_t entry_idx);
 
+/**
+ * @brief appends placeholders for entries that get filled in lazily
+ *
+ * The entries are empty until one of the getters below looks them
+ * up, at which point the list's fill callback is called on them.
+ * Their entry_idx counts up from 0, in append order.
+ * file_list_get_userdata_at_offset() does not fill entries in,
+ * and the file_list_sort_on_*() functions leave a list holding
+ * pending entries as is.
+ *
+ * @param list
+ * @param count
+ * @return whether or not the operation succeeded
+ */
+bool file_list_append_pending(file_list_t *list, size_t count);
+
+/**
+ * @brief sets the callback filling in pending entries
+ *
+ * @data is released with @fill_free once the list is cleared or
+ * freed, or another callback is set.
+ *
+ * @param list
+ * @param fill
+ * @param fill_free
+ * @param data
+ */
+void file_list_set_fill(file_list_t *list,
+      void (*fill)(file_list_t *list, size_t idx, void *data),
+      void (*fill_free)(void *data), void *data);
+
+bool file_list_is_pending(const file_list_t *list, size_t idx);
+
+void file_list_set_at_offset(file_list_t *list, size_t idx,
+      const char *path, const char *label,
+      unsigned type, size_t entry_idx);
+
 void file_list_pop(file_list_t *list, size_t *directory_ptr);
 
 void file_list_clear(file_list_t *list);
 
+/**
+ * @brief copies @src into @dst, replacing its entries
+ *
+ * @dst's fill callback is released. A @src still holding
+ * pending entries is not copied and leaves @dst empty.
+ *
+ * @param src
+ * @param dst
+ */
 void file_list_copy(const file_list_t *src, file_list_t *dst);
 
 void file_list_get_last(const file_list_t *list,
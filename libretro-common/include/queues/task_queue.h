@@ -57,6 +57,8 @@ typedef void (*retro_task_queue_msg_t)(const char *msg,
 
 typedef bool (*retro_task_retriever_t)(retro_task_t *task, void *data);
 
+typedef void (*retro_task_queue_trace_t)(retro_task_t *task, bool begin);
+
 typedef bool (*retro_task_condition_fn_t)(void *data);
 
 typedef struct
@@ -179,6 +181,12 @@ void task_queue_unset_threaded(void);
 
 bool task_queue_is_threaded(void);
 
+/* Sets a function called around each run of a task handler,
+ * for profiling. The threaded implementation also calls it with
+ * a NULL task when its worker thread starts and when it ends.
+ * Set it before task_queue_init. */
+void task_queue_set_trace(retro_task_queue_trace_t trace);
+
 /**
  * Calls func for every running task
  * until it returns true.
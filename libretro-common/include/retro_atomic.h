@@ -0,0 +1,62 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (retro_atomic.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_ATOMIC_H
+#define __LIBRETRO_SDK_ATOMIC_H
+
+/* Minimal set of sequentially consistent atomic operations on
+ * 32-bit integers (int/unsigned), enough for single producer /
+ * single consumer rings and reference counts.
+ *
+ * RETRO_ATOMIC_LOCK_FREE is defined when the operations below are
+ * real atomics. Otherwise they degrade to plain accesses on volatile
+ * variables, which is only safe on uniprocessor targets with
+ * cooperative threads. */
+
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define RETRO_ATOMIC_LOCK_FREE 1
+#define retro_atomic_load(ptr)             __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define retro_atomic_store(ptr, val)       __atomic_store_n((ptr), (val), __ATOMIC_SEQ_CST)
+#define retro_atomic_fetch_add(ptr, val)   __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+#define retro_atomic_fetch_sub(ptr, val)   __atomic_fetch_sub((ptr), (val), __ATOMIC_SEQ_CST)
+#elif defined(__GNUC__)
+/* The legacy __sync builtins are full barriers. */
+#define RETRO_ATOMIC_LOCK_FREE 1
+#define retro_atomic_load(ptr)             __sync_fetch_and_add((ptr), 0)
+#define retro_atomic_store(ptr, val)       do { __sync_synchronize(); *(ptr) = (val); __sync_synchronize(); } while (0)
+#define retro_atomic_fetch_add(ptr, val)   __sync_fetch_and_add((ptr), (val))
+#define retro_atomic_fetch_sub(ptr, val)   __sync_fetch_and_sub((ptr), (val))
+#elif defined(_MSC_VER) && !defined(_XBOX360)
+#include <intrin.h>
+#define RETRO_ATOMIC_LOCK_FREE 1
+#define retro_atomic_load(ptr)             _InterlockedCompareExchange((long volatile*)(ptr), 0, 0)
+#define retro_atomic_store(ptr, val)       _InterlockedExchange((long volatile*)(ptr), (long)(val))
+#define retro_atomic_fetch_add(ptr, val)   _InterlockedExchangeAdd((long volatile*)(ptr), (long)(val))
+#define retro_atomic_fetch_sub(ptr, val)   _InterlockedExchangeAdd((long volatile*)(ptr), -(long)(val))
+#else
+#define retro_atomic_load(ptr)             (*(ptr))
+#define retro_atomic_store(ptr, val)       (*(ptr) = (val))
+#define retro_atomic_fetch_add(ptr, val)   ((*(ptr) += (val)) - (val))
+#define retro_atomic_fetch_sub(ptr, val)   ((*(ptr) -= (val)) + (val))
+#endif
+
+#endif
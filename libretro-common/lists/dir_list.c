@@ -21,6 +21,8 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #if defined(_WIN32) && defined(_XBOX)
 #include <xtl.h>
@@ -38,6 +40,49 @@
 #include <string/stdstring.h>
 #include <retro_miscellaneous.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Number of directory listings kept around by the cache,
+ * and how long (in seconds) one may be reused for. */
+#define DIR_LIST_CACHE_SLOTS 16
+#define DIR_LIST_CACHE_TTL   10
+
+/* Upper bound on the threads reading subdirectories
+ * of a recursive listing. */
+#define DIR_LIST_MAX_THREADS 4
+
+typedef struct dir_list_item
+{
+   const char *name;
+   size_t offset;
+   bool is_dir;
+} dir_list_item_t;
+
+/* Raw contents of one directory, minus the '.' and '..'
+ * entries. Filtering by extension and hidden state happens
+ * on top of it, so that one listing can serve callers that
+ * ask for different subsets. */
+typedef struct dir_list_listing
+{
+   char *dir;
+   char *names;
+   dir_list_item_t *items;
+   size_t count;
+   int64_t mtime;
+   time_t stamp;
+   unsigned refs;
+   bool cached;
+   bool sorted;
+} dir_list_listing_t;
+
+static dir_list_listing_t *dir_list_cache[DIR_LIST_CACHE_SLOTS];
+static bool dir_list_cache_enabled = false;
+#ifdef HAVE_THREADS
+static slock_t *dir_list_cache_lock = NULL;
+#endif
+
 static int qstrcmp_plain(const void *a_, const void *b_)
 {
    const struct string_list_elem *a = (const struct string_list_elem*)a_;
@@ -70,9 +115,65 @@ static int qstrcmp_dir(const void *a_, const void *b_)
  **/
 void dir_list_sort(struct string_list *list, bool dir_first)
 {
-   if (list)
-      qsort(list->elems, list->size, sizeof(struct string_list_elem),
-            dir_first ? qstrcmp_dir : qstrcmp_plain);
+   size_t i;
+   size_t counts[RARCH_FILE_UNSUPPORTED + 1];
+   struct string_list_elem *sorted = NULL;
+
+   if (!list)
+      return;
+
+   for (i = 1; i < list->size; i++)
+      if (qstrcmp_plain(&list->elems[i - 1], &list->elems[i]) > 0)
+         break;
+
+   if (i < list->size)
+      goto sort;
+
+   /* Lists straight out of dir_list_new() are already in
+    * name order, so only the grouping by type is left to
+    * do, which a stable counting pass handles in O(n). */
+   if (!dir_first)
+      return;
+
+   memset(counts, 0, sizeof(counts));
+
+   for (i = 0; i < list->size; i++)
+   {
+      int type = list->elems[i].attr.i;
+      if (type < 0 || type > RARCH_FILE_UNSUPPORTED)
+         goto sort;
+      counts[type]++;
+   }
+
+   sorted = (struct string_list_elem*)malloc(
+         list->size * sizeof(*sorted));
+
+   if (!sorted)
+      goto sort;
+
+   {
+      size_t pos = 0;
+      int type;
+
+      /* Highest type first, as in qstrcmp_dir(). */
+      for (type = RARCH_FILE_UNSUPPORTED; type >= 0; type--)
+      {
+         size_t count = counts[type];
+         counts[type] = pos;
+         pos         += count;
+      }
+   }
+
+   for (i = 0; i < list->size; i++)
+      sorted[counts[list->elems[i].attr.i]++] = list->elems[i];
+
+   memcpy(list->elems, sorted, list->size * sizeof(*sorted));
+   free(sorted);
+   return;
+
+sort:
+   qsort(list->elems, list->size, sizeof(struct string_list_elem),
+         dir_first ? qstrcmp_dir : qstrcmp_plain);
 }
 
 /**
@@ -153,6 +254,296 @@ static int parse_dir_entry(const char *name, char *file_path,
    return 0;
 }
 
+static int dir_list_item_compare(const void *a_, const void *b_)
+{
+   const dir_list_item_t *a = (const dir_list_item_t*)a_;
+   const dir_list_item_t *b = (const dir_list_item_t*)b_;
+
+   return strcasecmp(a->name, b->name);
+}
+
+static void dir_list_listing_free(dir_list_listing_t *listing)
+{
+   if (!listing)
+      return;
+
+   free(listing->dir);
+   free(listing->names);
+   free(listing->items);
+   free(listing);
+}
+
+/**
+ * dir_list_listing_read:
+ * @dir                : directory path.
+ * @sorted             : sort the entries by name?
+ *
+ * Reads the entries of @dir from disk.
+ *
+ * Returns: new listing with one reference on success,
+ * NULL if @dir could not be opened.
+ **/
+static dir_list_listing_t *dir_list_listing_read(const char *dir,
+      bool sorted)
+{
+   size_t i;
+   size_t names_cap             = 4096;
+   size_t names_size            = 0;
+   size_t items_cap             = 64;
+   struct RDIR *entry           = NULL;
+   dir_list_listing_t *listing  = (dir_list_listing_t*)
+      calloc(1, sizeof(*listing));
+
+   if (!listing)
+      return NULL;
+
+   listing->refs  = 1;
+   listing->dir   = strdup(dir);
+   listing->names = (char*)malloc(names_cap);
+   listing->items = (dir_list_item_t*)malloc(
+         items_cap * sizeof(*listing->items));
+
+   if (!listing->dir || !listing->names || !listing->items)
+      goto error;
+
+   entry = retro_opendir(dir);
+
+   if (!entry || retro_dirent_error(entry))
+      goto error;
+
+   retro_dirent_include_hidden(entry, true);
+
+   while (retro_readdir(entry))
+   {
+      char file_path[PATH_MAX_LENGTH];
+      const char *name    = retro_dirent_get_name(entry);
+      size_t len          = strlen(name) + 1;
+      dir_list_item_t *item;
+
+      if (string_is_equal(name, ".") || string_is_equal(name, ".."))
+         continue;
+
+      if (listing->count >= items_cap)
+      {
+         dir_list_item_t *items = (dir_list_item_t*)realloc(
+               listing->items, items_cap * 2 * sizeof(*items));
+         if (!items)
+            goto error;
+         listing->items = items;
+         items_cap     *= 2;
+      }
+
+      if (names_size + len > names_cap)
+      {
+         char *names = NULL;
+
+         while (names_size + len > names_cap)
+            names_cap *= 2;
+
+         if (!(names = (char*)realloc(listing->names, names_cap)))
+            goto error;
+         listing->names = names;
+      }
+
+      file_path[0] = '\0';
+      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+
+      item         = &listing->items[listing->count++];
+      item->offset = names_size;
+      item->is_dir = retro_dirent_is_dir(entry, file_path);
+
+      memcpy(listing->names + names_size, name, len);
+      names_size  += len;
+   }
+
+   retro_closedir(entry);
+
+   /* Names are only stable once the buffer stops growing. */
+   for (i = 0; i < listing->count; i++)
+      listing->items[i].name = listing->names + listing->items[i].offset;
+
+   /* Recursive listings get sorted by the caller as a whole,
+    * sorting every subdirectory on the way is wasted work. */
+   if (sorted)
+      qsort(listing->items, listing->count, sizeof(*listing->items),
+            dir_list_item_compare);
+   listing->sorted = sorted;
+
+   return listing;
+
+error:
+   if (entry)
+      retro_closedir(entry);
+   dir_list_listing_free(listing);
+   return NULL;
+}
+
+/**
+ * dir_list_listing_get:
+ * @dir                : directory path.
+ * @sorted             : sort the entries by name?
+ *
+ * Returns the listing of @dir, from the cache when there is
+ * a recent enough copy of it and the modification time of
+ * @dir did not change since. Has to be released with
+ * dir_list_listing_release().
+ **/
+static dir_list_listing_t *dir_list_listing_get(const char *dir,
+      bool sorted)
+{
+   unsigned i;
+   int64_t mtime               = 0;
+   time_t now                  = 0;
+   dir_list_listing_t *listing = NULL;
+   dir_list_listing_t **slot   = NULL;
+
+   if (!dir_list_cache_enabled || !path_get_size_mtime(dir, NULL, &mtime))
+      return dir_list_listing_read(dir, sorted);
+
+   now = time(NULL);
+
+#ifdef HAVE_THREADS
+   slock_lock(dir_list_cache_lock);
+#endif
+   for (i = 0; i < DIR_LIST_CACHE_SLOTS; i++)
+   {
+      dir_list_listing_t *cached = dir_list_cache[i];
+
+      if (     cached
+            && cached->mtime == mtime
+            && now - cached->stamp < DIR_LIST_CACHE_TTL
+            && (cached->sorted || !sorted)
+            && string_is_equal(cached->dir, dir))
+      {
+         cached->refs++;
+         listing = cached;
+         break;
+      }
+   }
+#ifdef HAVE_THREADS
+   slock_unlock(dir_list_cache_lock);
+#endif
+
+   if (listing)
+      return listing;
+
+   if (!(listing = dir_list_listing_read(dir, sorted)))
+      return NULL;
+
+   /* A directory modified within the current second could
+    * change again without its mtime moving, so don't keep
+    * listings that can't be told apart from a later one. */
+   if ((int64_t)now <= mtime)
+      return listing;
+
+   listing->mtime = mtime;
+   listing->stamp = now;
+
+#ifdef HAVE_THREADS
+   slock_lock(dir_list_cache_lock);
+#endif
+   /* Replace an older listing of the same directory if there
+    * is one, else take a free slot, else evict the oldest. */
+   for (i = 0; i < DIR_LIST_CACHE_SLOTS; i++)
+   {
+      dir_list_listing_t *cached = dir_list_cache[i];
+
+      if (cached && string_is_equal(cached->dir, dir))
+      {
+         slot = &dir_list_cache[i];
+         break;
+      }
+
+      if (slot && !*slot)
+         continue;
+
+      if (!slot || !cached || cached->stamp < (*slot)->stamp)
+         slot = &dir_list_cache[i];
+   }
+
+   if (*slot)
+   {
+      (*slot)->cached = false;
+      if ((*slot)->refs == 0)
+         dir_list_listing_free(*slot);
+   }
+
+   listing->cached = true;
+   *slot           = listing;
+#ifdef HAVE_THREADS
+   slock_unlock(dir_list_cache_lock);
+#endif
+
+   return listing;
+}
+
+static void dir_list_listing_release(dir_list_listing_t *listing)
+{
+   bool is_free = false;
+
+#ifdef HAVE_THREADS
+   slock_lock(dir_list_cache_lock);
+#endif
+   listing->refs--;
+   is_free = !listing->cached && listing->refs == 0;
+#ifdef HAVE_THREADS
+   slock_unlock(dir_list_cache_lock);
+#endif
+
+   if (is_free)
+      dir_list_listing_free(listing);
+}
+
+/**
+ * dir_list_cache_init:
+ *
+ * Enables caching of directory listings.
+ **/
+void dir_list_cache_init(void)
+{
+   if (dir_list_cache_enabled)
+      return;
+
+#ifdef HAVE_THREADS
+   if (!(dir_list_cache_lock = slock_new()))
+      return;
+#endif
+
+   dir_list_cache_enabled = true;
+}
+
+/**
+ * dir_list_cache_deinit:
+ *
+ * Drops all cached directory listings and disables the cache.
+ **/
+void dir_list_cache_deinit(void)
+{
+   unsigned i;
+
+   if (!dir_list_cache_enabled)
+      return;
+
+   for (i = 0; i < DIR_LIST_CACHE_SLOTS; i++)
+   {
+      dir_list_listing_t *cached = dir_list_cache[i];
+
+      if (!cached)
+         continue;
+
+      cached->cached = false;
+      if (cached->refs == 0)
+         dir_list_listing_free(cached);
+      dir_list_cache[i] = NULL;
+   }
+
+#ifdef HAVE_THREADS
+   slock_free(dir_list_cache_lock);
+   dir_list_cache_lock    = NULL;
+#endif
+   dir_list_cache_enabled = false;
+}
+
 /**
  * dir_list_read:
  * @dir                : directory path.
@@ -172,25 +563,17 @@ static int dir_list_read(const char *dir,
       bool include_dirs, bool include_hidden,
       bool include_compressed, bool recursive)
 {
-   struct RDIR *entry = retro_opendir(dir);
-
-   if (!entry || retro_dirent_error(entry))
-      goto error;
+   size_t i;
+   dir_list_listing_t *listing = dir_list_listing_get(dir, !recursive);
 
-   retro_dirent_include_hidden(entry, include_hidden);
+   if (!listing)
+      return -1;
 
-   while (retro_readdir(entry))
+   for (i = 0; i < listing->count; i++)
    {
       char file_path[PATH_MAX_LENGTH];
-      bool is_dir                     = false;
-      int ret                         = 0;
-      const char *name                = retro_dirent_get_name(entry);
-      const char *file_ext            = path_get_extension(name);
-
-      file_path[0] = '\0';
-
-      fill_pathname_join(file_path, dir, name, sizeof(file_path));
-      is_dir = retro_dirent_is_dir(entry, file_path);
+      const dir_list_item_t *item     = &listing->items[i];
+      const char *name                = item->name;
 
       if (!include_hidden)
       {
@@ -198,34 +581,245 @@ static int dir_list_read(const char *dir,
             continue;
       }
 
-      if(is_dir && recursive)
+      file_path[0] = '\0';
+
+      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+
+      if (item->is_dir && recursive)
       {
-         if(strstr(name, ".") || strstr(name, ".."))
+         if (strstr(name, "."))
             continue;
 
          dir_list_read(file_path, list, ext_list, include_dirs,
                include_hidden, include_compressed, recursive);
       }
 
-      ret    = parse_dir_entry(name, file_path, is_dir,
-            include_dirs, include_compressed, list, ext_list, file_ext);
+      if (parse_dir_entry(name, file_path, item->is_dir,
+            include_dirs, include_compressed, list, ext_list,
+            path_get_extension(name)) == -1)
+      {
+         dir_list_listing_release(listing);
+         return -1;
+      }
+   }
+
+   dir_list_listing_release(listing);
+
+   return 0;
+}
+
+#ifdef HAVE_THREADS
+typedef struct dir_list_job
+{
+   char *path;
+   struct string_list *list;
+} dir_list_job_t;
+
+typedef struct dir_list_jobs
+{
+   dir_list_job_t *jobs;
+   size_t count;
+   size_t next;
+   slock_t *lock;
+   struct string_list *ext_list;
+   bool include_dirs;
+   bool include_hidden;
+   bool include_compressed;
+} dir_list_jobs_t;
+
+static void dir_list_read_thread(void *data)
+{
+   dir_list_jobs_t *jobs = (dir_list_jobs_t*)data;
+
+   for (;;)
+   {
+      dir_list_job_t *job = NULL;
+
+      slock_lock(jobs->lock);
+      if (jobs->next < jobs->count)
+         job = &jobs->jobs[jobs->next++];
+      slock_unlock(jobs->lock);
+
+      if (!job)
+         break;
+
+      if ((job->list = string_list_new()))
+         dir_list_read(job->path, job->list, jobs->ext_list,
+               jobs->include_dirs, jobs->include_hidden,
+               jobs->include_compressed, true);
+   }
+}
+
+/* Appends the elements of @src to @dst, leaving @src empty. */
+static bool dir_list_move(struct string_list *dst, struct string_list *src)
+{
+   if (dst->size + src->size > dst->cap)
+   {
+      size_t cap                     = dst->cap;
+      struct string_list_elem *elems = NULL;
+
+      while (dst->size + src->size > cap)
+         cap *= 2;
+
+      if (!(elems = (struct string_list_elem*)realloc(
+                  dst->elems, cap * sizeof(*elems))))
+         return false;
+
+      dst->elems = elems;
+      dst->cap   = cap;
+   }
+
+   memcpy(dst->elems + dst->size, src->elems,
+         src->size * sizeof(*src->elems));
+   dst->size += src->size;
+   src->size  = 0;
+   return true;
+}
+
+/**
+ * dir_list_read_parallel:
+ *
+ * Same as dir_list_read() with @recursive set, except that the
+ * subdirectories of @dir are read by a few threads at once.
+ * The resulting list is identical to the serial one.
+ *
+ * Returns: -1 on error, 0 on success.
+ **/
+static int dir_list_read_parallel(const char *dir,
+      struct string_list *list, struct string_list *ext_list,
+      bool include_dirs, bool include_hidden,
+      bool include_compressed)
+{
+   size_t i, j;
+   sthread_t *threads[DIR_LIST_MAX_THREADS - 1];
+   unsigned num_threads        = 0;
+   int ret                     = 0;
+   dir_list_jobs_t jobs        = {0};
+   dir_list_listing_t *listing = dir_list_listing_get(dir, false);
+
+   if (!listing)
+      return -1;
+
+   for (i = 0; i < listing->count; i++)
+   {
+      const dir_list_item_t *item = &listing->items[i];
+      if (item->is_dir && !strstr(item->name, "."))
+         jobs.count++;
+   }
+
+   if (jobs.count < 2)
+   {
+      dir_list_listing_release(listing);
+      return dir_list_read(dir, list, ext_list, include_dirs,
+            include_hidden, include_compressed, true);
+   }
+
+   jobs.jobs               = (dir_list_job_t*)calloc(
+         jobs.count, sizeof(*jobs.jobs));
+   jobs.lock               = slock_new();
+   jobs.ext_list           = ext_list;
+   jobs.include_dirs       = include_dirs;
+   jobs.include_hidden     = include_hidden;
+   jobs.include_compressed = include_compressed;
 
-      if (ret == -1)
-         goto error;
+   if (!jobs.jobs || !jobs.lock)
+   {
+      ret = -1;
+      goto end;
+   }
+
+   for (i = 0, j = 0; i < listing->count; i++)
+   {
+      char file_path[PATH_MAX_LENGTH];
+      const dir_list_item_t *item = &listing->items[i];
 
-      if (ret == 1)
+      if (!item->is_dir || strstr(item->name, "."))
          continue;
+
+      file_path[0] = '\0';
+      fill_pathname_join(file_path, dir, item->name, sizeof(file_path));
+
+      if (!(jobs.jobs[j++].path = strdup(file_path)))
+      {
+         ret = -1;
+         goto end;
+      }
    }
 
-   retro_closedir(entry);
+   /* The calling thread is one of the workers. */
+   while (     num_threads < DIR_LIST_MAX_THREADS - 1
+            && num_threads + 1 < jobs.count)
+   {
+      if (!(threads[num_threads] = sthread_create(
+                  dir_list_read_thread, &jobs)))
+         break;
+      num_threads++;
+   }
 
-   return 0;
+   dir_list_read_thread(&jobs);
 
-error:
-   if (entry)
-      retro_closedir(entry);
-   return -1;
+   while (num_threads > 0)
+      sthread_join(threads[--num_threads]);
+
+   for (i = 0, j = 0; i < listing->count && ret == 0; i++)
+   {
+      char file_path[PATH_MAX_LENGTH];
+      const dir_list_item_t *item = &listing->items[i];
+      const char *name            = item->name;
+
+      if (!include_hidden)
+      {
+         if (*name == '.')
+            continue;
+      }
+
+      if (item->is_dir)
+      {
+         dir_list_job_t *job = NULL;
+
+         if (strstr(name, "."))
+            continue;
+
+         job = &jobs.jobs[j++];
+
+         if (!job->list)
+         {
+            ret = -1;
+            break;
+         }
+
+         if (!dir_list_move(list, job->list))
+         {
+            ret = -1;
+            break;
+         }
+      }
+
+      file_path[0] = '\0';
+      fill_pathname_join(file_path, dir, name, sizeof(file_path));
+
+      if (parse_dir_entry(name, file_path, item->is_dir,
+            include_dirs, include_compressed, list, ext_list,
+            path_get_extension(name)) == -1)
+         ret = -1;
+   }
+
+end:
+   if (jobs.jobs)
+   {
+      for (i = 0; i < jobs.count; i++)
+      {
+         free(jobs.jobs[i].path);
+         string_list_free(jobs.jobs[i].list);
+      }
+      free(jobs.jobs);
+   }
+   slock_free(jobs.lock);
+   dir_list_listing_release(listing);
+
+   return ret;
 }
+#endif
 
 /**
  * dir_list_new:
@@ -246,6 +840,7 @@ struct string_list *dir_list_new(const char *dir,
       bool include_hidden, bool include_compressed,
       bool recursive)
 {
+   int ret                        = 0;
    struct string_list *ext_list   = NULL;
    struct string_list *list       = NULL;
 
@@ -255,8 +850,16 @@ struct string_list *dir_list_new(const char *dir,
    if (ext)
       ext_list = string_split(ext, "|");
 
-   if(dir_list_read(dir, list, ext_list, include_dirs,
-            include_hidden, include_compressed, recursive) == -1)
+#ifdef HAVE_THREADS
+   if (recursive)
+      ret = dir_list_read_parallel(dir, list, ext_list, include_dirs,
+            include_hidden, include_compressed);
+   else
+#endif
+      ret = dir_list_read(dir, list, ext_list, include_dirs,
+            include_hidden, include_compressed, recursive);
+
+   if (ret == -1)
    {
       string_list_free(list);
       string_list_free(ext_list);
@@ -50,6 +50,45 @@ bool file_list_reserve(file_list_t *list, size_t nitems)
    return new_data != NULL;
 }
 
+/* Fills in entry @idx if it's still pending. The getters
+ * take a const list, but filling an entry in doesn't change
+ * what callers see, only when the work is done. */
+static void file_list_fill_pending(const file_list_t *list, size_t idx)
+{
+   file_list_t *mut = (file_list_t*)list;
+
+   if (idx >= list->size || !list->list[idx].pending)
+      return;
+
+   mut->list[idx].pending = false;
+
+   if (list->fill)
+      list->fill(mut, idx, list->fill_data);
+}
+
+/* Pending entries are filled in by position, so a list
+ * holding any is kept in the order it was built in. */
+static bool file_list_has_pending(const file_list_t *list)
+{
+   size_t i;
+
+   for (i = 0; i < list->size; i++)
+      if (list->list[i].pending)
+         return true;
+
+   return false;
+}
+
+static void file_list_free_fill(file_list_t *list)
+{
+   if (list->fill_free && list->fill_data)
+      list->fill_free(list->fill_data);
+
+   list->fill      = NULL;
+   list->fill_free = NULL;
+   list->fill_data = NULL;
+}
+
 static void file_list_add(file_list_t *list, unsigned idx,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr,
@@ -63,6 +102,7 @@ static void file_list_add(file_list_t *list, unsigned idx,
    list->list[idx].entry_idx     = entry_idx;
    list->list[idx].userdata      = NULL;
    list->list[idx].actiondata    = NULL;
+   list->list[idx].pending       = false;
 
    if (label)
       list->list[idx].label      = strdup(label);
@@ -123,6 +163,72 @@ bool file_list_append(file_list_t *list,
    return true;
 }
 
+bool file_list_append_pending(file_list_t *list, size_t count)
+{
+   size_t i;
+
+   if (list->size + count > list->capacity &&
+         !file_list_reserve(list, list->size + count))
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      struct item_file *item = &list->list[list->size + i];
+
+      memset(item, 0, sizeof(*item));
+      item->entry_idx        = i;
+      item->pending          = true;
+   }
+
+   list->size += count;
+
+   return true;
+}
+
+void file_list_set_fill(file_list_t *list,
+      void (*fill)(file_list_t *list, size_t idx, void *data),
+      void (*fill_free)(void *data), void *data)
+{
+   if (!list)
+      return;
+
+   file_list_free_fill(list);
+
+   list->fill      = fill;
+   list->fill_free = fill_free;
+   list->fill_data = data;
+}
+
+bool file_list_is_pending(const file_list_t *list, size_t idx)
+{
+   if (!list || idx >= list->size)
+      return false;
+   return list->list[idx].pending;
+}
+
+void file_list_set_at_offset(file_list_t *list, size_t idx,
+      const char *path, const char *label,
+      unsigned type, size_t entry_idx)
+{
+   struct item_file *item = NULL;
+
+   if (!list)
+      return;
+
+   item            = &list->list[idx];
+
+   if (item->path)
+      free(item->path);
+   if (item->label)
+      free(item->label);
+
+   item->path      = path  ? strdup(path)  : NULL;
+   item->label     = label ? strdup(label) : NULL;
+   item->type      = type;
+   item->entry_idx = entry_idx;
+   item->pending   = false;
+}
+
 size_t file_list_get_size(const file_list_t *list)
 {
    if (!list)
@@ -185,6 +291,7 @@ void file_list_free(file_list_t *list)
    if (list->list)
       free(list->list);
    list->list = NULL;
+   file_list_free_fill(list);
    free(list);
 }
 
@@ -211,6 +318,7 @@ void file_list_clear(file_list_t *list)
    }
 
    list->size = 0;
+   file_list_free_fill(list);
 }
 
 void file_list_copy(const file_list_t *src, file_list_t *dst)
@@ -246,6 +354,13 @@ void file_list_copy(const file_list_t *src, file_list_t *dst)
 
    dst->size     = 0;
    dst->capacity = 0;
+   file_list_free_fill(dst);
+
+   /* The fill data belongs to @src and is released with it,
+    * so its pending entries can't be handed over. */
+   if (file_list_has_pending(src))
+      return;
+
    dst->list     = (struct item_file*)malloc(src->size * sizeof(struct item_file));
 
    if (!dst->list)
@@ -288,6 +403,8 @@ void file_list_get_label_at_offset(const file_list_t *list, size_t idx,
    if (!label || !list)
       return;
 
+   file_list_fill_pending(list, idx);
+
    *label = list->list[idx].path;
    if (list->list[idx].label)
       *label = list->list[idx].label;
@@ -313,6 +430,8 @@ void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
    if (!list)
       return;
 
+   file_list_fill_pending(list, idx);
+
    if (alt)
       *alt = list->list[idx].alt ?
          list->list[idx].alt : list->list[idx].path;
@@ -341,11 +460,15 @@ static int file_list_type_cmp(const void *a_, const void *b_)
 
 void file_list_sort_on_alt(file_list_t *list)
 {
+   if (file_list_has_pending(list))
+      return;
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
 }
 
 void file_list_sort_on_type(file_list_t *list)
 {
+   if (file_list_has_pending(list))
+      return;
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_type_cmp);
 }
 
@@ -374,6 +497,7 @@ void *file_list_get_actiondata_at_offset(const file_list_t *list, size_t idx)
 {
    if (!list)
       return NULL;
+   file_list_fill_pending(list, idx);
    return list->list[idx].actiondata;
 }
 
@@ -399,6 +523,7 @@ void *file_list_get_last_actiondata(const file_list_t *list)
 {
    if (!list)
       return NULL;
+   file_list_fill_pending(list, list->size - 1);
    return list->list[list->size - 1].actiondata;
 }
 
@@ -409,6 +534,8 @@ void file_list_get_at_offset(const file_list_t *list, size_t idx,
    if (!list)
       return;
 
+   file_list_fill_pending(list, idx);
+
    if (path)
       *path      = list->list[idx].path;
    if (label)
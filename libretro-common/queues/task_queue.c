@@ -56,6 +56,7 @@ struct retro_task_impl
 };
 
 static retro_task_queue_msg_t msg_push_bak;
+static retro_task_queue_trace_t task_trace = NULL;
 static task_queue_t tasks_running  = {NULL, NULL};
 static task_queue_t tasks_finished = {NULL, NULL};
 
@@ -179,7 +180,12 @@ static void retro_task_regular_gather(void)
    for (task = queue; task; task = next)
    {
       next = task->next;
+
+      if (task_trace)
+         task_trace(task, true);
       task->handler(task);
+      if (task_trace)
+         task_trace(task, false);
 
       task_queue_push_progress(task);
 
@@ -438,6 +444,9 @@ static void threaded_worker(void *userdata)
 {
    (void)userdata;
 
+   if (task_trace)
+      task_trace(NULL, true);
+
    for (;;)
    {
       retro_task_t *task  = NULL;
@@ -459,7 +468,11 @@ static void threaded_worker(void *userdata)
 
       slock_unlock(running_lock);
 
+      if (task_trace)
+         task_trace(task, true);
       task->handler(task);
+      if (task_trace)
+         task_trace(task, false);
 
       slock_lock(property_lock);
       finished = task->finished;
@@ -483,6 +496,9 @@ static void threaded_worker(void *userdata)
          slock_unlock(finished_lock);
       }
    }
+
+   if (task_trace)
+      task_trace(NULL, false);
 }
 
 static void retro_task_threaded_init(void)
@@ -566,6 +582,11 @@ void task_queue_init(bool threaded, retro_task_queue_msg_t msg_push)
    impl_current->init();
 }
 
+void task_queue_set_trace(retro_task_queue_trace_t trace)
+{
+   task_trace = trace;
+}
+
 void task_queue_set_threaded(void)
 {
    task_threaded_enable = true;
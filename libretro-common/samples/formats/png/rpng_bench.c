@@ -0,0 +1,169 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpng_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <formats/rpng.h>
+#include <formats/image.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+
+/* Times rpng_save_image_argb() on a generated screenshot-sized
+ * image, then decoding the result. rpng_bench is built with
+ * HAVE_THREADS and deflates row bands in parallel,
+ * rpng_bench_serial uses a single band. rpng_bench_scalar
+ * unfilters without the SSE2/NEON kernels. */
+
+static uint32_t *bench_make_image(unsigned width, unsigned height)
+{
+   unsigned x, y;
+   uint32_t seed  = 1;
+   uint32_t *data = (uint32_t*)malloc(width * height * sizeof(*data));
+
+   if (!data)
+      return NULL;
+
+   /* Gradients with a bit of noise, so that every filter
+    * gets picked and deflate has some work to do */
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         seed = seed * 1103515245 + 12345;
+
+         data[y * width + x] = 0xff000000
+            | (((x + (seed >> 28)) & 0xff) << 16)
+            | (((y + (seed >> 24)) & 0xff) << 8)
+            | ((x ^ y) & 0xff);
+      }
+   }
+
+   return data;
+}
+
+static bool bench_decode(void *buf, size_t len)
+{
+   int retval;
+   unsigned width  = 0;
+   unsigned height = 0;
+   uint32_t *data  = NULL;
+   rpng_t *rpng    = rpng_alloc();
+
+   if (!rpng)
+      return false;
+
+   if (!rpng_set_buf_ptr(rpng, buf) || !rpng_start(rpng))
+   {
+      rpng_free(rpng);
+      return false;
+   }
+
+   while (rpng_iterate_image(rpng));
+
+   do
+   {
+      retval = rpng_process_image(rpng,
+            (void**)&data, len, &width, &height);
+   } while (retval == IMAGE_PROCESS_NEXT);
+
+   rpng_free(rpng);
+   free(data);
+
+   return retval == IMAGE_PROCESS_END;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   retro_time_t start, total;
+   const char *path  = "/tmp/rpng_bench.png";
+   unsigned width    = 1920;
+   unsigned height   = 1080;
+   unsigned runs     = 10;
+   uint32_t *data    = NULL;
+   void *buf         = NULL;
+   ssize_t len       = 0;
+
+   if (argc > 1)
+      path   = argv[1];
+   if (argc > 3)
+   {
+      width  = strtoul(argv[2], NULL, 0);
+      height = strtoul(argv[3], NULL, 0);
+   }
+   if (argc > 4)
+      runs   = strtoul(argv[4], NULL, 0);
+
+   if (!width || !height || !runs)
+   {
+      fprintf(stderr, "Usage: %s [path] [width height] [runs]\n", argv[0]);
+      return 1;
+   }
+
+   data = bench_make_image(width, height);
+   if (!data)
+      return 1;
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < runs; i++)
+   {
+      if (!rpng_save_image_argb(path, data, width, height,
+               width * sizeof(*data)))
+      {
+         fprintf(stderr, "Failed to save %s.\n", path);
+         free(data);
+         return 1;
+      }
+   }
+   total = cpu_features_get_time_usec() - start;
+
+   printf("encode %ux%u: %.2f ms/image, %u cores\n", width, height,
+         total / 1000.0 / runs, cpu_features_get_core_amount());
+
+   free(data);
+
+   if (!filestream_read_file(path, &buf, &len))
+   {
+      fprintf(stderr, "Failed to read %s.\n", path);
+      return 1;
+   }
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < runs; i++)
+   {
+      if (!bench_decode(buf, (size_t)len))
+      {
+         fprintf(stderr, "Failed to decode %s.\n", path);
+         free(buf);
+         return 1;
+      }
+   }
+   total = cpu_features_get_time_usec() - start;
+
+   printf("decode %ux%u: %.2f ms/image\n", width, height,
+         total / 1000.0 / runs);
+
+   free(buf);
+   return 0;
+}
@@ -0,0 +1,272 @@
+/* public domain */
+/* make netplay_stress */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* Loopback stress test: connects many spectators to a host on this
+ * machine, answers the handshake of each, then counts the INPUT
+ * commands they are sent. Given the pid of the host, also reports its
+ * CPU time per INPUT command, i.e. per frame with one player. The host
+ * should run uncapped, with a core that does next to nothing:
+ *
+ *    retroarch -L <core> --host &
+ *    netplay_stress [spectators] [seconds] [port] [host pid]
+ *
+ * The host takes its port from netplay_ip_port in its config, not
+ * from --port. */
+
+#define STRESS_MAX_CLIENTS 256
+
+/* From network/netplay/netplay_private.h */
+#define STRESS_DEFAULT_PORT 55435
+#define STRESS_NICK_LEN     32
+#define STRESS_CMD_INPUT    0x0003
+#define STRESS_CMD_NICK     0x0020
+#define STRESS_CMD_INFO     0x0022
+#define STRESS_CMD_SYNC     0x0023
+
+struct stress_client
+{
+   int fd;
+   int header_done;
+   int synced;
+   uint32_t skip;
+   size_t len;
+   unsigned long inputs;
+   uint8_t buf[4096];
+};
+
+static struct stress_client stress_clients[STRESS_MAX_CLIENTS];
+
+static int stress_send_cmd(struct stress_client *c, uint32_t cmd,
+      const void *data, uint32_t size)
+{
+   uint32_t hdr[2];
+
+   hdr[0] = htonl(cmd);
+   hdr[1] = htonl(size);
+   return send(c->fd, hdr, sizeof(hdr), 0) == sizeof(hdr)
+      && (!size || send(c->fd, data, size, 0) == (ssize_t)size);
+}
+
+/* Handles what's in the buffer, 0 if the client should give up */
+static int stress_client_process(struct stress_client *c, unsigned idx)
+{
+   size_t pos = 0;
+
+   for (;;)
+   {
+      uint32_t cmd, size;
+
+      if (c->skip)
+      {
+         size_t n = c->len - pos;
+         if (n > c->skip)
+            n = c->skip;
+         pos     += n;
+         c->skip -= (uint32_t)n;
+         if (c->skip)
+            break;
+      }
+
+      if (!c->header_done)
+      {
+         uint32_t header[6];
+
+         if (c->len - pos < sizeof(header))
+            break;
+         /* No compression, no password */
+         memcpy(header, c->buf + pos, sizeof(header));
+         header[2] = 0;
+         header[3] = 0;
+         if (send(c->fd, header, sizeof(header), 0) != sizeof(header))
+            return 0;
+         pos           += sizeof(header);
+         c->header_done = 1;
+         continue;
+      }
+
+      if (c->len - pos < 2 * sizeof(uint32_t))
+         break;
+      memcpy(&cmd,  c->buf + pos,                    sizeof(cmd));
+      memcpy(&size, c->buf + pos + sizeof(uint32_t), sizeof(size));
+      cmd  = ntohl(cmd);
+      size = ntohl(size);
+
+      if (cmd == STRESS_CMD_NICK || cmd == STRESS_CMD_INFO)
+      {
+         if (size > sizeof(c->buf) - 2 * sizeof(uint32_t))
+            return 0;
+         if (c->len - pos < 2 * sizeof(uint32_t) + size)
+            break;
+
+         if (cmd == STRESS_CMD_NICK)
+         {
+            char nick[STRESS_NICK_LEN];
+
+            memset(nick, 0, sizeof(nick));
+            snprintf(nick, sizeof(nick), "spectator%u", idx);
+            if (!stress_send_cmd(c, cmd, nick, sizeof(nick)))
+               return 0;
+         }
+         /* The core info only has to match */
+         else if (!stress_send_cmd(c, cmd,
+                  c->buf + pos + 2 * sizeof(uint32_t), size))
+            return 0;
+      }
+      else
+      {
+         if (cmd == STRESS_CMD_SYNC)
+            c->synced = 1;
+         else if (cmd == STRESS_CMD_INPUT && c->synced)
+            c->inputs++;
+         c->skip = size;
+      }
+
+      pos += 2 * sizeof(uint32_t);
+      if (!c->skip)
+         pos += size;
+   }
+
+   c->len -= pos;
+   memmove(c->buf, c->buf + pos, c->len);
+   return 1;
+}
+
+static int64_t stress_time_usec(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* utime + stime of a process, in clock ticks */
+static unsigned long stress_cpu_ticks(int pid)
+{
+   char path[64], line[1024];
+   unsigned long utime = 0, stime = 0;
+   const char *p       = NULL;
+   FILE *f;
+
+   snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+   if (!(f = fopen(path, "r")))
+      return 0;
+   if (fgets(line, sizeof(line), f) && (p = strrchr(line, ')')))
+      sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+            &utime, &stime);
+   fclose(f);
+   return utime + stime;
+}
+
+int main(int argc, char *argv[])
+{
+   struct pollfd fds[STRESS_MAX_CLIENTS];
+   struct sockaddr_in addr;
+   unsigned i, synced       = 0;
+   unsigned long inputs     = 0;
+   unsigned long ticks      = 0;
+   int64_t start            = 0;
+   double elapsed           = 0.0;
+   unsigned n               = argc > 1 ? atoi(argv[1]) : 64;
+   unsigned seconds         = argc > 2 ? atoi(argv[2]) : 20;
+   int port                 = argc > 3 ? atoi(argv[3]) : STRESS_DEFAULT_PORT;
+   int pid                  = argc > 4 ? atoi(argv[4]) : 0;
+   int64_t end;
+
+   if (n > STRESS_MAX_CLIENTS)
+      n = STRESS_MAX_CLIENTS;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_port        = htons(port);
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   for (i = 0; i < n; i++)
+   {
+      int one = 1;
+      struct stress_client *c = &stress_clients[i];
+
+      c->fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (c->fd < 0 || connect(c->fd, (struct sockaddr*)&addr,
+               sizeof(addr)) < 0)
+      {
+         fprintf(stderr, "Connecting spectator %u failed.\n", i);
+         return 1;
+      }
+      setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      fds[i].fd     = c->fd;
+      fds[i].events = POLLIN;
+      /* Don't have the host take them all in one frame */
+      usleep(20000);
+   }
+
+   end = stress_time_usec() + (int64_t)seconds * 1000000;
+
+   while (stress_time_usec() < end)
+   {
+      if (poll(fds, n, 100) <= 0)
+         continue;
+
+      for (i = 0; i < n; i++)
+      {
+         struct stress_client *c = &stress_clients[i];
+         ssize_t got;
+
+         if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+
+         got = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+         if (got > 0)
+            c->len += got;
+         if (got <= 0 || !stress_client_process(c, i))
+         {
+            close(c->fd);
+            fds[i].fd = -1;
+         }
+      }
+
+      /* Measure from when everyone has caught up */
+      if (!start)
+      {
+         for (i = 0; i < n && stress_clients[i].synced; i++);
+         if (i == n)
+         {
+            start = stress_time_usec();
+            if (pid)
+               ticks = stress_cpu_ticks(pid);
+            for (i = 0; i < n; i++)
+               stress_clients[i].inputs = 0;
+         }
+      }
+   }
+
+   if (start)
+      elapsed = (stress_time_usec() - start) / 1000000.0;
+
+   for (i = 0; i < n; i++)
+   {
+      synced += stress_clients[i].synced;
+      inputs += stress_clients[i].inputs;
+   }
+
+   printf("%u/%u spectators synced, %.1f INPUT commands/s each\n",
+         synced, n, elapsed > 0.0 ? inputs / (double)synced / elapsed : 0.0);
+
+   if (ticks && inputs)
+      printf("host CPU: %.1f us per INPUT command\n",
+            (stress_cpu_ticks(pid) - ticks) * 1000000.0
+            / sysconf(_SC_CLK_TCK) / ((double)inputs / synced));
+
+   return 0;
+}
@@ -30,7 +30,9 @@
 struct zlib_trans_stream
 {
    bool inited;
+   bool sync_flush; /* deflate only: flush without ending the stream */
    int ex; /* window_bits or level */
+   int window_bits; /* deflate only */
    z_stream z;
 };
 
@@ -40,6 +42,7 @@ static void *zlib_deflate_stream_new(void)
    if (!ret)
       return NULL;
    ret->ex = 9;
+   ret->window_bits = MAX_WBITS;
    return (void *) ret;
 }
 
@@ -82,6 +85,21 @@ static bool zlib_deflate_define(void *data, const char *prop, uint32_t val)
          z->ex = (int) val;
       return true;
    }
+   /* Negative for a raw deflate stream, without the zlib header */
+   if (string_is_equal(prop, "window_bits"))
+   {
+      if (z)
+         z->window_bits = (int) val;
+      return true;
+   }
+   /* Flushing ends on a byte boundary and leaves the stream open,
+    * so it can be followed by another raw stream */
+   if (string_is_equal(prop, "sync_flush"))
+   {
+      if (z)
+         z->sync_flush = val != 0;
+      return true;
+   }
    return false;
 }
 
@@ -109,7 +127,8 @@ static void zlib_deflate_set_in(void *data, const uint8_t *in, uint32_t in_size)
 
    if (!z->inited)
    {
-      deflateInit(&z->z, z->ex);
+      deflateInit2(&z->z, z->ex, Z_DEFLATED, z->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       z->inited = true;
    }
 }
@@ -155,18 +174,21 @@ static bool zlib_deflate_trans(
 
    if (!zt->inited)
    {
-      deflateInit(z, zt->ex);
+      deflateInit2(z, zt->ex, Z_DEFLATED, zt->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       zt->inited = true;
    }
 
    pre_avail_in  = z->avail_in;
    pre_avail_out = z->avail_out;
-   zret          = deflate(z, flush ? Z_FINISH : Z_NO_FLUSH);
+   zret          = deflate(z, !flush ? Z_NO_FLUSH
+         : zt->sync_flush ? Z_SYNC_FLUSH : Z_FINISH);
 
    if (zret == Z_OK)
    {
       if (error)
-         *error = TRANS_STREAM_ERROR_AGAIN;
+         *error = (flush && zt->sync_flush && z->avail_out != 0)
+            ? TRANS_STREAM_ERROR_NONE : TRANS_STREAM_ERROR_AGAIN;
    }
    else if (zret == Z_STREAM_END)
    {
@@ -934,5 +934,8 @@ menu_ctx_driver_t menu_ctx_rgui = {
    NULL,
    NULL,
    NULL,
-   NULL
+   NULL,
+   NULL,
+   NULL,
+   true
 };
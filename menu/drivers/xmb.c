@@ -52,6 +52,7 @@
 #include "../widgets/menu_filebrowser.h"
 
 #include "../menu_event.h"
+#include "../menu_thumbnail_cache.h"
 
 #include "../../verbosity.h"
 #include "../../configuration.h"
@@ -950,19 +951,25 @@ end:
    string_list_free(list);
 }
 
-static void xmb_update_thumbnail_path(void *data, unsigned i)
+/* Builds the thumbnail path of entry @i with @content as
+ * the file name into @new_path, without touching the state
+ * of the current thumbnail. Returns false for entries of
+ * the file browser, which have no thumbnails. */
+static bool xmb_fill_thumbnail_path(xmb_handle_t *xmb, unsigned i,
+      const char *content, char *new_path, size_t len)
 {
    menu_entry_t entry;
    unsigned entry_type            = 0;
-   char new_path[PATH_MAX_LENGTH] = {0};
+   bool ret                       = true;
    settings_t     *settings       = config_get_ptr();
-   xmb_handle_t     *xmb          = (xmb_handle_t*)data;
    playlist_t     *playlist       = NULL;
    const char    *dir_thumbnails  = settings->paths.directory_thumbnails;
 
+   new_path[0]                    = '\0';
+
    menu_entry_init(&entry);
 
-   if (!xmb || string_is_empty(dir_thumbnails))
+   if (string_is_empty(dir_thumbnails))
       goto end;
 
    menu_entry_get(&entry, 0, i, NULL, true);
@@ -982,14 +989,14 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
                   new_path,
                   node->fullpath,
                   entry.path,
-                  sizeof(new_path));
+                  len);
 
          goto end;
       }
    }
    else if (filebrowser_get_type() != FILEBROWSER_NONE)
    {
-      xmb->thumbnail              = 0;
+      ret = false;
       goto end;
    }
 
@@ -1004,8 +1011,7 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
       if (string_is_equal(core_name, "imageviewer"))
       {
          if (!string_is_empty(entry.label))
-            strlcpy(new_path, entry.label,
-                  sizeof(new_path));
+            strlcpy(new_path, entry.label, len);
          goto end;
       }
    }
@@ -1016,7 +1022,7 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
             new_path,
             dir_thumbnails,
             xmb->thumbnail_system,
-            sizeof(new_path));
+            len);
 
    if (!string_is_empty(new_path))
    {
@@ -1029,8 +1035,7 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
       fill_pathname_join(tmp_new2, new_path,
             xmb_thumbnails_ident(), PATH_MAX_LENGTH * sizeof(char));
 
-      strlcpy(new_path, tmp_new2,
-            PATH_MAX_LENGTH * sizeof(char));
+      strlcpy(new_path, tmp_new2, len);
       free(tmp_new2);
    }
 
@@ -1039,12 +1044,12 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
     * http://datomatic.no-intro.org/stuff/The%20Official%20No-Intro%20Convention%20(20071030).zip
     * Replace these characters in the entry name with underscores.
     */
-   if (!string_is_empty(xmb->thumbnail_content))
+   if (!string_is_empty(content))
    {
       char *scrub_char_pointer       = NULL;
       char            *tmp_new       = (char*)
          malloc(PATH_MAX_LENGTH * sizeof(char));
-      char            *tmp           = strdup(xmb->thumbnail_content);
+      char            *tmp           = strdup(content);
 
       tmp_new[0]                     = '\0';
 
@@ -1058,8 +1063,7 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
             tmp, PATH_MAX_LENGTH * sizeof(char));
 
       if (!string_is_empty(tmp_new))
-         strlcpy(new_path,
-               tmp_new, sizeof(new_path));
+         strlcpy(new_path, tmp_new, len);
 
       free(tmp_new);
       free(tmp);
@@ -1069,12 +1073,27 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
    if (!string_is_empty(new_path))
       strlcat(new_path,
             file_path_str(FILE_PATH_PNG_EXTENSION),
-            sizeof(new_path));
+            len);
 
 end:
-   if (xmb && !string_is_empty(new_path))
-      xmb->thumbnail_file_path = strdup(new_path);
    menu_entry_free(&entry);
+   return ret;
+}
+
+static void xmb_update_thumbnail_path(void *data, unsigned i)
+{
+   char new_path[PATH_MAX_LENGTH];
+   xmb_handle_t     *xmb          = (xmb_handle_t*)data;
+
+   if (!xmb)
+      return;
+
+   if (!xmb_fill_thumbnail_path(xmb, i, xmb->thumbnail_content,
+            new_path, sizeof(new_path)))
+      xmb->thumbnail = 0;
+
+   if (!string_is_empty(new_path))
+      xmb->thumbnail_file_path = strdup(new_path);
 }
 
 static void xmb_update_savestate_thumbnail_path(void *data, unsigned i)
@@ -1143,7 +1162,7 @@ static void xmb_update_thumbnail_image(void *data)
       return;
 
    if (filestream_exists(xmb->thumbnail_file_path))
-      task_push_image_load(xmb->thumbnail_file_path,
+      menu_thumbnail_cache_load(xmb->thumbnail_file_path,
             menu_display_handle_thumbnail_upload, NULL);
    else
       xmb->thumbnail = 0;
@@ -1183,6 +1202,53 @@ static void xmb_set_thumbnail_content(void *data, char *s, size_t len)
    xmb->thumbnail_content = strdup(s);
 }
 
+/* Queue up the thumbnails of the entries surrounding the
+ * selection so that scrolling to them hits the cache. */
+static void xmb_prefetch_thumbnails(xmb_handle_t *xmb,
+      size_t selection, size_t end)
+{
+   unsigned i;
+   menu_entry_t entry;
+   char path[PATH_MAX_LENGTH];
+   settings_t *settings = config_get_ptr();
+   unsigned radius      = settings->uints.menu_thumbnail_prefetch;
+
+   for (i = 1; i <= radius; i++)
+   {
+      unsigned side;
+
+      for (side = 0; side < 2; side++)
+      {
+         size_t idx;
+
+         if (side == 0)
+         {
+            if (selection + i >= end)
+               continue;
+            idx = selection + i;
+         }
+         else
+         {
+            if (selection < i)
+               continue;
+            idx = selection - i;
+         }
+
+         menu_entry_init(&entry);
+         menu_entry_get(&entry, 0, idx, NULL, true);
+
+         if (     !string_is_empty(entry.path)
+               && xmb_fill_thumbnail_path(xmb, (unsigned)idx, entry.path,
+                  path, sizeof(path))
+               && !string_is_empty(path)
+               && filestream_exists(path))
+            menu_thumbnail_cache_prefetch(path);
+
+         menu_entry_free(&entry);
+      }
+   }
+}
+
 static void xmb_update_savestate_thumbnail_image(void *data)
 {
    xmb_handle_t *xmb = (xmb_handle_t*)data;
@@ -1270,6 +1336,7 @@ static void xmb_selection_pointer_changed(
                   xmb_set_thumbnail_content(xmb, entry.path, 0 /* will be ignored */);
                xmb_update_thumbnail_path(xmb, i);
                xmb_update_thumbnail_image(xmb);
+               xmb_prefetch_thumbnails(xmb, selection, end);
             }
             else if (((entry_type == FILE_TYPE_IMAGE || entry_type == FILE_TYPE_IMAGEVIEWER ||
                         entry_type == FILE_TYPE_RDB || entry_type == FILE_TYPE_RDB_ENTRY)
@@ -4075,9 +4142,8 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst,
    {
       struct item_file *d = &dst->list[j];
       struct item_file *s = &src->list[i];
-
-      void *src_udata = s->userdata;
-      void *src_adata = s->actiondata;
+      void *src_udata     = s->userdata;
+      void *src_adata     = s->actiondata;
 
       *d       = *s;
       d->alt   = string_is_empty(d->alt)   ? NULL : strdup(d->alt);
@@ -4098,6 +4164,10 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst,
    }
 
    dst->size = j;
+
+   /* Pending entries are copied as such, and
+    * filled in from the same source when drawn. */
+   menu_entries_copy_virtual(src, dst, first, last);
 }
 
 static void xmb_list_cache(void *data, enum menu_list_type type, unsigned action)
@@ -4682,5 +4752,8 @@ menu_ctx_driver_t menu_ctx_xmb = {
    xmb_set_thumbnail_content,
    xmb_osk_ptr_at_pos,
    xmb_update_savestate_thumbnail_path,
-   xmb_update_savestate_thumbnail_image
+   xmb_update_savestate_thumbnail_image,
+   NULL,
+   NULL,
+   true
 };
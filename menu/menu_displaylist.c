@@ -55,6 +55,7 @@
 #include "menu_driver.h"
 #include "menu_shader.h"
 #include "menu_networking.h"
+#include "menu_thumbnail_cache.h"
 #include "widgets/menu_dialog.h"
 #include "widgets/menu_list.h"
 #include "widgets/menu_filebrowser.h"
@@ -158,7 +159,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
 
    core_info_get_current_core(&core_info);
 
-   if (!core_info || !core_info->config_data)
+   if (!core_info || !core_info->has_info)
    {
       menu_entries_append_enum(info->list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -491,6 +492,34 @@ static int menu_displaylist_parse_system_info(menu_displaylist_info_t *info)
             MENU_ENUM_LABEL_CPU_CORES, MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
    }
 
+   {
+      menu_thumbnail_cache_stats_t stats;
+      unsigned lookups = 0;
+
+      menu_thumbnail_cache_get_stats(&stats);
+      lookups          = stats.hits + stats.misses;
+
+      snprintf(tmp, sizeof(tmp), "%s: %u KB / %u KB (%u)",
+            msg_hash_to_str(
+               MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_USAGE),
+            (unsigned)(stats.bytes_used / 1024),
+            (unsigned)(stats.bytes_max / 1024),
+            stats.entries);
+      menu_entries_append_enum(info->list, tmp, "",
+            MENU_ENUM_LABEL_SYSTEM_INFO_ENTRY,
+            MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+      snprintf(tmp, sizeof(tmp), "%s: %u / %u (%u%%), %u prefetched, %u evicted",
+            msg_hash_to_str(
+               MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_HITS),
+            stats.hits, lookups,
+            lookups ? (unsigned)((stats.hits * 100ULL) / lookups) : 0,
+            stats.prefetches, stats.evictions);
+      menu_entries_append_enum(info->list, tmp, "",
+            MENU_ENUM_LABEL_SYSTEM_INFO_ENTRY,
+            MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+   }
+
 
    for(controller = 0; controller < MAX_USERS; controller++)
    {
@@ -1243,12 +1272,140 @@ static int menu_displaylist_parse_system_info(menu_displaylist_info_t *info)
    return 0;
 }
 
+typedef struct menu_displaylist_playlist_source
+{
+   playlist_t *playlist;
+   char *path_playlist;
+   unsigned generation;
+   bool is_history;
+} menu_displaylist_playlist_source_t;
+
+/* The menu swaps its playlist out before rebuilding the list,
+ * check we're not looking at a stale one. A new playlist can
+ * get the address of the old one, so compare generations. */
+static bool menu_displaylist_playlist_source_valid(
+      menu_displaylist_playlist_source_t *src, size_t idx)
+{
+   playlist_t *playlist = NULL;
+
+   menu_driver_ctl(RARCH_MENU_CTL_PLAYLIST_GET, &playlist);
+
+   return playlist == src->playlist
+      && playlist_get_generation(playlist) == src->generation
+      && idx < playlist_size(playlist);
+}
+
+static void menu_displaylist_playlist_source_get(void *data, size_t idx,
+      menu_entries_virtual_entry_t *entry)
+{
+   menu_displaylist_playlist_source_t *src =
+      (menu_displaylist_playlist_source_t*)data;
+   size_t path_size      = sizeof(entry->buf);
+   const char *core_name = NULL;
+   const char *path      = NULL;
+   const char *label     = NULL;
+
+   if (menu_displaylist_playlist_source_valid(src, idx))
+      playlist_get_index(src->playlist, idx,
+            &path, &label, NULL, &core_name, NULL, NULL);
+
+   if (core_name)
+      strlcpy(entry->buf, core_name, path_size);
+
+   if (path)
+   {
+      char *path_short = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
+
+      path_short[0] = '\0';
+
+      fill_short_pathname_representation(path_short, path,
+            path_size);
+      strlcpy(entry->buf,
+            (!string_is_empty(label)) ? label : path_short,
+            path_size);
+
+      if (!string_is_empty(core_name))
+      {
+         if (!string_is_equal(core_name,
+                  file_path_str(FILE_PATH_DETECT)))
+         {
+            char *tmp       = (char*)
+               malloc(PATH_MAX_LENGTH * sizeof(char));
+
+            tmp[0] = '\0';
+
+            snprintf(tmp, path_size, " (%s)", core_name);
+            strlcat(entry->buf, tmp, path_size);
+
+            free(tmp);
+         }
+      }
+
+      free(path_short);
+   }
+
+   entry->enum_idx = MENU_ENUM_LABEL_PLAYLIST_ENTRY;
+   entry->type     = FILE_TYPE_RPL_ENTRY;
+
+   if (!path)
+   {
+      entry->path  = entry->buf;
+      entry->label = src->path_playlist;
+      entry->type  = FILE_TYPE_PLAYLIST_ENTRY;
+   }
+   else if (src->is_history)
+   {
+      entry->path  = entry->buf;
+      entry->label = path;
+   }
+   else
+   {
+      entry->path  = label;
+      entry->label = path;
+   }
+}
+
+static const char *menu_displaylist_playlist_source_get_name(void *data,
+      size_t idx, unsigned *type)
+{
+   menu_displaylist_playlist_source_t *src =
+      (menu_displaylist_playlist_source_t*)data;
+   const char *path  = NULL;
+   const char *label = NULL;
+
+   if (type)
+      *type = FILE_TYPE_RPL_ENTRY;
+
+   if (menu_displaylist_playlist_source_valid(src, idx))
+      playlist_get_index(src->playlist, idx,
+            &path, &label, NULL, NULL, NULL, NULL);
+
+   if (!string_is_empty(label))
+      return label;
+   if (path)
+      return path_basename(path);
+
+   if (type)
+      *type = FILE_TYPE_PLAYLIST_ENTRY;
+   return "";
+}
+
+static void menu_displaylist_playlist_source_free(void *data)
+{
+   menu_displaylist_playlist_source_t *src =
+      (menu_displaylist_playlist_source_t*)data;
+
+   free(src->path_playlist);
+   free(src);
+}
+
 static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       playlist_t *playlist, const char *path_playlist, bool is_history)
 {
-   unsigned i;
-   size_t list_size = 0;
-   size_t selection = menu_navigation_get_selection();
+   menu_entries_virtual_t source;
+   size_t list_size                        = 0;
+   size_t selection                        = menu_navigation_get_selection();
+   menu_displaylist_playlist_source_t *src = NULL;
 
    if (!playlist)
       goto error;
@@ -1269,89 +1426,42 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       free(lpl_basename);
    }
 
-   /* preallocate the file list */
-   file_list_reserve(info->list, list_size);
-
-   for (i = 0; i < list_size; i++)
+   if (!is_history && selection < list_size)
    {
-      char *path_copy                 = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-      char *fill_buf                  = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-      size_t path_size                = PATH_MAX_LENGTH * sizeof(char);
-      const char *core_name           = NULL;
-      const char *path                = NULL;
-      const char *label               = NULL;
-
-      fill_buf[0] = path_copy[0]      = '\0';
-
-      if (!string_is_empty(info->path))
-         strlcpy(path_copy, info->path, path_size);
-
-      path                            = path_copy;
-
-      playlist_get_index(playlist, i,
-            &path, &label, NULL, &core_name, NULL, NULL);
+      const char *label = NULL;
 
-      if (core_name)
-         strlcpy(fill_buf, core_name, path_size);
+      playlist_get_index(playlist, selection,
+            NULL, &label, NULL, NULL, NULL, NULL);
 
-      if (!is_history && i == selection && !string_is_empty(label))
+      if (!string_is_empty(label))
       {
          char *content_basename = strdup(label);
 
-         if (!string_is_empty(content_basename))
-         {
-            menu_driver_set_thumbnail_content(content_basename, strlen(content_basename) + 1);
-            menu_driver_ctl(RARCH_MENU_CTL_UPDATE_THUMBNAIL_PATH, NULL);
-            menu_driver_ctl(RARCH_MENU_CTL_UPDATE_THUMBNAIL_IMAGE, NULL);
-            free(content_basename);
-         }
+         menu_driver_set_thumbnail_content(content_basename, strlen(content_basename) + 1);
+         menu_driver_ctl(RARCH_MENU_CTL_UPDATE_THUMBNAIL_PATH, NULL);
+         menu_driver_ctl(RARCH_MENU_CTL_UPDATE_THUMBNAIL_IMAGE, NULL);
+         free(content_basename);
       }
+   }
 
-      if (path)
-      {
-         char *path_short = (char*)malloc(PATH_MAX_LENGTH * sizeof(char));
-
-         path_short[0] = '\0';
-
-         fill_short_pathname_representation(path_short, path,
-               path_size);
-         strlcpy(fill_buf,
-               (!string_is_empty(label)) ? label : path_short,
-               path_size);
-
-         if (!string_is_empty(core_name))
-         {
-            if (!string_is_equal(core_name,
-                     file_path_str(FILE_PATH_DETECT)))
-            {
-               char *tmp       = (char*)
-                  malloc(PATH_MAX_LENGTH * sizeof(char));
-
-               tmp[0] = '\0';
-
-               snprintf(tmp, path_size, " (%s)", core_name);
-               strlcat(fill_buf, tmp, path_size);
+   src = (menu_displaylist_playlist_source_t*)calloc(1, sizeof(*src));
 
-               free(tmp);
-            }
-         }
+   if (!src)
+      goto error;
 
-         free(path_short);
-      }
+   src->playlist      = playlist;
+   src->generation    = playlist_get_generation(playlist);
+   src->path_playlist = strdup(path_playlist ? path_playlist : "");
+   src->is_history    = is_history;
 
-      if (!path)
-         menu_entries_append_enum(info->list, fill_buf, path_playlist,
-               MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_PLAYLIST_ENTRY, 0, i);
-      else if (is_history)
-         menu_entries_append_enum(info->list, fill_buf,
-               path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
-      else
-         menu_entries_append_enum(info->list, label,
-               path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
+   /* Entries are only filled in once they scroll into view,
+    * building them all up front takes ages on big playlists. */
+   source.get         = menu_displaylist_playlist_source_get;
+   source.get_name    = menu_displaylist_playlist_source_get_name;
+   source.free        = menu_displaylist_playlist_source_free;
+   source.data        = src;
 
-      free(path_copy);
-      free(fill_buf);
-   }
+   menu_entries_append_virtual(info->list, list_size, &source);
 
    return 0;
 
@@ -2856,7 +2966,7 @@ static int menu_displaylist_parse_information_list(
           !string_is_equal(system->info.library_name,
              msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE))
          )
-         && core_info && core_info->config_data
+         && core_info && core_info->has_info
       )
       menu_entries_append_enum(info->list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_CORE_INFORMATION),
@@ -4382,9 +4492,10 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
             ret = menu_displaylist_parse_playlist(info,
                   playlist, path_playlist, false);
 
+            /* No need_sort, playlist_qsort() already
+             * sorted the entries by label. */
             if (ret == 0)
             {
-               info->need_sort    = true;
                info->need_refresh = true;
                info->need_push    = true;
             }
@@ -5319,6 +5430,12 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_THUMBNAILS,
                PARSE_ONLY_UINT, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE,
+               PARSE_ONLY_UINT, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_THUMBNAIL_PREFETCH,
+               PARSE_ONLY_UINT, false);
 
          info->need_refresh = true;
          info->need_push    = true;
@@ -5549,6 +5666,14 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
                   MENU_ENUM_LABEL_NETPLAY_NAT_TRAVERSAL,
                   PARSE_ONLY_BOOL, false) != -1)
                count++;
+            if (menu_displaylist_parse_settings_enum(menu, info,
+                  MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,
+                  PARSE_ONLY_BOOL, false) != -1)
+               count++;
+            if (menu_displaylist_parse_settings_enum(menu, info,
+                  MENU_ENUM_LABEL_NETPLAY_UDP_REDUNDANCY,
+                  PARSE_ONLY_UINT, false) != -1)
+               count++;
             if (menu_displaylist_parse_settings_enum(menu, info,
                   MENU_ENUM_LABEL_NETPLAY_SHARE_DIGITAL,
                   PARSE_ONLY_UINT, false) != -1)
@@ -5865,6 +5990,9 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_FRAME_DELAY,
                PARSE_ONLY_UINT, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+               PARSE_ONLY_BOOL, false);
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_BLACK_FRAME_INSERTION,
                PARSE_ONLY_BOOL, false);
@@ -6090,7 +6218,8 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_entries_ctl(MENU_ENTRIES_CTL_CLEAR, info->list);
          ret = menu_displaylist_parse_horizontal_list(info);
 
-         info->need_sort    = true;
+         /* No need_sort, the playlist is sorted by
+          * playlist_qsort() and its entries are virtual. */
          info->need_refresh = true;
          info->need_push    = true;
          break;
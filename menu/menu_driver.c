@@ -42,6 +42,7 @@
 #include "widgets/menu_dialog.h"
 #include "widgets/menu_list.h"
 #include "menu_shader.h"
+#include "menu_thumbnail_cache.h"
 
 #include "../config.def.h"
 #include "../content.h"
@@ -1621,6 +1622,8 @@ bool menu_driver_render(bool is_idle, bool rarch_is_inited,
       settings_t *settings = config_get_ptr();
       menu_animation_update_time(settings->bools.menu_timedate_enable);
 
+      menu_entries_fill_window(menu_navigation_get_selection());
+
       if (menu_driver_ctx->render)
          menu_driver_ctx->render(menu_userdata, is_idle);
    }
@@ -1652,6 +1655,13 @@ bool menu_driver_is_texture_set(void)
    return false;
 }
 
+/* Checks if the menu driver copes with lazily
+ * filled in entries, see menu_entries_append_virtual(). */
+bool menu_driver_has_virtual_lists(void)
+{
+   return menu_driver_ctx && menu_driver_ctx->virtual_lists;
+}
+
 /* Iterate the menu driver for one frame. */
 bool menu_driver_iterate(menu_ctx_iterate_t *iterate)
 {
@@ -1769,6 +1779,8 @@ bool menu_driver_init(bool video_is_threaded)
 
 void menu_driver_navigation_set(bool scroll)
 {
+   menu_entries_fill_window(menu_navigation_get_selection());
+
    if (menu_driver_ctx->navigation_set)
       menu_driver_ctx->navigation_set(menu_userdata, scroll);
 }
@@ -1934,6 +1946,10 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
          if (menu_driver_ctx && menu_driver_ctx->context_destroy)
             menu_driver_ctx->context_destroy(menu_userdata);
 
+         /* Cached thumbnails are converted for the current
+          * video driver, don't let them outlive it. */
+         menu_thumbnail_cache_free();
+
          if (menu_driver_data_own)
             return true;
 
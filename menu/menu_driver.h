@@ -496,6 +496,10 @@ typedef struct menu_ctx_driver
    int (*pointer_up)(void *data, unsigned x, unsigned y, unsigned ptr,
          menu_file_list_cbs_t *cbs,
          menu_entry_t *entry, unsigned action);
+   /* Set if the driver only ever looks at entries around the
+    * selection, so that huge lists can be filled in lazily.
+    * See menu_entries_append_virtual(). */
+   bool virtual_lists;
 } menu_ctx_driver_t;
 
 typedef struct menu_ctx_load_image
@@ -614,6 +618,8 @@ void menu_driver_frame(video_frame_info_t *video_info);
  * return true for RGUI, for instance. */
 bool menu_driver_is_texture_set(void);
 
+bool menu_driver_has_virtual_lists(void);
+
 bool menu_driver_is_alive(void);
 
 bool menu_driver_iterate(menu_ctx_iterate_t *iterate);
@@ -14,10 +14,12 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <retro_inline.h>
 #include <compat/strl.h>
+#include <compat/strcasestr.h>
 #include <string/stdstring.h>
 
 #include "menu_driver.h"
@@ -61,6 +63,134 @@ static bool menu_entries_clear(file_list_t *list)
    return true;
 }
 
+/* Tells the menu driver about entry @idx and sets up
+ * its callbacks. */
+static void menu_entries_init_entry(file_list_t *list, size_t idx,
+      const char *path, const char *label,
+      enum msg_hash_enums enum_idx, unsigned type, char *fullpath)
+{
+   menu_ctx_list_t list_info;
+   menu_file_list_cbs_t *cbs       = NULL;
+
+   list_info.fullpath    = fullpath;
+   list_info.list        = list;
+   list_info.path        = path;
+   list_info.label       = label;
+   list_info.idx         = idx;
+   list_info.entry_type  = type;
+
+   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+
+   file_list_free_actiondata(list, idx);
+   cbs = (menu_file_list_cbs_t*)
+      calloc(1, sizeof(menu_file_list_cbs_t));
+
+   if (!cbs)
+      return;
+
+   file_list_set_actiondata(list, idx, cbs);
+
+   cbs->enum_idx = enum_idx;
+
+   if (enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY) {
+      cbs->setting  = menu_setting_find_enum(enum_idx);
+   }
+
+   menu_cbs_init(list, cbs, path, label, type, idx);
+}
+
+/* How many entries are filled in on either side of the
+ * selection of a virtual list. */
+#define MENU_ENTRIES_VIRTUAL_MARGIN 64
+
+typedef struct menu_entries_virtual_name
+{
+   const char *name;
+   size_t idx;
+} menu_entries_virtual_name_t;
+
+typedef struct menu_entries_virtual_list
+{
+   menu_entries_virtual_t source;
+   /* Lists sharing source, see menu_entries_copy_virtual(). */
+   unsigned *refs;
+   char *fullpath;
+   /* The virtual entries are list entries [base, base + count),
+    * and source entries [offset, offset + count). */
+   size_t base;
+   size_t offset;
+   size_t count;
+   /* Entry names sorted case insensitively, built
+    * on the first search. */
+   menu_entries_virtual_name_t *names;
+   char *names_buf;
+} menu_entries_virtual_list_t;
+
+static void menu_entries_virtual_free(void *data)
+{
+   menu_entries_virtual_list_t *vlist = (menu_entries_virtual_list_t*)data;
+
+   if (--*vlist->refs == 0)
+   {
+      if (vlist->source.free)
+         vlist->source.free(vlist->source.data);
+      free(vlist->refs);
+   }
+   free(vlist->fullpath);
+   free(vlist->names);
+   free(vlist->names_buf);
+   free(vlist);
+}
+
+static void menu_entries_virtual_fill(file_list_t *list,
+      size_t idx, void *data)
+{
+   menu_entries_virtual_entry_t entry;
+   menu_entries_virtual_list_t *vlist = (menu_entries_virtual_list_t*)data;
+
+   if (idx < vlist->base || idx - vlist->base >= vlist->count)
+      return;
+
+   entry.path      = NULL;
+   entry.label     = NULL;
+   entry.enum_idx  = MSG_UNKNOWN;
+   entry.type      = 0;
+   entry.entry_idx = idx - vlist->base + vlist->offset;
+   entry.buf[0]    = '\0';
+
+   vlist->source.get(vlist->source.data, entry.entry_idx, &entry);
+
+   file_list_set_at_offset(list, idx, entry.path, entry.label,
+         entry.type, entry.entry_idx);
+
+   menu_entries_init_entry(list, idx, entry.path, entry.label,
+         entry.enum_idx, entry.type, vlist->fullpath);
+}
+
+static menu_entries_virtual_list_t *menu_entries_virtual_get(
+      const file_list_t *list)
+{
+   if (!list || list->fill != menu_entries_virtual_fill)
+      return NULL;
+   return (menu_entries_virtual_list_t*)list->fill_data;
+}
+
+/* Name of virtual entry @idx as used for searching and
+ * alphabet jumps, or NULL if @idx is a regular entry. */
+static const char *menu_entries_virtual_get_name(
+      const file_list_t *list, size_t idx, unsigned *type)
+{
+   menu_entries_virtual_list_t *vlist = menu_entries_virtual_get(list);
+
+   if (!vlist || idx < vlist->base || idx - vlist->base >= vlist->count)
+      return NULL;
+
+   return vlist->source.get_name(vlist->source.data,
+         idx - vlist->base + vlist->offset, type);
+}
+
 /**
  * menu_entries_elem_is_dir:
  * @list                     : File list handle.
@@ -75,7 +205,8 @@ static bool menu_entries_elem_is_dir(file_list_t *list,
 {
    unsigned type     = 0;
 
-   menu_entries_get_at_offset(list, offset, NULL, NULL, &type, NULL, NULL);
+   if (!menu_entries_virtual_get_name(list, offset, &type))
+      menu_entries_get_at_offset(list, offset, NULL, NULL, &type, NULL, NULL);
 
    return type == FILE_TYPE_DIRECTORY;
 }
@@ -94,10 +225,11 @@ static int menu_entries_elem_get_first_char(
       file_list_t *list, unsigned offset)
 {
    int ret          = 0;
-   const char *path = NULL;
+   const char *path = menu_entries_virtual_get_name(list, offset, NULL);
 
-   menu_entries_get_at_offset(list, offset,
-         NULL, NULL, NULL, NULL, &path);
+   if (!path)
+      menu_entries_get_at_offset(list, offset,
+            NULL, NULL, NULL, NULL, &path);
 
    if (path != NULL)
       ret = tolower((int)*path);
@@ -343,10 +475,8 @@ void menu_entries_append_enum(file_list_t *list, const char *path,
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx)
 {
-   menu_ctx_list_t list_info;
-   size_t idx;
+   char *fullpath                  = NULL;
    const char *menu_path           = NULL;
-   menu_file_list_cbs_t *cbs       = NULL;
    if (!list || !label)
       return;
 
@@ -354,41 +484,274 @@ void menu_entries_append_enum(file_list_t *list, const char *path,
 
    menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
 
-   idx                   = list->size - 1;
+   fullpath = string_is_empty(menu_path) ? NULL : strdup(menu_path);
 
-   list_info.fullpath    = NULL;
+   menu_entries_init_entry(list, list->size - 1,
+         path, label, enum_idx, type, fullpath);
 
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
-   list_info.list        = list;
-   list_info.path        = path;
-   list_info.label       = label;
-   list_info.idx         = idx;
-   list_info.entry_type  = type;
+   if (fullpath)
+      free(fullpath);
+}
 
-   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+static int menu_entries_virtual_name_cmp(const void *a, const void *b)
+{
+   const menu_entries_virtual_name_t *x = (const menu_entries_virtual_name_t*)a;
+   const menu_entries_virtual_name_t *y = (const menu_entries_virtual_name_t*)b;
+   int ret = strcasecmp(x->name, y->name);
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
+   if (ret)
+      return ret;
+   return x->idx < y->idx ? -1 : 1;
+}
 
-   file_list_free_actiondata(list, idx);
-   cbs = (menu_file_list_cbs_t*)
-      calloc(1, sizeof(menu_file_list_cbs_t));
+/* Names are copied, so that the index stays valid if
+ * the source changes underneath the list. */
+static bool menu_entries_virtual_build_names(
+      menu_entries_virtual_list_t *vlist)
+{
+   size_t i;
+   size_t len = 0;
+   char *buf  = NULL;
 
-   if (!cbs)
+   if (vlist->names)
+      return true;
+
+   for (i = 0; i < vlist->count; i++)
+   {
+      const char *name = vlist->source.get_name(vlist->source.data,
+            vlist->offset + i, NULL);
+      len += (name ? strlen(name) : 0) + 1;
+   }
+
+   vlist->names     = (menu_entries_virtual_name_t*)
+      malloc(vlist->count * sizeof(*vlist->names));
+   vlist->names_buf = (char*)malloc(len);
+
+   if (!vlist->names || !vlist->names_buf)
+   {
+      free(vlist->names);
+      free(vlist->names_buf);
+      vlist->names     = NULL;
+      vlist->names_buf = NULL;
+      return false;
+   }
+
+   buf = vlist->names_buf;
+
+   for (i = 0; i < vlist->count; i++)
+   {
+      const char *name = vlist->source.get_name(vlist->source.data,
+            vlist->offset + i, NULL);
+      size_t name_len  = name ? strlen(name) : 0;
+
+      if (name_len)
+         memcpy(buf, name, name_len);
+      buf[name_len]          = '\0';
+
+      vlist->names[i].name   = buf;
+      vlist->names[i].idx    = i;
+      buf                   += name_len + 1;
+   }
+
+   qsort(vlist->names, vlist->count, sizeof(*vlist->names),
+         menu_entries_virtual_name_cmp);
+
+   return true;
+}
+
+void menu_entries_append_virtual(file_list_t *list, size_t count,
+      const menu_entries_virtual_t *source)
+{
+   size_t i;
+   const char *menu_path              = NULL;
+   menu_entries_virtual_list_t *vlist = NULL;
+
+   if (!list || !source)
       return;
 
-   file_list_set_actiondata(list, idx, cbs);
+   vlist = (menu_entries_virtual_list_t*)calloc(1, sizeof(*vlist));
+   if (vlist)
+      vlist->refs = (unsigned*)malloc(sizeof(*vlist->refs));
 
-   cbs->enum_idx = enum_idx;
+   if (!vlist || !vlist->refs || !file_list_append_pending(list, count))
+   {
+      if (vlist)
+         free(vlist->refs);
+      free(vlist);
+      if (source->free)
+         source->free(source->data);
+      return;
+   }
 
-   if (enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
-       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
-       && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY) {
-      cbs->setting  = menu_setting_find_enum(enum_idx);
+   menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
+
+   *vlist->refs    = 1;
+   vlist->source   = *source;
+   vlist->fullpath = string_is_empty(menu_path) ? NULL : strdup(menu_path);
+   vlist->base     = list->size - count;
+   vlist->count    = count;
+
+   file_list_set_fill(list, menu_entries_virtual_fill,
+         menu_entries_virtual_free, vlist);
+
+   /* Drivers laying out the whole list get every
+    * entry right away, as with menu_entries_append_enum(). */
+   if (!menu_driver_has_virtual_lists())
+   {
+      for (i = vlist->base; i < list->size; i++)
+         file_list_get_actiondata_at_offset(list, i);
    }
+   else if (list == menu_entries_get_selection_buf_ptr(0))
+      menu_entries_fill_window(menu_navigation_get_selection());
+}
 
-   menu_cbs_init(list, cbs, path, label, type, idx);
+void menu_entries_copy_virtual(const file_list_t *src,
+      file_list_t *dst, size_t first, size_t last)
+{
+   size_t start, end;
+   menu_entries_virtual_list_t *copy  = NULL;
+   menu_entries_virtual_list_t *vlist = menu_entries_virtual_get(src);
+
+   if (!vlist || !dst || !vlist->count)
+      return;
+
+   start = first > vlist->base ? first : vlist->base;
+   end   = last + 1 < vlist->base + vlist->count
+      ? last + 1 : vlist->base + vlist->count;
+
+   if (start >= end)
+      return;
+
+   copy = (menu_entries_virtual_list_t*)calloc(1, sizeof(*copy));
+   if (!copy)
+      return;
+
+   copy->source   = vlist->source;
+   copy->refs     = vlist->refs;
+   copy->fullpath = vlist->fullpath ? strdup(vlist->fullpath) : NULL;
+   copy->base     = start - first;
+   copy->offset   = vlist->offset + (start - vlist->base);
+   copy->count    = end - start;
+
+   (*copy->refs)++;
+
+   file_list_set_fill(dst, menu_entries_virtual_fill,
+         menu_entries_virtual_free, copy);
+}
+
+void menu_entries_fill_window(size_t selection)
+{
+   size_t i, first, last;
+   file_list_t *list                  = menu_entries_get_selection_buf_ptr(0);
+   menu_entries_virtual_list_t *vlist = menu_entries_virtual_get(list);
+
+   if (!vlist || !vlist->count)
+      return;
+
+   first = selection > MENU_ENTRIES_VIRTUAL_MARGIN
+      ? selection - MENU_ENTRIES_VIRTUAL_MARGIN : 0;
+   last  = selection + MENU_ENTRIES_VIRTUAL_MARGIN;
+
+   if (first < vlist->base)
+      first = vlist->base;
+   if (last >= vlist->base + vlist->count)
+      last = vlist->base + vlist->count - 1;
+
+   for (i = first; i <= last; i++)
+      if (file_list_is_pending(list, i))
+         file_list_get_actiondata_at_offset(list, i);
+}
+
+bool menu_entries_search(const char *needle, size_t *idx)
+{
+   size_t i, lo, hi, len;
+   size_t prefix                      = (size_t)-1;
+   size_t mid                         = (size_t)-1;
+   file_list_t *list                  = menu_entries_get_selection_buf_ptr(0);
+   menu_entries_virtual_list_t *vlist = menu_entries_virtual_get(list);
+
+   if (!list || string_is_empty(needle))
+      return false;
+
+   if (!vlist)
+      return file_list_search(list, needle, idx);
+
+   /* Regular entries around the virtual ones are
+    * searched like file_list_search() does. */
+   for (i = 0; i < list->size; i++)
+   {
+      const char *alt = NULL;
+      const char *str = NULL;
+
+      if (vlist->count && i == vlist->base)
+      {
+         i += vlist->count - 1;
+         continue;
+      }
+
+      file_list_get_alt_at_offset(list, i, &alt);
+      if (!alt)
+      {
+         file_list_get_label_at_offset(list, i, &alt);
+         if (!alt)
+            continue;
+      }
+
+      str = (const char*)strcasestr(alt, needle);
+      if (str == alt)
+      {
+         prefix = i;
+         break;
+      }
+      else if (str && mid == (size_t)-1)
+         mid = i;
+   }
+
+   /* Prefix matches are a range of the sorted names. */
+   if (vlist->count && menu_entries_virtual_build_names(vlist))
+   {
+      len = strlen(needle);
+      lo  = 0;
+      hi  = vlist->count;
+
+      while (lo < hi)
+      {
+         size_t half = lo + (hi - lo) / 2;
+         if (strncasecmp(vlist->names[half].name, needle, len) < 0)
+            lo = half + 1;
+         else
+            hi = half;
+      }
+
+      for (; lo < vlist->count
+            && !strncasecmp(vlist->names[lo].name, needle, len); lo++)
+         if (vlist->base + vlist->names[lo].idx < prefix)
+            prefix = vlist->base + vlist->names[lo].idx;
+   }
+
+   if (prefix != (size_t)-1)
+   {
+      *idx = prefix;
+      return true;
+   }
+
+   for (i = 0; i < vlist->count && vlist->base + i < mid; i++)
+   {
+      const char *name = vlist->source.get_name(vlist->source.data,
+            vlist->offset + i, NULL);
+
+      if (name && strcasestr(name, needle))
+      {
+         mid = vlist->base + i;
+         break;
+      }
+   }
+
+   if (mid == (size_t)-1)
+      return false;
+
+   *idx = mid;
+   return true;
 }
 
 void menu_entries_prepend(file_list_t *list, const char *path, const char *label,
@@ -399,11 +762,16 @@ void menu_entries_prepend(file_list_t *list, const char *path, const char *label
    size_t idx;
    const char *menu_path           = NULL;
    menu_file_list_cbs_t *cbs       = NULL;
+   menu_entries_virtual_list_t *vlist = NULL;
    if (!list || !label)
       return;
 
    file_list_prepend(list, path, label, type, directory_ptr, entry_idx);
 
+   vlist = menu_entries_virtual_get(list);
+   if (vlist)
+      vlist->base++;
+
    menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
 
    idx              = 0;
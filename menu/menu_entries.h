@@ -21,6 +21,7 @@
 
 #include <boolean.h>
 #include <retro_common_api.h>
+#include <retro_miscellaneous.h>
 
 #include "widgets/menu_list.h"
 
@@ -113,6 +114,32 @@ typedef struct menu_file_list_cbs
          char *path_buf, size_t path_buf_size);
 } menu_file_list_cbs_t;
 
+/* One entry of a virtual list, as filled in by
+ * menu_entries_virtual_t.get. */
+typedef struct menu_entries_virtual_entry
+{
+   const char *path;
+   const char *label;
+   enum msg_hash_enums enum_idx;
+   unsigned type;
+   size_t entry_idx;
+   /* Scratch space for get() to format path or label in. */
+   char buf[PATH_MAX_LENGTH];
+} menu_entries_virtual_entry_t;
+
+typedef struct menu_entries_virtual
+{
+   /* Fills in entry @idx. entry_idx defaults to @idx. */
+   void (*get)(void *data, size_t idx,
+         menu_entries_virtual_entry_t *entry);
+   /* Returns the name entry @idx is searched and jumped to by,
+    * never NULL, and optionally its type. Has to be cheap,
+    * it gets called for every entry. */
+   const char *(*get_name)(void *data, size_t idx, unsigned *type);
+   void (*free)(void *data);
+   void *data;
+} menu_entries_virtual_t;
+
 int menu_entries_get_title(char *title, size_t title_len);
 
 bool menu_entries_current_core_is_no_core(void);
@@ -155,6 +182,52 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx);
 
+/**
+ * menu_entries_append_virtual:
+ * @list                     : File list handle.
+ * @count                    : Number of entries.
+ * @source                   : Where the entries come from.
+ *
+ * Appends @count entries that are only filled in from @source
+ * once they come close to the selection, so that building huge
+ * lists doesn't cost anything per entry. Drivers which don't
+ * set virtual_lists get all of them filled in right away.
+ * There can be only one such run of entries per list. The list
+ * owns @source->data from here on.
+ **/
+void menu_entries_append_virtual(file_list_t *list, size_t count,
+      const menu_entries_virtual_t *source);
+
+/**
+ * menu_entries_copy_virtual:
+ * @src                      : File list handle.
+ * @dst                      : Copy of entries [@first, @last] of @src.
+ * @first                    : First entry copied.
+ * @last                     : Last entry copied.
+ *
+ * Lets the virtual entries of @src that got copied into @dst
+ * as pending entries be filled in from the source of @src,
+ * which both lists share from here on.
+ **/
+void menu_entries_copy_virtual(const file_list_t *src,
+      file_list_t *dst, size_t first, size_t last);
+
+/* Fills in the virtual entries of the current
+ * selection list around @selection. */
+void menu_entries_fill_window(size_t selection);
+
+/**
+ * menu_entries_search:
+ * @needle                   : String to search for.
+ * @idx                      : Index of the match.
+ *
+ * Searches the current selection list like file_list_search(),
+ * without filling in virtual entries.
+ *
+ * Returns: true if there was a match.
+ **/
+bool menu_entries_search(const char *needle, size_t *idx);
+
 bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data);
 
 RETRO_END_DECLS
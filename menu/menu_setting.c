@@ -58,6 +58,7 @@
 #include "menu_driver.h"
 #include "menu_animation.h"
 #include "menu_input.h"
+#include "menu_thumbnail_cache.h"
 
 #include "../core.h"
 #include "../configuration.h"
@@ -1857,6 +1858,14 @@ void general_write_handler(void *data)
       case MENU_ENUM_LABEL_VIDEO_WINDOW_SHOW_DECORATIONS:
          video_display_server_set_window_decorations(settings->bools.video_window_show_decorations);
          break;
+      case MENU_ENUM_LABEL_USER_LANGUAGE:
+         msg_hash_set_uint(MSG_HASH_USER_LANGUAGE,
+               *msg_hash_get_uint(MSG_HASH_USER_LANGUAGE));
+         break;
+      case MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE:
+         /* Drop what no longer fits, the cache refills on demand. */
+         menu_thumbnail_cache_free();
+         break;
       default:
          break;
    }
@@ -3887,6 +3896,23 @@ static bool setting_append_list(
             menu_settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
             settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
 
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.video_frame_delay_auto,
+                  MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+                  MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO,
+                  frame_delay_auto,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE
+                  );
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
+
 #if !defined(RARCH_MOBILE)
             CONFIG_BOOL(
                   list, list_info,
@@ -6015,6 +6041,32 @@ static bool setting_append_list(
                   general_write_handler,
                   general_read_handler);
             menu_settings_list_current_add_range(list, list_info, 0, 3, 1, true, true);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.menu_thumbnail_cache_size,
+                  MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE,
+                  MENU_ENUM_LABEL_VALUE_THUMBNAIL_CACHE_SIZE,
+                  menu_thumbnail_cache_size,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 0, 256, 8, true, true);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.menu_thumbnail_prefetch,
+                  MENU_ENUM_LABEL_THUMBNAIL_PREFETCH,
+                  MENU_ENUM_LABEL_VALUE_THUMBNAIL_PREFETCH,
+                  menu_thumbnail_prefetch,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 0, 8, 1, true, true);
          }
 
          CONFIG_BOOL(
@@ -6939,6 +6991,36 @@ static bool setting_append_list(
                   SD_FLAG_NONE);
             settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.netplay_udp_input,
+                  MENU_ENUM_LABEL_NETPLAY_UDP_INPUT,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_INPUT,
+                  netplay_udp_input,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE);
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.netplay_udp_redundancy,
+                  MENU_ENUM_LABEL_NETPLAY_UDP_REDUNDANCY,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_UDP_REDUNDANCY,
+                  netplay_udp_redundancy,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 1, 60, 1, true, true);
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
             CONFIG_UINT(
                   list, list_info,
                   &settings->uints.netplay_share_digital,
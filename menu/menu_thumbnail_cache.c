@@ -0,0 +1,420 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <formats/image.h>
+#include <string/stdstring.h>
+
+#include "menu_thumbnail_cache.h"
+
+#include "../configuration.h"
+#include "../msg_hash.h"
+#include "../tasks/tasks_internal.h"
+
+#define MENU_THUMBNAIL_CACHE_BUCKETS     256
+#define MENU_THUMBNAIL_CACHE_MAX_PENDING 8
+
+/* All of the cache is only ever touched from the main thread:
+ * lookups come from the menu drivers, and insertions from task
+ * callbacks, which are run by task_queue_check(). */
+
+typedef struct menu_thumbnail_cache_entry
+{
+   uint32_t hash;
+   char *path;
+   size_t size;
+   struct texture_image image;
+   /* LRU list, head is the most recently used */
+   struct menu_thumbnail_cache_entry *prev;
+   struct menu_thumbnail_cache_entry *next;
+   /* Hash bucket chain */
+   struct menu_thumbnail_cache_entry *chain;
+} menu_thumbnail_cache_entry_t;
+
+typedef struct menu_thumbnail_cache_request
+{
+   char *path;
+   retro_task_callback_t cb;
+   void *user_data;
+   struct menu_thumbnail_cache_request *next;
+} menu_thumbnail_cache_request_t;
+
+typedef struct menu_thumbnail_cache
+{
+   menu_thumbnail_cache_entry_t *buckets[MENU_THUMBNAIL_CACHE_BUCKETS];
+   menu_thumbnail_cache_entry_t *head;
+   menu_thumbnail_cache_entry_t *tail;
+   menu_thumbnail_cache_request_t *pending;
+   unsigned pending_prefetches;
+   unsigned entries;
+   size_t bytes_used;
+   unsigned hits;
+   unsigned misses;
+   unsigned prefetches;
+   unsigned evictions;
+} menu_thumbnail_cache_t;
+
+static menu_thumbnail_cache_t thumbnail_cache;
+
+static size_t menu_thumbnail_cache_max_bytes(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (!settings)
+      return 0;
+
+   return (size_t)settings->uints.menu_thumbnail_cache_size * 1024 * 1024;
+}
+
+static void menu_thumbnail_cache_unlink(menu_thumbnail_cache_entry_t *entry)
+{
+   if (entry->prev)
+      entry->prev->next    = entry->next;
+   else
+      thumbnail_cache.head = entry->next;
+
+   if (entry->next)
+      entry->next->prev    = entry->prev;
+   else
+      thumbnail_cache.tail = entry->prev;
+
+   entry->prev = NULL;
+   entry->next = NULL;
+}
+
+static void menu_thumbnail_cache_link_head(menu_thumbnail_cache_entry_t *entry)
+{
+   entry->prev = NULL;
+   entry->next = thumbnail_cache.head;
+
+   if (thumbnail_cache.head)
+      thumbnail_cache.head->prev = entry;
+   else
+      thumbnail_cache.tail       = entry;
+
+   thumbnail_cache.head = entry;
+}
+
+static menu_thumbnail_cache_entry_t *menu_thumbnail_cache_find(
+      const char *path, uint32_t hash)
+{
+   menu_thumbnail_cache_entry_t *entry =
+      thumbnail_cache.buckets[hash % MENU_THUMBNAIL_CACHE_BUCKETS];
+
+   for (; entry; entry = entry->chain)
+      if (entry->hash == hash && string_is_equal(entry->path, path))
+         return entry;
+
+   return NULL;
+}
+
+static void menu_thumbnail_cache_remove(menu_thumbnail_cache_entry_t *entry)
+{
+   menu_thumbnail_cache_entry_t **link =
+      &thumbnail_cache.buckets[entry->hash % MENU_THUMBNAIL_CACHE_BUCKETS];
+
+   while (*link && *link != entry)
+      link = &(*link)->chain;
+   if (*link)
+      *link = entry->chain;
+
+   menu_thumbnail_cache_unlink(entry);
+
+   thumbnail_cache.bytes_used -= entry->size;
+   thumbnail_cache.entries--;
+
+   image_texture_free(&entry->image);
+   free(entry->path);
+   free(entry);
+}
+
+static void menu_thumbnail_cache_insert(const char *path,
+      const struct texture_image *img)
+{
+   menu_thumbnail_cache_entry_t *entry = NULL;
+   uint32_t hash                       = msg_hash_calculate(path);
+   size_t max_bytes                    = menu_thumbnail_cache_max_bytes();
+   size_t size                         = (size_t)img->width
+      * img->height * sizeof(uint32_t);
+
+   if (!img->pixels || size == 0 || size > max_bytes)
+      return;
+
+   /* Possible when a prefetch and a regular load raced. */
+   if (menu_thumbnail_cache_find(path, hash))
+      return;
+
+   while (thumbnail_cache.tail
+         && thumbnail_cache.bytes_used + size > max_bytes)
+   {
+      menu_thumbnail_cache_remove(thumbnail_cache.tail);
+      thumbnail_cache.evictions++;
+   }
+
+   entry = (menu_thumbnail_cache_entry_t*)calloc(1, sizeof(*entry));
+   if (!entry)
+      return;
+
+   entry->image.pixels = (uint32_t*)malloc(size);
+   if (!entry->image.pixels)
+   {
+      free(entry);
+      return;
+   }
+
+   memcpy(entry->image.pixels, img->pixels, size);
+   entry->image.width         = img->width;
+   entry->image.height        = img->height;
+   entry->image.supports_rgba = img->supports_rgba;
+   entry->hash                = hash;
+   entry->path                = strdup(path);
+   entry->size                = size;
+   entry->chain               =
+      thumbnail_cache.buckets[hash % MENU_THUMBNAIL_CACHE_BUCKETS];
+   thumbnail_cache.buckets[hash % MENU_THUMBNAIL_CACHE_BUCKETS] = entry;
+
+   menu_thumbnail_cache_link_head(entry);
+
+   thumbnail_cache.bytes_used += size;
+   thumbnail_cache.entries++;
+}
+
+static struct texture_image *menu_thumbnail_cache_copy(
+      const struct texture_image *src)
+{
+   size_t size               = (size_t)src->width
+      * src->height * sizeof(uint32_t);
+   struct texture_image *img = (struct texture_image*)
+      malloc(sizeof(*img));
+
+   if (!img)
+      return NULL;
+
+   img->pixels = (uint32_t*)malloc(size);
+   if (!img->pixels)
+   {
+      free(img);
+      return NULL;
+   }
+
+   memcpy(img->pixels, src->pixels, size);
+   img->width         = src->width;
+   img->height        = src->height;
+   img->supports_rgba = src->supports_rgba;
+
+   return img;
+}
+
+static void menu_thumbnail_cache_hit_handler(retro_task_t *task)
+{
+   task_set_data(task, task->state);
+   task->state = NULL;
+   task_set_finished(task, true);
+}
+
+static void menu_thumbnail_cache_hit_cleanup(retro_task_t *task)
+{
+   struct texture_image *img = (struct texture_image*)task->state;
+
+   if (!img)
+      return;
+
+   image_texture_free(img);
+   free(img);
+}
+
+/* Hands a cached copy to @cb from a task, so hits reach the menu
+ * drivers at the same point in the frame as loads that missed. */
+static bool menu_thumbnail_cache_push_hit(struct texture_image *img,
+      retro_task_callback_t cb, void *user_data)
+{
+   retro_task_t *t = (retro_task_t*)calloc(1, sizeof(*t));
+
+   if (!t)
+      return false;
+
+   t->state     = img;
+   t->handler   = menu_thumbnail_cache_hit_handler;
+   t->cleanup   = menu_thumbnail_cache_hit_cleanup;
+   t->callback  = cb;
+   t->user_data = user_data;
+
+   task_queue_push(t);
+
+   return true;
+}
+
+static menu_thumbnail_cache_request_t *menu_thumbnail_cache_find_pending(
+      const char *path)
+{
+   menu_thumbnail_cache_request_t *req = thumbnail_cache.pending;
+
+   for (; req; req = req->next)
+      if (string_is_equal(req->path, path))
+         return req;
+
+   return NULL;
+}
+
+static void menu_thumbnail_cache_cb(void *task_data,
+      void *user_data, const char *err)
+{
+   struct texture_image *img            = (struct texture_image*)task_data;
+   menu_thumbnail_cache_request_t *req  = (menu_thumbnail_cache_request_t*)
+      user_data;
+   menu_thumbnail_cache_request_t **link = &thumbnail_cache.pending;
+
+   while (*link && *link != req)
+      link = &(*link)->next;
+   if (*link)
+      *link = req->next;
+
+   if (!req->cb && thumbnail_cache.pending_prefetches > 0)
+      thumbnail_cache.pending_prefetches--;
+
+   if (img && !err)
+      menu_thumbnail_cache_insert(req->path, img);
+
+   if (req->cb)
+      req->cb(task_data, req->user_data, err);
+   else if (img)
+   {
+      image_texture_free(img);
+      free(img);
+   }
+
+   free(req->path);
+   free(req);
+}
+
+static bool menu_thumbnail_cache_push(const char *path,
+      retro_task_callback_t cb, void *user_data)
+{
+   menu_thumbnail_cache_request_t *req = (menu_thumbnail_cache_request_t*)
+      calloc(1, sizeof(*req));
+
+   if (!req)
+      return false;
+
+   req->path      = strdup(path);
+   req->cb        = cb;
+   req->user_data = user_data;
+
+   if (!task_push_image_load(path, menu_thumbnail_cache_cb, req))
+   {
+      free(req->path);
+      free(req);
+      return false;
+   }
+
+   req->next               = thumbnail_cache.pending;
+   thumbnail_cache.pending = req;
+
+   return true;
+}
+
+bool menu_thumbnail_cache_load(const char *path,
+      retro_task_callback_t cb, void *user_data)
+{
+   menu_thumbnail_cache_entry_t *entry = NULL;
+   menu_thumbnail_cache_request_t *req = NULL;
+
+   if (string_is_empty(path))
+      return false;
+
+   if (menu_thumbnail_cache_max_bytes() == 0)
+      return task_push_image_load(path, cb, user_data);
+
+   entry = menu_thumbnail_cache_find(path, msg_hash_calculate(path));
+
+   if (entry)
+   {
+      struct texture_image *img = menu_thumbnail_cache_copy(&entry->image);
+
+      if (img)
+      {
+         if (menu_thumbnail_cache_push_hit(img, cb, user_data))
+         {
+            thumbnail_cache.hits++;
+
+            menu_thumbnail_cache_unlink(entry);
+            menu_thumbnail_cache_link_head(entry);
+            return true;
+         }
+
+         image_texture_free(img);
+         free(img);
+      }
+   }
+
+   thumbnail_cache.misses++;
+
+   /* Piggyback on a prefetch of the same image, if any. */
+   req = menu_thumbnail_cache_find_pending(path);
+   if (req && !req->cb)
+   {
+      req->cb        = cb;
+      req->user_data = user_data;
+      if (thumbnail_cache.pending_prefetches > 0)
+         thumbnail_cache.pending_prefetches--;
+      return true;
+   }
+
+   return menu_thumbnail_cache_push(path, cb, user_data);
+}
+
+void menu_thumbnail_cache_prefetch(const char *path)
+{
+   if (string_is_empty(path) || menu_thumbnail_cache_max_bytes() == 0)
+      return;
+
+   if (thumbnail_cache.pending_prefetches >= MENU_THUMBNAIL_CACHE_MAX_PENDING)
+      return;
+
+   if (menu_thumbnail_cache_find(path, msg_hash_calculate(path)))
+      return;
+
+   if (menu_thumbnail_cache_find_pending(path))
+      return;
+
+   if (menu_thumbnail_cache_push(path, NULL, NULL))
+   {
+      thumbnail_cache.pending_prefetches++;
+      thumbnail_cache.prefetches++;
+   }
+}
+
+void menu_thumbnail_cache_get_stats(menu_thumbnail_cache_stats_t *stats)
+{
+   if (!stats)
+      return;
+
+   stats->hits       = thumbnail_cache.hits;
+   stats->misses     = thumbnail_cache.misses;
+   stats->prefetches = thumbnail_cache.prefetches;
+   stats->evictions  = thumbnail_cache.evictions;
+   stats->entries    = thumbnail_cache.entries;
+   stats->bytes_used = thumbnail_cache.bytes_used;
+   stats->bytes_max  = menu_thumbnail_cache_max_bytes();
+}
+
+void menu_thumbnail_cache_free(void)
+{
+   while (thumbnail_cache.head)
+      menu_thumbnail_cache_remove(thumbnail_cache.head);
+}
@@ -0,0 +1,73 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MENU_THUMBNAIL_CACHE_H
+#define _MENU_THUMBNAIL_CACHE_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <queues/task_queue.h>
+
+RETRO_BEGIN_DECLS
+
+typedef struct menu_thumbnail_cache_stats
+{
+   unsigned hits;
+   unsigned misses;
+   unsigned prefetches;
+   unsigned evictions;
+   unsigned entries;
+   size_t bytes_used;
+   size_t bytes_max;
+} menu_thumbnail_cache_stats_t;
+
+/**
+ * menu_thumbnail_cache_load:
+ * @path                : path of the image to load
+ * @cb                  : callback receiving the decoded texture_image
+ * @user_data           : passed as is to @cb
+ *
+ * Drop-in replacement for task_push_image_load() for menu thumbnails.
+ * On a cache hit a task hands @cb a copy of the decoded image,
+ * otherwise the image is loaded by a task and added to the cache
+ * once decoded. Either way @cb runs from task_queue_check() and
+ * owns the image.
+ *
+ * Returns: true if a task was pushed.
+ **/
+bool menu_thumbnail_cache_load(const char *path,
+      retro_task_callback_t cb, void *user_data);
+
+/**
+ * menu_thumbnail_cache_prefetch:
+ * @path                : path of the image to load
+ *
+ * Decodes @path in the background and adds it to the cache, so a
+ * later menu_thumbnail_cache_load() on it is a hit. Does nothing if
+ * the image is already cached or being loaded.
+ **/
+void menu_thumbnail_cache_prefetch(const char *path);
+
+void menu_thumbnail_cache_get_stats(menu_thumbnail_cache_stats_t *stats);
+
+/* Releases all cached images. Loads in flight are kept alive
+ * and will repopulate the cache when they finish. */
+void menu_thumbnail_cache_free(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -57,10 +57,64 @@ void filebrowser_set_type(enum filebrowser_enums type)
    filebrowser_types = type;
 }
 
+typedef struct filebrowser_entry
+{
+   size_t elem;
+   enum msg_file_type file_type;
+   enum msg_hash_enums enum_idx;
+} filebrowser_entry_t;
+
+typedef struct filebrowser_source
+{
+   struct string_list *str_list;
+   filebrowser_entry_t *entries;
+   bool path_is_compressed;
+} filebrowser_source_t;
+
+static const char *filebrowser_source_get_name(void *data,
+      size_t idx, unsigned *type)
+{
+   filebrowser_source_t *src     = (filebrowser_source_t*)data;
+   const filebrowser_entry_t *e  = &src->entries[idx];
+   const char *path              = src->str_list->elems[e->elem].data;
+
+   if (type)
+      *type = e->file_type;
+
+   /* Need to preserve slash first time. */
+   if (!string_is_empty(path) && !src->path_is_compressed)
+      path = path_basename(path);
+
+   return path ? path : "";
+}
+
+static void filebrowser_source_get(void *data, size_t idx,
+      menu_entries_virtual_entry_t *entry)
+{
+   filebrowser_source_t *src     = (filebrowser_source_t*)data;
+   const filebrowser_entry_t *e  = &src->entries[idx];
+
+   entry->path      = filebrowser_source_get_name(data, idx, NULL);
+   entry->label     = "";
+   entry->enum_idx  = e->enum_idx;
+   entry->type      = e->file_type;
+   entry->entry_idx = 0;
+}
+
+static void filebrowser_source_free(void *data)
+{
+   filebrowser_source_t *src     = (filebrowser_source_t*)data;
+
+   string_list_free(src->str_list);
+   free(src->entries);
+   free(src);
+}
+
 void filebrowser_parse(void *data, unsigned type_data)
 {
    size_t i, list_size;
    struct string_list *str_list         = NULL;
+   filebrowser_source_t *src            = NULL;
    unsigned items_found                 = 0;
    unsigned files_count                 = 0;
    unsigned dirs_count                  = 0;
@@ -145,16 +199,24 @@ void filebrowser_parse(void *data, unsigned type_data)
    }
    else
    {
+      src = (filebrowser_source_t*)calloc(1, sizeof(*src));
+      if (src)
+         src->entries = (filebrowser_entry_t*)
+            malloc(list_size * sizeof(*src->entries));
+      if (!src || !src->entries)
+      {
+         free(src);
+         src = NULL;
+         list_size = 0;
+      }
+
       for (i = 0; i < list_size; i++)
       {
-         char label[64];
          bool is_dir                   = false;
          enum msg_hash_enums enum_idx  = MSG_UNKNOWN;
          enum msg_file_type file_type  = FILE_TYPE_NONE;
          const char *path              = str_list->elems[i].data;
 
-         label[0] = '\0';
-
          switch (str_list->elems[i].attr.i)
          {
             case RARCH_DIRECTORY:
@@ -272,15 +334,37 @@ void filebrowser_parse(void *data, unsigned type_data)
                break;
          }
 
+         src->entries[items_found].elem      = i;
+         src->entries[items_found].file_type = file_type;
+         src->entries[items_found].enum_idx  = enum_idx;
          items_found++;
-         menu_entries_append_enum(info->list, path, label,
-               enum_idx,
-               file_type, 0, 0);
       }
    }
 
-   if (str_list && str_list->size > 0)
-      string_list_free(str_list);
+   /* The entries themselves are only built once
+    * they scroll into view. */
+   if (src && items_found > 0)
+   {
+      menu_entries_virtual_t source;
+
+      src->str_list           = str_list;
+      src->path_is_compressed = path_is_compressed;
+
+      source.get              = filebrowser_source_get;
+      source.get_name         = filebrowser_source_get_name;
+      source.free             = filebrowser_source_free;
+      source.data             = src;
+
+      menu_entries_append_virtual(info->list, items_found, &source);
+   }
+   else
+   {
+      if (src)
+         free(src->entries);
+      free(src);
+      if (str_list && str_list->size > 0)
+         string_list_free(str_list);
+   }
 
    if (items_found == 0)
    {
@@ -31,12 +31,8 @@ static char menu_input_dialog_keyboard_label[256]          = {0};
 static void menu_input_search_cb(void *userdata, const char *str)
 {
    size_t idx = 0;
-   file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
 
-   if (!selection_buf)
-      return;
-
-   if (str && *str && file_list_search(selection_buf, str, &idx))
+   if (str && *str && menu_entries_search(str, &idx))
    {
       menu_navigation_set_selection(idx);
       menu_driver_navigation_set(true);
@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <rhash.h>
@@ -29,6 +30,11 @@
 
 static unsigned uint_user_language;
 
+/* Strings of each language indexed by enum. Built on the main
+ * thread when the language is set, and only freed at deinit, so
+ * task threads can look them up without locking. */
+static const char **msg_hash_tables[RETRO_LANGUAGE_LAST];
+
 int menu_hash_get_help_enum(enum msg_hash_enums msg, char *s, size_t len)
 {
    int ret = -1;
@@ -92,12 +98,13 @@ int menu_hash_get_help_enum(enum msg_hash_enums msg, char *s, size_t len)
    return menu_hash_get_help_us_enum(msg, s, len);
 }
 
-const char *msg_hash_to_str(enum msg_hash_enums msg)
+static const char *msg_hash_to_str_lang(unsigned lang,
+      enum msg_hash_enums msg)
 {
    const char *ret = NULL;
 
 #ifdef HAVE_LANGEXTRA
-   switch (uint_user_language)
+   switch (lang)
    {
       case RETRO_LANGUAGE_FRENCH:
          ret = msg_hash_to_str_fr(msg);
@@ -158,6 +165,62 @@ const char *msg_hash_to_str(enum msg_hash_enums msg)
    return msg_hash_to_str_us(msg);
 }
 
+/* Builds the table of all strings of @lang, indexed by enum,
+ * out of the msg_hash_to_str_*() switches.
+ *
+ * Hotkey bind labels are formatted on the fly into a static
+ * buffer, those are left out and looked up the slow way. */
+static const char **msg_hash_build_strings(unsigned lang)
+{
+   unsigned i;
+   const char **strings = (const char**)
+      calloc(MSG_LAST, sizeof(*strings));
+
+   if (!strings)
+      return NULL;
+
+   for (i = 0; i < MSG_LAST; i++)
+   {
+#ifdef HAVE_MENU
+      if (i >= MENU_ENUM_LABEL_INPUT_HOTKEY_BIND_BEGIN &&
+            i <= MENU_ENUM_LABEL_INPUT_HOTKEY_BIND_END)
+         continue;
+#endif
+      strings[i] = msg_hash_to_str_lang(lang, (enum msg_hash_enums)i);
+   }
+
+   return strings;
+}
+
+const char *msg_hash_to_str(enum msg_hash_enums msg)
+{
+   const char *ret = NULL;
+   unsigned lang   = uint_user_language;
+
+   /* The language setting is also written to directly, a language
+    * without a table yet is looked up through the switches. */
+   if (lang < RETRO_LANGUAGE_LAST && msg_hash_tables[lang]
+         && (unsigned)msg < MSG_LAST)
+      ret = msg_hash_tables[lang][msg];
+
+   if (ret)
+      return ret;
+
+   return msg_hash_to_str_lang(lang, msg);
+}
+
+void msg_hash_deinit(void)
+{
+   unsigned i;
+
+   for (i = 0; i < RETRO_LANGUAGE_LAST; i++)
+   {
+      if (msg_hash_tables[i])
+         free((void*)msg_hash_tables[i]);
+      msg_hash_tables[i] = NULL;
+   }
+}
+
 uint32_t msg_hash_calculate(const char *s)
 {
    return djb2_calculate(s);
@@ -419,6 +482,8 @@ void msg_hash_set_uint(enum msg_hash_action type, unsigned val)
    switch (type)
    {
       case MSG_HASH_USER_LANGUAGE:
+         if (val < RETRO_LANGUAGE_LAST && !msg_hash_tables[val])
+            msg_hash_tables[val] = msg_hash_build_strings(val);
          uint_user_language = val;
          break;
       case MSG_HASH_NONE:
@@ -260,6 +260,7 @@ enum msg_hash_enums
    MSG_COULD_NOT_OPEN_DATA_TRACK,
    MSG_FOUND_FIRST_DATA_TRACK_ON_FILE,
    MSG_FRAMES,
+   MSG_LATE_FRAMES,
    MSG_FOUND_SHADER,
    MSG_LOADING_HISTORY_FILE,
    MSG_COULD_NOT_READ_STATE_FROM_MOVIE,
@@ -679,6 +680,7 @@ enum msg_hash_enums
    MENU_LABEL(VIDEO_GPU_SCREENSHOT),
    MENU_LABEL(VIDEO_BLACK_FRAME_INSERTION),
    MENU_LABEL(VIDEO_FRAME_DELAY),
+   MENU_LABEL(VIDEO_FRAME_DELAY_AUTO),
    MENU_LABEL(VIDEO_VSYNC),
    MENU_LABEL(VIDEO_HARD_SYNC),
    MENU_LABEL(VIDEO_HARD_SYNC_FRAMES),
@@ -768,6 +770,8 @@ enum msg_hash_enums
    MENU_LABEL(CONTENT_SHOW_ADD),
    MENU_LABEL(XMB_RIBBON_ENABLE),
    MENU_LABEL(THUMBNAILS),
+   MENU_LABEL(THUMBNAIL_CACHE_SIZE),
+   MENU_LABEL(THUMBNAIL_PREFETCH),
    MENU_LABEL(TIMEDATE_ENABLE),
    MENU_LABEL(BATTERY_LEVEL_ENABLE),
    MENU_LABEL(MATERIALUI_MENU_COLOR_THEME),
@@ -1176,6 +1180,8 @@ enum msg_hash_enums
    MENU_LABEL(NETPLAY_SPECTATOR_MODE_ENABLE),
    MENU_LABEL(NETPLAY_TCP_UDP_PORT),
    MENU_LABEL(NETPLAY_NAT_TRAVERSAL),
+   MENU_LABEL(NETPLAY_UDP_INPUT),
+   MENU_LABEL(NETPLAY_UDP_REDUNDANCY),
    MENU_LABEL(NETPLAY_REQUEST_DEVICE_I),
    MENU_ENUM_LABEL_NETPLAY_REQUEST_DEVICE_1,
    MENU_ENUM_LABEL_NETPLAY_REQUEST_DEVICE_LAST = MENU_ENUM_LABEL_NETPLAY_REQUEST_DEVICE_1 + MAX_USERS,
@@ -1567,6 +1573,8 @@ enum msg_hash_enums
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_DISPLAY_METRIC_MM_HEIGHT,
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_DISPLAY_METRIC_DPI,
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_LIBRETRODB_SUPPORT,
+   MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_USAGE,
+   MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_THUMBNAIL_CACHE_HITS,
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_OVERLAY_SUPPORT,
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_COMMAND_IFACE_SUPPORT,
    MENU_ENUM_LABEL_VALUE_SYSTEM_INFO_NETWORK_COMMAND_IFACE_SUPPORT,
@@ -2034,6 +2042,8 @@ unsigned *msg_hash_get_uint(enum msg_hash_action type);
 
 void msg_hash_set_uint(enum msg_hash_action type, unsigned val);
 
+void msg_hash_deinit(void);
+
 uint32_t msg_hash_calculate(const char *s);
 
 RETRO_END_DECLS
@@ -59,7 +59,9 @@ enum rarch_netplay_ctl_state
    RARCH_NETPLAY_CTL_DISCONNECT,
    RARCH_NETPLAY_CTL_FINISHED_NAT_TRAVERSAL,
    RARCH_NETPLAY_CTL_DESYNC_PUSH,
-   RARCH_NETPLAY_CTL_DESYNC_POP
+   RARCH_NETPLAY_CTL_DESYNC_POP,
+   RARCH_NETPLAY_CTL_GET_STATS,
+   RARCH_NETPLAY_CTL_IS_REPLAYING
 };
 
 /* Preferences for sharing digital devices */
@@ -83,6 +85,59 @@ enum rarch_netplay_share_analog_preference
    RARCH_NETPLAY_SHARE_ANALOG_LAST
 };
 
+#define NETPLAY_STATS_HISTOGRAM_SIZE 8
+
+typedef struct netplay_stats
+{
+   /* Size of a serialized state */
+   size_t state_size;
+
+   /* Rollback buffer snapshots. Times are in microseconds, sizes in bytes.
+    * The encoded size of the last snapshot is a good measure of how much
+    * of the state changes per frame. */
+   uint64_t snapshot_saves;
+   uint64_t snapshot_loads;
+   uint64_t snapshot_keyframes;
+   uint64_t snapshot_save_time;
+   uint64_t snapshot_load_time;
+   uint64_t snapshot_bytes;
+   uint64_t snapshot_last_time;
+   size_t snapshot_last_size;
+   size_t snapshot_memory;
+
+   /* Rollbacks. Replays that don't fit in the time budget of a frame are
+    * finished over the next frames, those frames are counted as deferred.
+    * rollback_depth[i] counts rollbacks of 2^i to 2^(i+1)-1 frames, and
+    * replay_time[i] frames spending less than 0.5 ms << i on replays. The
+    * last buckets hold everything larger. */
+   uint64_t rollbacks;
+   uint64_t replayed_frames;
+   uint64_t deferred_frames;
+   uint64_t replay_frame_time;
+   unsigned rollback_depth[NETPLAY_STATS_HISTOGRAM_SIZE];
+   unsigned replay_time[NETPLAY_STATS_HISTOGRAM_SIZE];
+
+   /* UDP input transport. udp_lost counts gaps in the datagrams received,
+    * udp_tcp_records input that was sent over TCP after all, and udp_rtt is
+    * the smoothed round trip time in microseconds. */
+   uint64_t udp_sent;
+   uint64_t udp_received;
+   uint64_t udp_lost;
+   uint64_t udp_input_frames;
+   uint64_t udp_tcp_records;
+   uint64_t udp_sim_dropped;
+   uint64_t udp_rtt;
+
+   /* Savestates sent to joining clients, and the longest time a frame spent
+    * sending one, in microseconds. state_stream_time is how long the last
+    * streamed savestate took from join to load, in milliseconds. */
+   uint64_t state_sends;
+   uint64_t state_send_bytes;
+   uint64_t state_send_stall;
+   uint64_t state_stream_rounds;
+   uint64_t state_stream_time;
+} netplay_stats_t;
+
 int16_t input_state_net(unsigned port, unsigned device,
       unsigned idx, unsigned id);
 
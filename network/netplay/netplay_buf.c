@@ -14,12 +14,18 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <net/net_compat.h>
 #include <net/net_socket.h>
 
 #include "netplay_private.h"
 
+#ifdef NETPLAY_HAVE_EPOLL
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 static size_t buf_used(struct socket_buffer *sbuf)
 {
    if (sbuf->end < sbuf->start)
@@ -165,6 +171,16 @@ bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
    return true;
 }
 
+/**
+ * netplay_send_pending
+ *
+ * Get the amount of data queued in the given socket buffer but not sent yet.
+ */
+size_t netplay_send_pending(struct socket_buffer *sbuf)
+{
+   return buf_used(sbuf);
+}
+
 /**
  * netplay_send_flush
  *
@@ -216,6 +232,32 @@ bool netplay_send_flush(struct socket_buffer *sbuf, int sockfd, bool block)
       }
       else
       {
+#ifdef NETPLAY_HAVE_EPOLL
+         /* Both halves with one call */
+         struct iovec iov[2];
+         struct msghdr msg;
+
+         memset(&msg, 0, sizeof(msg));
+         iov[0].iov_base = sbuf->data + sbuf->start;
+         iov[0].iov_len  = sbuf->bufsz - sbuf->start;
+         iov[1].iov_base = sbuf->data;
+         iov[1].iov_len  = sbuf->end;
+         msg.msg_iov     = iov;
+         msg.msg_iovlen  = 2;
+
+         sent = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+         if (sent < 0)
+            return isagain((int)sent);
+         if ((size_t)sent < iov[0].iov_len)
+         {
+            sbuf->start += sent;
+            return true;
+         }
+
+         sbuf->start = sent - iov[0].iov_len;
+         if (sbuf->start == sbuf->end)
+            sbuf->start = sbuf->end = 0;
+#else
          sent = socket_send_all_nonblocking(sockfd, sbuf->data + sbuf->start, sbuf->bufsz - sbuf->start, true);
          if (sent < 0)
             return false;
@@ -227,6 +269,7 @@ bool netplay_send_flush(struct socket_buffer *sbuf, int sockfd, bool block)
             return netplay_send_flush(sbuf, sockfd, false);
 
          }
+#endif
 
       }
 
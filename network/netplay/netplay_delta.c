@@ -16,13 +16,21 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <boolean.h>
+#include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <encodings/crc32.h>
+#include <features/features_cpu.h>
 
 #include "netplay_private.h"
 
+/* Unchanged gaps shorter than this are folded into the surrounding runs, as
+ * a run header costs about as much */
+#define NETPLAY_SNAPSHOT_MIN_GAP 16
+
 static void clear_input(netplay_input_state_t istate)
 {
    while (istate)
@@ -69,6 +77,303 @@ bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
    return true;
 }
 
+/*
+ * Snapshots are a list of runs, each one a header of two native uint32_t
+ * (unchanged bytes skipped since the end of the previous run, and run
+ * length) followed by the run's bytes XORed with the keyframe. States are
+ * compared a 64-bit word at a time, so runs start on word boundaries and
+ * cover whole words, save for the tail of the state.
+ */
+
+#define SNAPSHOT_WORD sizeof(uint64_t)
+
+static INLINE bool snapshot_word_equal(const uint8_t *a, const uint8_t *b,
+      size_t pos)
+{
+   uint64_t x, y;
+   memcpy(&x, a + pos, sizeof(x));
+   memcpy(&y, b + pos, sizeof(y));
+   return x == y;
+}
+
+static size_t snapshot_find_diff(const uint8_t *a, const uint8_t *b,
+      size_t pos, size_t size)
+{
+   while (pos + SNAPSHOT_WORD <= size)
+   {
+      if (!snapshot_word_equal(a, b, pos))
+         return pos;
+      pos += SNAPSHOT_WORD;
+   }
+   if (pos < size && memcmp(a + pos, b + pos, size - pos))
+      return pos;
+   return size;
+}
+
+/* Stops at @limit, unless the state ends first */
+static size_t snapshot_find_same(const uint8_t *a, const uint8_t *b,
+      size_t pos, size_t size, size_t limit)
+{
+   while (pos + SNAPSHOT_WORD <= size)
+   {
+      if (pos >= limit || snapshot_word_equal(a, b, pos))
+         return pos;
+      pos += SNAPSHOT_WORD;
+   }
+   return size;
+}
+
+static void snapshot_xor(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+      size_t len)
+{
+   size_t i = 0;
+
+   for (; i + SNAPSHOT_WORD <= len; i += SNAPSHOT_WORD)
+   {
+      uint64_t x, y;
+      memcpy(&x, a + i, sizeof(x));
+      memcpy(&y, b + i, sizeof(y));
+      x ^= y;
+      memcpy(dst + i, &x, sizeof(x));
+   }
+   for (; i < len; i++)
+      dst[i] = a[i] ^ b[i];
+}
+
+/**
+ * snapshot_encode
+ *
+ * Encode @state against @key into @out, giving up once the snapshot would
+ * exceed @out_size bytes.
+ *
+ * Returns: the size of the snapshot, or (size_t)-1 if it didn't fit.
+ */
+static size_t snapshot_encode(uint8_t *out, size_t out_size,
+      const uint8_t *state, const uint8_t *key, size_t size)
+{
+   size_t len      = 0;
+   size_t prev_end = 0;
+   size_t next     = snapshot_find_diff(state, key, 0, size);
+
+   while (next < size)
+   {
+      uint32_t header[2];
+      size_t start = next;
+      size_t limit;
+      size_t end;
+
+      if (len + sizeof(header) >= out_size)
+         return (size_t)-1;
+
+      /* Don't bother scanning past what would fit */
+      limit = start + (out_size - len - sizeof(header));
+      end   = snapshot_find_same(state, key, start, size, limit);
+
+      while (end < limit)
+      {
+         next = snapshot_find_diff(state, key, end, size);
+         if (next >= size || next - end >= NETPLAY_SNAPSHOT_MIN_GAP)
+            break;
+         end = snapshot_find_same(state, key, next, size, limit);
+      }
+
+      if (len + sizeof(header) + (end - start) > out_size || end == limit)
+         return (size_t)-1;
+
+      header[0] = (uint32_t)(start - prev_end);
+      header[1] = (uint32_t)(end - start);
+      memcpy(out + len, header, sizeof(header));
+      len += sizeof(header);
+
+      snapshot_xor(out + len, state + start, key + start, end - start);
+      len += end - start;
+
+      prev_end = end;
+   }
+
+   return len;
+}
+
+static void snapshot_decode(uint8_t *state, const uint8_t *snapshot,
+      size_t snapshot_size)
+{
+   size_t pos = 0;
+   size_t len = 0;
+
+   while (len + 2 * sizeof(uint32_t) <= snapshot_size)
+   {
+      uint32_t header[2];
+
+      memcpy(header, snapshot + len, sizeof(header));
+      len += sizeof(header);
+      pos += header[0];
+
+      snapshot_xor(state + pos, state + pos, snapshot + len, header[1]);
+      len += header[1];
+      pos += header[1];
+   }
+}
+
+static struct netplay_keyframe *netplay_keyframe_new(netplay_t *netplay,
+      const void *state)
+{
+   struct netplay_keyframe *keyframe = netplay->keyframe_spare;
+
+   if (keyframe)
+      netplay->keyframe_spare = NULL;
+   else
+   {
+      keyframe = (struct netplay_keyframe*)
+         malloc(sizeof(*keyframe) + netplay->state_size);
+      if (!keyframe)
+         return NULL;
+      netplay->stats.snapshot_memory += netplay->state_size;
+   }
+
+   keyframe->refs = 1;
+   memcpy(keyframe->data, state, netplay->state_size);
+
+   netplay->stats.snapshot_keyframes++;
+
+   return keyframe;
+}
+
+/**
+ * netplay_keyframe_unref
+ *
+ * Drop a reference to a keyframe, freeing it with the last one. One freed
+ * keyframe is kept around for reuse, as keyframes are large allocations
+ * that would otherwise be faulted in again every time.
+ */
+void netplay_keyframe_unref(netplay_t *netplay,
+      struct netplay_keyframe *keyframe)
+{
+   if (!keyframe || --keyframe->refs)
+      return;
+
+   if (!netplay->keyframe_spare)
+   {
+      netplay->keyframe_spare = keyframe;
+      return;
+   }
+
+   netplay->stats.snapshot_memory -= netplay->state_size;
+   free(keyframe);
+}
+
+/**
+ * netplay_delta_frame_save
+ * @netplay              : pointer to netplay object
+ * @delta                : delta frame to store the state in
+ * @state                : serialized state of netplay->state_size bytes,
+ *                         NULL for an all-zero state
+ *
+ * Store a serialized state in a delta frame, encoded against the current
+ * keyframe. A new keyframe is taken when the state has drifted too far from
+ * the current one.
+ *
+ * Returns: false if out of memory, in which case the frame holds no state.
+ */
+bool netplay_delta_frame_save(netplay_t *netplay, struct delta_frame *delta,
+      const void *state)
+{
+   size_t len         = (size_t)-1;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   netplay_keyframe_unref(netplay, delta->keyframe);
+   delta->keyframe      = NULL;
+   delta->snapshot_size = 0;
+
+   if (!state || !netplay->state_size)
+      return true;
+
+   if (netplay->snapshot_skip)
+      netplay->snapshot_skip--;
+   else if (netplay->keyframe)
+   {
+      len = snapshot_encode(netplay->snapshot_buffer,
+            netplay->snapshot_buffer_size, (const uint8_t*)state,
+            netplay->keyframe->data, netplay->state_size);
+
+      if (len != (size_t)-1)
+         netplay->snapshot_backoff = 0;
+      else if (netplay->keyframe_age == 0)
+      {
+         /* Most of the state changes every frame, so deltas don't pay */
+         netplay->snapshot_backoff = netplay->snapshot_backoff
+            ? MIN(netplay->snapshot_backoff * 2, 64) : 1;
+         netplay->snapshot_skip    = netplay->snapshot_backoff;
+      }
+   }
+
+   if (len == (size_t)-1)
+   {
+      /* Too different from the keyframe (or no keyframe yet), so this state
+       * becomes the new keyframe */
+      struct netplay_keyframe *keyframe = netplay_keyframe_new(netplay, state);
+      if (!keyframe)
+         return false;
+      netplay_keyframe_unref(netplay, netplay->keyframe);
+      netplay->keyframe     = keyframe;
+      netplay->keyframe_age = 0;
+      len                   = 0;
+   }
+   else
+      netplay->keyframe_age++;
+
+   if (len > delta->snapshot_cap)
+   {
+      uint8_t *snapshot = (uint8_t*)realloc(delta->snapshot, len);
+      if (!snapshot)
+         return false;
+      netplay->stats.snapshot_memory += len - delta->snapshot_cap;
+      delta->snapshot     = snapshot;
+      delta->snapshot_cap = len;
+   }
+
+   memcpy(delta->snapshot, netplay->snapshot_buffer, len);
+   delta->snapshot_size = len;
+   delta->keyframe      = netplay->keyframe;
+   delta->keyframe->refs++;
+
+   netplay->stats.snapshot_saves++;
+   netplay->stats.snapshot_bytes      += len;
+   netplay->stats.snapshot_last_size   = len;
+   netplay->stats.snapshot_last_time   = cpu_features_get_time_usec() - start;
+   netplay->stats.snapshot_save_time  += netplay->stats.snapshot_last_time;
+
+   return true;
+}
+
+/**
+ * netplay_delta_frame_load
+ * @netplay              : pointer to netplay object
+ * @delta                : delta frame to get the state of
+ *
+ * Decode the serialized state of a delta frame into netplay->state_buffer.
+ *
+ * Returns: netplay->state_buffer
+ */
+void *netplay_delta_frame_load(netplay_t *netplay, struct delta_frame *delta)
+{
+   retro_time_t start = cpu_features_get_time_usec();
+
+   if (!delta->keyframe)
+      memset(netplay->state_buffer, 0, netplay->state_size);
+   else
+   {
+      memcpy(netplay->state_buffer, delta->keyframe->data,
+            netplay->state_size);
+      snapshot_decode(netplay->state_buffer, delta->snapshot,
+            delta->snapshot_size);
+   }
+
+   netplay->stats.snapshot_loads++;
+   netplay->stats.snapshot_load_time += cpu_features_get_time_usec() - start;
+
+   return netplay->state_buffer;
+}
+
 /**
  * netplay_delta_frame_crc
  *
@@ -78,7 +383,9 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta)
 {
    if (!netplay->state_size)
       return 0;
-   return encoding_crc32(0L, (const unsigned char*)delta->state, netplay->state_size);
+   return encoding_crc32(0L,
+         (const unsigned char*)netplay_delta_frame_load(netplay, delta),
+         netplay->state_size);
 }
 
 /*
@@ -102,14 +409,20 @@ static void free_input_state(netplay_input_state_t *list)
  *
  * Free a delta frame's dependencies
  */
-void netplay_delta_frame_free(struct delta_frame *delta)
+void netplay_delta_frame_free(netplay_t *netplay, struct delta_frame *delta)
 {
    uint32_t i;
 
-   if (delta->state)
+   netplay_keyframe_unref(netplay, delta->keyframe);
+   delta->keyframe = NULL;
+
+   if (delta->snapshot)
    {
-      free(delta->state);
-      delta->state = NULL;
+      netplay->stats.snapshot_memory -= delta->snapshot_cap;
+      free(delta->snapshot);
+      delta->snapshot      = NULL;
+      delta->snapshot_size = 0;
+      delta->snapshot_cap  = 0;
    }
 
    for (i = 0; i < MAX_INPUT_DEVICES; i++)
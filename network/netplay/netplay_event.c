@@ -0,0 +1,299 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* sendmmsg */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <net/net_compat.h>
+#include <net/net_socket.h>
+
+#include "netplay_private.h"
+
+#ifdef NETPLAY_HAVE_EPOLL
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#endif
+
+/* With many spectators, trying every socket for input each time the network
+ * is polled costs a failed recv per connection, and sending each its input
+ * costs a datagram of its own. Where epoll is available, the sockets are
+ * registered with it once, only those it reports readable are read, and
+ * datagrams are gathered into one sendmmsg per frame.
+ *
+ * Elsewhere, connections are never registered, so they're all read as
+ * before and datagrams are sent one by one. */
+
+/* Tag of the UDP socket in epoll events, connections use their index */
+#define NETPLAY_EVENT_UDP 0xFFFFFFFFU
+
+#ifdef NETPLAY_HAVE_EPOLL
+struct netplay_event_batch
+{
+   struct mmsghdr msgs[NETPLAY_EVENT_DATAGRAMS];
+   struct iovec iovs[NETPLAY_EVENT_DATAGRAMS];
+   struct sockaddr_storage addrs[NETPLAY_EVENT_DATAGRAMS];
+   uint8_t data[NETPLAY_EVENT_DATAGRAMS][NETPLAY_UDP_MAX_DATAGRAM];
+   unsigned count;
+};
+
+static bool netplay_event_watch(netplay_t *netplay, int fd, uint32_t tag)
+{
+   struct epoll_event ev;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events   = EPOLLIN;
+   ev.data.u32 = tag;
+
+   if (epoll_ctl(netplay->event_fd, EPOLL_CTL_ADD, fd, &ev) == 0)
+      return true;
+
+   /* A closed fd's number may have been handed out again */
+   return errno == EEXIST &&
+      epoll_ctl(netplay->event_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+/* Register sockets opened since the last wait. They're read once anyway, in
+ * case something arrived before they were watched. */
+static void netplay_event_register(netplay_t *netplay)
+{
+   size_t i;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+
+      if (!connection->active || connection->event_registered)
+         continue;
+
+      if (netplay_event_watch(netplay, connection->fd, (uint32_t)i))
+      {
+         connection->event_registered = true;
+         connection->ready            = true;
+      }
+   }
+
+   if (netplay->udp_fd >= 0 && netplay->udp_fd != netplay->event_udp_fd &&
+       netplay_event_watch(netplay, netplay->udp_fd, NETPLAY_EVENT_UDP))
+   {
+      netplay->event_udp_fd = netplay->udp_fd;
+      netplay->udp_ready    = true;
+   }
+}
+#endif
+
+/**
+ * netplay_event_init
+ *
+ * Set up readiness notification for our sockets, where supported.
+ */
+void netplay_event_init(netplay_t *netplay)
+{
+   netplay->event_fd     = -1;
+   netplay->event_udp_fd = -1;
+   netplay->event_batch  = NULL;
+
+#ifdef NETPLAY_HAVE_EPOLL
+   netplay->event_fd = epoll_create1(EPOLL_CLOEXEC);
+   if (netplay->event_fd < 0)
+      RARCH_WARN("[netplay] Could not create epoll instance, "
+            "polling every connection.\n");
+
+   netplay->event_batch = (struct netplay_event_batch*)
+      calloc(1, sizeof(*netplay->event_batch));
+#endif
+}
+
+/**
+ * netplay_event_deinit
+ *
+ * Free what netplay_event_init set up.
+ */
+void netplay_event_deinit(netplay_t *netplay)
+{
+   if (netplay->event_fd >= 0)
+      socket_close(netplay->event_fd);
+   netplay->event_fd     = -1;
+   netplay->event_udp_fd = -1;
+
+   if (netplay->event_batch)
+      free(netplay->event_batch);
+   netplay->event_batch = NULL;
+}
+
+/**
+ * netplay_event_remove
+ *
+ * Stop watching a connection's socket, before closing it.
+ */
+void netplay_event_remove(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+#ifdef NETPLAY_HAVE_EPOLL
+   if (netplay->event_fd >= 0 && connection->event_registered)
+      epoll_ctl(netplay->event_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+#endif
+   connection->event_registered = false;
+   connection->ready            = false;
+}
+
+/**
+ * netplay_event_poll
+ *
+ * Wait up to timeout_ms for any of our sockets to become readable, and mark
+ * those that did ready. Returns -1 on error.
+ */
+int netplay_event_poll(netplay_t *netplay, unsigned timeout_ms)
+{
+   fd_set fds;
+   struct timeval tv = {0};
+   int max_fd        = 0;
+   size_t i;
+
+#ifdef NETPLAY_HAVE_EPOLL
+   if (netplay->event_fd >= 0)
+   {
+      struct epoll_event events[NETPLAY_EVENT_MAX];
+      int count, j;
+
+      netplay_event_register(netplay);
+
+      count = epoll_wait(netplay->event_fd, events, NETPLAY_EVENT_MAX,
+            (int)timeout_ms);
+      if (count < 0)
+         return (errno == EINTR) ? 0 : -1;
+
+      for (j = 0; j < count; j++)
+      {
+         uint32_t tag = events[j].data.u32;
+         if (tag == NETPLAY_EVENT_UDP)
+            netplay->udp_ready = true;
+         else if (tag < netplay->connections_size)
+            netplay->connections[tag].ready = true;
+      }
+
+      return count;
+   }
+#endif
+
+   /* Unwatched sockets are all read anyway, so only waiting needs doing */
+   if (!timeout_ms)
+      return 0;
+
+   FD_ZERO(&fds);
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (!connection->active)
+         continue;
+      FD_SET(connection->fd, &fds);
+      if (connection->fd >= max_fd)
+         max_fd = connection->fd + 1;
+   }
+   if (netplay->udp_fd >= 0)
+   {
+      FD_SET(netplay->udp_fd, &fds);
+      if (netplay->udp_fd >= max_fd)
+         max_fd = netplay->udp_fd + 1;
+   }
+
+   if (max_fd == 0)
+      return 0;
+
+   tv.tv_sec  = timeout_ms / 1000;
+   tv.tv_usec = (timeout_ms % 1000) * 1000;
+   return socket_select(max_fd, &fds, NULL, NULL, &tv);
+}
+
+/**
+ * netplay_event_queue_datagram
+ *
+ * Queue a datagram for the next netplay_event_flush_datagrams. Returns false
+ * if it must be sent by itself.
+ */
+bool netplay_event_queue_datagram(netplay_t *netplay,
+   const struct sockaddr_storage *addr, socklen_t addr_len,
+   const void *buf, size_t len)
+{
+#ifdef NETPLAY_HAVE_EPOLL
+   struct netplay_event_batch *batch = netplay->event_batch;
+   struct mmsghdr *msg;
+   unsigned i;
+
+   if (!batch || len > NETPLAY_UDP_MAX_DATAGRAM)
+      return false;
+
+   if (batch->count == NETPLAY_EVENT_DATAGRAMS)
+      netplay_event_flush_datagrams(netplay);
+
+   i   = batch->count++;
+   msg = &batch->msgs[i];
+   memcpy(batch->data[i], buf, len);
+   memcpy(&batch->addrs[i], addr, addr_len);
+   batch->iovs[i].iov_base = batch->data[i];
+   batch->iovs[i].iov_len  = len;
+
+   memset(msg, 0, sizeof(*msg));
+   msg->msg_hdr.msg_name    = &batch->addrs[i];
+   msg->msg_hdr.msg_namelen = addr_len;
+   msg->msg_hdr.msg_iov     = &batch->iovs[i];
+   msg->msg_hdr.msg_iovlen  = 1;
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * netplay_event_flush_datagrams
+ *
+ * Send all queued datagrams.
+ */
+void netplay_event_flush_datagrams(netplay_t *netplay)
+{
+#ifdef NETPLAY_HAVE_EPOLL
+   struct netplay_event_batch *batch = netplay->event_batch;
+   unsigned sent                     = 0;
+
+   if (!batch || !batch->count)
+      return;
+
+   /* A datagram that can't be sent now is lost like any other */
+   while (sent < batch->count && netplay->udp_fd >= 0)
+   {
+      int ret = sendmmsg(netplay->udp_fd, batch->msgs + sent,
+            batch->count - sent, 0);
+      if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+         /* Only this one failed, e.g. its peer went away */
+         sent++;
+         continue;
+      }
+      if (ret <= 0)
+         break;
+      sent += ret;
+   }
+
+   batch->count = 0;
+#endif
+}
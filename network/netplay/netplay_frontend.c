@@ -235,13 +235,17 @@ static bool get_self_input_state(netplay_t *netplay)
       netplay->read_frame_count[netplay->self_client_num] = netplay->self_frame_count + 1;
    }
 
-   /* And send this input to our peers */
+   /* And send this input to our peers, encoding each player's only once */
+   netplay->input_packet_gen++;
+   netplay->input_packets_shared = true;
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
       if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED)
          netplay_send_cur_input(netplay, &netplay->connections[i]);
    }
+   netplay->input_packets_shared = false;
+   netplay_event_flush_datagrams(netplay);
 
    /* Handle any delayed state changes */
    if (netplay->is_server)
@@ -314,24 +318,20 @@ static bool netplay_poll(void)
     * network latency */
    if (netplay_data->frame_run_time_avg || netplay_data->stateless_mode)
    {
-      /* FIXME: Using fixed 60fps for this calculation */
+      /* How many frames we can replay in a frame's replay budget, against
+       * how many we'd have to if the remote input we're missing turned
+       * out to be mispredicted. Replays that are still being caught up on
+       * count against us. */
       unsigned frames_per_frame = netplay_data->frame_run_time_avg ?
-                                  (16666/netplay_data->frame_run_time_avg) :
+                                  (unsigned)(netplay_sync_replay_budget()/netplay_data->frame_run_time_avg) :
                                    0;
-      unsigned frames_ahead = (netplay_data->run_frame_count > netplay_data->unread_frame_count) ?
+      unsigned frames_ahead = ((netplay_data->run_frame_count > netplay_data->unread_frame_count) ?
                               (netplay_data->run_frame_count - netplay_data->unread_frame_count) :
-                              0;
+                              0) + netplay_data->replay_deferred;
       settings_t *settings  = config_get_ptr();
       unsigned input_latency_frames_min = settings->uints.netplay_input_latency_frames_min;
       unsigned input_latency_frames_max = input_latency_frames_min + settings->uints.netplay_input_latency_frames_range;
 
-      /* Assume we need a couple frames worth of time to actually run the
-       * current frame */
-      if (frames_per_frame > 2)
-         frames_per_frame -= 2;
-      else
-         frames_per_frame = 0;
-
       /* Shall we adjust our latency? */
       if (netplay_data->stateless_mode)
       {
@@ -989,6 +989,7 @@ void netplay_post_frame(netplay_t *netplay)
    retro_assert(netplay);
    netplay_update_unread_ptr(netplay);
    netplay_sync_post_frame(netplay, false);
+   netplay_state_stream_send(netplay);
 
    for (i = 0; i < netplay->connections_size; i++)
    {
@@ -999,6 +1000,8 @@ void netplay_post_frame(netplay_t *netplay)
          netplay_hangup(netplay, connection);
    }
 
+   netplay_udp_post_frame(netplay);
+
    /* If we're disconnected, deinitialize */
    if (!netplay->is_server && !netplay->connections[0].active)
       netplay_disconnect(netplay);
@@ -1016,6 +1019,7 @@ static void netplay_force_future(netplay_t *netplay)
    /* Wherever we're inputting, that's where we consider our state to be loaded */
    netplay->run_ptr = netplay->self_ptr;
    netplay->run_frame_count = netplay->self_frame_count;
+   netplay->replay_deferred = 0;
 
 
    /* We need to ignore any intervening data from the other side,
@@ -1064,6 +1068,8 @@ void netplay_send_savestate(netplay_t *netplay,
    uint32_t header[4];
    uint32_t rd, wn;
    size_t i;
+   bool sent          = false;
+   retro_time_t start = cpu_features_get_time_usec();
 
    /* Compress it */
    z->compression_backend->set_in(z->compression_stream,
@@ -1092,11 +1098,29 @@ void netplay_send_savestate(netplay_t *netplay,
           connection->mode < NETPLAY_CONNECTION_CONNECTED ||
           connection->compression_supported != cx) continue;
 
-      if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
+      /* This supersedes any state being streamed to them */
+      netplay_state_stream_cancel(netplay, connection);
+
+      if (!netplay_udp_before_cmd(netplay, connection,
+               NETPLAY_CMD_LOAD_SAVESTATE) ||
+          !netplay_send(&connection->send_packet_buffer, connection->fd, header,
             sizeof(header)) ||
           !netplay_send(&connection->send_packet_buffer, connection->fd,
             netplay->zbuffer, wn))
          netplay_hangup(netplay, connection);
+      else
+      {
+         netplay->stats.state_sends++;
+         netplay->stats.state_send_bytes += sizeof(header) + wn;
+         sent = true;
+      }
+   }
+
+   if (sent)
+   {
+      retro_time_t tm = cpu_features_get_time_usec() - start;
+      if ((uint64_t)tm > netplay->stats.state_send_stall)
+         netplay->stats.state_send_stall = tm;
    }
 }
 
@@ -1126,19 +1150,24 @@ void netplay_load_savestate(netplay_t *netplay,
          if (!serial_info)
          {
             tmp_serial_info.size = netplay->state_size;
-            tmp_serial_info.data = netplay->buffer[netplay->run_ptr].state;
+            tmp_serial_info.data = netplay->state_buffer;
             if (!core_serialize(&tmp_serial_info))
                return;
             tmp_serial_info.data_const = tmp_serial_info.data;
             serial_info = &tmp_serial_info;
+            netplay_delta_frame_save(netplay,
+                  &netplay->buffer[netplay->run_ptr], netplay->state_buffer);
          }
-         else
+         else if (serial_info->size == netplay->state_size)
+            netplay_delta_frame_save(netplay,
+                  &netplay->buffer[netplay->run_ptr], serial_info->data_const);
+         else if (serial_info->size < netplay->state_size)
          {
-            if (serial_info->size <= netplay->state_size)
-            {
-               memcpy(netplay->buffer[netplay->run_ptr].state,
-                     serial_info->data_const, serial_info->size);
-            }
+            memcpy(netplay_delta_frame_load(netplay,
+                     &netplay->buffer[netplay->run_ptr]),
+                  serial_info->data_const, serial_info->size);
+            netplay_delta_frame_save(netplay,
+                  &netplay->buffer[netplay->run_ptr], netplay->state_buffer);
          }
       }
       else
@@ -1191,7 +1220,10 @@ static void netplay_core_reset(netplay_t *netplay)
       if (!connection->active ||
             connection->mode < NETPLAY_CONNECTION_CONNECTED) continue;
 
-      if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
+      netplay_state_stream_cancel(netplay, connection);
+
+      if (!netplay_udp_before_cmd(netplay, connection, NETPLAY_CMD_RESET) ||
+          !netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
                sizeof(cmd)))
          netplay_hangup(netplay, connection);
    }
@@ -1433,6 +1465,8 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
             goto done;
 
          case RARCH_NETPLAY_CTL_IS_CONNECTED:
+         case RARCH_NETPLAY_CTL_GET_STATS:
+         case RARCH_NETPLAY_CTL_IS_REPLAYING:
             ret = false;
             goto done;
          default:
@@ -1457,6 +1491,13 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
       case RARCH_NETPLAY_CTL_IS_CONNECTED:
          ret = netplay_data->is_connected;
          goto done;
+      case RARCH_NETPLAY_CTL_GET_STATS:
+         if (data)
+            *(netplay_stats_t*)data = netplay_data->stats;
+         goto done;
+      case RARCH_NETPLAY_CTL_IS_REPLAYING:
+         ret = netplay_should_skip(netplay_data);
+         goto done;
       case RARCH_NETPLAY_CTL_POST_FRAME:
          netplay_post_frame(netplay_data);
          break;
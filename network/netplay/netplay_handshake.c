@@ -205,11 +205,17 @@ bool netplay_handshake_init_send(netplay_t *netplay,
    struct netplay_connection *connection)
 {
    uint32_t header[6];
+   uint32_t features    = NETPLAY_COMPRESSION_SUPPORTED
+      | NETPLAY_FEATURE_STATE_STREAM;
    settings_t *settings = config_get_ptr();
 
+   if (netplay->udp_redundancy &&
+       (!netplay->is_server || netplay->udp_fd >= 0))
+      features |= NETPLAY_FEATURE_UDP_INPUT;
+
    header[0] = htonl(netplay_magic);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(features);
    header[3] = 0;
    header[4] = htonl(NETPLAY_PROTOCOL_VERSION);
    header[5] = htonl(netplay_impl_magic());
@@ -370,6 +376,9 @@ bool netplay_handshake_init(netplay_t *netplay,
 
    /* Check what compression is supported */
    compression  = ntohl(header[2]);
+   connection->udp.supported = (compression & NETPLAY_FEATURE_UDP_INPUT) != 0;
+   connection->state_stream_supported =
+      (compression & NETPLAY_FEATURE_STATE_STREAM) != 0;
    compression &= NETPLAY_COMPRESSION_SUPPORTED;
 
    if (compression & NETPLAY_COMPRESSION_ZLIB)
@@ -470,14 +479,26 @@ static void netplay_handshake_ready(netplay_t *netplay,
 
       RARCH_LOG("%s %u\n", msg_hash_to_str(MSG_CONNECTION_SLOT), slot);
 
-      /* Send them the savestate */
+      /* Send them the savestate, streamed if they can take it */
       if (!(netplay->quirks &
-               (NETPLAY_QUIRK_NO_SAVESTATES|NETPLAY_QUIRK_NO_TRANSMISSION)))
+               (NETPLAY_QUIRK_NO_SAVESTATES|NETPLAY_QUIRK_NO_TRANSMISSION)) &&
+          !netplay_state_stream_start(netplay, connection))
          netplay->force_send_savestate = true;
    }
    else
    {
       netplay->is_connected = true;
+
+      /* Our state is wrong until the server's is streamed to us */
+      netplay_state_recv_reset(netplay);
+      if (connection->state_stream_supported &&
+          !(netplay->quirks &
+               (NETPLAY_QUIRK_NO_SAVESTATES|NETPLAY_QUIRK_NO_TRANSMISSION)))
+      {
+         netplay->state_recv.active = true;
+         netplay->state_recv.start  = cpu_features_get_time_usec();
+      }
+
       snprintf(msg, sizeof(msg), "%s: \"%s\"",
             msg_hash_to_str(MSG_CONNECTED_TO),
             connection->nick);
@@ -667,7 +688,8 @@ bool netplay_handshake_sync(netplay_t *netplay,
    connection->mode = NETPLAY_CONNECTION_SPECTATING;
    netplay_handshake_ready(netplay, connection);
 
-   return true;
+   /* Input may go over UDP from here on */
+   return netplay_udp_offer(netplay, connection);
 }
 
 /**
@@ -986,6 +1008,7 @@ bool netplay_handshake_pre_sync(netplay_t *netplay,
    netplay->self_frame_count      = netplay->run_frame_count    =
       netplay->other_frame_count  = netplay->unread_frame_count =
       netplay->server_frame_count = new_frame_count;
+   netplay->replay_deferred       = 0;
 
    /* And clear out the framebuffer */
    for (i = 0; i < netplay->buffer_size; i++)
@@ -272,7 +272,6 @@ static bool netplay_init_socket_buffers(netplay_t *netplay)
 
 bool netplay_init_serialization(netplay_t *netplay)
 {
-   unsigned i;
    retro_ctx_size_info_t info;
 
    if (netplay->state_size)
@@ -283,19 +282,27 @@ bool netplay_init_serialization(netplay_t *netplay)
    if (!info.size)
       return false;
 
-   netplay->state_size = info.size;
+   /* Delta frames start out with an all-zero state, which takes no memory.
+    * Snapshots bigger than a quarter of the state are stored as a new
+    * keyframe instead. */
+   netplay->state_buffer         = (uint8_t*)calloc(info.size, 1);
+   netplay->snapshot_buffer_size = info.size / 4;
+   netplay->snapshot_buffer      = (uint8_t*)malloc(
+         netplay->snapshot_buffer_size + 1);
 
-   for (i = 0; i < netplay->buffer_size; i++)
+   if (!netplay->state_buffer || !netplay->snapshot_buffer)
    {
-      netplay->buffer[i].state = calloc(netplay->state_size, 1);
-
-      if (!netplay->buffer[i].state)
-      {
-         netplay->quirks |= NETPLAY_QUIRK_NO_SAVESTATES;
-         return false;
-      }
+      free(netplay->state_buffer);
+      free(netplay->snapshot_buffer);
+      netplay->state_buffer    = NULL;
+      netplay->snapshot_buffer = NULL;
+      netplay->quirks |= NETPLAY_QUIRK_NO_SAVESTATES;
+      return false;
    }
 
+   netplay->state_size       = info.size;
+   netplay->stats.state_size = info.size;
+
    netplay->zbuffer_size = netplay->state_size * 2;
    netplay->zbuffer = (uint8_t *) calloc(netplay->zbuffer_size, 1);
    if (!netplay->zbuffer)
@@ -327,12 +334,15 @@ bool netplay_try_init_serialization(netplay_t *netplay)
 
    /* Check if we can actually save */
    serial_info.data_const = NULL;
-   serial_info.data       = netplay->buffer[netplay->run_ptr].state;
+   serial_info.data       = netplay->state_buffer;
    serial_info.size       = netplay->state_size;
 
    if (!core_serialize(&serial_info))
       return false;
 
+   netplay_delta_frame_save(netplay,
+         &netplay->buffer[netplay->run_ptr], netplay->state_buffer);
+
    /* Once initialized, we no longer exhibit this quirk */
    netplay->quirks &= ~((uint64_t) NETPLAY_QUIRK_INITIALIZATION);
 
@@ -425,6 +435,8 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
       return NULL;
 
    netplay->listen_fd            = -1;
+   netplay->udp_fd               = -1;
+   netplay->event_fd             = -1;
    netplay->tcp_port             = port;
    netplay->cbs                  = *cb;
    netplay->is_server            = (direct_host == NULL && server == NULL);
@@ -461,11 +473,13 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
       return NULL;
    }
 
+   netplay_event_init(netplay);
+
+   if (!netplay_udp_init(netplay))
+      goto error;
+
    if (!netplay_init_buffers(netplay))
-   {
-      free(netplay);
-      return NULL;
-   }
+      goto error;
 
    if (netplay->is_server)
    {
@@ -512,6 +526,10 @@ error:
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   netplay_event_deinit(netplay);
+
+   netplay_udp_deinit(netplay);
+
    if (netplay->connections && netplay->connections[0].fd >= 0)
       socket_close(netplay->connections[0].fd);
 
@@ -532,9 +550,14 @@ void netplay_free(netplay_t *netplay)
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   netplay_event_deinit(netplay);
+
+   netplay_udp_deinit(netplay);
+
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
+      netplay_state_stream_cancel(netplay, connection);
       if (connection->active)
       {
          socket_close(connection->fd);
@@ -552,11 +575,62 @@ void netplay_free(netplay_t *netplay)
    if (netplay->buffer)
    {
       for (i = 0; i < netplay->buffer_size; i++)
-         netplay_delta_frame_free(&netplay->buffer[i]);
+         netplay_delta_frame_free(netplay, &netplay->buffer[i]);
 
       free(netplay->buffer);
    }
 
+   if (netplay->stats.snapshot_saves)
+      RARCH_LOG("[netplay] %u snapshots of %u byte states, %u bytes average, "
+            "%u keyframes, %.1f us to save, %.1f us to load\n",
+            (unsigned)netplay->stats.snapshot_saves,
+            (unsigned)netplay->state_size,
+            (unsigned)(netplay->stats.snapshot_bytes
+               / netplay->stats.snapshot_saves),
+            (unsigned)netplay->stats.snapshot_keyframes,
+            (double)netplay->stats.snapshot_save_time
+               / netplay->stats.snapshot_saves,
+            netplay->stats.snapshot_loads
+               ? (double)netplay->stats.snapshot_load_time
+                  / netplay->stats.snapshot_loads : 0.0);
+
+   if (netplay->stats.rollbacks)
+      RARCH_LOG("[netplay] %u rollbacks, %u frames replayed (%u deferred), "
+            "%u us per replayed frame\n",
+            (unsigned)netplay->stats.rollbacks,
+            (unsigned)netplay->stats.replayed_frames,
+            (unsigned)netplay->stats.deferred_frames,
+            (unsigned)netplay->stats.replay_frame_time);
+
+   if (netplay->stats.udp_sent)
+      RARCH_LOG("[netplay] UDP input: %u datagrams sent, %u received, "
+            "%u lost, %u frames of input taken from them, %u sent over TCP "
+            "instead, %u us round trip\n",
+            (unsigned)netplay->stats.udp_sent,
+            (unsigned)netplay->stats.udp_received,
+            (unsigned)netplay->stats.udp_lost,
+            (unsigned)netplay->stats.udp_input_frames,
+            (unsigned)netplay->stats.udp_tcp_records,
+            (unsigned)netplay->stats.udp_rtt);
+
+   if (netplay->stats.state_sends)
+      RARCH_LOG("[netplay] %u savestates sent, %u KiB, longest frame spent "
+            "sending one %u us\n",
+            (unsigned)netplay->stats.state_sends,
+            (unsigned)(netplay->stats.state_send_bytes / 1024),
+            (unsigned)netplay->stats.state_send_stall);
+
+   netplay_state_recv_reset(netplay);
+
+   netplay_keyframe_unref(netplay, netplay->keyframe);
+   if (netplay->keyframe_spare)
+      free(netplay->keyframe_spare);
+
+   if (netplay->state_buffer)
+      free(netplay->state_buffer);
+   if (netplay->snapshot_buffer)
+      free(netplay->snapshot_buffer);
+
    if (netplay->zbuffer)
       free(netplay->zbuffer);
 
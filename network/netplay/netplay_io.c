@@ -120,13 +120,17 @@ void netplay_hangup(netplay_t *netplay, struct netplay_connection *connection)
    RARCH_LOG("%s\n", dmsg);
    runloop_msg_queue_push(dmsg, 1, 180, false);
 
+   netplay_event_remove(netplay, connection);
    socket_close(connection->fd);
    connection->active = false;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
    netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
+   netplay_udp_reset(connection);
+   netplay_state_stream_cancel(netplay, connection);
 
    if (!netplay->is_server)
    {
+      netplay_state_recv_reset(netplay);
       netplay->self_mode = NETPLAY_CONNECTION_NONE;
       netplay->connected_players &= (1L<<netplay->self_client_num);
       for (i = 0; i < MAX_CLIENTS; i++)
@@ -209,40 +213,68 @@ void netplay_delayed_state_change(netplay_t *netplay)
    }
 }
 
+/* Send an INPUT command over UDP if we can, TCP otherwise */
+static bool send_input_to(netplay_t *netplay,
+      struct netplay_connection *connection, const uint32_t *buffer,
+      size_t bufused, uint32_t frame, uint32_t client_num, bool slave)
+{
+   if (!slave && netplay_udp_queue_input(netplay, connection, buffer, bufused,
+            frame, client_num))
+      return true;
+
+   return netplay_send(&connection->send_packet_buffer, connection->fd,
+         buffer, bufused*sizeof(uint32_t));
+}
+
 /* Send the specified input data */
 static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
       struct netplay_connection *only, struct netplay_connection *except,
       uint32_t client_num, bool slave)
 {
 #define BUFSZ 16 /* FIXME: Arbitrary restriction */
-   uint32_t buffer[BUFSZ], devices, device;
+   struct netplay_input_packet local;
+   struct netplay_input_packet *packet = &local;
+   uint32_t *buffer, devices, device;
    size_t bufused, i;
 
-   /* Set up the basic buffer */
-   bufused = 4;
-   buffer[0] = htonl(NETPLAY_CMD_INPUT);
-   buffer[2] = htonl(dframe->frame);
-   buffer[3] = htonl(client_num);
+   /* While every connection is sent the same frame, encode it only once */
+   if (netplay->input_packets_shared && client_num < MAX_CLIENTS)
+      packet = &netplay->input_packets[slave ? MAX_CLIENTS : client_num];
+   buffer = packet->data;
 
-   /* Add the device data */
-   devices = netplay->client_devices[client_num];
-   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   if (packet != &local && packet->gen == netplay->input_packet_gen)
+      bufused = packet->words;
+   else
    {
-      netplay_input_state_t istate;
-      if (!(devices & (1<<device)))
-         continue;
-      istate = dframe->real_input[device];
-      while (istate && (!istate->used || istate->client_num != (slave?MAX_CLIENTS:client_num)))
-         istate = istate->next;
-      if (!istate)
-         continue;
-      if (bufused + istate->size >= BUFSZ)
-         continue; /* FIXME: More severe? */
-      for (i = 0; i < istate->size; i++)
-         buffer[bufused+i] = htonl(istate->data[i]);
-      bufused += istate->size;
+      /* Set up the basic buffer */
+      bufused = 4;
+      buffer[0] = htonl(NETPLAY_CMD_INPUT);
+      buffer[2] = htonl(dframe->frame);
+      buffer[3] = htonl(client_num);
+
+      /* Add the device data */
+      devices = netplay->client_devices[client_num];
+      for (device = 0; device < MAX_INPUT_DEVICES; device++)
+      {
+         netplay_input_state_t istate;
+         if (!(devices & (1<<device)))
+            continue;
+         istate = dframe->real_input[device];
+         while (istate && (!istate->used || istate->client_num != (slave?MAX_CLIENTS:client_num)))
+            istate = istate->next;
+         if (!istate)
+            continue;
+         if (bufused + istate->size >= BUFSZ)
+            continue; /* FIXME: More severe? */
+         for (i = 0; i < istate->size; i++)
+            buffer[bufused+i] = htonl(istate->data[i]);
+         bufused += istate->size;
+      }
+      buffer[1] = htonl((bufused-2) * sizeof(uint32_t));
+
+      packet->words = bufused;
+      packet->gen   = netplay->input_packet_gen;
    }
-   buffer[1] = htonl((bufused-2) * sizeof(uint32_t));
 
 #ifdef DEBUG_NETPLAY_STEPS
    RARCH_LOG("Sending input for client %u\n", (unsigned) client_num);
@@ -251,7 +283,8 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
 
    if (only)
    {
-      if (!netplay_send(&only->send_packet_buffer, only->fd, buffer, bufused*sizeof(uint32_t)))
+      if (!send_input_to(netplay, only, buffer, bufused, dframe->frame,
+            client_num, slave))
       {
          netplay_hangup(netplay, only);
          return false;
@@ -268,8 +301,8 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
              (connection->mode != NETPLAY_CONNECTION_PLAYING ||
               i+1 != client_num))
          {
-            if (!netplay_send(&connection->send_packet_buffer, connection->fd,
-                  buffer, bufused*sizeof(uint32_t)))
+            if (!send_input_to(netplay, connection, buffer, bufused,
+                  dframe->frame, client_num, slave))
                netplay_hangup(netplay, connection);
          }
       }
@@ -337,6 +370,8 @@ bool netplay_send_cur_input(netplay_t *netplay,
          false))
       return false;
 
+   netplay_udp_send(netplay, connection);
+
    return true;
 }
 
@@ -356,6 +391,9 @@ bool netplay_send_raw_cmd(netplay_t *netplay,
    cmdbuf[0] = htonl(cmd);
    cmdbuf[1] = htonl(size);
 
+   if (!netplay_udp_before_cmd(netplay, connection, cmd))
+      return false;
+
    if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmdbuf,
          sizeof(cmdbuf)))
       return false;
@@ -884,6 +922,129 @@ static void handle_play_spectate(netplay_t *netplay, uint32_t client_num,
    }
 }
 
+/**
+ * netplay_handle_input
+ *
+ * Store the payload of an INPUT command. data is in network byte order and
+ * holds size words. Errors are only logged if verbose is set.
+ */
+enum netplay_input_result netplay_handle_input(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame_num,
+   uint32_t client_num, const uint32_t *data, size_t size, bool verbose)
+{
+   uint32_t input_size, devices, device;
+   struct delta_frame *dframe;
+
+   client_num &= 0xFFFF;
+
+   if (netplay->is_server)
+   {
+      /* Ignore the claimed client #, must be this client */
+      if (connection->mode != NETPLAY_CONNECTION_PLAYING &&
+          connection->mode != NETPLAY_CONNECTION_SLAVE)
+      {
+         if (verbose)
+            RARCH_ERR("Netplay input from non-participating player.\n");
+         return NETPLAY_INPUT_INVALID;
+      }
+      client_num = connection - netplay->connections + 1;
+   }
+
+   if (client_num > MAX_CLIENTS)
+   {
+      if (verbose)
+         RARCH_ERR("NETPLAY_CMD_INPUT received data for an unsupported client.\n");
+      return NETPLAY_INPUT_INVALID;
+   }
+
+   /* Figure out how much input is expected */
+   devices = netplay->client_devices[client_num];
+   input_size = netplay_expected_input_size(netplay, devices);
+
+   if (size != input_size)
+   {
+      if (verbose)
+         RARCH_ERR("NETPLAY_CMD_INPUT received an unexpected payload size.\n");
+      return NETPLAY_INPUT_INVALID;
+   }
+
+   if (client_num >= MAX_CLIENTS || !(netplay->connected_players & (1<<client_num)))
+   {
+      if (verbose)
+         RARCH_ERR("Invalid NETPLAY_CMD_INPUT player number.\n");
+      return NETPLAY_INPUT_INVALID;
+   }
+
+   /* Check the frame number only if they're not in slave mode */
+   if (connection->mode == NETPLAY_CONNECTION_PLAYING)
+   {
+      /* If we already had this, ignore the new transmission */
+      if (frame_num < netplay->read_frame_count[client_num])
+         return NETPLAY_INPUT_OLD;
+      else if (frame_num > netplay->read_frame_count[client_num])
+         return NETPLAY_INPUT_EARLY;
+   }
+
+   /* The data's good! */
+   dframe = &netplay->buffer[netplay->read_ptr[client_num]];
+   if (!netplay_delta_frame_ready(netplay, dframe, netplay->read_frame_count[client_num]))
+      return NETPLAY_INPUT_NOT_READY;
+
+   /* Copy in the input */
+   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   {
+      netplay_input_state_t istate;
+      uint32_t dsize, di;
+      if (!(devices & (1<<device)))
+         continue;
+
+      dsize = netplay_expected_input_size(netplay, 1 << device);
+      istate = netplay_input_state_for(&dframe->real_input[device],
+            client_num, dsize,
+            false /* Must be false because of slave-mode clients */,
+            false);
+      if (!istate)
+      {
+         /* Catastrophe! */
+         return NETPLAY_INPUT_INVALID;
+      }
+      for (di = 0; di < dsize; di++)
+         istate->data[di] = ntohl(data[di]);
+      data += dsize;
+   }
+   dframe->have_real[client_num] = true;
+
+   /* Slaves may go through several packets of data in the same frame
+    * if latency is choppy, so we advance and send their data after
+    * handling all network data this frame */
+   if (connection->mode == NETPLAY_CONNECTION_PLAYING)
+   {
+      netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
+      netplay->read_frame_count[client_num]++;
+
+      if (netplay->is_server)
+      {
+         /* Forward it on if it's past data */
+         if (dframe->frame <= netplay->self_frame_count)
+            send_input_frame(netplay, dframe, NULL, connection, client_num, false);
+      }
+   }
+
+   /* If this was server data, advance our server pointer too */
+   if (!netplay->is_server && client_num == 0)
+   {
+      netplay->server_ptr = netplay->read_ptr[0];
+      netplay->server_frame_count = netplay->read_frame_count[0];
+   }
+
+#ifdef DEBUG_NETPLAY_STEPS
+   RARCH_LOG("Received input from %u\n", client_num);
+   print_state(netplay);
+#endif
+
+   return NETPLAY_INPUT_ACCEPTED;
+}
+
 #undef RECV
 #define RECV(buf, sz) \
 recvd = netplay_recv(&connection->recv_packet_buffer, connection->fd, (buf), \
@@ -931,139 +1092,48 @@ static bool netplay_get_cmd(netplay_t *netplay,
 
       case NETPLAY_CMD_INPUT:
          {
-            uint32_t frame_num, client_num, input_size, devices, device;
-            struct delta_frame *dframe;
+            uint32_t frame_num, client_num;
+            uint32_t input[16]; /* No more is ever sent, see send_input_frame */
 
             if (cmd_size < 2*sizeof(uint32_t))
             {
                RARCH_ERR("NETPLAY_CMD_INPUT too short, no frame/client number.");
                return netplay_cmd_nak(netplay, connection);
             }
-
-            RECV(&frame_num, sizeof(frame_num))
-               return false;
-            RECV(&client_num, sizeof(client_num))
-               return false;
-            frame_num = ntohl(frame_num);
-            client_num = ntohl(client_num);
-            client_num &= 0xFFFF;
-
-            if (netplay->is_server)
-            {
-               /* Ignore the claimed client #, must be this client */
-               if (connection->mode != NETPLAY_CONNECTION_PLAYING &&
-                   connection->mode != NETPLAY_CONNECTION_SLAVE)
-               {
-                  RARCH_ERR("Netplay input from non-participating player.\n");
-                  return netplay_cmd_nak(netplay, connection);
-               }
-               client_num = connection - netplay->connections + 1;
-            }
-
-            if (client_num > MAX_CLIENTS)
-            {
-               RARCH_ERR("NETPLAY_CMD_INPUT received data for an unsupported client.\n");
-               return netplay_cmd_nak(netplay, connection);
-            }
-
-            /* Figure out how much input is expected */
-            devices = netplay->client_devices[client_num];
-            input_size = netplay_expected_input_size(netplay, devices);
-
-            if (cmd_size != (2+input_size) * sizeof(uint32_t))
+            if (cmd_size > 2*sizeof(uint32_t) + sizeof(input) ||
+                cmd_size % sizeof(uint32_t))
             {
                RARCH_ERR("NETPLAY_CMD_INPUT received an unexpected payload size.\n");
                return netplay_cmd_nak(netplay, connection);
             }
 
-            if (client_num >= MAX_CLIENTS || !(netplay->connected_players & (1<<client_num)))
+            RECV(&frame_num, sizeof(frame_num))
+               return false;
+            RECV(&client_num, sizeof(client_num))
+               return false;
+            if (cmd_size > 2*sizeof(uint32_t))
             {
-               RARCH_ERR("Invalid NETPLAY_CMD_INPUT player number.\n");
-               return netplay_cmd_nak(netplay, connection);
+               RECV(input, cmd_size - 2*sizeof(uint32_t))
+                  return false;
             }
 
-            /* Check the frame number only if they're not in slave mode */
-            if (connection->mode == NETPLAY_CONNECTION_PLAYING)
+            switch (netplay_handle_input(netplay, connection,
+                     ntohl(frame_num), ntohl(client_num), input,
+                     cmd_size / sizeof(uint32_t) - 2, true))
             {
-               if (frame_num < netplay->read_frame_count[client_num])
-               {
-                  uint32_t buf;
-                  /* We already had this, so ignore the new transmission */
-                  for (; input_size; input_size--)
-                  {
-                     RECV(&buf, sizeof(uint32_t))
-                        return netplay_cmd_nak(netplay, connection);
-                  }
+               case NETPLAY_INPUT_ACCEPTED:
+               case NETPLAY_INPUT_OLD:
                   break;
-               }
-               else if (frame_num > netplay->read_frame_count[client_num])
-               {
+               case NETPLAY_INPUT_NOT_READY:
+                  /* Hopefully we'll be ready after another round of input */
+                  goto shrt;
+               case NETPLAY_INPUT_EARLY:
                   /* Out of order = out of luck */
                   RARCH_ERR("Netplay input out of order.\n");
                   return netplay_cmd_nak(netplay, connection);
-               }
-            }
-
-            /* The data's good! */
-            dframe = &netplay->buffer[netplay->read_ptr[client_num]];
-            if (!netplay_delta_frame_ready(netplay, dframe, netplay->read_frame_count[client_num]))
-            {
-               /* Hopefully we'll be ready after another round of input */
-               goto shrt;
-            }
-
-            /* Copy in the input */
-            for (device = 0; device < MAX_INPUT_DEVICES; device++)
-            {
-               netplay_input_state_t istate;
-               uint32_t dsize, di;
-               if (!(devices & (1<<device)))
-                  continue;
-
-               dsize = netplay_expected_input_size(netplay, 1 << device);
-               istate = netplay_input_state_for(&dframe->real_input[device],
-                     client_num, dsize,
-                     false /* Must be false because of slave-mode clients */,
-                     false);
-               if (!istate)
-               {
-                  /* Catastrophe! */
+               default:
                   return netplay_cmd_nak(netplay, connection);
-               }
-               RECV(istate->data, dsize*sizeof(uint32_t))
-                  return false;
-               for (di = 0; di < dsize; di++)
-                  istate->data[di] = ntohl(istate->data[di]);
             }
-            dframe->have_real[client_num] = true;
-
-            /* Slaves may go through several packets of data in the same frame
-             * if latency is choppy, so we advance and send their data after
-             * handling all network data this frame */
-            if (connection->mode == NETPLAY_CONNECTION_PLAYING)
-            {
-               netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
-               netplay->read_frame_count[client_num]++;
-
-               if (netplay->is_server)
-               {
-                  /* Forward it on if it's past data */
-                  if (dframe->frame <= netplay->self_frame_count)
-                     send_input_frame(netplay, dframe, NULL, connection, client_num, false);
-               }
-            }
-
-            /* If this was server data, advance our server pointer too */
-            if (!netplay->is_server && client_num == 0)
-            {
-               netplay->server_ptr = netplay->read_ptr[0];
-               netplay->server_frame_count = netplay->read_frame_count[0];
-            }
-
-#ifdef DEBUG_NETPLAY_STEPS
-            RARCH_LOG("Received input from %u\n", client_num);
-            print_state(netplay);
-#endif
             break;
          }
 
@@ -1497,6 +1567,10 @@ static bool netplay_get_cmd(netplay_t *netplay,
             buffer[0] = ntohl(buffer[0]);
             buffer[1] = ntohl(buffer[1]);
 
+            /* Nothing to compare against until we have the server's state */
+            if (netplay->state_recv.active)
+               break;
+
             /* Received a CRC for some frame. If we still have it, check if it
              * matched. This approach could be improved with some quick modular
              * arithmetic. */
@@ -1676,10 +1750,12 @@ static bool netplay_get_cmd(netplay_t *netplay,
                ctrans->decompression_backend->set_in(ctrans->decompression_stream,
                   netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
                ctrans->decompression_backend->set_out(ctrans->decompression_stream,
-                  (uint8_t*)netplay->buffer[load_ptr].state,
+                  netplay_delta_frame_load(netplay, &netplay->buffer[load_ptr]),
                   (unsigned)netplay->state_size);
                ctrans->decompression_backend->trans(ctrans->decompression_stream,
                   true, &rd, &wn, NULL);
+               netplay_delta_frame_save(netplay, &netplay->buffer[load_ptr],
+                  netplay->state_buffer);
 
                /* Force a rewind to the relevant frame */
                netplay->force_rewind = true;
@@ -1702,6 +1778,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
                 * will make the other side unhappy. */
                netplay->run_ptr           = PREV_PTR(load_ptr);
                netplay->run_frame_count   = load_frame_count - 1;
+               netplay->replay_deferred   = 0;
                if (frame > netplay->self_frame_count)
                {
                   netplay->self_ptr         = netplay->run_ptr;
@@ -1720,6 +1797,10 @@ static bool netplay_get_cmd(netplay_t *netplay,
                }
             }
 
+            /* Anything streamed to us is out of date now */
+            if (!netplay->is_server)
+               netplay_state_recv_reset(netplay);
+
             /* Make sure our states are correct */
             netplay->savestate_request_outstanding = false;
             netplay->other_ptr                     = load_ptr;
@@ -1817,11 +1898,97 @@ static bool netplay_get_cmd(netplay_t *netplay,
             break;
          }
 
+      case NETPLAY_CMD_UDP:
+         {
+            uint32_t payload[2];
+
+            if (cmd_size != sizeof(payload))
+            {
+               RARCH_ERR("NETPLAY_CMD_UDP with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_UDP payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (!netplay_udp_handle_cmd(netplay, connection, payload))
+               return netplay_cmd_nak(netplay, connection);
+            break;
+         }
+
+      case NETPLAY_CMD_STATE_CHUNK:
+         {
+            uint32_t header[3];
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("NETPLAY_CMD_STATE_CHUNK from a client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (cmd_size <= sizeof(header) ||
+                cmd_size > sizeof(header) + netplay->zbuffer_size)
+            {
+               RARCH_ERR("NETPLAY_CMD_STATE_CHUNK with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(header, sizeof(header))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_STATE_CHUNK header.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(netplay->zbuffer, cmd_size - sizeof(header))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_STATE_CHUNK payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (!netplay_state_recv_chunk(netplay, connection,
+                     ntohl(header[0]), ntohl(header[1]), ntohl(header[2]),
+                     netplay->zbuffer, cmd_size - sizeof(header)))
+               return netplay_cmd_nak(netplay, connection);
+            break;
+         }
+
+      case NETPLAY_CMD_STATE_DONE:
+         {
+            uint32_t payload[2];
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("NETPLAY_CMD_STATE_DONE from a client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (cmd_size != sizeof(payload))
+            {
+               RARCH_ERR("NETPLAY_CMD_STATE_DONE with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(payload, sizeof(payload))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_STATE_DONE payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (!netplay_state_recv_done(netplay, ntohl(payload[0]),
+                     ntohl(payload[1])))
+               return netplay_cmd_nak(netplay, connection);
+            break;
+         }
+
       default:
          RARCH_ERR("%s.\n", msg_hash_to_str(MSG_UNKNOWN_NETPLAY_COMMAND_RECEIVED));
          return netplay_cmd_nak(netplay, connection);
    }
 
+   netplay_udp_after_cmd(connection, cmd);
    netplay_recv_flush(&connection->recv_packet_buffer);
    netplay->timeout_cnt = 0;
    if (had_input)
@@ -1844,17 +2011,14 @@ shrt:
 int netplay_poll_net_input(netplay_t *netplay, bool block)
 {
    bool had_input = false;
-   int max_fd = 0;
+   bool active    = false;
    size_t i;
 
    for (i = 0; i < netplay->connections_size; i++)
-   {
-      struct netplay_connection *connection = &netplay->connections[i];
-      if (connection->active && connection->fd >= max_fd)
-         max_fd = connection->fd + 1;
-   }
+      if (netplay->connections[i].active)
+         active = true;
 
-   if (max_fd == 0)
+   if (!active)
       return 0;
 
    netplay->timeout_cnt = 0;
@@ -1865,12 +2029,34 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
 
       netplay->timeout_cnt++;
 
-      /* Read input from each connection */
+      /* Find out which sockets have anything for us */
+      if (netplay_event_poll(netplay, 0) < 0)
+         return -1;
+
+      /* Input that arrived over UDP first */
+      netplay_udp_poll(netplay, &had_input);
+
+      /* Read input from each connection that may have some. One that just
+       * had a command may have more of them buffered. */
       for (i = 0; i < netplay->connections_size; i++)
       {
          struct netplay_connection *connection = &netplay->connections[i];
-         if (connection->active && !netplay_get_cmd(netplay, connection, &had_input))
+         bool had_cmd                          = false;
+
+         if (!connection->active)
+            continue;
+         if (connection->event_registered && !connection->ready &&
+             connection->mode >= NETPLAY_CONNECTION_CONNECTED)
+            continue;
+
+         connection->ready = false;
+         if (!netplay_get_cmd(netplay, connection, &had_cmd))
             netplay_hangup(netplay, connection);
+         else if (had_cmd)
+         {
+            connection->ready = true;
+            had_input         = true;
+         }
       }
 
       if (block)
@@ -1884,19 +2070,7 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
          /* If we're supposed to block but we didn't have enough input, wait for it */
          if (!had_input)
          {
-            fd_set fds;
-            struct timeval tv = {0};
-            tv.tv_usec = RETRY_MS * 1000;
-
-            FD_ZERO(&fds);
-            for (i = 0; i < netplay->connections_size; i++)
-            {
-               struct netplay_connection *connection = &netplay->connections[i];
-               if (connection->active)
-                  FD_SET(connection->fd, &fds);
-            }
-
-            if (socket_select(max_fd, &fds, NULL, NULL, &tv) < 0)
+            if (netplay_event_poll(netplay, RETRY_MS) < 0)
                return -1;
 
             RARCH_LOG("Network is stalling at frame %u, count %u of %d ...\n",
@@ -54,6 +54,7 @@ typedef uint32_t client_bitmap_t;
 
 #define NETPLAY_MAX_STALL_FRAMES       60
 #define NETPLAY_FRAME_RUN_TIME_WINDOW  120
+#define NETPLAY_REPLAY_BUDGET_PERCENT  50
 #define NETPLAY_MAX_REQ_STALL_TIME     60
 #define NETPLAY_MAX_REQ_STALL_FREQUENCY 120
 
@@ -95,6 +96,40 @@ typedef uint32_t client_bitmap_t;
 #define NETPLAY_COMPRESSION_SUPPORTED 0
 #endif
 
+/* Optional features, advertised in the high bits of the compression word of
+ * the handshake header. Older peers mask them away. */
+#define NETPLAY_FEATURE_UDP_INPUT    (1U<<16)
+#define NETPLAY_FEATURE_STATE_STREAM (1U<<17)
+
+/* UDP input transport */
+#define NETPLAY_UDP_MAX_DATAGRAM   1200
+#define NETPLAY_UDP_MAX_RECORDS    64
+#define NETPLAY_UDP_RECORD_WORDS   16
+#define NETPLAY_UDP_SEQ_WINDOW     64
+#define NETPLAY_UDP_TIMEOUT_USEC   (1500*1000)
+#define NETPLAY_UDP_SIM_QUEUE      256
+
+/* On Linux, sockets are watched with epoll rather than each being tried in
+ * turn, and writes are batched with sendmsg/sendmmsg. NETPLAY_EVENT_MAX is
+ * how many ready sockets are taken per wait, NETPLAY_EVENT_DATAGRAMS how many
+ * datagrams are queued per sendmmsg. */
+#if defined(__linux__) && !defined(ANDROID)
+#define NETPLAY_HAVE_EPOLL
+#endif
+#define NETPLAY_EVENT_MAX          128
+#define NETPLAY_EVENT_DATAGRAMS    32
+
+/* Savestates streamed to joining clients: the size of a chunk, how many
+ * rounds to send at most, how many frames old the state of the last round
+ * may be once it's sent, how much of it may be queued ahead of input, and
+ * the zlib level used to compress it */
+#define NETPLAY_STATE_CHUNK_SIZE     (64*1024)
+#define NETPLAY_STATE_STREAM_ROUNDS  8
+#define NETPLAY_STATE_STREAM_WINDOW  (NETPLAY_MAX_STALL_FRAMES/2)
+#define NETPLAY_STATE_STREAM_BACKLOG (512*1024)
+#define NETPLAY_STATE_STREAM_LEVEL   1
+#define NETPLAY_STATE_STREAM_FINAL   (1U<<31)
+
 enum netplay_cmd
 {
    /* Basic commands */
@@ -166,6 +201,15 @@ enum netplay_cmd
    /* Sends over cheats enabled on client (unsupported) */
    NETPLAY_CMD_CHEATS         = 0x0047,
 
+   /* Offer (server) or accept (client) the UDP input transport */
+   NETPLAY_CMD_UDP            = 0x0048,
+
+   /* A piece of a savestate streamed to a joining client */
+   NETPLAY_CMD_STATE_CHUNK    = 0x0049,
+
+   /* End of a round of a streamed savestate */
+   NETPLAY_CMD_STATE_DONE     = 0x004A,
+
    /* Misc. commands */
 
    /* Sends multiple config requests over,
@@ -287,13 +331,26 @@ typedef struct netplay_input_state
    uint32_t data[1];
 } *netplay_input_state_t;
 
+/* A full copy of a serialized state, shared by every delta frame encoded
+ * against it */
+struct netplay_keyframe
+{
+   unsigned refs;
+   uint8_t data[1];
+};
+
 struct delta_frame
 {
    bool used; /* a bit derpy, but this is how we know if the delta's been used at all */
    uint32_t frame;
 
-   /* The serialized state of the core at this frame, before input */
-   void *state;
+   /* The serialized state of the core at this frame, before input, stored
+    * as runs of bytes XORed against a shared keyframe. A NULL keyframe means
+    * the state is all zeroes. Use netplay_delta_frame_save/_load rather than
+    * touching these directly. */
+   struct netplay_keyframe *keyframe;
+   uint8_t *snapshot;
+   size_t snapshot_size, snapshot_cap;
 
    /* The CRC-32 of the serialized state if we've calculated it, else 0 */
    uint32_t crc;
@@ -316,6 +373,101 @@ struct delta_frame
    bool have_real[MAX_CLIENTS];
 };
 
+/* An INPUT command waiting to be acknowledged over UDP */
+struct netplay_udp_record
+{
+   /* Amount of TCP commands sent before it */
+   uint32_t fence;
+
+   uint32_t frame;
+   uint32_t client_num;
+
+   /* Value of the link's frame counter when it was queued */
+   uint32_t queued;
+
+   bool acked;
+
+   /* The INPUT command, in network byte order */
+   size_t words;
+   uint32_t data[NETPLAY_UDP_RECORD_WORDS];
+};
+
+enum rarch_netplay_udp_state
+{
+   NETPLAY_UDP_NONE = 0,
+
+   /* The server offered UDP and waits for the client to accept */
+   NETPLAY_UDP_OFFERED,
+
+   /* Datagrams are being exchanged, input still goes over TCP */
+   NETPLAY_UDP_OPEN,
+
+   /* The peer acknowledged one of our datagrams, input goes over UDP */
+   NETPLAY_UDP_ESTABLISHED
+};
+
+/* UDP side channel of a connection, carrying INPUT commands. Every datagram
+ * repeats the input the peer hasn't acknowledged yet, up to a window of
+ * frames, so a lost datagram doesn't delay anything behind it. Input that
+ * leaves the window unacknowledged is sent over TCP instead. */
+struct netplay_udp_link
+{
+   enum rarch_netplay_udp_state state;
+
+   /* Did the peer advertise NETPLAY_FEATURE_UDP_INPUT? */
+   bool supported;
+
+   /* Identifies the connection in datagrams */
+   uint32_t token;
+
+   /* Address of the peer. The server learns it from the first datagram. */
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+
+   /* TCP commands that must stay in order with input (MODE, LOAD_SAVESTATE,
+    * RESET...) sent and received since the transport was negotiated. A record
+    * is only used by the receiver once it handled as many commands as were
+    * sent before the record, so input never overtakes them. */
+   uint32_t cmds_sent, cmds_recvd;
+
+   /* Sequence number of the next datagram we send, and when we sent the
+    * last ones */
+   uint32_t send_seq;
+   retro_time_t send_time[NETPLAY_UDP_SEQ_WINDOW];
+
+   /* Highest sequence number the peer acknowledged */
+   uint32_t acked_seq;
+
+   /* Highest sequence number received and a bitmap of the 32 before it */
+   uint32_t recv_seq, recv_bits;
+   retro_time_t recv_time;
+
+   /* Frames flushed so far and smoothed round trip time */
+   uint32_t frames;
+   retro_time_t rtt;
+
+   struct netplay_udp_record records[NETPLAY_UDP_MAX_RECORDS];
+   size_t record_head, record_count;
+};
+
+/* Delays and drops outgoing datagrams, for testing */
+struct netplay_udp_sim_packet
+{
+   retro_time_t due;
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+   size_t len;
+   uint8_t data[NETPLAY_UDP_MAX_DATAGRAM];
+};
+
+struct netplay_udp_sim
+{
+   unsigned loss;
+   retro_time_t latency;
+   struct netplay_udp_sim_packet *queue;
+   size_t head, count;
+};
+
 struct socket_buffer
 {
    unsigned char *data;
@@ -324,6 +476,21 @@ struct socket_buffer
    size_t read;
 };
 
+/* Server side of a streamed savestate, see netplay_stream.c */
+struct netplay_state_job;
+
+/* Datagrams queued for a single sendmmsg, see netplay_event.c */
+struct netplay_event_batch;
+
+/* An INPUT command encoded once and sent to every connection that needs it */
+struct netplay_input_packet
+{
+   /* Generation of netplay->input_packet_gen it was encoded in */
+   uint32_t gen;
+   size_t words;
+   uint32_t data[16];
+};
+
 /* Each connection gets a connection struct */
 struct netplay_connection
 {
@@ -369,6 +536,46 @@ struct netplay_connection
    /* For the server: When was the last time we requested this client to stall?
     * For the client: How many frames of stall do we have left? */
    uint32_t stall_frame;
+
+   /* UDP input transport */
+   struct netplay_udp_link udp;
+
+   /* Did the peer advertise NETPLAY_FEATURE_STATE_STREAM? */
+   bool state_stream_supported;
+
+   /* Savestate being streamed to this client, if any */
+   struct netplay_state_job *state_job;
+
+   /* Is fd watched by netplay->event_fd, and did it signal readiness or
+    * leave data in recv_packet_buffer? Unwatched connections are always
+    * read. */
+   bool event_registered;
+   bool ready;
+};
+
+/* Client side of a streamed savestate. Chunks of the first round are
+ * decompressed into state, those of later rounds are XORed into it. Once the
+ * final round is in, the state is loaded into the frame it was taken at and
+ * replayed from there. */
+struct netplay_state_recv
+{
+   /* Expecting a streamed savestate. Our state can't be trusted until it's
+    * loaded, so CRCs aren't checked meanwhile. */
+   bool active;
+
+   /* The final round is in, waiting to load it */
+   bool ready;
+
+   uint32_t round;
+   uint32_t frame;
+
+   /* Bytes of the first round received */
+   size_t received;
+
+   uint8_t *state;
+   uint8_t *scratch;
+
+   retro_time_t start;
 };
 
 /* Compression transcoder */
@@ -444,6 +651,31 @@ struct netplay
    /* TCP port (only set if serving) */
    uint16_t tcp_port;
 
+   /* UDP socket for input and its port when serving, and the minimum amount
+    * of frames repeated in each datagram */
+   int udp_fd;
+   uint16_t udp_port;
+   unsigned udp_redundancy;
+   struct netplay_udp_sim *udp_sim;
+
+   /* epoll instance our sockets are registered with, or -1 if every socket
+    * is simply tried, the UDP socket registered with it, whether that's
+    * readable, and datagrams waiting to be sent in one go */
+   int event_fd;
+   int event_udp_fd;
+   bool udp_ready;
+   struct netplay_event_batch *event_batch;
+
+   /* INPUT commands of the current frame, per client number (MAX_CLIENTS for
+    * slave input). Only used while sending the same frame to every
+    * connection, which bumps input_packet_gen so nothing stale is reused. */
+   struct netplay_input_packet input_packets[MAX_CLIENTS + 1];
+   uint32_t input_packet_gen;
+   bool input_packets_shared;
+
+   /* Savestate being streamed to us after joining */
+   struct netplay_state_recv state_recv;
+
    /* NAT traversal info (if NAT traversal is used and serving) */
    bool nat_traversal, nat_traversal_task_oustanding;
    struct natt_status nat_traversal_state;
@@ -451,6 +683,28 @@ struct netplay
    struct delta_frame *buffer;
    size_t buffer_size;
 
+   /* The state the core serializes into and unserializes from. Delta frame
+    * snapshots are encoded from and decoded into it. */
+   uint8_t *state_buffer;
+
+   /* Scratch space for encoding a snapshot, large enough for the worst case */
+   uint8_t *snapshot_buffer;
+   size_t snapshot_buffer_size;
+
+   /* The keyframe new snapshots are encoded against, and a released one
+    * kept for reuse */
+   struct netplay_keyframe *keyframe;
+   struct netplay_keyframe *keyframe_spare;
+
+   /* Snapshots taken against the current keyframe. When even a single frame
+    * changes too much to encode, encoding is skipped for snapshot_skip
+    * frames, backing off exponentially. */
+   unsigned keyframe_age;
+   unsigned snapshot_skip, snapshot_backoff;
+
+   /* Counters reported by RARCH_NETPLAY_CTL_GET_STATS */
+   netplay_stats_t stats;
+
    /* Compression transcoder */
    struct compression_transcoder compress_nil,
                                  compress_zlib;
@@ -501,6 +755,11 @@ struct netplay
    /* Are we replaying old frames? */
    bool is_replay;
 
+   /* Frames of a replay that didn't fit in the time budget of the frame it
+    * started in. run_ptr is left behind by that many frames, which are
+    * fast-forwarded through on the following frames. */
+   uint32_t replay_deferred;
+
    /* We don't want to poll several times on a frame. */
    bool can_poll;
 
@@ -603,6 +862,13 @@ void netplay_deinit_socket_buffer(struct socket_buffer *sbuf);
 bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
    size_t len);
 
+/**
+ * netplay_send_pending
+ *
+ * Get the amount of data queued in the given socket buffer but not sent yet.
+ */
+size_t netplay_send_pending(struct socket_buffer *sbuf);
+
 /**
  * netplay_send_flush
  *
@@ -656,6 +922,33 @@ void netplay_recv_flush(struct socket_buffer *sbuf);
 bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
    uint32_t frame);
 
+/**
+ * netplay_delta_frame_save
+ * @netplay              : pointer to netplay object
+ * @delta                : delta frame to store the state in
+ * @state                : serialized state of netplay->state_size bytes,
+ *                         NULL for an all-zero state
+ *
+ * Store a serialized state in a delta frame, encoded against the current
+ * keyframe. A new keyframe is taken when the state has drifted too far from
+ * the current one.
+ *
+ * Returns: false if out of memory, in which case the frame holds no state.
+ */
+bool netplay_delta_frame_save(netplay_t *netplay, struct delta_frame *delta,
+      const void *state);
+
+/**
+ * netplay_delta_frame_load
+ * @netplay              : pointer to netplay object
+ * @delta                : delta frame to get the state of
+ *
+ * Decode the serialized state of a delta frame into netplay->state_buffer.
+ *
+ * Returns: netplay->state_buffer
+ */
+void *netplay_delta_frame_load(netplay_t *netplay, struct delta_frame *delta);
+
 /**
  * netplay_delta_frame_crc
  *
@@ -668,7 +961,15 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta);
  *
  * Free a delta frame's dependencies
  */
-void netplay_delta_frame_free(struct delta_frame *delta);
+void netplay_delta_frame_free(netplay_t *netplay, struct delta_frame *delta);
+
+/**
+ * netplay_keyframe_unref
+ *
+ * Drop a reference to a keyframe, releasing it with the last one.
+ */
+void netplay_keyframe_unref(netplay_t *netplay,
+      struct netplay_keyframe *keyframe);
 
 /**
  * netplay_input_state_for
@@ -698,6 +999,57 @@ uint32_t netplay_expected_input_size(netplay_t *netplay, uint32_t devices);
 bool netplay_lan_ad_server(netplay_t *netplay);
 
 
+/***************************************************************
+ * NETPLAY-EVENT.C
+ **************************************************************/
+
+/**
+ * netplay_event_init
+ *
+ * Set up readiness notification for our sockets, where supported.
+ */
+void netplay_event_init(netplay_t *netplay);
+
+/**
+ * netplay_event_deinit
+ *
+ * Free what netplay_event_init set up.
+ */
+void netplay_event_deinit(netplay_t *netplay);
+
+/**
+ * netplay_event_remove
+ *
+ * Stop watching a connection's socket, before closing it.
+ */
+void netplay_event_remove(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_event_poll
+ *
+ * Wait up to timeout_ms for any of our sockets to become readable, and mark
+ * those that did ready. Returns -1 on error.
+ */
+int netplay_event_poll(netplay_t *netplay, unsigned timeout_ms);
+
+/**
+ * netplay_event_queue_datagram
+ *
+ * Queue a datagram for the next netplay_event_flush_datagrams. Returns false
+ * if it must be sent by itself.
+ */
+bool netplay_event_queue_datagram(netplay_t *netplay,
+   const struct sockaddr_storage *addr, socklen_t addr_len,
+   const void *buf, size_t len);
+
+/**
+ * netplay_event_flush_datagrams
+ *
+ * Send all queued datagrams.
+ */
+void netplay_event_flush_datagrams(netplay_t *netplay);
+
 /***************************************************************
  * NETPLAY-FRONTEND.C
  **************************************************************/
@@ -893,6 +1245,32 @@ bool netplay_cmd_stall(netplay_t *netplay,
  */
 int netplay_poll_net_input(netplay_t *netplay, bool block);
 
+enum netplay_input_result
+{
+   NETPLAY_INPUT_ACCEPTED = 0,
+
+   /* Input for a frame we already have */
+   NETPLAY_INPUT_OLD,
+
+   /* Input past the next frame we expect */
+   NETPLAY_INPUT_EARLY,
+
+   /* Our buffer isn't ready for it yet */
+   NETPLAY_INPUT_NOT_READY,
+
+   NETPLAY_INPUT_INVALID
+};
+
+/**
+ * netplay_handle_input
+ *
+ * Store the payload of an INPUT command. data is in network byte order and
+ * holds size words. Errors are only logged if verbose is set.
+ */
+enum netplay_input_result netplay_handle_input(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame_num,
+   uint32_t client_num, const uint32_t *data, size_t size, bool verbose);
+
 /**
  * netplay_handle_slaves
  *
@@ -942,6 +1320,167 @@ uint32_t netplay_key_hton(unsigned key);
 void netplay_key_hton_init(void);
 
 
+/***************************************************************
+ * NETPLAY-STREAM.C
+ **************************************************************/
+
+/**
+ * netplay_state_stream_start
+ *
+ * Start streaming our savestate to a client that just joined. Returns false
+ * if it must be sent the old way.
+ */
+bool netplay_state_stream_start(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_state_stream_cancel
+ *
+ * Stop streaming a savestate to the connection, if we were.
+ */
+void netplay_state_stream_cancel(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_state_stream_capture
+ *
+ * Take the state for streams waiting to start a round. Called in pre-frame,
+ * with netplay->state_buffer holding the state of the running frame.
+ */
+void netplay_state_stream_capture(netplay_t *netplay);
+
+/**
+ * netplay_state_stream_send
+ *
+ * Send what's been compressed of each stream, as far as the socket buffers
+ * allow without delaying input.
+ */
+void netplay_state_stream_send(netplay_t *netplay);
+
+/**
+ * netplay_state_recv_chunk
+ *
+ * Handle a NETPLAY_CMD_STATE_CHUNK.
+ */
+bool netplay_state_recv_chunk(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t round, uint32_t offset,
+   uint32_t isize, const uint8_t *data, size_t size);
+
+/**
+ * netplay_state_recv_done
+ *
+ * Handle a NETPLAY_CMD_STATE_DONE.
+ */
+bool netplay_state_recv_done(netplay_t *netplay, uint32_t round,
+   uint32_t frame);
+
+/**
+ * netplay_state_recv_apply
+ *
+ * Load a completely received savestate once its frame is known, rewinding
+ * to it.
+ */
+void netplay_state_recv_apply(netplay_t *netplay);
+
+/**
+ * netplay_state_recv_reset
+ *
+ * Forget the savestate being streamed to us.
+ */
+void netplay_state_recv_reset(netplay_t *netplay);
+
+/***************************************************************
+ * NETPLAY-UDP.C
+ **************************************************************/
+
+/**
+ * netplay_udp_init
+ *
+ * Open the UDP input socket of a server and set up the simulator.
+ */
+bool netplay_udp_init(netplay_t *netplay);
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP input socket.
+ */
+void netplay_udp_deinit(netplay_t *netplay);
+
+/**
+ * netplay_udp_offer
+ *
+ * Offer the UDP transport to a client that just finished its handshake.
+ */
+bool netplay_udp_offer(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_udp_handle_cmd
+ *
+ * Handle the payload of a NETPLAY_CMD_UDP.
+ */
+bool netplay_udp_handle_cmd(netplay_t *netplay,
+   struct netplay_connection *connection, const uint32_t *payload);
+
+/**
+ * netplay_udp_reset
+ *
+ * Forget the UDP state of a connection.
+ */
+void netplay_udp_reset(struct netplay_connection *connection);
+
+/**
+ * netplay_udp_queue_input
+ *
+ * Queue an INPUT command for the next datagrams to the connection. Returns
+ * false if it must go over TCP.
+ */
+bool netplay_udp_queue_input(netplay_t *netplay,
+   struct netplay_connection *connection, const uint32_t *cmd, size_t words,
+   uint32_t frame, uint32_t client_num);
+
+/**
+ * netplay_udp_before_cmd
+ *
+ * Prepare for sending a TCP command: any queued input is sent over TCP first,
+ * so the peer sees it before the command.
+ */
+bool netplay_udp_before_cmd(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t cmd);
+
+/**
+ * netplay_udp_after_cmd
+ *
+ * Account for a TCP command received from the connection.
+ */
+void netplay_udp_after_cmd(struct netplay_connection *connection,
+   uint32_t cmd);
+
+/**
+ * netplay_udp_send
+ *
+ * Send a datagram with the acknowledgements and queued input for the
+ * connection.
+ */
+void netplay_udp_send(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_udp_post_frame
+ *
+ * Per frame housekeeping: age queued input, send what's pending.
+ */
+void netplay_udp_post_frame(netplay_t *netplay);
+
+/**
+ * netplay_udp_poll
+ *
+ * Read and handle all pending datagrams.
+ */
+void netplay_udp_poll(netplay_t *netplay, bool *had_input);
+
+
 /***************************************************************
  * NETPLAY-SYNC.C
  **************************************************************/
@@ -967,6 +1506,14 @@ void netplay_update_unread_ptr(netplay_t *netplay);
  */
 bool netplay_resolve_input(netplay_t *netplay, size_t sim_ptr, bool resim);
 
+/**
+ * netplay_sync_replay_budget
+ *
+ * How much time replaying frames may take in a single frame, so that it
+ * still fits in the frame period of the core along with the frame itself.
+ */
+retro_time_t netplay_sync_replay_budget(void);
+
 /**
  * netplay_sync_pre_frame
  * @netplay              : pointer to netplay object
@@ -0,0 +1,660 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <net/net_compat.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "netplay_private.h"
+
+/* A joining client used to be sent our savestate in a single
+ * LOAD_SAVESTATE, compressed and loaded by every peer within one frame. It is
+ * streamed instead, while the game keeps running:
+ *
+ * Each round takes the state of the latest frame all input is known for,
+ * splits it into chunks, and has a worker thread compress them while the
+ * main thread sends whatever is ready. The first round sends the whole state,
+ * later rounds only what changed since the previous one, as chunks XORed
+ * against it. Once a round took few enough frames that the client still has
+ * its frame, the client loads that state and replays its own input from
+ * there, the same way as after any misprediction. Nobody else is involved.
+ */
+
+struct netplay_state_job
+{
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool quit;
+#endif
+
+   const struct trans_stream_backend *backend;
+   void *stream;
+
+   /* State of this round and of the previous one */
+   uint8_t *state;
+   uint8_t *base;
+
+   /* Chunk XORed against the previous round */
+   uint8_t *scratch;
+
+   /* Compressed chunks, zchunk_size apart, and their sizes. A size of 0 is a
+    * chunk that didn't change since the previous round. */
+   uint8_t *zdata;
+   uint32_t *zsize;
+   size_t zchunk_size;
+   size_t chunks;
+   size_t state_size;
+
+   /* Chunks compressed so far this round, and whether that failed. Shared
+    * with the worker. */
+   size_t compressed;
+   bool failed;
+
+   /* Main thread only */
+   uint32_t round;
+   uint32_t frame;
+   size_t sent;
+   bool capture;
+   uint64_t bytes;
+   retro_time_t start;
+};
+
+static bool netplay_state_job_compress(struct netplay_state_job *job,
+      size_t i)
+{
+   uint32_t rd, wn;
+   size_t offset      = i * NETPLAY_STATE_CHUNK_SIZE;
+   size_t len         = MIN(NETPLAY_STATE_CHUNK_SIZE,
+         job->state_size - offset);
+   const uint8_t *src = job->state + offset;
+
+   if (job->round)
+   {
+      const uint8_t *base = job->base + offset;
+      bool changed        = false;
+      size_t j;
+
+      for (j = 0; j < len; j++)
+      {
+         job->scratch[j] = src[j] ^ base[j];
+         changed        |= job->scratch[j] != 0;
+      }
+
+      if (!changed)
+      {
+         job->zsize[i] = 0;
+         return true;
+      }
+      src = job->scratch;
+   }
+
+   job->backend->set_in(job->stream, src, (uint32_t)len);
+   job->backend->set_out(job->stream,
+         job->zdata + i * job->zchunk_size, (uint32_t)job->zchunk_size);
+   if (!job->backend->trans(job->stream, true, &rd, &wn, NULL) ||
+         rd != len || !wn)
+      return false;
+
+   job->zsize[i] = wn;
+   return true;
+}
+
+#ifdef HAVE_THREADS
+static void netplay_state_job_thread(void *data)
+{
+   struct netplay_state_job *job = (struct netplay_state_job*)data;
+
+   slock_lock(job->lock);
+   while (!job->quit)
+   {
+      if (job->compressed < job->chunks && !job->failed)
+      {
+         size_t i = job->compressed;
+         bool ok;
+
+         slock_unlock(job->lock);
+         ok = netplay_state_job_compress(job, i);
+         slock_lock(job->lock);
+
+         if (ok)
+            job->compressed++;
+         else
+            job->failed = true;
+         continue;
+      }
+
+      scond_wait(job->cond, job->lock);
+   }
+   slock_unlock(job->lock);
+}
+#endif
+
+static void netplay_state_job_free(struct netplay_state_job *job)
+{
+#ifdef HAVE_THREADS
+   if (job->thread)
+   {
+      slock_lock(job->lock);
+      job->quit = true;
+      scond_signal(job->cond);
+      slock_unlock(job->lock);
+      sthread_join(job->thread);
+   }
+   if (job->cond)
+      scond_free(job->cond);
+   if (job->lock)
+      slock_free(job->lock);
+#endif
+
+   if (job->stream)
+      job->backend->stream_free(job->stream);
+
+   free(job->state);
+   free(job->base);
+   free(job->scratch);
+   free(job->zdata);
+   free(job->zsize);
+   free(job);
+}
+
+/**
+ * netplay_state_stream_start
+ *
+ * Start streaming our savestate to a client that just joined. Returns false
+ * if it must be sent the old way.
+ */
+bool netplay_state_stream_start(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   struct netplay_state_job *job;
+
+   if (!connection->state_stream_supported || !netplay->state_size)
+      return false;
+
+   netplay_state_stream_cancel(netplay, connection);
+
+   job = (struct netplay_state_job*)calloc(1, sizeof(*job));
+   if (!job)
+      return false;
+
+#if HAVE_ZLIB
+   if (connection->compression_supported == NETPLAY_COMPRESSION_ZLIB)
+      job->backend = trans_stream_get_zlib_deflate_backend();
+#endif
+   if (!job->backend)
+      job->backend  = trans_stream_get_pipe_backend();
+
+   job->state_size  = netplay->state_size;
+   job->chunks      = (job->state_size + NETPLAY_STATE_CHUNK_SIZE - 1)
+      / NETPLAY_STATE_CHUNK_SIZE;
+   job->compressed  = job->chunks;
+   /* Room for incompressible chunks: zlib adds a few bytes per 16K block */
+   job->zchunk_size = NETPLAY_STATE_CHUNK_SIZE + NETPLAY_STATE_CHUNK_SIZE / 8
+      + 64;
+   job->capture     = true;
+   job->start       = cpu_features_get_time_usec();
+
+   job->stream      = job->backend->stream_new();
+   job->state       = (uint8_t*)malloc(job->state_size);
+   job->base        = (uint8_t*)malloc(job->state_size);
+   job->scratch     = (uint8_t*)malloc(NETPLAY_STATE_CHUNK_SIZE);
+   job->zdata       = (uint8_t*)malloc(job->chunks * job->zchunk_size);
+   job->zsize       = (uint32_t*)calloc(job->chunks, sizeof(uint32_t));
+
+   if (!job->stream || !job->state || !job->base || !job->scratch ||
+       !job->zdata || !job->zsize)
+      goto error;
+
+   if (job->backend->define)
+      job->backend->define(job->stream, "level", NETPLAY_STATE_STREAM_LEVEL);
+
+#ifdef HAVE_THREADS
+   job->lock   = slock_new();
+   job->cond   = scond_new();
+   if (!job->lock || !job->cond)
+      goto error;
+   job->thread = sthread_create(netplay_state_job_thread, job);
+   if (!job->thread)
+      goto error;
+#endif
+
+   connection->state_job = job;
+   return true;
+
+error:
+   netplay_state_job_free(job);
+   return false;
+}
+
+/**
+ * netplay_state_stream_cancel
+ *
+ * Stop streaming a savestate to the connection, if we were.
+ */
+void netplay_state_stream_cancel(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   if (!connection->state_job)
+      return;
+
+   netplay_state_job_free(connection->state_job);
+   connection->state_job = NULL;
+}
+
+/**
+ * netplay_state_stream_capture
+ *
+ * Take the state for streams waiting to start a round. Called in pre-frame,
+ * with netplay->state_buffer holding the state of the running frame.
+ */
+void netplay_state_stream_capture(netplay_t *netplay)
+{
+   const uint8_t *state = NULL;
+   uint32_t frame       = 0;
+   retro_time_t start   = 0;
+   size_t i;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      struct netplay_state_job *job         = connection->state_job;
+
+      if (!connection->active || !job || !job->capture)
+         continue;
+
+      if (!state)
+      {
+         start = cpu_features_get_time_usec();
+
+         /* Only a state all input is known for is the same for everybody */
+         if (netplay->other_frame_count >= netplay->run_frame_count)
+         {
+            state = netplay->state_buffer;
+            frame = netplay->run_frame_count;
+         }
+         else
+         {
+            struct delta_frame *delta = &netplay->buffer[netplay->other_ptr];
+            if (!delta->used || delta->frame != netplay->other_frame_count)
+               return;
+            state = (const uint8_t*)netplay_delta_frame_load(netplay, delta);
+            frame = netplay->other_frame_count;
+         }
+      }
+
+      if (job->round)
+      {
+         uint8_t *tmp = job->base;
+         job->base    = job->state;
+         job->state   = tmp;
+      }
+      memcpy(job->state, state, job->state_size);
+      job->frame   = frame;
+      job->sent    = 0;
+      job->capture = false;
+
+#ifdef HAVE_THREADS
+      slock_lock(job->lock);
+      job->compressed = 0;
+      scond_signal(job->cond);
+      slock_unlock(job->lock);
+#else
+      job->compressed = 0;
+#endif
+   }
+
+   if (state)
+   {
+      retro_time_t tm = cpu_features_get_time_usec() - start;
+      if ((uint64_t)tm > netplay->stats.state_send_stall)
+         netplay->stats.state_send_stall = tm;
+   }
+}
+
+static bool netplay_state_job_send(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   uint32_t cmd[5];
+   struct netplay_state_job *job = connection->state_job;
+   size_t compressed;
+   bool failed;
+
+#ifdef HAVE_THREADS
+   slock_lock(job->lock);
+   compressed = job->compressed;
+   failed     = job->failed;
+   slock_unlock(job->lock);
+#else
+   {
+      /* Without a worker, compress as much as fits in a bit of the frame */
+      retro_time_t start = cpu_features_get_time_usec();
+      while (job->compressed < job->chunks && !job->failed &&
+             cpu_features_get_time_usec() - start < 2000)
+      {
+         if (netplay_state_job_compress(job, job->compressed))
+            job->compressed++;
+         else
+            job->failed = true;
+      }
+   }
+   compressed = job->compressed;
+   failed     = job->failed;
+#endif
+
+   if (failed)
+   {
+      /* Catastrophe! Fall back to sending the whole state at once */
+      RARCH_ERR("[netplay] Failed to compress savestate chunk.\n");
+      netplay_state_stream_cancel(netplay, connection);
+      netplay->force_send_savestate = true;
+      return true;
+   }
+
+   if (!netplay_send_flush(&connection->send_packet_buffer, connection->fd,
+            false))
+      return false;
+
+   while (job->sent < compressed)
+   {
+      size_t offset = job->sent * NETPLAY_STATE_CHUNK_SIZE;
+      uint32_t size = job->zsize[job->sent];
+
+      if (size)
+      {
+         struct socket_buffer *sbuf = &connection->send_packet_buffer;
+         size_t pending             = netplay_send_pending(sbuf);
+
+         /* Leave room for input, which mustn't wait behind a whole state */
+         if (pending >= NETPLAY_STATE_STREAM_BACKLOG ||
+               pending + sizeof(cmd) + size +
+               NETPLAY_MAX_STALL_FRAMES * 16 >= sbuf->bufsz)
+            break;
+
+         cmd[0] = htonl(NETPLAY_CMD_STATE_CHUNK);
+         cmd[1] = htonl(3*sizeof(uint32_t) + size);
+         cmd[2] = htonl(job->round);
+         cmd[3] = htonl((uint32_t)offset);
+         cmd[4] = htonl((uint32_t)MIN(NETPLAY_STATE_CHUNK_SIZE,
+                  job->state_size - offset));
+
+         if (!netplay_send(sbuf, connection->fd, cmd, sizeof(cmd)) ||
+             !netplay_send(sbuf, connection->fd,
+                job->zdata + job->sent * job->zchunk_size, size))
+            return false;
+
+         job->bytes += sizeof(cmd) + size;
+      }
+
+      job->sent++;
+   }
+
+   if (job->sent == job->chunks)
+   {
+      /* The round is out. It's the last one if the client will still have
+       * its frame when it gets there. */
+      bool final = netplay->self_frame_count - job->frame
+            <= NETPLAY_STATE_STREAM_WINDOW ||
+         job->round + 1 >= NETPLAY_STATE_STREAM_ROUNDS;
+
+      cmd[0] = htonl(NETPLAY_CMD_STATE_DONE);
+      cmd[1] = htonl(2*sizeof(uint32_t));
+      cmd[2] = htonl(job->round | (final ? NETPLAY_STATE_STREAM_FINAL : 0));
+      cmd[3] = htonl(job->frame);
+
+      if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
+               4*sizeof(uint32_t)))
+         return false;
+      job->bytes += 4*sizeof(uint32_t);
+
+      if (final)
+      {
+         retro_time_t tm = cpu_features_get_time_usec() - job->start;
+
+         RARCH_LOG("[netplay] Streamed savestate to %s: %u rounds, %u KiB, "
+               "%u ms.\n", connection->nick, job->round + 1,
+               (unsigned)(job->bytes / 1024), (unsigned)(tm / 1000));
+
+         netplay->stats.state_sends++;
+         netplay->stats.state_send_bytes    += job->bytes;
+         netplay->stats.state_stream_rounds += job->round + 1;
+         netplay->stats.state_stream_time    = tm / 1000;
+
+         netplay_state_stream_cancel(netplay, connection);
+      }
+      else
+      {
+         job->round++;
+         job->capture = true;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * netplay_state_stream_send
+ *
+ * Send what's been compressed of each stream, as far as the socket buffers
+ * allow without delaying input.
+ */
+void netplay_state_stream_send(netplay_t *netplay)
+{
+   retro_time_t start = cpu_features_get_time_usec();
+   bool any           = false;
+   size_t i;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+
+      if (!connection->active || !connection->state_job ||
+            connection->state_job->capture)
+         continue;
+
+      any = true;
+      if (!netplay_state_job_send(netplay, connection))
+         netplay_hangup(netplay, connection);
+   }
+
+   if (any)
+   {
+      retro_time_t tm = cpu_features_get_time_usec() - start;
+      if ((uint64_t)tm > netplay->stats.state_send_stall)
+         netplay->stats.state_send_stall = tm;
+   }
+}
+
+/**
+ * netplay_state_recv_chunk
+ *
+ * Handle a NETPLAY_CMD_STATE_CHUNK.
+ */
+bool netplay_state_recv_chunk(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t round, uint32_t offset,
+   uint32_t isize, const uint8_t *data, size_t size)
+{
+   struct netplay_state_recv *recv = &netplay->state_recv;
+   struct compression_transcoder *ctrans;
+   uint32_t rd, wn;
+   uint8_t *out;
+
+   if (!recv->state)
+   {
+      if (round != 0 || !netplay->state_size)
+         return false;
+
+      recv->state   = (uint8_t*)malloc(netplay->state_size);
+      recv->scratch = (uint8_t*)malloc(NETPLAY_STATE_CHUNK_SIZE);
+      if (!recv->state || !recv->scratch)
+      {
+         netplay_state_recv_reset(netplay);
+         return false;
+      }
+      recv->active   = true;
+      recv->round    = 0;
+      recv->received = 0;
+      if (!recv->start)
+         recv->start = cpu_features_get_time_usec();
+   }
+
+   if (round != recv->round || recv->ready ||
+       offset >= netplay->state_size ||
+       isize > netplay->state_size - offset ||
+       isize > NETPLAY_STATE_CHUNK_SIZE ||
+       offset % NETPLAY_STATE_CHUNK_SIZE)
+   {
+      RARCH_ERR("NETPLAY_CMD_STATE_CHUNK out of place.\n");
+      return false;
+   }
+
+   switch (connection->compression_supported)
+   {
+      case NETPLAY_COMPRESSION_ZLIB:
+         ctrans = &netplay->compress_zlib;
+         break;
+      default:
+         ctrans = &netplay->compress_nil;
+   }
+
+   out = round ? recv->scratch : recv->state + offset;
+   ctrans->decompression_backend->set_in(ctrans->decompression_stream,
+         data, (uint32_t)size);
+   ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+         out, isize);
+   if (!ctrans->decompression_backend->trans(ctrans->decompression_stream,
+            true, &rd, &wn, NULL) || wn != isize)
+   {
+      RARCH_ERR("NETPLAY_CMD_STATE_CHUNK failed to decompress.\n");
+      return false;
+   }
+
+   if (round)
+   {
+      uint8_t *state = recv->state + offset;
+      size_t i;
+      for (i = 0; i < isize; i++)
+         state[i] ^= out[i];
+   }
+   else
+      recv->received += isize;
+
+   return true;
+}
+
+/**
+ * netplay_state_recv_done
+ *
+ * Handle a NETPLAY_CMD_STATE_DONE.
+ */
+bool netplay_state_recv_done(netplay_t *netplay, uint32_t round,
+   uint32_t frame)
+{
+   struct netplay_state_recv *recv = &netplay->state_recv;
+   bool final                      = (round & NETPLAY_STATE_STREAM_FINAL)
+      ? true : false;
+
+   round &= ~NETPLAY_STATE_STREAM_FINAL;
+
+   if (!recv->state || recv->ready || round != recv->round ||
+       recv->received != netplay->state_size)
+   {
+      RARCH_ERR("NETPLAY_CMD_STATE_DONE out of place.\n");
+      return false;
+   }
+
+   if (final)
+   {
+      recv->ready = true;
+      recv->frame = frame;
+   }
+   else
+      recv->round++;
+
+   return true;
+}
+
+/**
+ * netplay_state_recv_apply
+ *
+ * Load a completely received savestate once its frame is known, rewinding
+ * to it.
+ */
+void netplay_state_recv_apply(netplay_t *netplay)
+{
+   struct netplay_state_recv *recv = &netplay->state_recv;
+   uint32_t frame                  = recv->frame;
+   size_t i;
+
+   if (!recv->ready)
+      return;
+
+   /* Wait until we've run that frame and have all its input */
+   if (frame > netplay->run_frame_count ||
+       frame > netplay->unread_frame_count)
+      return;
+
+   for (i = 0; i < netplay->buffer_size; i++)
+   {
+      struct delta_frame *delta = &netplay->buffer[i];
+
+      if (!delta->used || delta->frame != frame)
+         continue;
+
+      if (!netplay_delta_frame_save(netplay, delta, recv->state))
+         break;
+
+      netplay->other_ptr         = i;
+      netplay->other_frame_count = frame;
+      netplay->force_rewind      = true;
+
+      netplay->stats.state_stream_time =
+         (cpu_features_get_time_usec() - recv->start) / 1000;
+      RARCH_LOG("[netplay] Loaded streamed savestate of frame %u after "
+            "%u ms.\n", frame, (unsigned)netplay->stats.state_stream_time);
+
+      netplay_state_recv_reset(netplay);
+      return;
+   }
+
+   /* It took too long, that frame is gone */
+   RARCH_WARN("[netplay] Streamed savestate arrived too late.\n");
+   netplay_state_recv_reset(netplay);
+   netplay_cmd_request_savestate(netplay);
+}
+
+/**
+ * netplay_state_recv_reset
+ *
+ * Forget the savestate being streamed to us.
+ */
+void netplay_state_recv_reset(netplay_t *netplay)
+{
+   struct netplay_state_recv *recv = &netplay->state_recv;
+
+   free(recv->state);
+   free(recv->scratch);
+   memset(recv, 0, sizeof(*recv));
+}
@@ -25,6 +25,7 @@
 
 #include "../../autosave.h"
 #include "../../driver.h"
+#include "../../gfx/video_driver.h"
 #include "../../input/input_driver.h"
 
 #if 0
@@ -462,7 +463,7 @@ static void netplay_handle_frame_hash(netplay_t *netplay, struct delta_frame *de
          netplay_cmd_crc(netplay, delta);
       }
    }
-   else if (delta->crc && netplay->crcs_valid)
+   else if (delta->crc && netplay->crcs_valid && !netplay->state_recv.active)
    {
       /* We have a remote CRC, so check it */
       uint32_t local_crc = netplay_delta_frame_crc(netplay, delta);
@@ -495,6 +496,146 @@ static void netplay_handle_frame_hash(netplay_t *netplay, struct delta_frame *de
    }
 }
 
+/**
+ * netplay_sync_replay_budget
+ *
+ * How much time replaying frames may take in a single frame, so that it
+ * still fits in the frame period of the core along with the frame itself.
+ */
+retro_time_t netplay_sync_replay_budget(void)
+{
+   struct retro_system_av_info *av_info = video_viewport_get_system_av_info();
+   retro_time_t frame_time              = 16666;
+
+   if (av_info && av_info->timing.fps > 0.0)
+      frame_time = (retro_time_t)(1000000.0 / av_info->timing.fps);
+
+   return frame_time * NETPLAY_REPLAY_BUDGET_PERCENT / 100;
+}
+
+static unsigned netplay_stats_bucket(uint64_t value)
+{
+   unsigned bucket = 0;
+
+   while (value > 1 && bucket < NETPLAY_STATS_HISTOGRAM_SIZE - 1)
+   {
+      value >>= 1;
+      bucket++;
+   }
+
+   return bucket;
+}
+
+/**
+ * netplay_replay_frame
+ * @netplay              : pointer to netplay object
+ *
+ * Re-simulate the frame at replay_ptr, recording the state it starts from.
+ * Video and audio output are dropped while is_replay is set.
+ */
+static void netplay_replay_frame(netplay_t *netplay)
+{
+   retro_ctx_serialize_info_t serial_info;
+   retro_time_t start, tm;
+   struct delta_frame *ptr = &netplay->buffer[netplay->replay_ptr];
+
+   serial_info.data       = netplay->state_buffer;
+   serial_info.size       = netplay->state_size;
+   serial_info.data_const = NULL;
+
+   start = cpu_features_get_time_usec();
+
+   /* Remember the current state */
+   memset(serial_info.data, 0, serial_info.size);
+   core_serialize(&serial_info);
+   netplay_delta_frame_save(netplay, ptr, netplay->state_buffer);
+   if (netplay->replay_frame_count < netplay->unread_frame_count)
+      netplay_handle_frame_hash(netplay, ptr);
+
+   /* Re-simulate this frame's input */
+   netplay_resolve_input(netplay, netplay->replay_ptr, true);
+
+   autosave_lock();
+   core_run();
+   autosave_unlock();
+   netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
+   netplay->replay_frame_count++;
+
+#ifdef DEBUG_NONDETERMINISTIC_CORES
+   if (ptr->have_remote && netplay_delta_frame_ready(netplay, &netplay->buffer[netplay->replay_ptr], netplay->replay_frame_count))
+   {
+      RARCH_LOG("PRE  %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
+      if (netplay->is_server)
+         RARCH_LOG("INP  %X %X\n", ptr->real_input_state[0], ptr->self_state[0]);
+      else
+         RARCH_LOG("INP  %X %X\n", ptr->self_state[0], ptr->real_input_state[0]);
+      ptr = &netplay->buffer[netplay->replay_ptr];
+      serial_info.data = netplay->state_buffer;
+      memset(serial_info.data, 0, serial_info.size);
+      core_serialize(&serial_info);
+      netplay_delta_frame_save(netplay, ptr, netplay->state_buffer);
+      RARCH_LOG("POST %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
+   }
+#endif
+
+   /* Get our time window */
+   tm = cpu_features_get_time_usec() - start;
+   netplay->frame_run_time_sum -= netplay->frame_run_time[netplay->frame_run_time_ptr];
+   netplay->frame_run_time[netplay->frame_run_time_ptr] = tm;
+   netplay->frame_run_time_sum += tm;
+   netplay->frame_run_time_ptr++;
+   if (netplay->frame_run_time_ptr >= NETPLAY_FRAME_RUN_TIME_WINDOW)
+      netplay->frame_run_time_ptr = 0;
+
+   netplay->stats.replayed_frames++;
+}
+
+/**
+ * netplay_finish_replay
+ * @netplay              : pointer to netplay object
+ * @target               : frame the replay was meant to reach
+ * @start                : when the replay started
+ *
+ * Wrap up a replay, leaving run_ptr wherever it got to if it ran out of
+ * time before reaching @target.
+ */
+static void netplay_finish_replay(netplay_t *netplay, uint32_t target,
+      retro_time_t start)
+{
+   retro_time_t tm = cpu_features_get_time_usec() - start;
+
+   /* Average our time */
+   netplay->frame_run_time_avg = netplay->frame_run_time_sum / NETPLAY_FRAME_RUN_TIME_WINDOW;
+
+   netplay->run_ptr         = netplay->replay_ptr;
+   netplay->run_frame_count = netplay->replay_frame_count;
+   if (netplay->replay_frame_count < target)
+   {
+      uint32_t deferred = target - netplay->replay_frame_count;
+      if (deferred > netplay->replay_deferred)
+         netplay->stats.deferred_frames += deferred - netplay->replay_deferred;
+      netplay->replay_deferred = deferred;
+   }
+   else
+      netplay->replay_deferred = 0;
+
+   netplay->stats.replay_frame_time = netplay->frame_run_time_avg;
+   netplay->stats.replay_time[netplay_stats_bucket(tm / 250)]++;
+
+   if (netplay->unread_frame_count < netplay->run_frame_count)
+   {
+      netplay->other_ptr = netplay->unread_ptr;
+      netplay->other_frame_count = netplay->unread_frame_count;
+   }
+   else
+   {
+      netplay->other_ptr = netplay->run_ptr;
+      netplay->other_frame_count = netplay->run_frame_count;
+   }
+   netplay->is_replay = false;
+   netplay->force_rewind = false;
+}
+
 /**
  * netplay_sync_pre_frame
  * @netplay              : pointer to netplay object
@@ -508,37 +649,47 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
    if (netplay_delta_frame_ready(netplay, &netplay->buffer[netplay->run_ptr], netplay->run_frame_count))
    {
       serial_info.data_const = NULL;
-      serial_info.data = netplay->buffer[netplay->run_ptr].state;
+      serial_info.data = netplay->state_buffer;
       serial_info.size = netplay->state_size;
 
       memset(serial_info.data, 0, serial_info.size);
       if ((netplay->quirks & NETPLAY_QUIRK_INITIALIZATION) || netplay->run_frame_count == 0)
       {
          /* Don't serialize until it's safe */
+         netplay_delta_frame_save(netplay,
+               &netplay->buffer[netplay->run_ptr], NULL);
       }
       else if (!(netplay->quirks & NETPLAY_QUIRK_NO_SAVESTATES) && core_serialize(&serial_info))
       {
+         netplay_delta_frame_save(netplay,
+               &netplay->buffer[netplay->run_ptr], netplay->state_buffer);
+
          if (netplay->force_send_savestate && !netplay->stall && !netplay->remote_paused)
          {
             /* Bring our running frame and input frames into parity so we don't
              * send old info */
             if (netplay->run_ptr != netplay->self_ptr)
             {
-               memcpy(netplay->buffer[netplay->self_ptr].state,
-                  netplay->buffer[netplay->run_ptr].state,
-                  netplay->state_size);
+               netplay_delta_frame_save(netplay,
+                  &netplay->buffer[netplay->self_ptr], netplay->state_buffer);
                netplay->run_ptr = netplay->self_ptr;
                netplay->run_frame_count = netplay->self_frame_count;
+               netplay->replay_deferred = 0;
             }
 
             /* Send this along to the other side */
-            serial_info.data_const = netplay->buffer[netplay->run_ptr].state;
+            serial_info.data_const = netplay->state_buffer;
             netplay_load_savestate(netplay, &serial_info, false);
             netplay->force_send_savestate = false;
          }
+
+         netplay_state_stream_capture(netplay);
       }
       else
       {
+         netplay_delta_frame_save(netplay,
+               &netplay->buffer[netplay->run_ptr], NULL);
+
          /* If the core can't serialize properly, we must stall for the
           * remote input on EVERY frame, because we can't recover */
          netplay->quirks |= NETPLAY_QUIRK_NO_SAVESTATES;
@@ -724,6 +875,9 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
       netplay->force_reset = false;
    }
 
+   /* Load a streamed savestate once it's in */
+   netplay_state_recv_apply(netplay);
+
    netplay->replay_ptr = netplay->other_ptr;
    netplay->replay_frame_count = netplay->other_frame_count;
 
@@ -772,6 +926,10 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
         netplay->replay_frame_count < netplay->run_frame_count))
    {
       retro_ctx_serialize_info_t serial_info;
+      retro_time_t start     = cpu_features_get_time_usec();
+      retro_time_t budget    = netplay_sync_replay_budget();
+      uint32_t target        = netplay->run_frame_count
+         + netplay->replay_deferred;
 
       /* Replay frames. */
       netplay->is_replay = true;
@@ -795,7 +953,8 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
          netplay_wait_and_init_serialization(netplay);
 
       serial_info.data       = NULL;
-      serial_info.data_const = netplay->buffer[netplay->replay_ptr].state;
+      serial_info.data_const = netplay_delta_frame_load(netplay,
+            &netplay->buffer[netplay->replay_ptr]);
       serial_info.size       = netplay->state_size;
 
       if (!core_unserialize(&serial_info))
@@ -803,73 +962,37 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
          RARCH_ERR("Netplay savestate loading failed: Prepare for desync!\n");
       }
 
-      while (netplay->replay_frame_count < netplay->run_frame_count)
-      {
-         retro_time_t start, tm;
-
-         struct delta_frame *ptr = &netplay->buffer[netplay->replay_ptr];
-         serial_info.data       = ptr->state;
-         serial_info.size       = netplay->state_size;
-         serial_info.data_const = NULL;
-
-         start = cpu_features_get_time_usec();
+      netplay->stats.rollbacks++;
+      netplay->stats.rollback_depth[netplay_stats_bucket(
+            target - netplay->replay_frame_count)]++;
 
-         /* Remember the current state */
-         memset(serial_info.data, 0, serial_info.size);
-         core_serialize(&serial_info);
-         if (netplay->replay_frame_count < netplay->unread_frame_count)
-            netplay_handle_frame_hash(netplay, ptr);
+      /* Replay up to where we were, or as far as the budget allows. The
+       * rest is caught up on over the next frames. */
+      while (netplay->replay_frame_count < target &&
+             cpu_features_get_time_usec() - start < budget)
+         netplay_replay_frame(netplay);
 
-         /* Re-simulate this frame's input */
-         netplay_resolve_input(netplay, netplay->replay_ptr, true);
-
-         autosave_lock();
-         core_run();
-         autosave_unlock();
-         netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
-         netplay->replay_frame_count++;
-
-#ifdef DEBUG_NONDETERMINISTIC_CORES
-         if (ptr->have_remote && netplay_delta_frame_ready(netplay, &netplay->buffer[netplay->replay_ptr], netplay->replay_frame_count))
-         {
-            RARCH_LOG("PRE  %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
-            if (netplay->is_server)
-               RARCH_LOG("INP  %X %X\n", ptr->real_input_state[0], ptr->self_state[0]);
-            else
-               RARCH_LOG("INP  %X %X\n", ptr->self_state[0], ptr->real_input_state[0]);
-            ptr = &netplay->buffer[netplay->replay_ptr];
-            serial_info.data = ptr->state;
-            memset(serial_info.data, 0, serial_info.size);
-            core_serialize(&serial_info);
-            RARCH_LOG("POST %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
-         }
-#endif
-
-         /* Get our time window */
-         tm = cpu_features_get_time_usec() - start;
-         netplay->frame_run_time_sum -= netplay->frame_run_time[netplay->frame_run_time_ptr];
-         netplay->frame_run_time[netplay->frame_run_time_ptr] = tm;
-         netplay->frame_run_time_sum += tm;
-         netplay->frame_run_time_ptr++;
-         if (netplay->frame_run_time_ptr >= NETPLAY_FRAME_RUN_TIME_WINDOW)
-            netplay->frame_run_time_ptr = 0;
-      }
+      netplay_finish_replay(netplay, target, start);
+   }
+   else if (netplay->replay_deferred && !stalled)
+   {
+      /* Fast-forward through what's left of an earlier replay */
+      retro_time_t start = cpu_features_get_time_usec();
+      retro_time_t budget = netplay_sync_replay_budget();
+      uint32_t target     = netplay->run_frame_count
+         + netplay->replay_deferred;
 
-      /* Average our time */
-      netplay->frame_run_time_avg = netplay->frame_run_time_sum / NETPLAY_FRAME_RUN_TIME_WINDOW;
+      netplay->is_replay          = true;
+      netplay->replay_ptr         = netplay->run_ptr;
+      netplay->replay_frame_count = netplay->run_frame_count;
 
-      if (netplay->unread_frame_count < netplay->run_frame_count)
+      do
       {
-         netplay->other_ptr = netplay->unread_ptr;
-         netplay->other_frame_count = netplay->unread_frame_count;
-      }
-      else
-      {
-         netplay->other_ptr = netplay->run_ptr;
-         netplay->other_frame_count = netplay->run_frame_count;
-      }
-      netplay->is_replay = false;
-      netplay->force_rewind = false;
+         netplay_replay_frame(netplay);
+      } while (netplay->replay_frame_count < target &&
+             cpu_features_get_time_usec() - start < budget);
+
+      netplay_finish_replay(netplay, target, start);
    }
 
    if (netplay->is_server)
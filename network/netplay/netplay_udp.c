@@ -0,0 +1,854 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <net/net_compat.h>
+#include <net/net_socket.h>
+
+#include "netplay_private.h"
+
+#include "../../configuration.h"
+#include "../../gfx/video_driver.h"
+
+/* Datagram layout, in 32-bit words in network byte order:
+ *
+ *    token, sequence number, highest sequence number received,
+ *    bitmap of the 32 sequence numbers received before that,
+ *    count of frame acknowledgements,
+ *    that many { client number, next frame expected from that client },
+ *    then up to the end of the datagram, INPUT commands each preceded by
+ *    their fence (see struct netplay_udp_link).
+ */
+#define NETPLAY_UDP_HEADER_WORDS 5
+
+static uint32_t netplay_udp_rand_state = 0;
+
+static uint32_t netplay_udp_rand(void)
+{
+   uint32_t x = netplay_udp_rand_state;
+
+   if (!x)
+      x = (uint32_t)cpu_features_get_time_usec() | 1;
+
+   /* xorshift32 */
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+
+   netplay_udp_rand_state = x;
+   return x;
+}
+
+static void netplay_udp_sendto(netplay_t *netplay,
+      const struct sockaddr_storage *addr, socklen_t addr_len,
+      const void *buf, size_t len)
+{
+   struct netplay_udp_sim *sim = netplay->udp_sim;
+
+   if (sim)
+   {
+      struct netplay_udp_sim_packet *packet;
+
+      if (sim->loss && netplay_udp_rand() % 100 < sim->loss)
+      {
+         netplay->stats.udp_sim_dropped++;
+         return;
+      }
+
+      if (sim->latency)
+      {
+         if (sim->count == NETPLAY_UDP_SIM_QUEUE)
+         {
+            netplay->stats.udp_sim_dropped++;
+            return;
+         }
+
+         packet           = &sim->queue[
+            (sim->head + sim->count) % NETPLAY_UDP_SIM_QUEUE];
+         packet->due      = cpu_features_get_time_usec() + sim->latency;
+         packet->addr     = *addr;
+         packet->addr_len = addr_len;
+         packet->len      = len;
+         memcpy(packet->data, buf, len);
+         sim->count++;
+         return;
+      }
+   }
+
+   if (!netplay_event_queue_datagram(netplay, addr, addr_len, buf, len))
+      sendto(netplay->udp_fd, (const char*)buf, len, 0,
+            (const struct sockaddr*)addr, addr_len);
+}
+
+/* Send the delayed datagrams that are due */
+static void netplay_udp_sim_pump(netplay_t *netplay)
+{
+   struct netplay_udp_sim *sim = netplay->udp_sim;
+   retro_time_t now;
+
+   if (!sim || !sim->count)
+      return;
+
+   now = cpu_features_get_time_usec();
+   while (sim->count && sim->queue[sim->head].due <= now)
+   {
+      struct netplay_udp_sim_packet *packet = &sim->queue[sim->head];
+      sendto(netplay->udp_fd, (const char*)packet->data, packet->len, 0,
+            (const struct sockaddr*)&packet->addr, packet->addr_len);
+      sim->head = (sim->head + 1) % NETPLAY_UDP_SIM_QUEUE;
+      sim->count--;
+   }
+}
+
+static bool netplay_udp_set_port(struct sockaddr_storage *addr,
+      uint16_t port)
+{
+   switch (addr->ss_family)
+   {
+      case AF_INET:
+         ((struct sockaddr_in*)addr)->sin_port = htons(port);
+         return true;
+#ifdef AF_INET6
+      case AF_INET6:
+         ((struct sockaddr_in6*)addr)->sin6_port = htons(port);
+         return true;
+#endif
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static uint16_t netplay_udp_get_port(const struct sockaddr_storage *addr)
+{
+   switch (addr->ss_family)
+   {
+      case AF_INET:
+         return ntohs(((const struct sockaddr_in*)addr)->sin_port);
+#ifdef AF_INET6
+      case AF_INET6:
+         return ntohs(((const struct sockaddr_in6*)addr)->sin6_port);
+#endif
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+static int netplay_udp_socket(int family)
+{
+   int fd = socket(family, SOCK_DGRAM, 0);
+
+   if (fd < 0)
+      return -1;
+
+#if defined(AF_INET6) && defined(IPPROTO_IPV6) && defined(IPV6_V6ONLY)
+   if (family == AF_INET6)
+   {
+      /* Same as the TCP socket, take IPv4 too */
+      int on = 0;
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&on, sizeof(on));
+   }
+#endif
+
+   if (!socket_nonblock(fd))
+   {
+      socket_close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+/**
+ * netplay_udp_init
+ *
+ * Open the UDP input socket of a server and set up the simulator.
+ */
+bool netplay_udp_init(netplay_t *netplay)
+{
+   const char *sim_loss    = NULL;
+   const char *sim_latency = NULL;
+   settings_t *settings    = config_get_ptr();
+
+   netplay->udp_fd = -1;
+
+   if (!settings->bools.netplay_udp_input)
+      return true;
+
+   netplay->udp_redundancy = settings->uints.netplay_udp_redundancy;
+   if (netplay->udp_redundancy < 1)
+      netplay->udp_redundancy = 1;
+   else if (netplay->udp_redundancy > NETPLAY_MAX_STALL_FRAMES)
+      netplay->udp_redundancy = NETPLAY_MAX_STALL_FRAMES;
+
+   /* Fault injection for testing, deliberately not a setting. */
+   sim_loss    = getenv("RETROARCH_NETPLAY_UDP_SIM_LOSS");
+   sim_latency = getenv("RETROARCH_NETPLAY_UDP_SIM_LATENCY");
+
+   if (sim_loss || sim_latency)
+   {
+      struct netplay_udp_sim *sim = (struct netplay_udp_sim*)
+         calloc(1, sizeof(*sim));
+      if (!sim)
+         return false;
+
+      if (sim_loss)
+         sim->loss    = (unsigned)strtoul(sim_loss, NULL, 10);
+      if (sim_latency)
+         sim->latency = (retro_time_t)strtoul(sim_latency, NULL, 10) * 1000;
+      if (sim->latency)
+      {
+         sim->queue = (struct netplay_udp_sim_packet*)
+            malloc(NETPLAY_UDP_SIM_QUEUE * sizeof(*sim->queue));
+         if (!sim->queue)
+         {
+            free(sim);
+            return false;
+         }
+      }
+      netplay->udp_sim = sim;
+
+      RARCH_WARN("[netplay] Simulating %u%% loss and %u ms latency on "
+            "outgoing UDP input.\n",
+            sim->loss, (unsigned)(sim->latency / 1000));
+   }
+
+   if (netplay->is_server)
+   {
+#ifndef HAVE_SOCKET_LEGACY
+      /* Listen on the same address as TCP, but any port: the TCP port is
+       * usually the one LAN discovery uses too. Clients are told the port
+       * when the transport is offered. */
+      struct sockaddr_storage addr;
+      socklen_t addr_len = sizeof(addr);
+
+      if (getsockname(netplay->listen_fd, (struct sockaddr*)&addr,
+               &addr_len) == 0)
+      {
+         netplay_udp_set_port(&addr, 0);
+         netplay->udp_fd = netplay_udp_socket(addr.ss_family);
+         if (netplay->udp_fd >= 0 &&
+             (bind(netplay->udp_fd, (struct sockaddr*)&addr, addr_len) < 0 ||
+              getsockname(netplay->udp_fd, (struct sockaddr*)&addr,
+                 &addr_len) < 0))
+         {
+            socket_close(netplay->udp_fd);
+            netplay->udp_fd = -1;
+         }
+         else if (netplay->udp_fd >= 0)
+            netplay->udp_port = netplay_udp_get_port(&addr);
+      }
+#endif
+
+      if (netplay->udp_fd < 0)
+         RARCH_WARN("[netplay] Could not open the UDP input socket, "
+               "input will only be sent over TCP.\n");
+   }
+
+   return true;
+}
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP input socket.
+ */
+void netplay_udp_deinit(netplay_t *netplay)
+{
+   if (netplay->udp_fd >= 0)
+      socket_close(netplay->udp_fd);
+   netplay->udp_fd = -1;
+
+   if (netplay->udp_sim)
+   {
+      if (netplay->udp_sim->queue)
+         free(netplay->udp_sim->queue);
+      free(netplay->udp_sim);
+      netplay->udp_sim = NULL;
+   }
+}
+
+/**
+ * netplay_udp_reset
+ *
+ * Forget the UDP state of a connection.
+ */
+void netplay_udp_reset(struct netplay_connection *connection)
+{
+   memset(&connection->udp, 0, sizeof(connection->udp));
+}
+
+/**
+ * netplay_udp_offer
+ *
+ * Offer the UDP transport to a client that just finished its handshake.
+ */
+bool netplay_udp_offer(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   struct netplay_udp_link *link = &connection->udp;
+   uint32_t payload[2];
+   size_t i;
+
+   if (netplay->udp_fd < 0 || !link->supported)
+      return true;
+
+   /* Pick a token no other connection uses */
+   do
+   {
+      link->token = netplay_udp_rand();
+      for (i = 0; i < netplay->connections_size; i++)
+      {
+         struct netplay_connection *other = &netplay->connections[i];
+         if (other != connection && other->active &&
+             other->udp.state != NETPLAY_UDP_NONE &&
+             other->udp.token == link->token)
+            break;
+      }
+   } while (!link->token || i < netplay->connections_size);
+
+   payload[0] = htonl(link->token);
+   payload[1] = htonl(netplay->udp_port);
+
+   if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_UDP,
+            payload, sizeof(payload)))
+      return false;
+
+   link->state     = NETPLAY_UDP_OFFERED;
+   link->cmds_sent = 0;
+   link->send_seq  = 1;
+   return true;
+}
+
+/**
+ * netplay_udp_handle_cmd
+ *
+ * Handle the payload of a NETPLAY_CMD_UDP.
+ */
+bool netplay_udp_handle_cmd(netplay_t *netplay,
+   struct netplay_connection *connection, const uint32_t *payload)
+{
+   struct netplay_udp_link *link = &connection->udp;
+   uint32_t token                = ntohl(payload[0]);
+   uint32_t port                 = ntohl(payload[1]);
+
+   if (netplay->is_server)
+   {
+      /* The client accepted our offer */
+      if (link->state != NETPLAY_UDP_OFFERED || token != link->token)
+      {
+         RARCH_ERR("NETPLAY_CMD_UDP for a transport we didn't offer.\n");
+         return false;
+      }
+      link->state      = NETPLAY_UDP_OPEN;
+      link->cmds_recvd = 0;
+      return true;
+   }
+
+   /* The server's offer. If we can't take it, stay quiet, and it keeps
+    * sending input over TCP. */
+   if (!netplay->udp_redundancy || link->state != NETPLAY_UDP_NONE ||
+       !token || port == 0 || port > 65535)
+      return true;
+
+#ifndef HAVE_SOCKET_LEGACY
+   link->addr_len = sizeof(link->addr);
+   if (getpeername(connection->fd, (struct sockaddr*)&link->addr,
+            &link->addr_len) < 0)
+      return true;
+
+   if (!netplay_udp_set_port(&link->addr, port))
+      return true;
+
+   if (netplay->udp_fd < 0)
+      netplay->udp_fd = netplay_udp_socket(link->addr.ss_family);
+   if (netplay->udp_fd < 0)
+   {
+      RARCH_WARN("[netplay] Could not open the UDP input socket, "
+            "input will only be sent over TCP.\n");
+      return true;
+   }
+
+   {
+      uint32_t reply[2];
+      reply[0] = htonl(token);
+      reply[1] = 0;
+      if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_UDP,
+               reply, sizeof(reply)))
+         return false;
+   }
+
+   link->token      = token;
+   link->state      = NETPLAY_UDP_OPEN;
+   link->cmds_sent  = 0;
+   link->cmds_recvd = 0;
+   link->send_seq   = 1;
+#endif
+
+   return true;
+}
+
+/* Send all queued input over TCP */
+static bool netplay_udp_flush_records(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   struct netplay_udp_link *link = &connection->udp;
+
+   while (link->record_count)
+   {
+      struct netplay_udp_record *record = &link->records[link->record_head];
+
+      if (!record->acked)
+      {
+         if (!netplay_send(&connection->send_packet_buffer, connection->fd,
+                  record->data, record->words * sizeof(uint32_t)))
+            return false;
+         netplay->stats.udp_tcp_records++;
+      }
+
+      link->record_head = (link->record_head + 1) % NETPLAY_UDP_MAX_RECORDS;
+      link->record_count--;
+   }
+
+   return true;
+}
+
+/**
+ * netplay_udp_queue_input
+ *
+ * Queue an INPUT command for the next datagrams to the connection. Returns
+ * false if it must go over TCP.
+ */
+bool netplay_udp_queue_input(netplay_t *netplay,
+   struct netplay_connection *connection, const uint32_t *cmd, size_t words,
+   uint32_t frame, uint32_t client_num)
+{
+   struct netplay_udp_link *link = &connection->udp;
+   struct netplay_udp_record *record;
+
+   if (link->state != NETPLAY_UDP_ESTABLISHED)
+      return false;
+
+   if (words > NETPLAY_UDP_RECORD_WORDS ||
+       link->record_count == NETPLAY_UDP_MAX_RECORDS)
+   {
+      /* Input must arrive in order, so everything queued goes first */
+      netplay_udp_flush_records(netplay, connection);
+      return false;
+   }
+
+   record = &link->records[
+      (link->record_head + link->record_count) % NETPLAY_UDP_MAX_RECORDS];
+   record->fence      = link->cmds_sent;
+   record->frame      = frame;
+   record->client_num = client_num;
+   record->queued     = link->frames;
+   record->acked      = false;
+   record->words      = words;
+   memcpy(record->data, cmd, words * sizeof(uint32_t));
+   link->record_count++;
+
+   return true;
+}
+
+/* Does the command have to stay in order with the input around it? Input is
+ * the current frame's own business, and the rest doesn't refer to a frame
+ * whose input must already be there. */
+static bool netplay_udp_cmd_ordered(uint32_t cmd)
+{
+   switch (cmd)
+   {
+      case NETPLAY_CMD_ACK:
+      case NETPLAY_CMD_INPUT:
+      case NETPLAY_CMD_NOINPUT:
+      case NETPLAY_CMD_CRC:
+      case NETPLAY_CMD_REQUEST_SAVESTATE:
+      case NETPLAY_CMD_PAUSE:
+      case NETPLAY_CMD_RESUME:
+      case NETPLAY_CMD_STALL:
+      case NETPLAY_CMD_UDP:
+      case NETPLAY_CMD_STATE_CHUNK:
+      case NETPLAY_CMD_STATE_DONE:
+         return false;
+      default:
+         break;
+   }
+
+   return true;
+}
+
+/**
+ * netplay_udp_before_cmd
+ *
+ * Prepare for sending a TCP command: any queued input is sent over TCP first,
+ * so the peer sees it before the command.
+ */
+bool netplay_udp_before_cmd(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t cmd)
+{
+   if (!netplay_udp_cmd_ordered(cmd))
+      return true;
+
+   connection->udp.cmds_sent++;
+   return netplay_udp_flush_records(netplay, connection);
+}
+
+/**
+ * netplay_udp_after_cmd
+ *
+ * Account for a TCP command received from the connection.
+ */
+void netplay_udp_after_cmd(struct netplay_connection *connection,
+   uint32_t cmd)
+{
+   if (netplay_udp_cmd_ordered(cmd))
+      connection->udp.cmds_recvd++;
+}
+
+/**
+ * netplay_udp_send
+ *
+ * Send a datagram with the acknowledgements and queued input for the
+ * connection.
+ */
+void netplay_udp_send(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   uint32_t buf[NETPLAY_UDP_MAX_DATAGRAM / sizeof(uint32_t)];
+   const size_t max_words        = sizeof(buf) / sizeof(uint32_t);
+   struct netplay_udp_link *link = &connection->udp;
+   size_t words, acks, i;
+   uint32_t client;
+
+   if (netplay->udp_fd < 0 || !connection->active ||
+       link->state < NETPLAY_UDP_OPEN || !link->addr_len)
+      return;
+
+   buf[0] = htonl(link->token);
+   buf[1] = htonl(link->send_seq);
+   buf[2] = htonl(link->recv_seq);
+   buf[3] = htonl(link->recv_bits);
+   words  = NETPLAY_UDP_HEADER_WORDS;
+
+   /* Tell the peer how far we got with each player */
+   acks = 0;
+   for (client = 0; client < MAX_CLIENTS; client++)
+   {
+      if (client == netplay->self_client_num ||
+          !(netplay->connected_players & (1 << client)))
+         continue;
+      buf[words++] = htonl(client);
+      buf[words++] = htonl(netplay->read_frame_count[client]);
+      acks++;
+   }
+   buf[4] = htonl((uint32_t)acks);
+
+   /* And repeat all input it hasn't acknowledged, oldest first */
+   for (i = 0; i < link->record_count; i++)
+   {
+      struct netplay_udp_record *record = &link->records[
+         (link->record_head + i) % NETPLAY_UDP_MAX_RECORDS];
+      if (record->acked)
+         continue;
+      if (words + 1 + record->words > max_words)
+         break;
+      buf[words++] = htonl(record->fence);
+      memcpy(buf + words, record->data, record->words * sizeof(uint32_t));
+      words += record->words;
+   }
+
+   link->send_time[link->send_seq % NETPLAY_UDP_SEQ_WINDOW] =
+      cpu_features_get_time_usec();
+   link->send_seq++;
+
+   netplay_udp_sendto(netplay, &link->addr, link->addr_len, buf,
+         words * sizeof(uint32_t));
+   netplay->stats.udp_sent++;
+}
+
+/* Input older than this many frames goes over TCP instead. It's at least the
+ * configured redundancy, but must also cover the round trip, or all input
+ * would be sent twice. */
+static uint32_t netplay_udp_window(netplay_t *netplay,
+      struct netplay_udp_link *link)
+{
+   struct retro_system_av_info *av_info = video_viewport_get_system_av_info();
+   retro_time_t frame_time              = 16666;
+   uint32_t window                      = netplay->udp_redundancy;
+   uint32_t rtt_frames;
+
+   if (av_info && av_info->timing.fps > 0.0)
+      frame_time = (retro_time_t)(1000000.0 / av_info->timing.fps);
+
+   rtt_frames = (uint32_t)(link->rtt / frame_time) + 2;
+   if (rtt_frames > window)
+      window = rtt_frames;
+   if (window > NETPLAY_MAX_STALL_FRAMES)
+      window = NETPLAY_MAX_STALL_FRAMES;
+
+   return window;
+}
+
+/**
+ * netplay_udp_post_frame
+ *
+ * Per frame housekeeping: age queued input, send what's pending.
+ */
+void netplay_udp_post_frame(netplay_t *netplay)
+{
+   retro_time_t now;
+   size_t i;
+
+   if (netplay->udp_fd < 0)
+      return;
+
+   netplay_udp_sim_pump(netplay);
+
+   now = cpu_features_get_time_usec();
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      struct netplay_udp_link *link         = &connection->udp;
+      uint32_t window;
+
+      if (!connection->active || link->state < NETPLAY_UDP_OPEN)
+         continue;
+
+      if (link->state == NETPLAY_UDP_ESTABLISHED &&
+          now - link->recv_time > NETPLAY_UDP_TIMEOUT_USEC)
+      {
+         RARCH_WARN("[netplay] UDP input from %s timed out, "
+               "falling back to TCP.\n", connection->nick);
+         link->state = NETPLAY_UDP_OPEN;
+         if (!netplay_udp_flush_records(netplay, connection))
+         {
+            netplay_hangup(netplay, connection);
+            continue;
+         }
+      }
+
+      link->frames++;
+
+      /* Whatever fell out of the window is sent over TCP */
+      window = netplay_udp_window(netplay, link);
+      while (link->record_count)
+      {
+         struct netplay_udp_record *record =
+            &link->records[link->record_head];
+
+         if (!record->acked)
+         {
+            if (link->frames - record->queued < window)
+               break;
+            if (!netplay_send(&connection->send_packet_buffer, connection->fd,
+                     record->data, record->words * sizeof(uint32_t)))
+            {
+               netplay_hangup(netplay, connection);
+               break;
+            }
+            netplay->stats.udp_tcp_records++;
+         }
+
+         link->record_head = (link->record_head + 1) % NETPLAY_UDP_MAX_RECORDS;
+         link->record_count--;
+      }
+
+      /* Hung up by a failed send above */
+      if (!connection->active)
+         continue;
+
+      netplay_udp_send(netplay, connection);
+   }
+
+   netplay_event_flush_datagrams(netplay);
+}
+
+static void netplay_udp_handle_datagram(netplay_t *netplay,
+      struct netplay_connection *connection, const uint32_t *buf,
+      size_t words, bool *had_input)
+{
+   struct netplay_udp_link *link = &connection->udp;
+   uint32_t seq                  = ntohl(buf[1]);
+   uint32_t ack                  = ntohl(buf[2]);
+   uint32_t acks                 = ntohl(buf[4]);
+   retro_time_t now              = cpu_features_get_time_usec();
+   size_t pos, i;
+
+   /* Sequence tracking */
+   if (!link->recv_seq || (int32_t)(seq - link->recv_seq) > 0)
+   {
+      uint32_t shift = link->recv_seq ? seq - link->recv_seq : 0;
+      if (shift)
+      {
+         link->recv_bits = shift < 32 ? link->recv_bits << shift : 0;
+         if (shift <= 32)
+            link->recv_bits |= 1U << (shift - 1);
+         netplay->stats.udp_lost += shift - 1;
+      }
+      link->recv_seq = seq;
+   }
+   else
+   {
+      uint32_t back = link->recv_seq - seq;
+      if (!back || back > 32 || (link->recv_bits & (1U << (back - 1))))
+         return; /* Duplicate or too old to tell */
+
+      /* Late, not lost */
+      link->recv_bits |= 1U << (back - 1);
+      if (netplay->stats.udp_lost)
+         netplay->stats.udp_lost--;
+   }
+   link->recv_time = now;
+   netplay->stats.udp_received++;
+
+   /* Our own datagrams being acknowledged */
+   if (ack && (int32_t)(ack - link->acked_seq) > 0 &&
+       (int32_t)(link->send_seq - ack) > 0)
+   {
+      if (link->send_seq - ack <= NETPLAY_UDP_SEQ_WINDOW)
+      {
+         retro_time_t sample = now
+            - link->send_time[ack % NETPLAY_UDP_SEQ_WINDOW];
+         link->rtt = link->rtt ? (link->rtt * 7 + sample) / 8 : sample;
+         netplay->stats.udp_rtt = link->rtt;
+      }
+      link->acked_seq = ack;
+
+      if (link->state == NETPLAY_UDP_OPEN)
+      {
+         RARCH_LOG("[netplay] Sending input to %s over UDP.\n",
+               connection->nick);
+         link->state = NETPLAY_UDP_ESTABLISHED;
+      }
+   }
+
+   /* Input the peer has, per player */
+   pos = NETPLAY_UDP_HEADER_WORDS;
+   for (; acks && pos + 2 <= words; acks--, pos += 2)
+   {
+      uint32_t client_num = ntohl(buf[pos]);
+      uint32_t next_frame = ntohl(buf[pos + 1]);
+
+      for (i = 0; i < link->record_count; i++)
+      {
+         struct netplay_udp_record *record = &link->records[
+            (link->record_head + i) % NETPLAY_UDP_MAX_RECORDS];
+         if (record->client_num == client_num &&
+             (int32_t)(next_frame - record->frame) > 0)
+            record->acked = true;
+      }
+   }
+   while (link->record_count && link->records[link->record_head].acked)
+   {
+      link->record_head = (link->record_head + 1) % NETPLAY_UDP_MAX_RECORDS;
+      link->record_count--;
+   }
+
+   /* And the input itself */
+   while (pos + 5 <= words)
+   {
+      uint32_t fence     = ntohl(buf[pos]);
+      uint32_t cmd       = ntohl(buf[pos + 1]);
+      uint32_t cmd_size  = ntohl(buf[pos + 2]);
+      size_t   cmd_words = cmd_size / sizeof(uint32_t);
+      enum netplay_input_result result;
+
+      if (cmd != NETPLAY_CMD_INPUT || cmd_size % sizeof(uint32_t) ||
+          cmd_words < 2 || pos + 3 + cmd_words > words)
+         break;
+
+      /* Don't overtake a TCP command sent before this input */
+      if ((int32_t)(fence - link->cmds_recvd) > 0)
+         break;
+
+      result = netplay_handle_input(netplay, connection,
+            ntohl(buf[pos + 3]), ntohl(buf[pos + 4]),
+            buf + pos + 5, cmd_words - 2, false);
+      if (result == NETPLAY_INPUT_NOT_READY)
+         break;
+      if (result == NETPLAY_INPUT_ACCEPTED)
+      {
+         netplay->stats.udp_input_frames++;
+         netplay->timeout_cnt = 0;
+         *had_input           = true;
+      }
+
+      pos += 3 + cmd_words;
+   }
+}
+
+/**
+ * netplay_udp_poll
+ *
+ * Read and handle all pending datagrams.
+ */
+void netplay_udp_poll(netplay_t *netplay, bool *had_input)
+{
+   uint32_t buf[NETPLAY_UDP_MAX_DATAGRAM / sizeof(uint32_t)];
+
+   if (netplay->udp_fd < 0)
+      return;
+
+   netplay_udp_sim_pump(netplay);
+
+   /* Nothing to read if it's watched and didn't say otherwise */
+   if (netplay->udp_fd == netplay->event_udp_fd && !netplay->udp_ready)
+      return;
+   netplay->udp_ready = false;
+
+   for (;;)
+   {
+      struct sockaddr_storage addr;
+      socklen_t addr_len = sizeof(addr);
+      uint32_t token;
+      ssize_t len        = recvfrom(netplay->udp_fd, (char*)buf, sizeof(buf),
+            0, (struct sockaddr*)&addr, &addr_len);
+      size_t i;
+
+      if (len < 0)
+         break;
+      if ((size_t)len < NETPLAY_UDP_HEADER_WORDS * sizeof(uint32_t))
+         continue;
+
+      token = ntohl(buf[0]);
+      for (i = 0; i < netplay->connections_size; i++)
+      {
+         struct netplay_connection *connection = &netplay->connections[i];
+         if (!connection->active ||
+             connection->udp.state < NETPLAY_UDP_OPEN ||
+             connection->udp.token != token)
+            continue;
+
+         /* The server answers wherever the client's datagrams come from */
+         if (netplay->is_server)
+         {
+            connection->udp.addr     = addr;
+            connection->udp.addr_len = addr_len;
+         }
+
+         netplay_udp_handle_datagram(netplay, connection, buf,
+               len / sizeof(uint32_t), had_input);
+         break;
+      }
+   }
+}
@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -24,6 +25,14 @@
 #endif
 
 #include <compat/strl.h>
+#include <retro_atomic.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_THREAD_STORAGE
+#include <rthreads/rthreads.h>
+#endif
 
 #include "performance_counters.h"
 
@@ -36,6 +45,75 @@
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
 #endif
 
+/* Frame probes and trace events go to a ring per thread, which only that
+ * thread writes, so recording takes no lock. Exporting copies the rings out
+ * while they're being written and drops what got overwritten during the
+ * copy. Without thread local storage, all threads share one ring and
+ * reserve slots in it atomically, each slot then says when it's done. */
+#define PERF_PROBE_RING_SIZE   8192
+#define PERF_PROBE_MAX_THREADS 32
+
+/* How often a running trace is written out */
+#define PERF_TRACE_FLUSH_USEC  1000000
+
+struct perf_probe_event
+{
+   retro_time_t start;
+   /* Trace events only, frame probes are named after their probe */
+   const char *name;
+   /* Duration of frame probes, value of counters */
+   uint32_t duration;
+   /* enum performance_probe or enum performance_trace_event */
+   uint32_t probe;
+#ifndef HAVE_THREAD_STORAGE
+   /* Position in the ring plus one once written, 0 while being written */
+   unsigned seq;
+#endif
+};
+
+struct perf_probe_ring
+{
+   struct perf_probe_event events[PERF_PROBE_RING_SIZE];
+   /* Name of the thread, for traces */
+   const char *name;
+   unsigned write;
+   /* Cleared when the thread ends, so a thread of the same name can
+    * carry on with the ring */
+   bool active;
+};
+
+static const char *perf_probe_names[PERF_PROBE_LAST] = {
+   "core_run",
+   "video_frame",
+   "audio_flush",
+   "input_poll",
+   "softfilter",
+   "input_latency",
+};
+
+static struct perf_probe_ring *perf_probe_rings[PERF_PROBE_MAX_THREADS];
+static unsigned perf_probe_ring_count;
+static retro_time_t perf_probe_input_time;
+static bool perf_probes_inited;
+#ifdef HAVE_THREAD_STORAGE
+static sthread_tls_t perf_probe_tls;
+static sthread_tls_t perf_probe_name_tls;
+static slock_t *perf_probe_lock;
+static bool perf_probe_tls_valid;
+/* Marks threads that came after all rings were handed out */
+static char perf_probe_no_ring;
+#endif
+
+bool performance_trace_enabled;
+static RFILE *perf_trace_file;
+static struct perf_probe_event *perf_trace_events;
+static retro_time_t perf_trace_last_flush;
+static unsigned perf_trace_read[PERF_PROBE_MAX_THREADS];
+static bool perf_trace_named[PERF_PROBE_MAX_THREADS];
+static unsigned perf_trace_written;
+static bool perf_trace_first;
+static unsigned perf_trace_lost;
+
 static struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 static struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 static unsigned perf_ptr_rarch;
@@ -112,6 +190,12 @@ void rarch_perf_log(void)
 
    RARCH_LOG("[PERF]: Performance counters (RetroArch):\n");
    log_counters(perf_counters_rarch, perf_ptr_rarch);
+
+   {
+      char summary[1024];
+      if (performance_probes_get_summary(summary, sizeof(summary)))
+         RARCH_LOG("[PERF]: Frame probes:\n%s", summary);
+   }
 }
 
 void retro_perf_log(void)
@@ -173,3 +257,637 @@ void rarch_timer_begin(rarch_timer_t *timer, uint64_t sec)
    timer->timer_begin = true;
    timer->timer_end   = false;
 }
+
+static struct perf_probe_ring *performance_probe_get_ring(void)
+{
+#ifdef HAVE_THREAD_STORAGE
+   unsigned i;
+   struct perf_probe_ring *ring = NULL;
+   const char *name             = NULL;
+   void *data                   = NULL;
+
+   if (!perf_probe_tls_valid)
+      return NULL;
+
+   data = sthread_tls_get(&perf_probe_tls);
+   if (data == &perf_probe_no_ring)
+      return NULL;
+   if (data)
+      return (struct perf_probe_ring*)data;
+
+   name = (const char*)sthread_tls_get(&perf_probe_name_tls);
+
+   slock_lock(perf_probe_lock);
+
+   /* Threads that get started again, like the video thread on a driver
+    * reinit, pick up where the last one of their name left off */
+   for (i = 0; name && i < perf_probe_ring_count; i++)
+   {
+      if (     perf_probe_rings[i]
+            && !perf_probe_rings[i]->active
+            && perf_probe_rings[i]->name
+            && string_is_equal(perf_probe_rings[i]->name, name))
+      {
+         ring = perf_probe_rings[i];
+         break;
+      }
+   }
+
+   if (!ring && perf_probe_ring_count < PERF_PROBE_MAX_THREADS)
+   {
+      ring = (struct perf_probe_ring*)calloc(1, sizeof(*ring));
+      if (ring)
+      {
+         ring->name = name;
+         perf_probe_rings[perf_probe_ring_count] = ring;
+         retro_atomic_store(&perf_probe_ring_count,
+               perf_probe_ring_count + 1);
+      }
+   }
+
+   if (ring)
+      ring->active = true;
+
+   slock_unlock(perf_probe_lock);
+
+   sthread_tls_set(&perf_probe_tls, ring ? (void*)ring : &perf_probe_no_ring);
+   return ring;
+#else
+   return perf_probe_rings[0];
+#endif
+}
+
+static void performance_probe_push(uint32_t probe, const char *name,
+      retro_time_t start, retro_time_t duration)
+{
+   struct perf_probe_event *event = NULL;
+   struct perf_probe_ring *ring   = performance_probe_get_ring();
+   unsigned write;
+
+   if (!ring)
+      return;
+
+#ifdef HAVE_THREAD_STORAGE
+   write           = ring->write;
+#else
+   write           = retro_atomic_fetch_add(&ring->write, 1);
+#endif
+   event           = &ring->events[write & (PERF_PROBE_RING_SIZE - 1)];
+#ifndef HAVE_THREAD_STORAGE
+   retro_atomic_store(&event->seq, 0);
+#endif
+   event->start    = start;
+   event->name     = name;
+   event->duration = (duration > 0) ? (uint32_t)duration : 0;
+   event->probe    = probe;
+#ifdef HAVE_THREAD_STORAGE
+   retro_atomic_store(&ring->write, write + 1);
+#else
+   retro_atomic_store(&event->seq, write + 1);
+#endif
+}
+
+/**
+ * performance_probes_init:
+ *
+ * Get ready to record frame probes and trace events. Rings are only
+ * allocated once something is recorded, and are kept until exit, as
+ * threads may still be recording into them at any point before that.
+ **/
+void performance_probes_init(void)
+{
+   if (perf_probes_inited)
+      return;
+   perf_probes_inited = true;
+
+#ifdef HAVE_THREAD_STORAGE
+   perf_probe_lock      = slock_new();
+   perf_probe_tls_valid = perf_probe_lock
+      && sthread_tls_create(&perf_probe_tls)
+      && sthread_tls_create(&perf_probe_name_tls);
+#else
+   perf_probe_rings[0]   = (struct perf_probe_ring*)
+      calloc(1, sizeof(*perf_probe_rings[0]));
+   perf_probe_ring_count = perf_probe_rings[0] ? 1 : 0;
+#endif
+
+   performance_trace_thread_begin("main");
+}
+
+/**
+ * performance_probe_record:
+ * @probe              : which probe
+ * @start              : when it started, in microseconds
+ * @duration           : how long it took, in microseconds
+ *
+ * Record one frame probe from the calling thread.
+ **/
+void performance_probe_record(enum performance_probe probe,
+      retro_time_t start, retro_time_t duration)
+{
+   if (probe == PERF_PROBE_INPUT_POLL)
+      perf_probe_input_time = start + duration;
+
+   performance_probe_push(probe, NULL, start, duration);
+}
+
+/**
+ * performance_probe_present:
+ *
+ * Call when a frame has been handed to the video driver, to record the
+ * time since input was last polled.
+ **/
+void performance_probe_present(void)
+{
+   retro_time_t input_time = perf_probe_input_time;
+
+   /* Frames that didn't poll input have no latency to speak of */
+   if (!input_time)
+      return;
+
+   perf_probe_input_time = 0;
+   performance_probe_record(PERF_PROBE_INPUT_LATENCY, input_time,
+         cpu_features_get_time_usec() - input_time);
+}
+
+/* Copies out what a ring got since *pos, oldest first, and moves *pos
+ * past it. Returns the number of events copied, which is less than what
+ * *pos moved by if some were written over before they could be. */
+static unsigned performance_probe_read(struct perf_probe_ring *ring,
+      unsigned *pos, struct perf_probe_event *events)
+{
+   unsigned i, count;
+   unsigned begin = *pos;
+   unsigned end   = retro_atomic_load(&ring->write);
+#ifdef HAVE_THREAD_STORAGE
+   unsigned overwritten;
+#else
+   unsigned copied = 0;
+#endif
+
+   if (end - begin > PERF_PROBE_RING_SIZE)
+      begin = end - PERF_PROBE_RING_SIZE;
+   count = end - begin;
+   *pos  = end;
+
+#ifdef HAVE_THREAD_STORAGE
+   for (i = 0; i < count; i++)
+      events[i] = ring->events[(begin + i) & (PERF_PROBE_RING_SIZE - 1)];
+
+   /* The first events copied may since have been written over. The
+    * slot of 'write' is stored before write + 1 is published, so it
+    * may be half-written too. */
+   end         = retro_atomic_load(&ring->write);
+   overwritten = end + 1 - begin > PERF_PROBE_RING_SIZE
+      ? end + 1 - begin - PERF_PROBE_RING_SIZE : 0;
+   if (overwritten >= count)
+      return 0;
+
+   if (overwritten)
+      memmove(events, events + overwritten,
+            (count - overwritten) * sizeof(*events));
+   return count - overwritten;
+#else
+   /* Slots are reserved before they're written, so only take those
+    * that were done, and weren't written over while being copied */
+   for (i = 0; i < count; i++)
+   {
+      struct perf_probe_event *event =
+         &ring->events[(begin + i) & (PERF_PROBE_RING_SIZE - 1)];
+      unsigned seq = retro_atomic_load(&event->seq);
+
+      if (seq != begin + i + 1)
+         continue;
+
+      events[copied] = *event;
+      if (retro_atomic_load(&event->seq) == seq)
+         copied++;
+   }
+
+   return copied;
+#endif
+}
+
+/* Copies out what a ring holds, oldest first. Returns the number of
+ * events copied. */
+static unsigned performance_probe_snapshot(struct perf_probe_ring *ring,
+      struct perf_probe_event *events)
+{
+   unsigned pos = retro_atomic_load(&ring->write);
+   pos         -= MIN(pos, PERF_PROBE_RING_SIZE);
+   return performance_probe_read(ring, &pos, events);
+}
+
+static int performance_probe_duration_cmp(const void *a_, const void *b_)
+{
+   uint32_t a = *(const uint32_t*)a_;
+   uint32_t b = *(const uint32_t*)b_;
+   return (a < b) ? -1 : (a > b);
+}
+
+/**
+ * performance_probe_get_stats:
+ * @probe              : which probe
+ * @stats              : filled in with durations in microseconds
+ *
+ * Summarize the recent frames of a probe, over all threads.
+ *
+ * Returns: true (1) if the probe was recorded at all.
+ **/
+bool performance_probe_get_stats(enum performance_probe probe,
+      struct performance_probe_stats *stats)
+{
+   unsigned i, j, count;
+   unsigned rings                   = MIN(
+         retro_atomic_load(&perf_probe_ring_count), PERF_PROBE_MAX_THREADS);
+   struct perf_probe_event *events  = (struct perf_probe_event*)
+      malloc(PERF_PROBE_RING_SIZE * sizeof(*events));
+   uint32_t *durations              = (uint32_t*)
+      malloc(rings * PERF_PROBE_RING_SIZE * sizeof(*durations));
+
+   memset(stats, 0, sizeof(*stats));
+
+   if (!events || !durations)
+      goto end;
+
+   for (i = 0, count = 0; i < rings; i++)
+   {
+      unsigned num;
+
+      if (!perf_probe_rings[i])
+         continue;
+
+      num = performance_probe_snapshot(perf_probe_rings[i], events);
+      for (j = 0; j < num; j++)
+         if (events[j].probe == (uint32_t)probe)
+            durations[count++] = events[j].duration;
+   }
+
+   if (count)
+   {
+      qsort(durations, count, sizeof(*durations),
+            performance_probe_duration_cmp);
+      stats->p50   = durations[count / 2];
+      stats->p99   = durations[(count * 99) / 100];
+      stats->max   = durations[count - 1];
+      stats->count = count;
+   }
+
+end:
+   free(events);
+   free(durations);
+   return stats->count != 0;
+}
+
+/**
+ * performance_probes_get_summary:
+ * @s                  : output buffer
+ * @len                : size of @s
+ *
+ * Write one line per recorded probe with its p50, p99 and maximum.
+ *
+ * Returns: the length of the summary.
+ **/
+size_t performance_probes_get_summary(char *s, size_t len)
+{
+   unsigned i;
+   size_t pos = 0;
+
+   if (len)
+      *s = '\0';
+
+   for (i = 0; i < PERF_PROBE_LAST && pos < len; i++)
+   {
+      struct performance_probe_stats stats;
+      int ret;
+
+      if (!performance_probe_get_stats((enum performance_probe)i, &stats))
+         continue;
+
+      ret = snprintf(s + pos, len - pos,
+            "%s: p50 %u us, p99 %u us, max %u us, %u samples\n",
+            perf_probe_names[i], (unsigned)stats.p50, (unsigned)stats.p99,
+            (unsigned)stats.max, stats.count);
+      if (ret < 0)
+         break;
+      pos = MIN(pos + ret, len - 1);
+   }
+
+   return pos;
+}
+
+/* Formats an event as Chrome trace event JSON. Names are written as they
+ * are, so they must not need escaping. */
+static int performance_probe_format(char *s, size_t len,
+      const struct perf_probe_event *event, unsigned tid)
+{
+   switch (event->probe)
+   {
+      case PERF_TRACE_BEGIN:
+      case PERF_TRACE_END:
+         return snprintf(s, len,
+               "{\"name\":\"%s\",\"cat\":\"thread\",\"ph\":\"%c\","
+               "\"pid\":1,\"tid\":%u,\"ts\":%" PRId64 "}",
+               event->name, event->probe == PERF_TRACE_BEGIN ? 'B' : 'E',
+               tid, (int64_t)event->start);
+      case PERF_TRACE_COUNTER:
+         return snprintf(s, len,
+               "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,"
+               "\"ts\":%" PRId64 ",\"args\":{\"value\":%u}}",
+               event->name, tid, (int64_t)event->start,
+               (unsigned)event->duration);
+      default:
+         break;
+   }
+
+   if (event->probe >= PERF_PROBE_LAST)
+      return 0;
+
+   return snprintf(s, len,
+         "{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\","
+         "\"pid\":1,\"tid\":%u,\"ts\":%" PRId64 ",\"dur\":%u}",
+         perf_probe_names[event->probe], tid,
+         (int64_t)event->start, (unsigned)event->duration);
+}
+
+static int performance_probe_format_thread(char *s, size_t len,
+      const struct perf_probe_ring *ring, unsigned tid)
+{
+   return snprintf(s, len,
+         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+         "\"args\":{\"name\":\"%s\"}}", tid, ring->name);
+}
+
+/* Writes a formatted event, after a separator unless it's the first */
+static void performance_probe_write_event(RFILE *file,
+      const char *s, size_t size, int len, bool *first)
+{
+   if (len <= 0 || (size_t)len >= size)
+      return;
+
+   filestream_write(file, *first ? "\n" : ",\n", *first ? 1 : 2);
+   filestream_write(file, s, len);
+   *first = false;
+}
+
+/**
+ * performance_probes_write_trace:
+ * @path               : file to write
+ *
+ * Export the recorded frame probes and trace events as Chrome trace
+ * event JSON, which chrome://tracing and Perfetto can open.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool performance_probes_write_trace(const char *path)
+{
+   unsigned i, j;
+   char buf[256];
+   bool first                      = true;
+   unsigned rings                  = MIN(
+         retro_atomic_load(&perf_probe_ring_count), PERF_PROBE_MAX_THREADS);
+   struct perf_probe_event *events = NULL;
+   RFILE *file                     = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   events = (struct perf_probe_event*)
+      malloc(PERF_PROBE_RING_SIZE * sizeof(*events));
+   if (!events)
+   {
+      filestream_close(file);
+      return false;
+   }
+
+   filestream_write(file, "{\"traceEvents\":[", 16);
+
+   for (i = 0; i < rings; i++)
+   {
+      unsigned num;
+      struct perf_probe_ring *ring = perf_probe_rings[i];
+
+      if (!ring)
+         continue;
+
+      if (ring->name)
+         performance_probe_write_event(file, buf, sizeof(buf),
+               performance_probe_format_thread(buf, sizeof(buf), ring, i),
+               &first);
+
+      num = performance_probe_snapshot(ring, events);
+      for (j = 0; j < num; j++)
+         performance_probe_write_event(file, buf, sizeof(buf),
+               performance_probe_format(buf, sizeof(buf), &events[j], i),
+               &first);
+   }
+
+   filestream_write(file, "\n],\"displayTimeUnit\":\"ms\"}\n", 27);
+   filestream_close(file);
+   free(events);
+
+   return true;
+}
+
+/**
+ * performance_trace_record:
+ * @type               : kind of event
+ * @name               : what it's about, which must outlive the trace
+ * @value              : value of a counter
+ *
+ * Record a trace event from the calling thread. Use the
+ * performance_trace_* macros, which skip this while not tracing.
+ **/
+void performance_trace_record(enum performance_trace_event type,
+      const char *name, unsigned value)
+{
+   performance_probe_push(type, name, cpu_features_get_time_usec(), value);
+}
+
+/**
+ * performance_trace_thread_begin:
+ * @name               : name of the thread, which must outlive the trace
+ *
+ * Call at the start of a thread, so traces can tell it apart.
+ **/
+void performance_trace_thread_begin(const char *name)
+{
+#ifdef HAVE_THREAD_STORAGE
+   if (perf_probe_tls_valid)
+      sthread_tls_set(&perf_probe_name_tls, name);
+#else
+   if (perf_probe_rings[0] && !perf_probe_rings[0]->name)
+      perf_probe_rings[0]->name = name;
+#endif
+}
+
+/**
+ * performance_trace_thread_end:
+ *
+ * Call before a thread named with performance_trace_thread_begin returns,
+ * to hand its ring on to the next thread of that name.
+ **/
+void performance_trace_thread_end(void)
+{
+#ifdef HAVE_THREAD_STORAGE
+   void *data = NULL;
+
+   if (!perf_probe_tls_valid)
+      return;
+
+   data = sthread_tls_get(&perf_probe_tls);
+   if (data && data != &perf_probe_no_ring)
+   {
+      slock_lock(perf_probe_lock);
+      ((struct perf_probe_ring*)data)->active = false;
+      slock_unlock(perf_probe_lock);
+   }
+
+   sthread_tls_set(&perf_probe_tls, NULL);
+   sthread_tls_set(&perf_probe_name_tls, NULL);
+#endif
+}
+
+/* Writes out what the rings got since the last time */
+static void performance_trace_write(void)
+{
+   unsigned i, j;
+   char buf[256];
+   unsigned rings = MIN(
+         retro_atomic_load(&perf_probe_ring_count), PERF_PROBE_MAX_THREADS);
+
+   for (i = 0; i < rings; i++)
+   {
+      unsigned num, from;
+      struct perf_probe_ring *ring = perf_probe_rings[i];
+
+      if (!ring)
+         continue;
+
+      if (!perf_trace_named[i] && ring->name)
+      {
+         performance_probe_write_event(perf_trace_file, buf, sizeof(buf),
+               performance_probe_format_thread(buf, sizeof(buf), ring, i),
+               &perf_trace_first);
+         perf_trace_named[i] = true;
+      }
+
+      from             = perf_trace_read[i];
+      num              = performance_probe_read(ring,
+            &perf_trace_read[i], perf_trace_events);
+      perf_trace_lost += (perf_trace_read[i] - from) - num;
+
+      for (j = 0; j < num; j++)
+         performance_probe_write_event(perf_trace_file, buf, sizeof(buf),
+               performance_probe_format(buf, sizeof(buf),
+                  &perf_trace_events[j], i),
+               &perf_trace_first);
+
+      perf_trace_written += num;
+   }
+}
+
+/**
+ * performance_trace_start:
+ * @path               : file to write the trace to
+ *
+ * Start tracing what all threads do, until performance_trace_stop.
+ * The trace is written out as it goes, in the JSON array format of
+ * Chrome trace events, which chrome://tracing and Perfetto can open even
+ * if RetroArch didn't get to finish it.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool performance_trace_start(const char *path)
+{
+   unsigned i, rings;
+
+   performance_trace_stop();
+
+   perf_trace_events = (struct perf_probe_event*)
+      malloc(PERF_PROBE_RING_SIZE * sizeof(*perf_trace_events));
+   if (!perf_trace_events)
+      return false;
+
+   perf_trace_file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!perf_trace_file)
+   {
+      free(perf_trace_events);
+      perf_trace_events = NULL;
+      return false;
+   }
+
+   filestream_write(perf_trace_file, "[", 1);
+
+   /* Leave out what was recorded before. Rings that don't exist yet
+    * start from zero. */
+   rings = MIN(retro_atomic_load(&perf_probe_ring_count),
+         PERF_PROBE_MAX_THREADS);
+   for (i = 0; i < PERF_PROBE_MAX_THREADS; i++)
+   {
+      perf_trace_read[i]  = (i < rings && perf_probe_rings[i])
+         ? retro_atomic_load(&perf_probe_rings[i]->write) : 0;
+      perf_trace_named[i] = false;
+   }
+
+   perf_trace_first          = true;
+   perf_trace_written        = 0;
+   perf_trace_lost           = 0;
+   perf_trace_last_flush     = cpu_features_get_time_usec();
+   performance_trace_enabled = true;
+
+   RARCH_LOG("[PERF]: Tracing to \"%s\".\n", path);
+   return true;
+}
+
+/**
+ * performance_trace_flush:
+ *
+ * Write out a running trace, at most once a second. Call from the
+ * main loop.
+ **/
+void performance_trace_flush(void)
+{
+   retro_time_t now;
+
+   if (!perf_trace_file)
+      return;
+
+   now = cpu_features_get_time_usec();
+   if (now - perf_trace_last_flush < PERF_TRACE_FLUSH_USEC)
+      return;
+   perf_trace_last_flush = now;
+
+   performance_trace_begin("trace_flush");
+   performance_trace_write();
+   performance_trace_end("trace_flush");
+}
+
+/**
+ * performance_trace_stop:
+ *
+ * Stop tracing, and finish writing the trace.
+ **/
+void performance_trace_stop(void)
+{
+   if (!perf_trace_file)
+      return;
+
+   performance_trace_enabled = false;
+   performance_trace_write();
+
+   filestream_write(perf_trace_file, "\n]\n", 3);
+   filestream_close(perf_trace_file);
+   free(perf_trace_events);
+   perf_trace_file   = NULL;
+   perf_trace_events = NULL;
+
+   if (perf_trace_lost)
+      RARCH_WARN("[PERF]: Trace stopped, %u events were lost.\n",
+            perf_trace_lost);
+   else
+      RARCH_LOG("[PERF]: Trace stopped, %u events written.\n",
+            perf_trace_written);
+}
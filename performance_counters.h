@@ -30,6 +30,36 @@ RETRO_BEGIN_DECLS
 #define MAX_COUNTERS 64
 #endif
 
+/* Frame probes: how long each part of a frame took, kept per frame so that
+ * the distribution and not just the average can be looked at. */
+enum performance_probe
+{
+   PERF_PROBE_CORE_RUN = 0,
+   PERF_PROBE_VIDEO_FRAME,
+   PERF_PROBE_AUDIO_FLUSH,
+   PERF_PROBE_INPUT_POLL,
+   PERF_PROBE_SOFTFILTER,
+   /* From input being polled to the frame being handed to the driver */
+   PERF_PROBE_INPUT_LATENCY,
+   PERF_PROBE_LAST
+};
+
+/* Trace events, which go to the same per thread rings as frame probes */
+enum performance_trace_event
+{
+   PERF_TRACE_BEGIN = PERF_PROBE_LAST,
+   PERF_TRACE_END,
+   PERF_TRACE_COUNTER
+};
+
+struct performance_probe_stats
+{
+   retro_time_t p50;
+   retro_time_t p99;
+   retro_time_t max;
+   unsigned count;
+};
+
 typedef struct rarch_timer
 {
    int64_t current;
@@ -89,6 +119,90 @@ void rarch_perf_register(struct retro_perf_counter *perf);
  **/
 #define performance_counter_stop_plus(is_perfcnt_enable, perf) performance_counter_stop_internal(is_perfcnt_enable, perf)
 
+void performance_probes_init(void);
+
+void performance_probe_record(enum performance_probe probe,
+      retro_time_t start, retro_time_t duration);
+
+void performance_probe_present(void);
+
+bool performance_probe_get_stats(enum performance_probe probe,
+      struct performance_probe_stats *stats);
+
+size_t performance_probes_get_summary(char *s, size_t len);
+
+bool performance_probes_write_trace(const char *path);
+
+/**
+ * performance_probe_start:
+ * @start              : retro_time_t to store the start time in
+ *
+ * Start timing a frame probe.
+ **/
+#define performance_probe_start(is_perfcnt_enable, start) \
+   if ((is_perfcnt_enable)) \
+      start = cpu_features_get_time_usec()
+
+/**
+ * performance_probe_stop:
+ * @probe              : enum performance_probe
+ * @start              : start time from performance_probe_start
+ *
+ * Record how long a frame probe took.
+ **/
+#define performance_probe_stop(is_perfcnt_enable, probe, start) \
+   if ((is_perfcnt_enable)) \
+      performance_probe_record(probe, start, \
+            cpu_features_get_time_usec() - (start))
+
+/* Set while a trace is being taken, see performance_trace_start */
+extern bool performance_trace_enabled;
+
+void performance_trace_record(enum performance_trace_event type,
+      const char *name, unsigned value);
+
+void performance_trace_thread_begin(const char *name);
+
+void performance_trace_thread_end(void);
+
+bool performance_trace_start(const char *path);
+
+void performance_trace_flush(void);
+
+void performance_trace_stop(void);
+
+/**
+ * performance_trace_begin:
+ * @name               : string literal naming what's starting
+ *
+ * Trace the start of something on the calling thread. Costs a branch
+ * while not tracing.
+ **/
+#define performance_trace_begin(name) \
+   if (performance_trace_enabled) \
+      performance_trace_record(PERF_TRACE_BEGIN, name, 0)
+
+/**
+ * performance_trace_end:
+ * @name               : same as given to performance_trace_begin
+ *
+ * Trace the end of what performance_trace_begin started.
+ **/
+#define performance_trace_end(name) \
+   if (performance_trace_enabled) \
+      performance_trace_record(PERF_TRACE_END, name, 0)
+
+/**
+ * performance_trace_counter:
+ * @name               : string literal naming the counter
+ * @value              : its current value
+ *
+ * Trace the value of a counter, like how full a buffer is.
+ **/
+#define performance_trace_counter(name, value) \
+   if (performance_trace_enabled) \
+      performance_trace_record(PERF_TRACE_COUNTER, name, value)
+
 void rarch_timer_tick(rarch_timer_t *timer);
 
 bool rarch_timer_is_running(rarch_timer_t *timer);
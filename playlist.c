@@ -15,11 +15,14 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include <libretro.h>
 #include <boolean.h>
+#include <retro_atomic.h>
 #include <compat/posix_string.h>
 #include <string/stdstring.h>
 #include <streams/interface_stream.h>
@@ -33,14 +36,29 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+#define PLAYLIST_MIN_ENTRIES 16
+
+/* path, label and crc32 of entries read from disk point into
+ * the file buffer of the playlist, see playlist_free_string(). */
 struct playlist_entry
 {
    char *path;
    char *label;
+   /* core_path, core_name and db_name are interned,
+    * they belong to the playlist string pool. */
    char *core_path;
    char *core_name;
    char *db_name;
    char *crc32;
+   /* Larger is closer to the top of the playlist. */
+   uint64_t order;
+   uint32_t hash;
+};
+
+struct playlist_string
+{
+   char *str;
+   uint32_t hash;
 };
 
 struct content_playlist
@@ -50,13 +68,337 @@ struct content_playlist
    size_t cap;
 
    char *conf_path;
-   struct playlist_entry *entries;
+
+   /* Ring of entries, the top one is entries[head].
+    * entries_size is a power of two. */
+   struct playlist_entry **entries;
+   size_t entries_size;
+   size_t head;
+
+   /* All entries hashed by path, open addressing. Several
+    * entries can share a path when they use different cores. */
+   struct playlist_entry **index;
+   size_t index_size;
+
+   /* Pool of the core paths, core names and database names,
+    * which are repeated over most entries. */
+   struct playlist_string *strings;
+   size_t strings_size;
+   size_t strings_count;
+
+   uint64_t order;
+
+   /* Contents of the playlist file, parsed in place, and the
+    * entries read from it, allocated in one block. */
+   char *buf;
+   size_t buf_size;
+   struct playlist_entry *loaded;
+   size_t loaded_count;
+
+   /* Tells this playlist apart from a later one at the same address */
+   unsigned generation;
 };
 
+static unsigned playlist_generation;
+
 typedef int (playlist_sort_fun_t)(
       const struct playlist_entry *a,
       const struct playlist_entry *b);
 
+static uint32_t playlist_hash_string(const char *s)
+{
+   uint32_t hash = 5381;
+
+   while (*s)
+      hash = (hash << 5) + hash + (uint8_t)*s++;
+
+   return hash;
+}
+
+static uint32_t playlist_hash_path(const char *path)
+{
+   uint32_t hash = 5381;
+
+   if (!path)
+      return 0;
+
+   while (*path)
+#ifdef _WIN32
+      hash = (hash << 5) + hash + (uint8_t)tolower((uint8_t)*path++);
+#else
+      hash = (hash << 5) + hash + (uint8_t)*path++;
+#endif
+
+   return hash;
+}
+
+static bool playlist_path_equal(const char *a, const char *b)
+{
+   if (!a || !b)
+      return !a && !b;
+#ifdef _WIN32
+   /* prevent duplicates on case-insensitive operating systems */
+   return string_is_equal_noncase(a, b);
+#else
+   return string_is_equal(a, b);
+#endif
+}
+
+static struct playlist_string *playlist_string_find(
+      const struct playlist_string *strings, size_t size,
+      const char *str, uint32_t hash)
+{
+   size_t slot = hash & (size - 1);
+
+   while (strings[slot].str)
+   {
+      if (strings[slot].hash == hash && string_is_equal(strings[slot].str, str))
+         break;
+      slot = (slot + 1) & (size - 1);
+   }
+
+   return (struct playlist_string*)&strings[slot];
+}
+
+static bool playlist_strings_grow(playlist_t *playlist)
+{
+   size_t i;
+   size_t size                     = playlist->strings_size
+      ? playlist->strings_size * 2 : PLAYLIST_MIN_ENTRIES;
+   struct playlist_string *strings = (struct playlist_string*)
+      calloc(size, sizeof(*strings));
+
+   if (!strings)
+      return false;
+
+   for (i = 0; i < playlist->strings_size; i++)
+      if (playlist->strings[i].str)
+         *playlist_string_find(strings, size, playlist->strings[i].str,
+               playlist->strings[i].hash) = playlist->strings[i];
+
+   free(playlist->strings);
+   playlist->strings      = strings;
+   playlist->strings_size = size;
+   return true;
+}
+
+/* Returns the pooled copy of @str, or NULL if @str is empty. */
+static char *playlist_intern(playlist_t *playlist, const char *str)
+{
+   uint32_t hash                  = 0;
+   struct playlist_string *string = NULL;
+
+   if (string_is_empty(str))
+      return NULL;
+
+   if ((playlist->strings_count + 1) * 2 > playlist->strings_size)
+      if (!playlist_strings_grow(playlist))
+         return NULL;
+
+   hash   = playlist_hash_string(str);
+   string = playlist_string_find(playlist->strings,
+         playlist->strings_size, str, hash);
+
+   if (!string->str)
+   {
+      if (!(string->str = strdup(str)))
+         return NULL;
+      string->hash = hash;
+      playlist->strings_count++;
+   }
+
+   return string->str;
+}
+
+/* Same as playlist_intern(), but does not add @str to the pool. */
+static char *playlist_intern_find(playlist_t *playlist, const char *str)
+{
+   if (string_is_empty(str) || !playlist->strings_size)
+      return NULL;
+
+   return playlist_string_find(playlist->strings, playlist->strings_size,
+         str, playlist_hash_string(str))->str;
+}
+
+static struct playlist_entry *playlist_entry_at(playlist_t *playlist,
+      size_t idx)
+{
+   return playlist->entries[(playlist->head + idx)
+      & (playlist->entries_size - 1)];
+}
+
+static void playlist_entry_set(playlist_t *playlist,
+      size_t idx, struct playlist_entry *entry)
+{
+   playlist->entries[(playlist->head + idx)
+      & (playlist->entries_size - 1)] = entry;
+}
+
+static void playlist_index_insert(struct playlist_entry **index,
+      size_t size, struct playlist_entry *entry)
+{
+   size_t slot = entry->hash & (size - 1);
+
+   while (index[slot])
+      slot = (slot + 1) & (size - 1);
+
+   index[slot] = entry;
+}
+
+static bool playlist_index_grow(playlist_t *playlist, size_t size)
+{
+   size_t i;
+   struct playlist_entry **index = (struct playlist_entry**)
+      calloc(size, sizeof(*index));
+
+   if (!index)
+      return false;
+
+   for (i = 0; i < playlist->size; i++)
+      playlist_index_insert(index, size, playlist_entry_at(playlist, i));
+
+   free(playlist->index);
+   playlist->index      = index;
+   playlist->index_size = size;
+   return true;
+}
+
+static void playlist_index_remove(playlist_t *playlist,
+      struct playlist_entry *entry)
+{
+   size_t i, j;
+   size_t mask = playlist->index_size - 1;
+
+   if (!playlist->index)
+      return;
+
+   for (i = entry->hash & mask; playlist->index[i]; i = (i + 1) & mask)
+      if (playlist->index[i] == entry)
+         break;
+
+   if (!playlist->index[i])
+      return;
+
+   /* Backward shift deletion, keeps the probe
+    * sequences of the following slots intact. */
+   for (j = (i + 1) & mask; playlist->index[j]; j = (j + 1) & mask)
+   {
+      size_t home = playlist->index[j]->hash & mask;
+
+      if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+         continue;
+
+      playlist->index[i] = playlist->index[j];
+      i                  = j;
+   }
+
+   playlist->index[i] = NULL;
+}
+
+/* Returns the topmost entry with @path, and with @core_path
+ * unless it is NULL. @core_path has to be interned. Unless
+ * @exact, paths are compared the way playlist_push() does,
+ * ignoring case on Windows. */
+static struct playlist_entry *playlist_index_find(playlist_t *playlist,
+      const char *path, const char *core_path, bool exact)
+{
+   size_t i;
+   struct playlist_entry *found = NULL;
+   uint32_t hash                = playlist_hash_path(path);
+   size_t mask                  = playlist->index_size - 1;
+
+   if (!playlist->index)
+      return NULL;
+
+   for (i = hash & mask; playlist->index[i]; i = (i + 1) & mask)
+   {
+      struct playlist_entry *entry = playlist->index[i];
+
+      if (entry->hash != hash)
+         continue;
+
+      if (exact ? !string_is_equal(entry->path, path)
+            : !playlist_path_equal(entry->path, path))
+         continue;
+
+      if (core_path && entry->core_path != core_path)
+         continue;
+
+      if (!found || entry->order > found->order)
+         found = entry;
+   }
+
+   return found;
+}
+
+/* Makes room for one more entry in the ring and the index. */
+static bool playlist_reserve(playlist_t *playlist)
+{
+   if (playlist->size == playlist->entries_size)
+   {
+      size_t i;
+      size_t size                     = playlist->entries_size
+         ? playlist->entries_size * 2 : PLAYLIST_MIN_ENTRIES;
+      struct playlist_entry **entries = (struct playlist_entry**)
+         calloc(size, sizeof(*entries));
+
+      if (!entries)
+         return false;
+
+      for (i = 0; i < playlist->size; i++)
+         entries[i] = playlist_entry_at(playlist, i);
+
+      free(playlist->entries);
+      playlist->entries      = entries;
+      playlist->entries_size = size;
+      playlist->head         = 0;
+   }
+
+   if ((playlist->size + 1) * 2 > playlist->index_size)
+      return playlist_index_grow(playlist, playlist->index_size
+            ? playlist->index_size * 2 : PLAYLIST_MIN_ENTRIES * 2);
+
+   return true;
+}
+
+/* Removes the entry at @idx from the ring and the index,
+ * the caller owns it afterwards. */
+static struct playlist_entry *playlist_remove(playlist_t *playlist,
+      size_t idx)
+{
+   size_t i;
+   struct playlist_entry *entry = playlist_entry_at(playlist, idx);
+
+   /* Close the gap from whichever end is nearer. */
+   if (idx < playlist->size / 2)
+   {
+      for (i = idx; i > 0; i--)
+         playlist_entry_set(playlist, i, playlist_entry_at(playlist, i - 1));
+      playlist->head = (playlist->head + 1) & (playlist->entries_size - 1);
+   }
+   else
+   {
+      for (i = idx; i + 1 < playlist->size; i++)
+         playlist_entry_set(playlist, i, playlist_entry_at(playlist, i + 1));
+   }
+
+   playlist->size--;
+   playlist_index_remove(playlist, entry);
+
+   return entry;
+}
+
+/* Assigns the order of every entry from its position. */
+static void playlist_renumber(playlist_t *playlist)
+{
+   size_t i;
+
+   for (i = 0; i < playlist->size; i++)
+      playlist_entry_at(playlist, i)->order = playlist->size - i;
+
+   playlist->order = playlist->size;
+}
+
 uint32_t playlist_get_size(playlist_t *playlist)
 {
    if (!playlist)
@@ -88,21 +430,57 @@ void playlist_get_index(playlist_t *playlist,
       const char **crc32,
       const char **db_name)
 {
-   if (!playlist)
+   const struct playlist_entry *entry = NULL;
+
+   if (!playlist || idx >= playlist->size)
       return;
 
+   entry = playlist_entry_at(playlist, idx);
+
    if (path)
-      *path      = playlist->entries[idx].path;
+      *path      = entry->path;
    if (label)
-      *label     = playlist->entries[idx].label;
+      *label     = entry->label;
    if (core_path)
-      *core_path = playlist->entries[idx].core_path;
+      *core_path = entry->core_path;
    if (core_name)
-      *core_name = playlist->entries[idx].core_name;
+      *core_name = entry->core_name;
    if (db_name)
-      *db_name   = playlist->entries[idx].db_name;
+      *db_name   = entry->db_name;
    if (crc32)
-      *crc32     = playlist->entries[idx].crc32;
+      *crc32     = entry->crc32;
+}
+
+static void playlist_free_string(playlist_t *playlist, char *str)
+{
+   if (str >= playlist->buf && str < playlist->buf + playlist->buf_size)
+      return;
+
+   free(str);
+}
+
+/**
+ * playlist_free_entry:
+ * @playlist            : Playlist handle.
+ * @entry               : Playlist entry handle.
+ *
+ * Frees playlist entry.
+ **/
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
+{
+   if (!entry)
+      return;
+
+   playlist_free_string(playlist, entry->path);
+   playlist_free_string(playlist, entry->label);
+   playlist_free_string(playlist, entry->crc32);
+
+   if (entry >= playlist->loaded
+         && entry < playlist->loaded + playlist->loaded_count)
+      return;
+
+   free(entry);
 }
 
 /**
@@ -115,13 +493,11 @@ void playlist_get_index(playlist_t *playlist,
 void playlist_delete_index(playlist_t *playlist,
       size_t idx)
 {
-   if (!playlist)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (playlist->size - idx) * sizeof(struct playlist_entry));
+   playlist_free_entry(playlist, playlist_remove(playlist, idx));
 
-   playlist->size     = playlist->size - 1;
    playlist->modified = true;
 }
 
@@ -132,76 +508,38 @@ void playlist_get_index_by_path(playlist_t *playlist,
       char **crc32,
       char **db_name)
 {
-   size_t i;
-   if (!playlist)
+   struct playlist_entry *entry = NULL;
+
+   if (!playlist || !search_path)
       return;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (!string_is_equal(playlist->entries[i].path, search_path))
-         continue;
+   entry = playlist_index_find(playlist, search_path, NULL, true);
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
-   }
+   if (!entry)
+      return;
+
+   if (path)
+      *path      = entry->path;
+   if (label)
+      *label     = entry->label;
+   if (core_path)
+      *core_path = entry->core_path;
+   if (core_name)
+      *core_name = entry->core_name;
+   if (db_name)
+      *db_name   = entry->db_name;
+   if (crc32)
+      *crc32     = entry->crc32;
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32)
 {
-   size_t i;
-   if (!playlist)
+   if (!playlist || !path)
       return false;
 
-   for (i = 0; i < playlist->size; i++)
-      if (string_is_equal(playlist->entries[i].path, path))
-         return true;
-
-   return false;
-}
-
-/**
- * playlist_free_entry:
- * @entry               : Playlist entry handle.
- *
- * Frees playlist entry.
- **/
-static void playlist_free_entry(struct playlist_entry *entry)
-{
-   if (!entry)
-      return;
-
-   if (entry->path != NULL)
-      free(entry->path);
-   if (entry->label != NULL)
-      free(entry->label);
-   if (entry->core_path != NULL)
-      free(entry->core_path);
-   if (entry->core_name != NULL)
-      free(entry->core_name);
-   if (entry->db_name != NULL)
-      free(entry->db_name);
-   if (entry->crc32 != NULL)
-      free(entry->crc32);
-
-   entry->path      = NULL;
-   entry->label     = NULL;
-   entry->core_path = NULL;
-   entry->core_name = NULL;
-   entry->db_name   = NULL;
-   entry->crc32     = NULL;
+   return playlist_index_find(playlist, path, NULL, true) != NULL;
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
@@ -212,56 +550,50 @@ void playlist_update(playlist_t *playlist, size_t idx,
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   entry            = &playlist->entries[idx];
+   entry            = playlist_entry_at(playlist, idx);
 
    if (path && (path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
+      /* The entry is hashed by path. */
+      playlist_index_remove(playlist, entry);
+      playlist_free_string(playlist, entry->path);
       entry->path        = strdup(path);
+      entry->hash        = playlist_hash_path(entry->path);
+      playlist_index_insert(playlist->index, playlist->index_size, entry);
       playlist->modified = true;
    }
 
    if (label && (label != entry->label))
    {
-      if (entry->label != NULL)
-         free(entry->label);
+      playlist_free_string(playlist, entry->label);
       entry->label       = strdup(label);
       playlist->modified = true;
    }
 
    if (core_path && (core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
-      entry->core_path   = NULL;
-      entry->core_path   = strdup(core_path);
+      entry->core_path   = playlist_intern(playlist, core_path);
       playlist->modified = true;
    }
 
    if (core_name && (core_name != entry->core_name))
    {
-      if (entry->core_name != NULL)
-         free(entry->core_name);
-      entry->core_name   = strdup(core_name);
+      entry->core_name   = playlist_intern(playlist, core_name);
       playlist->modified = true;
    }
 
    if (db_name && (db_name != entry->db_name))
    {
-      if (entry->db_name != NULL)
-         free(entry->db_name);
-      entry->db_name     = strdup(db_name);
+      entry->db_name     = playlist_intern(playlist, db_name);
       playlist->modified = true;
    }
 
    if (crc32 && (crc32 != entry->crc32))
    {
-      if (entry->crc32 != NULL)
-         free(entry->crc32);
+      playlist_free_string(playlist, entry->crc32);
       entry->crc32       = strdup(crc32);
       playlist->modified = true;
    }
@@ -282,9 +614,9 @@ bool playlist_push(playlist_t *playlist,
       const char *crc32,
       const char *db_name)
 {
-   size_t i;
-   bool core_path_empty = string_is_empty(core_path);
-   bool core_name_empty = string_is_empty(core_name);
+   struct playlist_entry *entry = NULL;
+   bool core_path_empty         = string_is_empty(core_path);
+   bool core_name_empty         = string_is_empty(core_name);
 
    if (core_path_empty || core_name_empty)
    {
@@ -308,79 +640,67 @@ bool playlist_push(playlist_t *playlist,
    if (!playlist)
       return false;
 
-   for (i = 0; i < playlist->size; i++)
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. Core paths are
+    * interned, so an unknown one cannot match any entry. */
    {
-      struct playlist_entry tmp;
-      bool equal_path;
-
-      equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-#ifdef _WIN32
-          /*prevent duplicates on case-insensitive operating systems*/
-          string_is_equal_noncase(path,playlist->entries[i].path)
-#else
-          string_is_equal(path,playlist->entries[i].path)
-#endif
-          );
+      const char *interned = playlist_intern_find(playlist, core_path);
 
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
+      if (interned)
+         entry = playlist_index_find(playlist, path, interned, false);
+   }
 
-      if (!string_is_equal(playlist->entries[i].core_path, core_path))
-         continue;
+   if (entry)
+   {
+      size_t i;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
-      if (i == 0)
+      if (entry == playlist_entry_at(playlist, 0))
          return false;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      for (i = 1; playlist_entry_at(playlist, i) != entry; i++);
+      for (; i > 0; i--)
+         playlist_entry_set(playlist, i, playlist_entry_at(playlist, i - 1));
+      playlist_entry_set(playlist, 0, entry);
+
+      entry->order = ++playlist->order;
 
       goto success;
    }
 
+   if (playlist->cap == 0)
+      return false;
+
    if (playlist->size == playlist->cap)
-   {
-      struct playlist_entry *entry = &playlist->entries[playlist->cap - 1];
+      playlist_free_entry(playlist, playlist_remove(playlist, playlist->size - 1));
 
-      if (entry)
-         playlist_free_entry(entry);
-      playlist->size--;
-   }
+   if (!playlist_reserve(playlist))
+      return false;
 
-   if (playlist->entries)
-   {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
-
-      playlist->entries[0].path         = NULL;
-      playlist->entries[0].label        = NULL;
-      playlist->entries[0].core_path    = NULL;
-      playlist->entries[0].core_name    = NULL;
-      playlist->entries[0].db_name      = NULL;
-      playlist->entries[0].crc32        = NULL;
-      if (!string_is_empty(path))
-         playlist->entries[0].path      = strdup(path);
-      if (!string_is_empty(label))
-         playlist->entries[0].label     = strdup(label);
-      if (!string_is_empty(core_path))
-         playlist->entries[0].core_path = strdup(core_path);
-      if (!string_is_empty(core_name))
-         playlist->entries[0].core_name = strdup(core_name);
-      if (!string_is_empty(db_name))
-         playlist->entries[0].db_name   = strdup(db_name);
-      if (!string_is_empty(crc32))
-         playlist->entries[0].crc32     = strdup(crc32);
-   }
+   entry = (struct playlist_entry*)calloc(1, sizeof(*entry));
+   if (!entry)
+      return false;
 
+   if (!string_is_empty(path))
+      entry->path      = strdup(path);
+   if (!string_is_empty(label))
+      entry->label     = strdup(label);
+   if (!string_is_empty(crc32))
+      entry->crc32     = strdup(crc32);
+   entry->core_path    = playlist_intern(playlist, core_path);
+   entry->core_name    = playlist_intern(playlist, core_name);
+   entry->db_name      = playlist_intern(playlist, db_name);
+   entry->hash         = playlist_hash_path(entry->path);
+   entry->order        = ++playlist->order;
+
+   playlist->head      = (playlist->head - 1) & (playlist->entries_size - 1);
+   playlist->entries[playlist->head] = entry;
    playlist->size++;
 
+   playlist_index_insert(playlist->index, playlist->index_size, entry);
+
 success:
    playlist->modified = true;
 
@@ -390,35 +710,73 @@ success:
 void playlist_write_file(playlist_t *playlist)
 {
    size_t i;
-   RFILE *file = NULL;
+   char *buf  = NULL;
+   char *out  = NULL;
+   size_t len = 0;
 
    if (!playlist || !playlist->modified)
       return;
 
-   file = filestream_open(playlist->conf_path,
-         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   /* Six lines per entry, see playlist_read_file(). */
+   for (i = 0; i < playlist->size; i++)
+   {
+      const struct playlist_entry *entry = playlist_entry_at(playlist, i);
+
+      len += (entry->path      ? strlen(entry->path)      : 0)
+           + (entry->label     ? strlen(entry->label)     : 0)
+           + (entry->core_path ? strlen(entry->core_path) : 0)
+           + (entry->core_name ? strlen(entry->core_name) : 0)
+           + (entry->crc32     ? strlen(entry->crc32)     : 0)
+           + (entry->db_name   ? strlen(entry->db_name)   : 0)
+           + PLAYLIST_ENTRIES;
+   }
+
+   /* One write instead of one per entry. */
+   buf = (char*)malloc(len + 1);
 
-   if (!file)
+   if (!buf)
    {
       RARCH_ERR("Failed to write to playlist file: %s\n", playlist->conf_path);
       return;
    }
 
+   out = buf;
+
    for (i = 0; i < playlist->size; i++)
-      filestream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
-            playlist->entries[i].path    ? playlist->entries[i].path    : "",
-            playlist->entries[i].label   ? playlist->entries[i].label   : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name,
-            playlist->entries[i].crc32   ? playlist->entries[i].crc32   : "",
-            playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
-            );
+   {
+      unsigned j;
+      const struct playlist_entry *entry = playlist_entry_at(playlist, i);
+      const char *fields[PLAYLIST_ENTRIES];
+
+      fields[0] = entry->path;
+      fields[1] = entry->label;
+      fields[2] = entry->core_path;
+      fields[3] = entry->core_name;
+      fields[4] = entry->crc32;
+      fields[5] = entry->db_name;
+
+      for (j = 0; j < PLAYLIST_ENTRIES; j++)
+      {
+         size_t field_len = fields[j] ? strlen(fields[j]) : 0;
+
+         memcpy(out, fields[j], field_len);
+         out   += field_len;
+         *out++ = '\n';
+      }
+   }
+
+   if (!filestream_write_file(playlist->conf_path, buf, (ssize_t)len))
+   {
+      RARCH_ERR("Failed to write to playlist file: %s\n", playlist->conf_path);
+      free(buf);
+      return;
+   }
+
+   free(buf);
 
    playlist->modified = false;
 
    RARCH_LOG("Written to playlist file: %s\n", playlist->conf_path);
-
-   filestream_close(file);
 }
 
 /**
@@ -439,14 +797,13 @@ void playlist_free(playlist_t *playlist)
 
    playlist->conf_path = NULL;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      struct playlist_entry *entry = &playlist->entries[i];
+   playlist_clear(playlist);
 
-      if (entry)
-         playlist_free_entry(entry);
-   }
+   for (i = 0; i < playlist->strings_size; i++)
+      free(playlist->strings[i].str);
 
+   free(playlist->strings);
+   free(playlist->index);
    free(playlist->entries);
    playlist->entries = NULL;
 
@@ -466,13 +823,21 @@ void playlist_clear(playlist_t *playlist)
       return;
 
    for (i = 0; i < playlist->size; i++)
-   {
-      struct playlist_entry *entry = &playlist->entries[i];
+      playlist_free_entry(playlist, playlist_entry_at(playlist, i));
 
-      if (entry)
-         playlist_free_entry(entry);
-   }
-   playlist->size = 0;
+   if (playlist->index)
+      memset(playlist->index, 0,
+            playlist->index_size * sizeof(*playlist->index));
+
+   free(playlist->loaded);
+   free(playlist->buf);
+
+   playlist->loaded       = NULL;
+   playlist->loaded_count = 0;
+   playlist->buf          = NULL;
+   playlist->buf_size     = 0;
+   playlist->size         = 0;
+   playlist->head         = 0;
 }
 
 /**
@@ -489,68 +854,132 @@ size_t playlist_size(playlist_t *playlist)
    return playlist->size;
 }
 
+unsigned playlist_get_generation(playlist_t *playlist)
+{
+   if (!playlist)
+      return 0;
+   return playlist->generation;
+}
+
+
+/* Returns the next line of the buffer, NUL terminated in place
+ * regardless of Windows or Unix line endings. */
+static char *playlist_next_line(char **cursor, char *end)
+{
+   char *line = *cursor;
+   char *eol  = NULL;
+
+   if (line >= end)
+      return NULL;
+
+   eol = (char*)memchr(line, '\n', end - line);
+
+   if (eol)
+      *cursor = eol + 1;
+   else
+   {
+      /* filestream_read_file() terminates the buffer. */
+      eol     = end;
+      *cursor = end;
+   }
+
+   *eol = '\0';
+   if (eol > line && eol[-1] == '\r')
+      eol[-1] = '\0';
+
+   return line;
+}
 
 static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
-   unsigned i;
-   char buf[PLAYLIST_ENTRIES][1024];
-   intfstream_t *file = intfstream_open_file(
-         path, RETRO_VFS_FILE_ACCESS_READ,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   char *cursor = NULL;
+   char *end    = NULL;
+   void *buf    = NULL;
+   ssize_t len  = 0;
+   size_t lines = 0;
 
    /* If playlist file does not exist,
     * create an empty playlist instead.
     */
-   if (!file)
+   if (!path_is_valid(path) || !filestream_read_file(path, &buf, &len))
+      return true;
+
+   if (len <= 0)
+   {
+      free(buf);
+      return true;
+   }
+
+   playlist->buf      = (char*)buf;
+   playlist->buf_size = (size_t)len;
+   end                = playlist->buf + len;
+
+   /* The entries are allocated in one go, count them first. */
+   for (cursor = playlist->buf; cursor < end; lines++)
+   {
+      char *eol = (char*)memchr(cursor, '\n', end - cursor);
+      cursor    = eol ? eol + 1 : end;
+   }
+
+   playlist->loaded_count = lines / PLAYLIST_ENTRIES;
+   if (playlist->loaded_count > playlist->cap)
+      playlist->loaded_count = playlist->cap;
+
+   if (!playlist->loaded_count)
       return true;
 
-   for (i = 0; i < PLAYLIST_ENTRIES; i++)
-      buf[i][0] = '\0';
+   playlist->loaded = (struct playlist_entry*)calloc(
+         playlist->loaded_count, sizeof(*playlist->loaded));
 
-   for (playlist->size = 0; playlist->size < playlist->cap; )
+   if (!playlist->loaded)
+   {
+      playlist->loaded_count = 0;
+      return true;
+   }
+
+   cursor = playlist->buf;
+
+   while (playlist->size < playlist->loaded_count)
    {
       unsigned i;
-      struct playlist_entry *entry     = NULL;
-      for (i = 0; i < PLAYLIST_ENTRIES; i++)
-      {
-         char *last  = NULL;
-         *buf[i]     = '\0';
+      char *fields[PLAYLIST_ENTRIES];
+      struct playlist_entry *entry = NULL;
 
-         if (!intfstream_gets(file, buf[i], sizeof(buf[i])))
+      for (i = 0; i < PLAYLIST_ENTRIES; i++)
+         if (!(fields[i] = playlist_next_line(&cursor, end)))
             goto end;
 
-         /* Read playlist entry and terminate string with NUL character
-          * regardless of Windows or Unix line endings
-          */
-         if((last = strrchr(buf[i], '\r')))
-            *last = '\0';
-         else if((last = strrchr(buf[i], '\n')))
-            *last = '\0';
-      }
+      if (!*fields[2] || !*fields[3])
+         continue;
 
-      entry = &playlist->entries[playlist->size];
+      if (!playlist_reserve(playlist))
+         goto end;
 
-      if (!*buf[2] || !*buf[3])
-         continue;
+      entry = &playlist->loaded[playlist->size];
+
+      if (*fields[0])
+         entry->path      = fields[0];
+      if (*fields[1])
+         entry->label     = fields[1];
+
+      entry->core_path    = playlist_intern(playlist, fields[2]);
+      entry->core_name    = playlist_intern(playlist, fields[3]);
+      if (*fields[4])
+         entry->crc32     = fields[4];
+      if (*fields[5])
+         entry->db_name   = playlist_intern(playlist, fields[5]);
+      entry->hash         = playlist_hash_path(entry->path);
 
-      if (*buf[0])
-         entry->path      = strdup(buf[0]);
-      if (*buf[1])
-         entry->label     = strdup(buf[1]);
-
-      entry->core_path    = strdup(buf[2]);
-      entry->core_name    = strdup(buf[3]);
-      if (*buf[4])
-         entry->crc32     = strdup(buf[4]);
-      if (*buf[5])
-         entry->db_name   = strdup(buf[5]);
+      /* Entries are read top to bottom, append them. */
+      playlist_entry_set(playlist, playlist->size, entry);
       playlist->size++;
+
+      playlist_index_insert(playlist->index, playlist->index_size, entry);
    }
 
 end:
-   intfstream_close(file);
-   free(file);
+   playlist_renumber(playlist);
    return true;
 }
 
@@ -565,34 +994,28 @@ end:
  **/
 playlist_t *playlist_init(const char *path, size_t size)
 {
-   struct playlist_entry *entries = NULL;
-   playlist_t           *playlist = (playlist_t*)malloc(sizeof(*playlist));
+   playlist_t           *playlist = (playlist_t*)calloc(1, sizeof(*playlist));
    if (!playlist)
       return NULL;
 
-   entries = (struct playlist_entry*)calloc(size, sizeof(*entries));
-   if (!entries)
-   {
-      free(playlist);
-      return NULL;
-   }
-
+   /* Storage grows with the playlist, the capacity
+    * is only the number of entries it may hold. */
    playlist->modified  = false;
    playlist->size      = 0;
    playlist->cap       = size;
    playlist->conf_path = strdup(path);
-   playlist->entries   = entries;
+   playlist->generation = retro_atomic_fetch_add(&playlist_generation, 1) + 1;
 
    playlist_read_file(playlist, path);
 
    return playlist;
 }
 
-static int playlist_qsort_func(const struct playlist_entry *a,
-      const struct playlist_entry *b)
+static int playlist_qsort_func(const struct playlist_entry **a,
+      const struct playlist_entry **b)
 {
-   const char *a_label = a ? a->label : NULL;
-   const char *b_label = b ? b->label : NULL;
+   const char *a_label = *a ? (*a)->label : NULL;
+   const char *b_label = *b ? (*b)->label : NULL;
 
    if (!a_label || !b_label)
       return 0;
@@ -602,7 +1025,31 @@ static int playlist_qsort_func(const struct playlist_entry *a,
 
 void playlist_qsort(playlist_t *playlist)
 {
-   qsort(playlist->entries, playlist->size,
-         sizeof(struct playlist_entry),
+   size_t i;
+
+   if (!playlist || !playlist->size)
+      return;
+
+   /* Unwrap the ring so the entries are contiguous. */
+   if (playlist->head + playlist->size > playlist->entries_size)
+   {
+      struct playlist_entry **entries = (struct playlist_entry**)
+         malloc(playlist->size * sizeof(*entries));
+
+      if (!entries)
+         return;
+
+      for (i = 0; i < playlist->size; i++)
+         entries[i] = playlist_entry_at(playlist, i);
+
+      memcpy(playlist->entries, entries, playlist->size * sizeof(*entries));
+      playlist->head = 0;
+      free(entries);
+   }
+
+   qsort(playlist->entries + playlist->head, playlist->size,
+         sizeof(struct playlist_entry*),
          (int (*)(const void *, const void *))playlist_qsort_func);
+
+   playlist_renumber(playlist);
 }
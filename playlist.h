@@ -62,6 +62,16 @@ void playlist_clear(playlist_t *playlist);
  **/
 size_t playlist_size(playlist_t *playlist);
 
+/**
+ * playlist_get_generation:
+ * @playlist        	   : Playlist handle.
+ *
+ * Gets a number identifying this playlist. Unlike its
+ * address, it isn't reused once the playlist is freed.
+ * Returns: generation of playlist, 0 if NULL.
+ **/
+unsigned playlist_get_generation(playlist_t *playlist);
+
 /**
  * playlist_get_index:
  * @playlist               : Playlist handle.
@@ -18,10 +18,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <string.h>
+
 #include <retro_assert.h>
+#include <retro_atomic.h>
 #include <compat/msvc.h>
 
 #include <boolean.h>
+#include <features/features_cpu.h>
 #include <queues/fifo_queue.h>
 #include <rthreads/rthreads.h>
 #include <gfx/scaler/scaler.h>
@@ -66,6 +70,7 @@ extern "C" {
 
 #include "../../configuration.h"
 #include "../../gfx/video_driver.h"
+#include "../../performance_counters.h"
 #include "../../verbosity.h"
 
 #ifndef AV_CODEC_FLAG_QSCALE
@@ -206,6 +211,23 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+#define MAX_FRAMES 32
+
+/* Pipeline statistics are logged this often while recording. */
+#define STATS_INTERVAL_SECONDS 60
+
+/* FFmpeg has a tendency to read a bit past the end of
+ * the input picture, so pad every frame buffer. */
+#define FRAME_PADDING 64
+
+/* Frame queued for the encoder thread. attr.data points
+ * into buf, which is owned by the slot and reused. */
+struct ff_frame
+{
+   struct ffemu_video_data attr;
+   uint8_t *buf;
+};
+
 typedef struct ffmpeg
 {
    struct ff_video_info video;
@@ -215,16 +237,46 @@ typedef struct ffmpeg
 
    struct ffemu_params params;
 
-   scond_t *cond;
+   /* Signalled when there is work for the video/audio encoder thread. */
+   scond_t *video_cond;
+   scond_t *audio_cond;
+   /* Signalled when there is room for the producer. */
+   scond_t *space_cond;
    slock_t *cond_lock;
+   /* Only protects audio_fifo, video goes through frames. */
    slock_t *lock;
+   /* Serializes access to the muxer between the encoder threads. */
+   slock_t *mux_lock;
    fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
-   sthread_t *thread;
-
-   volatile bool alive;
-   volatile bool can_sleep;
+   sthread_t *video_thread;
+   sthread_t *audio_thread;
+
+   /* Single producer / single consumer ring of frame buffers.
+    * frame_write is only advanced by the producer once the frame
+    * is complete, frame_read only by the encoder once it is done
+    * with the frame, so neither side needs a lock. */
+   struct ff_frame frames[MAX_FRAMES];
+   size_t frame_size;
+   volatile unsigned frame_write;
+   volatile unsigned frame_read;
+
+   /* Raised by either side before sleeping on cond_lock,
+    * so the other side only has to signal when needed. */
+   volatile int video_waiting;
+   volatile int audio_waiting;
+   volatile int producer_waiting;
+
+   /* Pipeline statistics, logged every stats_interval pushed
+    * frames and when recording ends. Only the producer writes them. */
+   unsigned stats_interval;
+   unsigned frames_pushed;
+   unsigned frames_dropped;
+   unsigned video_stalls;
+   unsigned audio_stalls;
+   unsigned video_peak;
+   size_t audio_peak;
+
+   volatile int alive;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -499,6 +551,8 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
    video->codec->pix_fmt             = video->pix_fmt;
 
    video->codec->thread_count = params->threads;
+   if (!video->codec->thread_count)
+      video->codec->thread_count = cpu_features_get_core_amount();
 
    if (params->video_qscale)
    {
@@ -665,70 +719,105 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
-
-static void ffmpeg_thread(void *data);
+static void ffmpeg_video_thread(void *data);
+static void ffmpeg_audio_thread(void *data);
 
 static bool init_thread(ffmpeg_t *handle)
 {
+   unsigned i;
+   size_t frame_size = handle->params.fb_width * handle->params.fb_height *
+      handle->video.pix_size + handle->params.fb_width *
+      handle->video.pix_size + FRAME_PADDING;
+
    handle->lock = slock_new();
    handle->cond_lock = slock_new();
-   handle->cond = scond_new();
+   handle->mux_lock = slock_new();
+   handle->video_cond = scond_new();
+   handle->audio_cond = scond_new();
+   handle->space_cond = scond_new();
    handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
 
-   handle->alive = true;
-   handle->can_sleep = true;
-   handle->thread = sthread_create(ffmpeg_thread, handle);
+   handle->frame_size = frame_size;
+
+   for (i = 0; i < MAX_FRAMES; i++)
+   {
+      handle->frames[i].buf = (uint8_t*)av_malloc(frame_size);
+      retro_assert(handle->frames[i].buf);
+   }
+
+   handle->frame_write = 0;
+   handle->frame_read  = 0;
+   retro_atomic_store(&handle->alive, 1);
+
+   handle->stats_interval = (unsigned)(handle->params.fps *
+         STATS_INTERVAL_SECONDS / handle->video.frame_drop_ratio);
+   if (!handle->stats_interval)
+      handle->stats_interval = 1;
+
+   /* Audio and video are encoded on their own threads,
+    * so a slow video codec doesn't hold up audio and the
+    * other way around. */
+   handle->video_thread = sthread_create(ffmpeg_video_thread, handle);
+   if (handle->config.audio_enable)
+   {
+      handle->audio_thread = sthread_create(ffmpeg_audio_thread, handle);
+      retro_assert(handle->audio_thread);
+   }
 
-   retro_assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   retro_assert(handle->lock && handle->cond_lock && handle->mux_lock &&
+      handle->video_cond && handle->audio_cond && handle->space_cond &&
+      handle->audio_fifo && handle->video_thread);
 
    return true;
 }
 
 static void deinit_thread(ffmpeg_t *handle)
 {
-   if (!handle->thread)
+   if (!handle->video_thread)
       return;
 
    slock_lock(handle->cond_lock);
-   handle->alive = false;
-   handle->can_sleep = false;
+   retro_atomic_store(&handle->alive, 0);
+   scond_signal(handle->video_cond);
+   scond_signal(handle->audio_cond);
+   scond_signal(handle->space_cond);
    slock_unlock(handle->cond_lock);
 
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+   sthread_join(handle->video_thread);
+   if (handle->audio_thread)
+      sthread_join(handle->audio_thread);
 
    slock_free(handle->lock);
    slock_free(handle->cond_lock);
-   scond_free(handle->cond);
+   scond_free(handle->video_cond);
+   scond_free(handle->audio_cond);
+   scond_free(handle->space_cond);
 
-   handle->thread = NULL;
+   handle->video_thread = NULL;
+   handle->audio_thread = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
+   unsigned i;
+
    if (handle->audio_fifo)
    {
       fifo_free(handle->audio_fifo);
       handle->audio_fifo = NULL;
    }
 
-   if (handle->attr_fifo)
+   for (i = 0; i < MAX_FRAMES; i++)
    {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
+      av_free(handle->frames[i].buf);
+      handle->frames[i].buf = NULL;
    }
 
-   if (handle->video_fifo)
+   if (handle->mux_lock)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      slock_free(handle->mux_lock);
+      handle->mux_lock = NULL;
    }
 }
 
@@ -821,14 +910,138 @@ error:
    return NULL;
 }
 
+static unsigned ffmpeg_frames_queued(ffmpeg_t *handle)
+{
+   return retro_atomic_load(&handle->frame_write)
+      - retro_atomic_load(&handle->frame_read);
+}
+
+static bool ffmpeg_frame_space(ffmpeg_t *handle, size_t unused)
+{
+   return ffmpeg_frames_queued(handle) < MAX_FRAMES;
+}
+
+static bool ffmpeg_audio_space(ffmpeg_t *handle, size_t size)
+{
+   bool space;
+   slock_lock(handle->lock);
+   space = fifo_write_avail(handle->audio_fifo) >= size;
+   slock_unlock(handle->lock);
+   return space;
+}
+
+static bool ffmpeg_audio_ready(ffmpeg_t *handle, size_t size)
+{
+   bool ready;
+
+   if (!handle->config.audio_enable)
+      return false;
+
+   slock_lock(handle->lock);
+   ready = fifo_read_avail(handle->audio_fifo) >= size;
+   slock_unlock(handle->lock);
+   return ready;
+}
+
+static bool ffmpeg_video_ready(ffmpeg_t *handle, size_t unused)
+{
+   return ffmpeg_frames_queued(handle) != 0;
+}
+
+/* Sleeps on @cond until @ready holds or the thread is shut down.
+ * @waiting is raised before @ready is checked again under cond_lock,
+ * and ffmpeg_wake() checks it after publishing, so a wakeup can't
+ * fall in between. */
+static void ffmpeg_wait(ffmpeg_t *handle, scond_t *cond,
+      volatile int *waiting,
+      bool (*ready)(ffmpeg_t*, size_t), size_t arg)
+{
+   slock_lock(handle->cond_lock);
+   retro_atomic_store(waiting, 1);
+   if (retro_atomic_load(&handle->alive) && !ready(handle, arg))
+      scond_wait(cond, handle->cond_lock);
+   retro_atomic_store(waiting, 0);
+   slock_unlock(handle->cond_lock);
+}
+
+static void ffmpeg_wake(ffmpeg_t *handle, scond_t *cond,
+      volatile int *waiting)
+{
+   if (!retro_atomic_load(waiting))
+      return;
+
+   slock_lock(handle->cond_lock);
+   scond_signal(cond);
+   slock_unlock(handle->cond_lock);
+}
+
+/* Waits until the producer owns a free slot at frame_write.
+ * Returns false once recording is shutting down. */
+static bool ffmpeg_wait_frame_space(ffmpeg_t *handle)
+{
+   if (!ffmpeg_frame_space(handle, 0))
+      handle->video_stalls++;
+
+   while (!ffmpeg_frame_space(handle, 0))
+   {
+      if (!retro_atomic_load(&handle->alive))
+         return false;
+
+      ffmpeg_wait(handle, handle->space_cond,
+            &handle->producer_waiting, ffmpeg_frame_space, 0);
+   }
+
+   return retro_atomic_load(&handle->alive);
+}
+
+/* Lends the slot the next frame will be queued in. The frontend
+ * reads the GPU framebuffer back straight into it, and the frame
+ * then gets published by ffmpeg_push_video() without a copy. Only
+ * the producer touches that slot until frame_write is advanced,
+ * so handing it out needs no further bookkeeping. A frame that is
+ * never pushed just leaves the slot to be reused. */
+static void *ffmpeg_get_video_buffer(void *data, size_t size)
+{
+   ffmpeg_t *handle = (ffmpeg_t*)data;
+
+   if (!handle || size > handle->frame_size)
+      return NULL;
+
+   if (!ffmpeg_wait_frame_space(handle))
+      return NULL;
+
+   return handle->frames[handle->frame_write % MAX_FRAMES].buf;
+}
+
+/* Called by the producer. frame_read doubles as the count of
+ * frames the video thread is done with. */
+static void ffmpeg_log_stats(ffmpeg_t *handle)
+{
+   size_t audio_queued = 0;
+   unsigned encoded    = retro_atomic_load(&handle->frame_read);
+
+   if (handle->config.audio_enable)
+   {
+      slock_lock(handle->lock);
+      audio_queued = fifo_read_avail(handle->audio_fifo);
+      slock_unlock(handle->lock);
+   }
+
+   RARCH_LOG("[FFmpeg]: %u frames pushed, %u encoded, %u dropped by frame_drop_ratio.\n",
+         handle->frames_pushed, encoded, handle->frames_dropped);
+   RARCH_LOG("[FFmpeg]: Video queue %u/%u frames (peak %u), %u stalls. "
+         "Audio queue %u bytes (peak %u), %u stalls.\n",
+         ffmpeg_frames_queued(handle), MAX_FRAMES, handle->video_peak,
+         handle->video_stalls, (unsigned)audio_queued,
+         (unsigned)handle->audio_peak, handle->audio_stalls);
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct ffemu_video_data *vid)
 {
-   unsigned y;
    bool drop_frame;
-   struct ffemu_video_data attr_data;
-   ffmpeg_t *handle = (ffmpeg_t*)data;
-   int offset = 0;
+   struct ff_frame *frame = NULL;
+   ffmpeg_t *handle       = (ffmpeg_t*)data;
 
    if (!handle || !vid)
       return false;
@@ -839,54 +1052,66 @@ static bool ffmpeg_push_video(void *data,
    handle->video.frame_drop_count %= handle->video.frame_drop_ratio;
 
    if (drop_frame)
-      return true;
-
-   for (;;)
    {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
-
-      if (avail >= sizeof(*vid))
-         break;
-
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
+      handle->frames_dropped++;
+      performance_trace_counter("record_frames_dropped",
+            handle->frames_dropped);
+      return true;
    }
 
-   slock_lock(handle->lock);
+   if (!ffmpeg_wait_frame_space(handle))
+      return false;
 
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *vid;
+   /* The slot is ours until frame_write is advanced. */
+   frame       = &handle->frames[handle->frame_write % MAX_FRAMES];
+   frame->attr = *vid;
 
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
+   if (frame->attr.is_dupe)
+   {
+      frame->attr.width = frame->attr.height = frame->attr.pitch = 0;
+      frame->attr.data  = NULL;
+   }
+   else if ((const uint8_t*)vid->data >= frame->buf
+         && (const uint8_t*)vid->data < frame->buf + handle->frame_size)
+   {
+      /* Written into the slot lent by ffmpeg_get_video_buffer(),
+       * the encoder scales from it as is, pitch included. */
+   }
    else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+   {
+      unsigned y;
+      const uint8_t *src = (const uint8_t*)vid->data;
+      uint8_t *dst       = frame->buf;
+
+      if (frame->attr.width > handle->params.fb_width)
+         frame->attr.width = handle->params.fb_width;
+      if (frame->attr.height > handle->params.fb_height)
+         frame->attr.height = handle->params.fb_height;
+
+      /* The core may reuse its framebuffer as soon as retro_run()
+       * returns, so this one copy is needed. Tightly pack our frame
+       * to conserve memory, libretro tends to use a very large pitch.
+       * The encoder thread scales straight out of the slot. */
+      frame->attr.pitch = frame->attr.width * handle->video.pix_size;
+      frame->attr.data  = frame->buf;
+
+      if ((size_t)vid->pitch == frame->attr.pitch)
+         memcpy(dst, src, frame->attr.pitch * frame->attr.height);
+      else
+         for (y = 0; y < frame->attr.height; y++,
+               src += vid->pitch, dst += frame->attr.pitch)
+            memcpy(dst, src, frame->attr.pitch);
+   }
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   retro_atomic_store(&handle->frame_write, handle->frame_write + 1);
+   ffmpeg_wake(handle, handle->video_cond, &handle->video_waiting);
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+   handle->frames_pushed++;
+   if (ffmpeg_frames_queued(handle) > handle->video_peak)
+      handle->video_peak = ffmpeg_frames_queued(handle);
 
-   slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+   if (handle->frames_pushed % handle->stats_interval == 0)
+      ffmpeg_log_stats(handle);
 
    return true;
 }
@@ -894,6 +1119,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
+   size_t size, queued;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -902,42 +1128,47 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (!handle->alive)
-         return false;
-
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   if (!ffmpeg_audio_space(handle, size))
+      handle->audio_stalls++;
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   while (!ffmpeg_audio_space(handle, size))
+   {
+      if (!retro_atomic_load(&handle->alive))
+         return false;
 
-      slock_unlock(handle->cond_lock);
+      ffmpeg_wait(handle, handle->space_cond,
+            &handle->producer_waiting, ffmpeg_audio_space, size);
    }
 
+   if (!retro_atomic_load(&handle->alive))
+      return false;
+
    slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   queued = fifo_read_avail(handle->audio_fifo);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+
+   if (queued > handle->audio_peak)
+      handle->audio_peak = queued;
+   performance_trace_counter("record_audio_queued", queued);
+   ffmpeg_wake(handle, handle->audio_cond, &handle->audio_waiting);
 
    return true;
 }
 
+static int ffmpeg_write_packet(ffmpeg_t *handle, AVPacket *pkt)
+{
+   int ret;
+
+   slock_lock(handle->mux_lock);
+   ret = av_interleaved_write_frame(handle->muxer.ctx, pkt);
+   slock_unlock(handle->mux_lock);
+
+   return ret;
+}
+
 static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 {
    int got_packet = 0;
@@ -996,6 +1227,10 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
    }
    else
    {
+      /* The pitch can change from frame to frame, frames read
+       * back from the GPU are bottom-up with a negative pitch. */
+      handle->video.scaler.in_stride = vid->pitch;
+
       video_frame_record_scale(
             &handle->video.scaler,
             handle->video.conv_frame->data[0],
@@ -1025,7 +1260,7 @@ static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
 
    if (pkt.size)
    {
-      if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+      if (ffmpeg_write_packet(handle, &pkt) < 0)
          return false;
    }
 
@@ -1033,6 +1268,17 @@ static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
    return true;
 }
 
+/* Encodes the oldest queued frame and gives its slot back
+ * to the producer. */
+static void ffmpeg_pop_video(ffmpeg_t *handle)
+{
+   struct ff_frame *frame = &handle->frames[handle->frame_read % MAX_FRAMES];
+
+   ffmpeg_push_video_thread(handle, &frame->attr);
+
+   retro_atomic_store(&handle->frame_read, handle->frame_read + 1);
+}
+
 static void planarize_float(float *out, const float *in, size_t frames)
 {
    size_t i;
@@ -1254,7 +1500,7 @@ static bool ffmpeg_push_audio_thread(ffmpeg_t *handle,
 
       if (pkt.size)
       {
-         if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+         if (ffmpeg_write_packet(handle, &pkt) < 0)
             return false;
       }
    }
@@ -1283,7 +1529,7 @@ static void ffmpeg_flush_audio(ffmpeg_t *handle, void *audio_buf,
    {
       AVPacket pkt;
       if (!encode_audio(handle, &pkt, true) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            ffmpeg_write_packet(handle, &pkt) < 0)
          break;
    }
 }
@@ -1294,7 +1540,7 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
    {
       AVPacket pkt;
       if (!encode_video(handle, &pkt, NULL) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            ffmpeg_write_packet(handle, &pkt) < 0)
          break;
    }
 }
@@ -1302,8 +1548,6 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
    bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width *
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ?
       (handle->audio.codec->frame_size *
        handle->params.channels * sizeof(int16_t)) : 0;
@@ -1316,8 +1560,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 
    do
    {
-      struct ffemu_video_data attr_buf;
-
       did_work = false;
 
       if (handle->config.audio_enable)
@@ -1336,14 +1578,9 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
          }
       }
 
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
+      if (ffmpeg_frames_queued(handle))
       {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
-
+         ffmpeg_pop_video(handle);
          did_work = true;
       }
    } while (did_work);
@@ -1355,7 +1592,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -1366,6 +1602,10 @@ static bool ffmpeg_finalize(void *data)
    if (!handle)
       return false;
 
+   /* Queue depth at the time recording stopped,
+    * before whatever is left gets flushed. */
+   ffmpeg_log_stats(handle);
+
    deinit_thread(handle);
 
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
@@ -1376,86 +1616,76 @@ static bool ffmpeg_finalize(void *data)
    /* Write final data. */
    av_write_trailer(handle->muxer.ctx);
 
+   RARCH_LOG("[FFmpeg]: %u frames encoded.\n", handle->frame_read);
+
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+static void ffmpeg_video_thread(void *data)
 {
-   size_t audio_buf_size;
-   void *audio_buf = NULL;
-   ffmpeg_t *ff    = (ffmpeg_t*)data;
-   /* For some reason, FFmpeg has a tendency to crash
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-
-   retro_assert(video_buf);
+   ffmpeg_t *ff = (ffmpeg_t*)data;
 
-   audio_buf_size = ff->config.audio_enable ?
-      (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
-   audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
+   performance_trace_thread_begin("ffmpeg_video");
 
-   while (ff->alive)
+   while (retro_atomic_load(&ff->alive))
    {
-      struct ffemu_video_data attr_buf;
+      unsigned queued = ffmpeg_frames_queued(ff);
 
-      bool avail_video = false;
-      bool avail_audio = false;
+      performance_trace_counter("record_frames_queued", queued);
 
-      slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+      if (!queued)
+      {
+         ffmpeg_wait(ff, ff->video_cond, &ff->video_waiting,
+               ffmpeg_video_ready, 0);
+         continue;
+      }
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+      performance_trace_begin("encode_video");
+      ffmpeg_pop_video(ff);
+      performance_trace_end("encode_video");
+      ffmpeg_wake(ff, ff->space_cond, &ff->producer_waiting);
+   }
 
-      if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+   performance_trace_thread_end();
+}
 
-         slock_unlock(ff->cond_lock);
-      }
+static void ffmpeg_audio_thread(void *data)
+{
+   ffmpeg_t *ff          = (ffmpeg_t*)data;
+   size_t audio_buf_size = ff->audio.codec->frame_size *
+      ff->params.channels * sizeof(int16_t);
+   void *audio_buf       = av_malloc(audio_buf_size);
 
-      if (avail_video && video_buf)
-      {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
-      }
+   retro_assert(audio_buf);
 
-      if (avail_audio && audio_buf)
+   performance_trace_thread_begin("ffmpeg_audio");
+
+   while (retro_atomic_load(&ff->alive))
+   {
+      struct ffemu_audio_data aud = {0};
+
+      if (!ffmpeg_audio_ready(ff, audio_buf_size))
       {
-         struct ffemu_audio_data aud = {0};
+         ffmpeg_wait(ff, ff->audio_cond, &ff->audio_waiting,
+               ffmpeg_audio_ready, audio_buf_size);
+         continue;
+      }
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
+      slock_lock(ff->lock);
+      fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+      slock_unlock(ff->lock);
+      ffmpeg_wake(ff, ff->space_cond, &ff->producer_waiting);
 
-         aud.frames = ff->audio.codec->frame_size;
-         aud.data = audio_buf;
+      aud.frames = ff->audio.codec->frame_size;
+      aud.data = audio_buf;
 
-         ffmpeg_push_audio_thread(ff, &aud, true);
-      }
+      performance_trace_begin("encode_audio");
+      ffmpeg_push_audio_thread(ff, &aud, true);
+      performance_trace_end("encode_audio");
    }
 
-   av_free(video_buf);
+   performance_trace_thread_end();
+
    av_free(audio_buf);
 }
 
@@ -1465,5 +1695,6 @@ const record_driver_t ffemu_ffmpeg = {
    ffmpeg_push_video,
    ffmpeg_push_audio,
    ffmpeg_finalize,
+   ffmpeg_get_video_buffer,
    "ffmpeg",
 };
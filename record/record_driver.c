@@ -31,6 +31,7 @@
 #include "../configuration.h"
 #include "../driver.h"
 #include "../gfx/video_driver.h"
+#include "../performance_counters.h"
 #include "../retroarch.h"
 #include "../verbosity.h"
 #include "../msg_hash.h"
@@ -191,6 +192,7 @@ void recording_dump_frame(const void *data, unsigned width,
 {
    bool has_gpu_record = false;
    uint8_t *gpu_buf    = NULL;
+   uint8_t *record_buf = NULL;
    struct ffemu_video_data
       ffemu_data       = {0};
 
@@ -241,16 +243,26 @@ void recording_dump_frame(const void *data, unsigned width,
       if (!gpu_buf)
          return;
 
+      /* Read back straight into the recording driver's own
+       * buffer when it lends one, so it doesn't have to copy. */
+      if (recording_driver && recording_driver->get_video_buffer)
+         record_buf = (uint8_t*)recording_driver->get_video_buffer(
+               recording_data,
+               recording_gpu_width * recording_gpu_height * 3);
+
+      if (!record_buf)
+         record_buf = gpu_buf;
+
       /* Big bottleneck.
        * Since we might need to do read-backs asynchronously,
        * it might take 3-4 times before this returns true. */
-      if (!video_driver_read_viewport(gpu_buf, is_idle))
+      if (!video_driver_read_viewport(record_buf, is_idle))
          return;
 
       ffemu_data.pitch  = (int)(recording_gpu_width * 3);
       ffemu_data.width  = (unsigned)recording_gpu_width;
       ffemu_data.height = (unsigned)recording_gpu_height;
-      ffemu_data.data   = gpu_buf + (ffemu_data.height - 1) * ffemu_data.pitch;
+      ffemu_data.data   = record_buf + (ffemu_data.height - 1) * ffemu_data.pitch;
 
       ffemu_data.pitch  = -ffemu_data.pitch;
    }
@@ -259,7 +271,11 @@ void recording_dump_frame(const void *data, unsigned width,
       ffemu_data.is_dupe = !data;
 
    if (recording_driver && recording_driver->push_video)
+   {
+      performance_trace_begin("record_push_video");
       recording_driver->push_video(recording_data, &ffemu_data);
+      performance_trace_end("record_push_video");
+   }
 }
 
 bool recording_deinit(void)
@@ -299,7 +315,11 @@ void recording_push_audio(const int16_t *data, size_t samples)
    ffemu_data.frames                  = samples / 2;
 
    if (recording_driver && recording_driver->push_audio)
+   {
+      performance_trace_begin("record_push_audio");
       recording_driver->push_audio(recording_data, &ffemu_data);
+      performance_trace_end("record_push_audio");
+   }
 }
 
 /**
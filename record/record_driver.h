@@ -87,6 +87,10 @@ typedef struct record_driver
    bool  (*push_video)(void *data, const struct ffemu_video_data *video_data);
    bool  (*push_audio)(void *data, const struct ffemu_audio_data *audio_data);
    bool  (*finalize)(void *data);
+   /* Optional. Returns a buffer of at least size bytes the next
+    * push_video may point into, which spares the driver a copy.
+    * NULL if the driver has none to lend. */
+   void *(*get_video_buffer)(void *data, size_t size);
    const char *ident;
 } record_driver_t;
 
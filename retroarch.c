@@ -37,6 +37,7 @@
 #include <boolean.h>
 #include <string/stdstring.h>
 #include <lists/string_list.h>
+#include <lists/dir_list.h>
 #include <retro_timers.h>
 
 #include <compat/strl.h>
@@ -133,6 +134,16 @@
 
 #define SHADER_FILE_WATCH_DELAY_MSEC 500
 
+/* Where absolute monotonic deadlines can be slept to, the frame limiter
+ * waits out the frame itself: it sleeps until shortly before the deadline,
+ * then spins the rest. How long it spins follows how late sleeps have been
+ * waking up, within these bounds (in usec). */
+#if defined(__linux__) && defined(TIMER_ABSTIME)
+#define HAVE_FRAME_LIMIT_DEADLINE
+#define FRAME_LIMIT_SPIN_MIN_USEC 20
+#define FRAME_LIMIT_SPIN_MAX_USEC 2000
+#endif
+
 /* Descriptive names for options without short variant.
  *
  * Please keep the name in sync with the option name.
@@ -251,6 +262,10 @@ static unsigned runloop_max_frames                         = 0;
 static retro_usec_t runloop_frame_time_last                = 0;
 static retro_time_t frame_limit_minimum_time               = 0.0;
 static retro_time_t frame_limit_last_time                  = 0.0;
+#ifdef HAVE_FRAME_LIMIT_DEADLINE
+static retro_time_t frame_limit_oversleep                  = 0;
+static retro_time_t frame_limit_spin_time                  = FRAME_LIMIT_SPIN_MIN_USEC;
+#endif
 
 extern bool input_driver_flushing_input;
 
@@ -1398,6 +1413,27 @@ error:
    return false;
 }
 
+static void runloop_task_trace(retro_task_t *task, bool begin)
+{
+   if (!task)
+   {
+      if (begin)
+         performance_trace_thread_begin("task_worker");
+      else
+         performance_trace_thread_end();
+      return;
+   }
+
+   if (begin)
+   {
+      performance_trace_begin("task");
+   }
+   else
+   {
+      performance_trace_end("task");
+   }
+}
+
 bool rarch_ctl(enum rarch_ctl_state state, void *data)
 {
    switch(state)
@@ -1445,12 +1481,14 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
 
          retroarch_msg_queue_deinit();
          driver_uninit(DRIVERS_CMD_ALL);
+         performance_trace_stop();
          command_event(CMD_EVENT_LOG_FILE_DEINIT, NULL);
 
          rarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
          global_free();
          rarch_ctl(RARCH_CTL_DATA_DEINIT, NULL);
          config_free();
+         msg_hash_deinit();
          break;
       case RARCH_CTL_PREINIT:
          libretro_free_system_info(&runloop_system.info);
@@ -1501,6 +1539,7 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          sthread_tls_create(&rarch_tls);
          sthread_tls_set(&rarch_tls, MAGIC_POINTER);
 #endif
+         performance_probes_init();
          retroarch_init_state();
          {
             uint8_t i;
@@ -1760,6 +1799,10 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
             bool threaded_enable = false;
 #endif
             task_queue_deinit();
+            task_image_decode_deinit();
+            dir_list_cache_deinit();
+            dir_list_cache_init();
+            task_queue_set_trace(runloop_task_trace);
             task_queue_init(threaded_enable, runloop_msg_queue_push);
          }
          break;
@@ -1773,6 +1816,8 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          return runloop_shutdown_initiated;
       case RARCH_CTL_DATA_DEINIT:
          task_queue_deinit();
+         task_image_decode_deinit();
+         dir_list_cache_deinit();
          break;
       case RARCH_CTL_IS_CORE_OPTION_UPDATED:
          if (!runloop_core_options)
@@ -3092,18 +3137,99 @@ void runloop_unset(enum runloop_action action)
    }
 }
 
+#ifdef HAVE_FRAME_LIMIT_DEADLINE
 /**
- * runloop_iterate:
+ * runloop_frame_limit_wait:
+ * @deadline           : Time to wait until, as returned by
+ *                       cpu_features_get_time_usec().
  *
- * Run Libretro core in RetroArch for one frame.
+ * Sleeps until shortly before @deadline on the same monotonic clock, then
+ * spins up to it. The spin is calibrated from how late sleeping wakes up.
+ **/
+static void runloop_frame_limit_wait(retro_time_t deadline)
+{
+   retro_time_t wake = deadline - frame_limit_spin_time;
+   retro_time_t now  = cpu_features_get_time_usec();
+
+   if (wake > now)
+   {
+      struct timespec ts;
+      retro_time_t late;
+
+      ts.tv_sec  = (time_t)(wake / 1000000);
+      ts.tv_nsec = (long)(wake % 1000000) * 1000;
+
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+            == EINTR);
+
+      now  = cpu_features_get_time_usec();
+      late = now - wake;
+
+      /* Spin for about twice the usual oversleep, so the occasional
+       * slower wakeup still lands before the deadline */
+      frame_limit_oversleep = (frame_limit_oversleep * 7 + late) / 8;
+      frame_limit_spin_time = 2 * frame_limit_oversleep;
+      if (frame_limit_spin_time < FRAME_LIMIT_SPIN_MIN_USEC)
+         frame_limit_spin_time = FRAME_LIMIT_SPIN_MIN_USEC;
+      else if (frame_limit_spin_time > FRAME_LIMIT_SPIN_MAX_USEC)
+         frame_limit_spin_time = FRAME_LIMIT_SPIN_MAX_USEC;
+   }
+
+   while (now < deadline)
+      now = cpu_features_get_time_usec();
+}
+#endif
+
+/**
+ * runloop_frame_limit:
+ * @sleep_ms           : How long the caller should sleep, in milliseconds.
  *
- * Returns: 0 on success, 1 if we have to wait until
- * button input in order to wake up the loop,
- * -1 if we forcibly quit out of the RetroArch iteration loop.
+ * Holds frames back to frame_limit_minimum_time apart. Deadlines follow
+ * each other from frame_limit_last_time so that rounding doesn't build up,
+ * unless a frame fell more than a quarter of a frame behind, in which case the
+ * schedule starts over from now instead of rushing to catch up.
+ *
+ * Returns: 1 if the caller has to sleep for @sleep_ms, otherwise 0.
  **/
-int runloop_iterate(unsigned *sleep_ms)
+static int runloop_frame_limit(unsigned *sleep_ms)
 {
-   unsigned i;
+   retro_time_t now      = cpu_features_get_time_usec();
+   retro_time_t deadline = frame_limit_last_time + frame_limit_minimum_time;
+
+#ifdef HAVE_FRAME_LIMIT_DEADLINE
+   if (now < deadline)
+   {
+      performance_trace_begin("frame_limit");
+      runloop_frame_limit_wait(deadline);
+      performance_trace_end("frame_limit");
+   }
+
+   if (now - deadline > frame_limit_minimum_time / 4)
+      frame_limit_last_time  = cpu_features_get_time_usec();
+   else
+      frame_limit_last_time  = deadline;
+
+   return 0;
+#else
+   retro_time_t to_sleep_ms = (deadline - now) / 1000;
+
+   if (to_sleep_ms > 0)
+   {
+      *sleep_ms = (unsigned)to_sleep_ms;
+      /* Combat jitter a bit. */
+      frame_limit_last_time += frame_limit_minimum_time;
+      return 1;
+   }
+
+   frame_limit_last_time  = now;
+   return 0;
+#endif
+}
+
+static int runloop_iterate_internal(unsigned *sleep_ms)
+{
+   unsigned i, frame_delay;
+   retro_time_t run_start, run_time;
    bool input_nonblock_state                    = input_driver_is_nonblock_state();
    settings_t *settings                         = config_get_ptr();
    unsigned max_users                           = *(input_driver_get_uint(INPUT_ACTION_MAX_USERS));
@@ -3184,10 +3310,26 @@ int runloop_iterate(unsigned *sleep_ms)
       input_push_analog_dpad(auto_binds,    dpad_mode);
    }
 
-   if ((settings->uints.video_frame_delay > 0) && !input_nonblock_state)
-      retro_sleep(settings->uints.video_frame_delay);
+   frame_delay = video_driver_frame_delay();
+   if ((frame_delay > 0) && !input_nonblock_state)
+   {
+      performance_trace_begin("frame_delay");
+      retro_sleep(frame_delay);
+      performance_trace_end("frame_delay");
+   }
 
+   performance_trace_begin("core_run");
+   run_start = cpu_features_get_time_usec();
    core_run();
+   run_time  = cpu_features_get_time_usec() - run_start;
+   performance_trace_end("core_run");
+
+   if (runloop_perfcnt_enable)
+      performance_probe_record(PERF_PROBE_CORE_RUN, run_start, run_time);
+
+   /* Fast-forward and slow motion don't run at the refresh rate */
+   if (!input_nonblock_state && !runloop_slowmotion)
+      video_driver_frame_delay_update(run_time);
 
 #ifdef HAVE_CHEEVOS
    if (runloop_check_cheevos())
@@ -3214,23 +3356,32 @@ int runloop_iterate(unsigned *sleep_ms)
 
    if (settings->floats.fastforward_ratio)
       end:
-   {
-      retro_time_t to_sleep_ms  = (
-            (frame_limit_last_time + frame_limit_minimum_time)
-            - cpu_features_get_time_usec()) / 1000;
+      return runloop_frame_limit(sleep_ms);
 
-      if (to_sleep_ms > 0)
-      {
-         *sleep_ms = (unsigned)to_sleep_ms;
-         /* Combat jitter a bit. */
-         frame_limit_last_time += frame_limit_minimum_time;
-         return 1;
-      }
+   return 0;
+}
 
-      frame_limit_last_time  = cpu_features_get_time_usec();
-   }
+/**
+ * runloop_iterate:
+ *
+ * Run Libretro core in RetroArch for one frame.
+ *
+ * Returns: 0 on success, 1 if we have to wait until
+ * button input in order to wake up the loop,
+ * -1 if we forcibly quit out of the RetroArch iteration loop.
+ **/
+int runloop_iterate(unsigned *sleep_ms)
+{
+   int ret;
 
-   return 0;
+   if (performance_trace_enabled)
+      performance_trace_flush();
+
+   performance_trace_begin("runloop_iterate");
+   ret = runloop_iterate_internal(sleep_ms);
+   performance_trace_end("runloop_iterate");
+
+   return ret;
 }
 
 rarch_system_info_t *runloop_get_system_info(void)
@@ -23,6 +23,10 @@
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <retro_miscellaneous.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
 
 #include "../gfx/video_driver.h"
 #include "../file_path_special.h"
@@ -35,9 +39,20 @@ enum image_status_enum
    IMAGE_STATUS_TRANSFER = 0,
    IMAGE_STATUS_TRANSFER_PARSE,
    IMAGE_STATUS_PROCESS_TRANSFER,
-   IMAGE_STATUS_PROCESS_TRANSFER_PARSE
+   IMAGE_STATUS_PROCESS_TRANSFER_PARSE,
+   IMAGE_STATUS_DECODE_THREADED
 };
 
+#ifdef HAVE_THREADS
+enum image_decode_state
+{
+   IMAGE_DECODE_NONE = 0,
+   IMAGE_DECODE_PENDING,
+   IMAGE_DECODE_RUNNING,
+   IMAGE_DECODE_DONE
+};
+#endif
+
 struct nbio_image_handle
 {
    enum image_type_enum type;
@@ -52,11 +67,50 @@ struct nbio_image_handle
    void *handle;
    transfer_cb_t  cb;
    struct texture_image ti;
+#ifdef HAVE_THREADS
+   enum image_decode_state decode_state;
+   struct nbio_image_handle *decode_next;
+#endif
 };
 
-static int cb_image_menu_upload_generic(void *data, size_t len)
+#ifdef HAVE_THREADS
+/* How long a decode thread waits for more work before exiting */
+#define IMAGE_DECODE_IDLE_USEC 5000000
+/* How long the task handler waits on a decode before letting the
+ * task queue get on with other tasks */
+#define IMAGE_DECODE_WAIT_USEC 2000
+
+/* Images are decoded on a pool of up to one thread per core, fed
+ * from a queue. Everything in here, and the decode_* members of
+ * queued images, is protected by the lock. */
+struct image_decode_pool
+{
+   slock_t *lock;
+   scond_t *work_cond;
+   scond_t *done_cond;
+   struct nbio_image_handle *queue;
+   unsigned threads;
+   unsigned idle;
+   bool quit;
+};
+
+/* Set up by the first decode, from the task handler */
+static struct image_decode_pool image_decode_pool;
+#endif
+
+static void task_image_color_convert(struct nbio_image_handle *image)
 {
    unsigned r_shift, g_shift, b_shift, a_shift;
+
+   image_texture_set_color_shifts(&r_shift, &g_shift, &b_shift,
+         &a_shift, &image->ti);
+
+   image_texture_color_convert(r_shift, g_shift, b_shift,
+         a_shift, &image->ti);
+}
+
+static int cb_image_menu_upload_generic(void *data, size_t len)
+{
    nbio_handle_t             *nbio = (nbio_handle_t*)data;
    struct nbio_image_handle *image = (struct nbio_image_handle*)nbio->data;
 
@@ -72,11 +126,7 @@ static int cb_image_menu_upload_generic(void *data, size_t len)
          break;
    }
 
-   image_texture_set_color_shifts(&r_shift, &g_shift, &b_shift,
-         &a_shift, &image->ti);
-
-   image_texture_color_convert(r_shift, g_shift, b_shift,
-         a_shift, &image->ti);
+   task_image_color_convert(image);
 
    image->is_blocking_on_processing         = false;
    image->is_blocking                       = true;
@@ -147,12 +197,207 @@ static int task_image_iterate_process_transfer(struct nbio_image_handle *image)
    return -1;
 }
 
+#ifdef HAVE_THREADS
+/* Runs the whole transfer/process state machine of an image
+ * in one go, so that several images can be decoded at once
+ * instead of being interleaved on the task worker. */
+static void task_image_decode(struct nbio_image_handle *image)
+{
+   unsigned width                  = 0;
+   unsigned height                 = 0;
+   int retval                      = IMAGE_PROCESS_NEXT;
+
+   while (image_transfer_iterate(image->handle, image->type));
+
+   while (retval == IMAGE_PROCESS_NEXT)
+      retval = task_image_process(image, &width, &height);
+
+   if (retval == IMAGE_PROCESS_END)
+      task_image_color_convert(image);
+
+   image->processing_final_state = retval;
+}
+
+static void task_image_decode_worker(void *data)
+{
+   struct image_decode_pool *pool = &image_decode_pool;
+
+   slock_lock(pool->lock);
+
+   for (;;)
+   {
+      struct nbio_image_handle *image = pool->queue;
+
+      if (!image)
+      {
+         bool woken;
+
+         if (pool->quit)
+            break;
+
+         pool->idle++;
+         woken = scond_wait_timeout(pool->work_cond, pool->lock,
+               IMAGE_DECODE_IDLE_USEC);
+         pool->idle--;
+
+         if (!woken && !pool->queue)
+            break;
+         continue;
+      }
+
+      pool->queue         = image->decode_next;
+      image->decode_next  = NULL;
+      image->decode_state = IMAGE_DECODE_RUNNING;
+      slock_unlock(pool->lock);
+
+      task_image_decode(image);
+
+      slock_lock(pool->lock);
+      image->decode_state = IMAGE_DECODE_DONE;
+      scond_broadcast(pool->done_cond);
+   }
+
+   pool->threads--;
+   scond_broadcast(pool->done_cond);
+   slock_unlock(pool->lock);
+}
+
+static bool task_image_decode_queue(struct nbio_image_handle *image)
+{
+   struct nbio_image_handle **tail = NULL;
+   struct image_decode_pool *pool  = &image_decode_pool;
+   unsigned max_threads            = cpu_features_get_core_amount();
+
+   if (!pool->lock)
+   {
+      pool->lock      = slock_new();
+      pool->work_cond = scond_new();
+      pool->done_cond = scond_new();
+
+      if (!pool->lock || !pool->work_cond || !pool->done_cond)
+      {
+         if (pool->lock)
+            slock_free(pool->lock);
+         if (pool->work_cond)
+            scond_free(pool->work_cond);
+         if (pool->done_cond)
+            scond_free(pool->done_cond);
+         memset(pool, 0, sizeof(*pool));
+         return false;
+      }
+   }
+
+   slock_lock(pool->lock);
+
+   if (!pool->idle && pool->threads < (max_threads ? max_threads : 1))
+   {
+      sthread_t *thread = sthread_create(task_image_decode_worker, NULL);
+
+      if (thread)
+      {
+         sthread_detach(thread);
+         pool->threads++;
+      }
+   }
+
+   if (!pool->threads)
+   {
+      slock_unlock(pool->lock);
+      return false;
+   }
+
+   for (tail = &pool->queue; *tail; tail = &(*tail)->decode_next);
+
+   *tail               = image;
+   image->decode_next  = NULL;
+   image->decode_state = IMAGE_DECODE_PENDING;
+   scond_signal(pool->work_cond);
+
+   slock_unlock(pool->lock);
+   return true;
+}
+
+/* Returns true once the image is decoded, waiting at most
+ * timeout_us for it. */
+static bool task_image_decode_wait(struct nbio_image_handle *image,
+      int64_t timeout_us)
+{
+   bool done;
+   struct image_decode_pool *pool = &image_decode_pool;
+
+   slock_lock(pool->lock);
+   if (image->decode_state != IMAGE_DECODE_DONE)
+      scond_wait_timeout(pool->done_cond, pool->lock, timeout_us);
+   done = image->decode_state == IMAGE_DECODE_DONE;
+   slock_unlock(pool->lock);
+
+   return done;
+}
+
+/* Takes the image out of the pool, before its handle is freed:
+ * a queued decode is dropped, a running one waited for. */
+static void task_image_decode_cancel(struct nbio_image_handle *image)
+{
+   struct image_decode_pool *pool = &image_decode_pool;
+
+   if (image->decode_state == IMAGE_DECODE_NONE)
+      return;
+
+   slock_lock(pool->lock);
+
+   if (image->decode_state == IMAGE_DECODE_PENDING)
+   {
+      struct nbio_image_handle **it = &pool->queue;
+
+      while (*it && *it != image)
+         it = &(*it)->decode_next;
+      if (*it)
+         *it = image->decode_next;
+   }
+
+   while (image->decode_state == IMAGE_DECODE_RUNNING)
+      scond_wait(pool->done_cond, pool->lock);
+
+   image->decode_state = IMAGE_DECODE_NONE;
+   image->decode_next  = NULL;
+
+   slock_unlock(pool->lock);
+}
+#endif
+
+/* Called once the task queue is gone, so nothing is queued
+ * anymore: stops the idle decode threads and frees the pool. */
+void task_image_decode_deinit(void)
+{
+#ifdef HAVE_THREADS
+   struct image_decode_pool *pool = &image_decode_pool;
+
+   if (!pool->lock)
+      return;
+
+   slock_lock(pool->lock);
+   pool->quit = true;
+   scond_broadcast(pool->work_cond);
+   while (pool->threads)
+      scond_wait(pool->done_cond, pool->lock);
+   slock_unlock(pool->lock);
+
+   slock_free(pool->lock);
+   scond_free(pool->work_cond);
+   scond_free(pool->done_cond);
+   memset(pool, 0, sizeof(*pool));
+#endif
+}
+
 static void task_image_cleanup(nbio_handle_t *nbio)
 {
    struct nbio_image_handle *image = (struct nbio_image_handle*)nbio->data;
 
    if (image)
    {
+#ifdef HAVE_THREADS
+      task_image_decode_cancel(image);
+#endif
       image_transfer_free(image->handle, image->type);
 
       image->handle                 = NULL;
@@ -225,8 +470,33 @@ bool task_image_load_handler(retro_task_t *task)
 
    if (image)
    {
+#ifdef HAVE_THREADS
+      /* Don't let the cleanup free the handle under a running decode. */
+      if (task_get_cancelled(task))
+         task_image_decode_cancel(image);
+#endif
+
       switch (image->status)
       {
+#ifdef HAVE_THREADS
+         case IMAGE_STATUS_DECODE_THREADED:
+            /* Sleeps rather than spins, but only briefly, so other
+             * tasks still get their turn. */
+            if (!task_image_decode_wait(image, IMAGE_DECODE_WAIT_USEC))
+               break;
+
+            image->decode_state = IMAGE_DECODE_NONE;
+
+            if (image->processing_final_state == IMAGE_PROCESS_END)
+            {
+               image->is_blocking_on_processing = false;
+               image->is_blocking               = true;
+               image->is_finished               = true;
+            }
+            else
+               task_set_cancelled(task, true);
+            break;
+#endif
          case IMAGE_STATUS_PROCESS_TRANSFER:
             if (image && task_image_iterate_process_transfer(image) == -1)
                image->status = IMAGE_STATUS_PROCESS_TRANSFER_PARSE;
@@ -241,6 +511,16 @@ bool task_image_load_handler(retro_task_t *task)
                image->status = IMAGE_STATUS_PROCESS_TRANSFER;
             break;
          case IMAGE_STATUS_TRANSFER:
+#ifdef HAVE_THREADS
+            if (     image->handle
+                  && !image->is_blocking
+                  && !image->is_finished
+                  && task_image_decode_queue(image))
+            {
+               image->status = IMAGE_STATUS_DECODE_THREADED;
+               break;
+            }
+#endif
             if (!image->is_blocking && !image->is_finished)
             {
                for (i = 0; i < image->pos_increment; i++)
@@ -333,6 +613,10 @@ bool task_push_image_load(const char *fullpath, retro_task_callback_t cb, void *
    image->ti.height                  = 0;
    image->ti.pixels                  = NULL;
    image->ti.supports_rgba           = false;
+#ifdef HAVE_THREADS
+   image->decode_state               = IMAGE_DECODE_NONE;
+   image->decode_next                = NULL;
+#endif
 
    if (strstr(fullpath, file_path_str(FILE_PATH_PNG_EXTENSION)))
    {
@@ -49,6 +49,7 @@
 #include "../configuration.h"
 #include "../gfx/video_driver.h"
 #include "../msg_hash.h"
+#include "../performance_counters.h"
 #include "../retroarch.h"
 #include "../verbosity.h"
 #include "tasks_internal.h"
@@ -144,6 +145,8 @@ static void autosave_thread(void *data)
    bool first_log   = true;
    autosave_t *save = (autosave_t*)data;
 
+   performance_trace_thread_begin("autosave");
+
    while (!save->quit)
    {
       bool differ;
@@ -158,7 +161,10 @@ static void autosave_thread(void *data)
       if (differ)
       {
          /* Should probably deal with this more elegantly. */
-         intfstream_t *file = intfstream_open_file(save->path,
+         intfstream_t *file = NULL;
+
+         performance_trace_begin("autosave_write");
+         file = intfstream_open_file(save->path,
                RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
          if (file)
@@ -182,6 +188,8 @@ static void autosave_thread(void *data)
             if (failed)
                RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
          }
+
+         performance_trace_end("autosave_write");
       }
 
       slock_lock(save->cond_lock);
@@ -195,6 +203,8 @@ static void autosave_thread(void *data)
 
       slock_unlock(save->cond_lock);
    }
+
+   performance_trace_thread_end();
 }
 
 /**
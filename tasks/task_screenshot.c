@@ -39,6 +39,9 @@
 #ifdef HAVE_RPNG
 #include <formats/rpng.h>
 #define IMG_EXT "png"
+/* Screenshots are taken on the fly, level 9 takes several times as
+ * long for a few percent smaller files. */
+#define SCREENSHOT_PNG_COMPRESSION_LEVEL 6
 #else
 #define IMG_EXT "bmp"
 #endif
@@ -123,12 +126,13 @@ static void task_screenshot_handler(retro_task_t *task)
 
    scaler_ctx_gen_reset(&state->scaler);
 
-   ret = rpng_save_image_bgr24(
+   ret = rpng_save_image_bgr24_level(
          state->filename,
          state->out_buffer,
          state->width,
          state->height,
-         state->width * 3
+         state->width * 3,
+         SCREENSHOT_PNG_COMPRESSION_LEVEL
          );
 
    free(state->out_buffer);
@@ -0,0 +1,16 @@
+# Read after the top-level Makefile, see Makefile in this directory.
+
+BENCH_DIR := tools/benchmarks
+
+# The object of the source each benchmark includes
+BENCH_SOURCE_OBJ_core_info := core_info.o
+BENCH_SOURCE_OBJ_playlist := playlist.o
+BENCH_SOURCE_OBJ_msg_hash := msg_hash.o
+BENCH_SOURCE_OBJ_frame_limit := retroarch.o
+BENCH_SOURCE_OBJ_cheevos := cheevos/cheevos.o
+
+$(BENCH_DIR)/%_bench: $(BENCH_DIR)/%_bench.c $(RARCH_OBJ)
+	$(Q)$(CC) $(CPPFLAGS) $(CFLAGS) $(DEFINES) -c -o $@.o $<
+	$(Q)$(LINK) -o $@ $@.o $(filter-out $(OBJDIR)/frontend/frontend.o \
+		$(OBJDIR)/$(BENCH_SOURCE_OBJ_$*),$(RARCH_OBJ)) \
+		$(LIBS) $(LDFLAGS) $(LIBRARY_DIRS)
@@ -0,0 +1,314 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../cheevos/cheevos.c"
+
+/* Interpreted against compiled conditions, over a memory trace recorded
+ * from a deterministic run where each frame rewrites a few hundred bytes
+ * of RAM, the way a game updating its state would. The generated set
+ * reads a hot region of RAM with every size and condition type, so reads
+ * repeat across cheevos like in real sets. To bench a real set instead,
+ * pass a file with one memaddr per line and a RAM snapshot to start from.
+ * Addresses go straight to the bench RAM, through a single memory map. */
+
+#define BENCH_RAM     0x10000
+#define BENCH_HOT     0x2000
+#define BENCH_CHEEVOS 1000
+#define BENCH_FRAMES  3600
+#define BENCH_WRITES  256
+
+typedef struct
+{
+   uint16_t offset;
+   uint8_t  value;
+} bench_write_t;
+
+static uint8_t bench_ram[BENCH_RAM];
+static uint8_t bench_snapshot[BENCH_RAM];
+static bench_write_t bench_trace[BENCH_FRAMES][BENCH_WRITES];
+static uint32_t bench_seed = 1;
+
+static unsigned bench_rand(unsigned n)
+{
+   bench_seed = bench_seed * 1664525 + 1013904223;
+   return (bench_seed >> 8) % n;
+}
+
+static char *bench_make_memaddr(void)
+{
+   static const char *sizes = "MNOPQRSTLUH X";
+   static const char *ops[] = {"=", "!=", "<", "<=", ">", ">="};
+   char memaddr[1024];
+   size_t len    = 0;
+   unsigned sets = 1 + (bench_rand(4) == 0) * (1 + bench_rand(3));
+   unsigned i, j;
+
+   for (i = 0; i < sets; i++)
+   {
+      unsigned conds = 2 + bench_rand(5);
+
+      if (i)
+         memaddr[len++] = 'S';
+
+      for (j = 0; j < conds; j++)
+      {
+         static const char *types[] = {"", "", "", "", "", "R:", "P:", "A:", "C:"};
+         char size     = sizes[bench_rand(13)];
+         unsigned addr = bench_rand(BENCH_HOT);
+
+         if (j)
+            memaddr[len++] = '_';
+
+         len += snprintf(memaddr + len, sizeof(memaddr) - len, "%s0x%c%04x",
+               types[bench_rand(9)], size, addr);
+
+         if (bench_rand(3) == 0)
+            len += snprintf(memaddr + len, sizeof(memaddr) - len, "%sd0x%c%04x",
+                  ops[bench_rand(6)], size, addr);
+         else
+            len += snprintf(memaddr + len, sizeof(memaddr) - len, "%s%u",
+                  ops[bench_rand(6)], bench_rand(4));
+
+         if (bench_rand(4) == 0)
+            len += snprintf(memaddr + len, sizeof(memaddr) - len, ".%u.",
+                  1 + bench_rand(20));
+      }
+   }
+
+   memaddr[len] = 0;
+   return strdup(memaddr);
+}
+
+static unsigned bench_read_memaddrs(const char *path, char **memaddrs)
+{
+   char line[4096];
+   unsigned count = 0;
+   FILE *file     = fopen(path, "r");
+
+   if (!file)
+      return 0;
+
+   while (count < BENCH_CHEEVOS && fgets(line, sizeof(line), file))
+   {
+      line[strcspn(line, "\r\n")] = 0;
+      if (*line)
+         memaddrs[count++] = strdup(line);
+   }
+
+   fclose(file);
+   return count;
+}
+
+static void bench_record_trace(void)
+{
+   unsigned i, j;
+
+   for (i = 0; i < BENCH_FRAMES; i++)
+   {
+      for (j = 0; j < BENCH_WRITES; j++)
+      {
+         bench_trace[i][j].offset = bench_rand(BENCH_HOT + 4);
+         bench_trace[i][j].value  = bench_rand(8) ? bench_rand(4)
+            : bench_rand(256);
+      }
+   }
+}
+
+static void bench_load_set(cheevoset_t *set, char **memaddrs, unsigned count)
+{
+   unsigned i, j, k;
+
+   set->cheevos = (cheevo_t*)calloc(count, sizeof(*set->cheevos));
+   set->count   = count;
+   set->program = NULL;
+
+   for (i = 0; i < count; i++)
+   {
+      cheevos_condition_t *condition = &set->cheevos[i].condition;
+
+      cheevos_parse_condition(condition, memaddrs[i]);
+      set->cheevos[i].active = CHEEVOS_ACTIVE_SOFTCORE;
+
+      for (j = 0; j < condition->count; j++)
+      {
+         for (k = 0; k < condition->condsets[j].count; k++)
+         {
+            cheevos_cond_t *cond = &condition->condsets[j].conds[k];
+
+            cond->source.bank_id = 0;
+            cond->target.bank_id = 0;
+
+            if (cond->source.type != CHEEVOS_VAR_TYPE_VALUE_COMP)
+               cond->source.value %= BENCH_RAM - 4;
+            if (cond->target.type != CHEEVOS_VAR_TYPE_VALUE_COMP)
+               cond->target.value %= BENCH_RAM - 4;
+         }
+      }
+   }
+}
+
+/* Replays the trace, resetting a cheevo's conditions when it triggers so
+ * they keep counting hits. Returns the time spent testing. */
+static retro_time_t bench_replay(cheevoset_t *set, uint8_t *results)
+{
+   unsigned i, j;
+   retro_time_t total = 0;
+
+   memcpy(bench_ram, bench_snapshot, sizeof(bench_ram));
+
+   for (i = 0; i < BENCH_FRAMES; i++)
+   {
+      retro_time_t t0;
+
+      for (j = 0; j < BENCH_WRITES; j++)
+         bench_ram[bench_trace[i][j].offset] = bench_trace[i][j].value;
+
+      t0 = cpu_features_get_time_usec();
+
+      if (set->program)
+         cheevos_program_load(set->program);
+
+      for (j = 0; j < set->count; j++)
+      {
+         cheevo_t *cheevo = &set->cheevos[j];
+         int valid;
+
+         if (set->program)
+         {
+            int dirty_conds = 0;
+            int reset_conds = 0;
+
+            valid = cheevos_program_test(set->program, j,
+                  &dirty_conds, &reset_conds);
+            cheevos_update_cheevo(cheevo, dirty_conds, reset_conds);
+         }
+         else
+            valid = cheevos_test_cheevo(cheevo);
+
+         if (valid)
+         {
+            unsigned k;
+            for (k = 0; k < cheevo->condition.count; k++)
+               cheevos_reset_cond_set(&cheevo->condition.condsets[k], 0);
+         }
+
+         results[i * set->count + j] = valid;
+      }
+
+      total += cpu_features_get_time_usec() - t0;
+   }
+
+   return total;
+}
+
+static bool bench_same_state(const cheevoset_t *a, const cheevoset_t *b)
+{
+   unsigned i, j, k;
+
+   for (i = 0; i < a->count; i++)
+   {
+      const cheevos_condition_t *ca = &a->cheevos[i].condition;
+      const cheevos_condition_t *cb = &b->cheevos[i].condition;
+
+      if (a->cheevos[i].dirty != b->cheevos[i].dirty)
+         return false;
+
+      for (j = 0; j < ca->count; j++)
+      {
+         for (k = 0; k < ca->condsets[j].count; k++)
+         {
+            const cheevos_cond_t *x = &ca->condsets[j].conds[k];
+            const cheevos_cond_t *y = &cb->condsets[j].conds[k];
+
+            if (  x->curr_hits       != y->curr_hits
+               || x->source.previous != y->source.previous
+               || x->target.previous != y->target.previous)
+               return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   static rarch_memory_descriptor_t desc;
+   static char *memaddrs[BENCH_CHEEVOS];
+   unsigned i, count = 0, triggered = 0;
+   cheevoset_t interpreted, compiled;
+   retro_time_t t_interpreted, t_compiled;
+   uint8_t *results_interpreted, *results_compiled;
+   rarch_system_info_t *system = runloop_get_system_info();
+
+   desc.core.ptr                 = bench_ram;
+   desc.core.len                 = BENCH_RAM;
+   system->mmaps.descriptors     = &desc;
+   system->mmaps.num_descriptors = 1;
+
+   if (argc > 1)
+      count = bench_read_memaddrs(argv[1], memaddrs);
+   else
+      for (; count < BENCH_CHEEVOS; count++)
+         memaddrs[count] = bench_make_memaddr();
+
+   if (argc > 2)
+   {
+      FILE *file = fopen(argv[2], "rb");
+      if (file)
+      {
+         fread(bench_snapshot, 1, sizeof(bench_snapshot), file);
+         fclose(file);
+      }
+   }
+
+   bench_record_trace();
+   bench_load_set(&interpreted, memaddrs, count);
+   bench_load_set(&compiled, memaddrs, count);
+   cheevos_compile_cheevo_set(&compiled);
+
+   if (!compiled.program)
+   {
+      printf("could not compile the set\n");
+      return 1;
+   }
+
+   results_interpreted = (uint8_t*)malloc(BENCH_FRAMES * count);
+   results_compiled    = (uint8_t*)malloc(BENCH_FRAMES * count);
+
+   t_interpreted = bench_replay(&interpreted, results_interpreted);
+   t_compiled    = bench_replay(&compiled, results_compiled);
+
+   for (i = 0; i < BENCH_FRAMES * count; i++)
+      triggered += results_interpreted[i];
+
+   printf("%u cheevos, %u frames, %u triggers\n",
+         count, BENCH_FRAMES, triggered);
+   printf("interpreted: %6.2f us/frame\n",
+         (double)t_interpreted / BENCH_FRAMES);
+   printf("compiled:    %6.2f us/frame (%.1fx)\n",
+         (double)t_compiled / BENCH_FRAMES,
+         (double)t_interpreted / (t_compiled ? t_compiled : 1));
+
+   if (memcmp(results_interpreted, results_compiled, BENCH_FRAMES * count)
+         || !bench_same_state(&interpreted, &compiled))
+   {
+      printf("MISMATCH between interpreted and compiled results\n");
+      return 1;
+   }
+
+   printf("results and hits match\n");
+   return 0;
+}
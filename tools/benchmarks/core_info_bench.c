@@ -0,0 +1,176 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+#include <retro_assert.h>
+
+#include "../../core_info.c"
+
+/* Matches a 20k file scan against a synthetic core set sized like
+ * the full buildbot one, with and without the lookup index. */
+
+#define BENCH_CORES      400
+#define BENCH_FILES      20000
+#define BENCH_EXTENSIONS 300
+#define BENCH_DATABASES  150
+
+static bool bench_naive_database_supports(const char *database,
+      const char *path)
+{
+   size_t i;
+
+   for (i = 0; i < core_info_curr_list->count; i++)
+   {
+      const core_info_t *info = &core_info_curr_list->list[i];
+
+      if (!string_list_find_elem(info->supported_extensions_list,
+               path_get_extension(path)))
+         continue;
+
+      if (!string_list_find_elem(info->databases_list, database))
+         continue;
+
+      return true;
+   }
+
+   return false;
+}
+
+static size_t bench_naive_supported_cores(const char *path)
+{
+   size_t i;
+   size_t supported = 0;
+
+   for (i = 0; i < core_info_curr_list->count; i++)
+      if (string_list_find_elem_prefix(
+               core_info_curr_list->list[i].supported_extensions_list,
+               ".", path_get_extension(path)))
+         supported++;
+
+   return supported;
+}
+
+static core_info_list_t *bench_core_info_list(void)
+{
+   size_t i, j;
+   core_info_list_t *list = (core_info_list_t*)calloc(1, sizeof(*list));
+
+   list->list  = (core_info_t*)calloc(BENCH_CORES, sizeof(*list->list));
+   list->count = BENCH_CORES;
+
+   for (i = 0; i < BENCH_CORES; i++)
+   {
+      char buf[1024];
+      core_info_t *info = &list->list[i];
+
+      buf[0] = '\0';
+      for (j = 0; j < 3 + (size_t)rand() % 10; j++)
+      {
+         char ext[32];
+         snprintf(ext, sizeof(ext), "ext%d|", rand() % BENCH_EXTENSIONS);
+         strlcat(buf, ext, sizeof(buf));
+      }
+      strlcat(buf, "zip|7z", sizeof(buf));
+
+      info->id                        = (unsigned)i;
+      info->supported_extensions      = strdup(buf);
+      info->supported_extensions_list = string_split(buf, "|");
+
+      snprintf(buf, sizeof(buf), "Maker - System %d|Maker - System %d",
+            rand() % BENCH_DATABASES, rand() % BENCH_DATABASES);
+      info->databases                 = strdup(buf);
+      info->databases_list            = string_split(buf, "|");
+
+      snprintf(buf, sizeof(buf), "core%u_libretro.so", (unsigned)i);
+      info->path                      = strdup(buf);
+      info->display_name              = strdup(buf);
+   }
+
+   list->index = core_info_index_new(list);
+   return list;
+}
+
+static void bench_core_info_index(void)
+{
+   size_t i;
+   clock_t start;
+   const core_info_t *infos = NULL;
+   size_t num_infos         = 0;
+   size_t matches[2]        = {0};
+   char (*files)[32]        = malloc(BENCH_FILES * sizeof(*files));
+   char (*databases)[32]    = malloc(BENCH_FILES * sizeof(*databases));
+
+   srand(1234);
+
+   core_info_curr_list = bench_core_info_list();
+
+   for (i = 0; i < BENCH_FILES; i++)
+   {
+      /* Some of the files have an extension no core knows. */
+      snprintf(files[i], sizeof(files[i]), "game%u.ext%d",
+            (unsigned)i, rand() % (BENCH_EXTENSIONS + 50));
+      snprintf(databases[i], sizeof(databases[i]),
+            "Maker - System %d.rdb", rand() % BENCH_DATABASES);
+   }
+
+   start = clock();
+   for (i = 0; i < BENCH_FILES; i++)
+   {
+      char database[32];
+      strlcpy(database, databases[i], sizeof(database));
+      path_remove_extension(database);
+      matches[0] += bench_naive_database_supports(database, files[i]);
+   }
+   printf("database, linear scan: %7.2f ms\n",
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   start = clock();
+   for (i = 0; i < BENCH_FILES; i++)
+      matches[1] += core_info_database_supports_content_path(
+            databases[i], files[i]);
+   printf("database, index:       %7.2f ms\n",
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   retro_assert(matches[0] == matches[1]);
+   matches[0] = matches[1] = 0;
+
+   start = clock();
+   for (i = 0; i < BENCH_FILES; i++)
+      matches[0] += bench_naive_supported_cores(files[i]);
+   printf("cores, linear scan:    %7.2f ms\n",
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   start = clock();
+   for (i = 0; i < BENCH_FILES; i++)
+   {
+      core_info_list_get_supported_cores(core_info_curr_list,
+            files[i], &infos, &num_infos);
+      matches[1] += num_infos;
+   }
+   printf("cores, index:          %7.2f ms\n",
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   retro_assert(matches[0] == matches[1]);
+
+   core_info_deinit_list();
+   free(files);
+   free(databases);
+}
+
+int main(int argc, char *argv[])
+{
+   bench_core_info_index();
+   return 0;
+}
@@ -0,0 +1,86 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "../../retroarch.c"
+
+/* Frame pacing of the limiter alone, as with the null video driver: nothing
+ * blocks on vsync and presenting costs nothing, so the intervals between
+ * frames are down to runloop_frame_limit(). Build with
+ * HAVE_FRAME_LIMIT_DEADLINE left undefined in retroarch.c to compare
+ * against whole-millisecond sleeps. */
+
+#define BENCH_FRAMES 2000
+
+static int bench_interval_cmp(const void *a_, const void *b_)
+{
+   retro_time_t a = *(const retro_time_t*)a_;
+   retro_time_t b = *(const retro_time_t*)b_;
+   return (a < b) ? -1 : (a > b);
+}
+
+static void bench_frame_limit(float hz)
+{
+   unsigned i;
+   double mean, var       = 0.0;
+   retro_time_t total     = 0;
+   retro_time_t *interval = (retro_time_t*)
+      malloc(BENCH_FRAMES * sizeof(*interval));
+   retro_time_t prev;
+
+   frame_limit_minimum_time = (retro_time_t)roundf(1000000.0f / hz);
+   frame_limit_last_time    = cpu_features_get_time_usec();
+   prev                     = frame_limit_last_time;
+
+   for (i = 0; i < BENCH_FRAMES; i++)
+   {
+      unsigned sleep_ms = 0;
+      retro_time_t now;
+
+      if (runloop_frame_limit(&sleep_ms) == 1 && sleep_ms > 0)
+         retro_sleep(sleep_ms);
+
+      now         = cpu_features_get_time_usec();
+      interval[i] = now - prev;
+      total      += interval[i];
+      prev        = now;
+   }
+
+   mean = (double)total / BENCH_FRAMES;
+   for (i = 0; i < BENCH_FRAMES; i++)
+      var += (interval[i] - mean) * (interval[i] - mean);
+
+   qsort(interval, BENCH_FRAMES, sizeof(*interval), bench_interval_cmp);
+
+   printf("%5.0f Hz: mean %6.0f us, stddev %5.0f us, "
+         "p1 %6d, p50 %6d, p99 %6d, max %6d us\n",
+         hz, mean, sqrt(var / BENCH_FRAMES),
+         (int)interval[BENCH_FRAMES / 100],
+         (int)interval[BENCH_FRAMES / 2],
+         (int)interval[BENCH_FRAMES * 99 / 100],
+         (int)interval[BENCH_FRAMES - 1]);
+
+   free(interval);
+}
+
+int main(int argc, char *argv[])
+{
+   bench_frame_limit(60.0f);
+   bench_frame_limit(120.0f);
+   bench_frame_limit(144.0f);
+   bench_frame_limit(240.0f);
+   return 0;
+}
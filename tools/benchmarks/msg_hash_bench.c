@@ -0,0 +1,56 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include "../../msg_hash.c"
+
+/* Looks strings up the way a menu render does, a few per
+ * visible entry, through the tables and through the switches. */
+
+#define BENCH_FRAMES  100000
+#define BENCH_ENTRIES 40
+
+static void bench_msg_hash(unsigned lang)
+{
+   unsigned i, j;
+   clock_t start;
+   size_t sum = 0;
+
+   msg_hash_set_uint(MSG_HASH_USER_LANGUAGE, lang);
+
+   start = clock();
+   for (i = 0; i < BENCH_FRAMES; i++)
+      for (j = 0; j < BENCH_ENTRIES * 3; j++)
+         sum += *msg_hash_to_str(
+                  (enum msg_hash_enums)((i * 7 + j * 13) % MSG_LAST));
+   printf("lang %u, table:  %.1f ms\n", lang,
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   start = clock();
+   for (i = 0; i < BENCH_FRAMES; i++)
+      for (j = 0; j < BENCH_ENTRIES * 3; j++)
+         sum += *msg_hash_to_str_lang(lang,
+                  (enum msg_hash_enums)((i * 7 + j * 13) % MSG_LAST));
+   printf("lang %u, switch: %.1f ms (%u)\n", lang,
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC, (unsigned)sum);
+}
+
+int main(int argc, char *argv[])
+{
+   bench_msg_hash(RETRO_LANGUAGE_ENGLISH);
+   bench_msg_hash(RETRO_LANGUAGE_FRENCH);
+   return 0;
+}
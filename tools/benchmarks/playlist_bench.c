@@ -0,0 +1,70 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include "../../playlist.c"
+
+/* Fills a playlist the way a database scan does, then
+ * reloads it from disk. */
+
+#define BENCH_ENTRIES 50000
+
+static void bench_playlist(const char *lpl)
+{
+   unsigned i;
+   clock_t start;
+   playlist_t *playlist = NULL;
+
+   remove(lpl);
+
+   playlist = playlist_init(lpl, 99999);
+
+   start = clock();
+   for (i = 0; i < BENCH_ENTRIES; i++)
+   {
+      char path[64];
+      char label[64];
+      char crc[16];
+
+      snprintf(path,  sizeof(path),  "/roms/System %u/Game %u.bin", i % 20, i);
+      snprintf(label, sizeof(label), "Game %u", i);
+      snprintf(crc,   sizeof(crc),   "%08X|crc", i * 2654435761u);
+
+      if (!playlist_entry_exists(playlist, path, crc))
+         playlist_push(playlist, path, label,
+               "DETECT", "DETECT", crc, "System.lpl");
+   }
+   printf("push %u entries: %.1f ms\n", (unsigned)playlist_size(playlist),
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   start = clock();
+   playlist_write_file(playlist);
+   playlist_free(playlist);
+   printf("write: %.1f ms\n", (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   start = clock();
+   playlist = playlist_init(lpl, 99999);
+   printf("load %u entries: %.1f ms\n", (unsigned)playlist_size(playlist),
+         (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+   playlist_free(playlist);
+}
+
+int main(int argc, char *argv[])
+{
+   bench_playlist(argc > 1 ? argv[1] : "bench.lpl");
+   return 0;
+}